@@ -36,6 +36,7 @@
 `define UART0
 `define USB_HID
 `define SPI_SDCARD
+`define SPI_SDCARD_HW
 `define SPI_ETH
 
 `elsif BOARD_LAKRITZ
@@ -55,6 +56,7 @@
 `define UART0
 `define USB_HID
 `define SPI_SDCARD
+`define SPI_SDCARD_HW
 
 `elsif BOARD_MOZART_ML1
 
@@ -73,6 +75,7 @@
 `define UART0
 `define USB_HID
 `define SPI_SDCARD
+`define SPI_SDCARD_HW
 `define ETH_RMII
 
 `elsif BOARD_LEBKUCHEN
@@ -91,6 +94,7 @@
 `define UART0
 `define USB_HID
 `define SPI_SDCARD
+`define SPI_SDCARD_HW
 `define SPI_FLASH
 
 `elsif BOARD_KOLSCH
@@ -108,6 +112,7 @@
 `define UART0
 `define USB_HID
 //`define SPI_SDCARD
+//`define SPI_SDCARD_HW
 //`define SPI_FLASH
 
 `elsif BOARD_ULX3S
@@ -127,5 +132,6 @@
 `define UART0
 `define USB_HID
 `define SPI_SDCARD
+`define SPI_SDCARD_HW
 
 `endif
@@ -74,5 +74,8 @@ localparam CSR_FEATURES =
 `endif
 `ifdef LED_DEBUG
 	(32'h1 << 19) |
+`endif
+`ifdef SPI_SDCARD_HW
+	(32'h1 << 20) |
 `endif
 	32'h0;
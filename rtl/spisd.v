@@ -0,0 +1,192 @@
+/*
+ * Zeitlos SOC
+ * Copyright (c) 2025 Lone Dynamics Corporation. All rights reserved.
+ *
+ * SPI master for the SD card: a shift engine with its own clock
+ * divider, fed and drained through small TX/RX FIFOs, so moving a byte
+ * costs the CPU one bus write and one bus read instead of the several
+ * reg_sdcard transactions per BIT that bit-banging through spibb.v
+ * takes. Built instead of spibb.v when a board defines SPI_SDCARD_HW
+ * (rtl/boards.vh), and reported through the CSRs (rtl/csrs.vh,
+ * sw/common/zsoc.h's Z_FEATURE_SPI_SDCARD_HW) so the driver can tell.
+ *
+ * spibb.v's register is kept, unchanged, at word 0: software that
+ * only knows about bit-banging (the BIOS, an older kernel) still works
+ * on this bitstream, and CS is driven through it either way -- the
+ * engine never touches CS. While the engine is shifting it owns SCK
+ * and MOSI; the rest of the time they follow the bit-bang register.
+ *
+ * Registers (word offsets from 0xb000_0000):
+ *
+ *   0  BB      spibb.v's: W {ss, sck, mosi} in bits 3:1, R adds miso in bit 0
+ *   1  STATUS  R: bit 0 busy (shifting, or TX FIFO not empty), bit 1 TX
+ *              full, bit 2 RX empty, 15:8 TX level, 23:16 RX level
+ *   2  CTRL    RW: 15:0 divider -- SCK is clk / (2 * (div + 1)) -- bit
+ *              16 discard (received bits aren't queued; for writes)
+ *   3  DATA8   W: queue one byte (7:0). R: pop one RX entry
+ *   4  DATA32  W: queue one 32-bit word, sent MSB first. R: pop one RX
+ *              entry (same as DATA8)
+ *
+ * Every FIFO entry is one transfer, 8 or 32 bits, in the order it was
+ * queued; a popped entry holds the byte in 7:0, or the word with the
+ * first bit received in bit 31. The engine won't start a transfer
+ * while the RX FIFO is full (unless discarding), so nothing received
+ * is ever dropped -- a reader just has to keep at most FIFO_DEPTH
+ * transfers outstanding. SPI mode 0: SCK idles low, MISO is sampled on
+ * the rising edge, MOSI changes on the falling one.
+ */
+
+module spisd_wb #(
+	parameter FIFO_DEPTH_LOG2 = 4,
+	parameter DIV_RESET = 16'd63	// ~375kHz at 48MHz -- slow enough for card init
+)
+(
+	input wb_clk_i,
+	input wb_rst_i,
+	input [31:0] wb_adr_i,
+	input [31:0] wb_dat_i,
+	output reg [31:0] wb_dat_o,
+	input wb_we_i,
+	input [3:0] wb_sel_i,
+	input wb_stb_i,
+	output wb_ack_o,
+	input wb_cyc_i,
+	output sd_ss, sd_sck, sd_mosi,
+	input sd_miso
+);
+
+	localparam DEPTH = 1 << FIFO_DEPTH_LOG2;
+
+	reg ack;
+	assign wb_ack_o = ack;
+
+	// bit-bang register (spibb.v)
+	reg bb_ss, bb_sck, bb_mosi;
+
+	reg [15:0] div;
+	reg discard;
+
+	// FIFOs -- pointers one bit wider than the index, so full and
+	// empty are told apart by the level alone
+	reg [32:0] tx_mem [0:DEPTH-1];	// {is_word, data}
+	reg [FIFO_DEPTH_LOG2:0] tx_wp, tx_rp;
+	reg [31:0] rx_mem [0:DEPTH-1];
+	reg [FIFO_DEPTH_LOG2:0] rx_wp, rx_rp;
+
+	wire [FIFO_DEPTH_LOG2:0] tx_level = tx_wp - tx_rp;
+	wire [FIFO_DEPTH_LOG2:0] rx_level = rx_wp - rx_rp;
+	wire tx_empty = (tx_level == 0);
+	wire tx_full = (tx_level == DEPTH);
+	wire rx_empty = (rx_level == 0);
+	wire rx_full = (rx_level == DEPTH);
+
+	// shift engine
+	reg running;
+	reg phase;			// SCK level while running
+	reg [15:0] div_cnt;
+	reg [5:0] bits_left;
+	reg [31:0] tx_sh, rx_sh;
+	reg rx_keep;		// this transfer's result goes into the RX FIFO
+
+	wire busy = running || !tx_empty;
+
+	assign sd_ss = bb_ss;
+	assign sd_sck = running ? phase : bb_sck;
+	assign sd_mosi = running ? tx_sh[31] : bb_mosi;
+
+	wire [7:0] tx_level8 = tx_level;
+	wire [7:0] rx_level8 = rx_level;
+
+	wire wb_req = wb_cyc_i && wb_stb_i && !ack;
+
+	always @(posedge wb_clk_i) begin
+
+		ack <= 0;
+
+		if (wb_rst_i) begin
+
+			bb_ss <= 1;
+			bb_sck <= 1;
+			bb_mosi <= 1;
+			div <= DIV_RESET;
+			discard <= 0;
+			tx_wp <= 0;
+			tx_rp <= 0;
+			rx_wp <= 0;
+			rx_rp <= 0;
+			running <= 0;
+			phase <= 0;
+
+		end else begin
+
+			// -- bus side --
+
+			if (wb_req && wb_we_i) begin
+				case (wb_adr_i[2:0])
+					3'd0: {bb_ss, bb_sck, bb_mosi} <= wb_dat_i[3:1];
+					3'd2: {discard, div} <= wb_dat_i[16:0];
+					3'd3, 3'd4: if (!tx_full) begin
+						// a byte goes out of the top of the shifter
+						// like a word does
+						tx_mem[tx_wp[FIFO_DEPTH_LOG2-1:0]] <= (wb_adr_i[2:0] == 3'd4) ?
+							{1'b1, wb_dat_i} : {1'b0, wb_dat_i[7:0], 24'hff_ffff};
+						tx_wp <= tx_wp + 1;
+					end
+					default: ;
+				endcase
+				ack <= 1;
+			end else if (wb_req) begin
+				case (wb_adr_i[2:0])
+					3'd0: wb_dat_o <= { 28'b0, bb_ss, bb_sck, bb_mosi, sd_miso };
+					3'd1: wb_dat_o <= { 8'b0, rx_level8, tx_level8, 5'b0, rx_empty, tx_full, busy };
+					3'd2: wb_dat_o <= { 15'b0, discard, div };
+					3'd3, 3'd4: begin
+						wb_dat_o <= rx_mem[rx_rp[FIFO_DEPTH_LOG2-1:0]];
+						if (!rx_empty) rx_rp <= rx_rp + 1;
+					end
+					default: wb_dat_o <= 32'h0;
+				endcase
+				ack <= 1;
+			end
+
+			// -- shift engine --
+
+			if (!running) begin
+				if (!tx_empty && (discard || !rx_full)) begin
+					tx_sh <= tx_mem[tx_rp[FIFO_DEPTH_LOG2-1:0]][31:0];
+					bits_left <= tx_mem[tx_rp[FIFO_DEPTH_LOG2-1:0]][32] ? 6'd32 : 6'd8;
+					tx_rp <= tx_rp + 1;
+					rx_sh <= 0;
+					rx_keep <= !discard;
+					div_cnt <= div;
+					phase <= 0;
+					running <= 1;
+				end
+			end else if (div_cnt != 0) begin
+				div_cnt <= div_cnt - 1;
+			end else begin
+				div_cnt <= div;
+				if (!phase) begin
+					// rising edge: sample
+					phase <= 1;
+					rx_sh <= { rx_sh[30:0], sd_miso };
+				end else begin
+					// falling edge: next bit out
+					phase <= 0;
+					tx_sh <= { tx_sh[30:0], 1'b1 };
+					bits_left <= bits_left - 1;
+					if (bits_left == 1) begin
+						running <= 0;
+						if (rx_keep) begin
+							rx_mem[rx_wp[FIFO_DEPTH_LOG2-1:0]] <= rx_sh;
+							rx_wp <= rx_wp + 1;
+						end
+					end
+				end
+			end
+
+		end
+
+	end
+
+endmodule
@@ -1025,11 +1025,17 @@ module sysctl #()
 	);
 `endif
 
-	// WISHBONE SLAVE: SPI BIT-BANG INTERFACE FOR SDCARD
+	// WISHBONE SLAVE: SPI BIT-BANG INTERFACE FOR SDCARD -- or, with
+	// SPI_SDCARD_HW, the FIFO'd SPI master (rtl/spisd.v), which keeps
+	// the bit-bang register at the same address
 `ifdef SPI_SDCARD
 	wire wbm_cyc_spisdcard = cs_spisdcard && wbm_cyc;
 
+`ifdef SPI_SDCARD_HW
+	spisd_wb #() wbs_spisd0_i
+`else
 	spibb_wb #() wbs_spibb0_i
+`endif
 	(
 		.wb_clk_i(wbm_clk),
 		.wb_rst_i(wbm_rst),
@@ -23,6 +23,9 @@ enum {
 	ZSYS_UART_PUTC,
 	ZSYS_UART_RX_EMPTY,
 	ZSYS_UART_TX_FULL,
+	/* further down syscalls.def -- only the ids handled below */
+	ZSYS_FAST_ENTRY = 26,
+	ZSYS_UART_WRITE = 27,
 };
 
 /* ------------------------------------------------------------------- */
@@ -254,6 +257,24 @@ static void do_syscall(machine_t *m) {
 		bus_write32(m, obj + ZOBJ_VAL_OFFSET, 0); /* host stdout never "full" */
 		break;
 
+	case ZSYS_UART_WRITE: {
+		/* z_uart_write_args_t (zeitlos.h): buf at +0, len at +4,
+		 * written at +8 */
+		uint32_t buf = bus_read32(m, obj);
+		uint32_t len = bus_read32(m, obj + 4);
+		for (uint32_t i = 0; i < len; i++)
+			putchar((int)bus_read8(m, buf + i));
+		fflush(stdout);
+		bus_write32(m, obj + 8, len);
+		break;
+	}
+
+	case ZSYS_FAST_ENTRY:
+		/* no register-based fast entry here (sw/common/fastcalls.def):
+		 * leaving the obj untouched (val 0) is how zeitlos.c's
+		 * z_fast_entry() learns to stay on the ordinary path above. */
+		break;
+
 	case ZSYS_UI_PRINT:
 		/* obj is a z_obj_t*; if it's a string object, print it. We don't
 		 * have the real z_type_t enum values pinned down here, so this
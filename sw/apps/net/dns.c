@@ -207,6 +207,28 @@ static uint16_t skip_name(const uint8_t *p, uint16_t offset, uint16_t len) {
 
 }
 
+// a Z_NET_DNS_RESOLVE_REPLY -- {"ok":1, "ip":ip} or {"ok":0,
+// "error":err}, built in a stack arena and copy-sent, same as net.c's
+// own send_reply()
+#define REPLY_ARENA_SIZE 256
+
+static void send_reply(uint32_t pid, uint32_t tag, uint32_t ip, const char *err) {
+	void *buf[REPLY_ARENA_SIZE / sizeof(void *)];
+	z_arena_t a;
+	z_arena_init(&a, buf, sizeof(buf));
+	z_msg_t reply;
+	reply.to = pid;
+	reply.subject = Z_NET_DNS_RESOLVE_REPLY;
+	reply.tag = tag;
+	reply.obj = z_arena_map(&a, 2);
+	z_arena_map_set(&a, &reply.obj, "ok", z_obj_uint32(err ? 0 : 1));
+	if (err)
+		z_arena_map_set(&a, &reply.obj, "error", z_arena_str(&a, err));
+	else
+		z_arena_map_set(&a, &reply.obj, "ip", z_obj_uint32(ip));
+	z_msg_send_copy(&reply);
+}
+
 static void finish_query(bool ok, uint32_t ip, const char *err) {
 
 	if (ok) {
@@ -217,16 +239,7 @@ static void finish_query(bool ok, uint32_t ip, const char *err) {
 		printf("net: dns: %s -> failed: %s\n", pending_hostname, err);
 	}
 
-	z_obj_t reply = z_obj_map(2);
-	z_map_set(&reply, "ok", z_obj_uint32(ok ? 1 : 0));
-	if (ok)
-		z_map_set(&reply, "ip", z_obj_uint32(ip));
-	else
-		z_map_set(&reply, "error", z_obj_str(err));
-	// `reply` intentionally never freed -- same one-shot, bounded-cost
-	// borrowed-reply tradeoff net.c's own reply_error() documents for
-	// itself (docs/messaging.md).
-	z_msg_new_send(requester_pid, Z_NET_DNS_RESOLVE_REPLY, requester_tag, reply);
+	send_reply(requester_pid, requester_tag, ip, ok ? NULL : err);
 
 	udp_close(local_port);
 	state = DNS_IDLE;
@@ -321,28 +334,19 @@ static void handle_dns_reply(uint32_t src_ip, uint16_t src_port,
 void dns_resolve_start(const char *hostname, uint32_t req_pid, uint32_t tag) {
 
 	if (state != DNS_IDLE) {
-		z_obj_t reply = z_obj_map(2);
-		z_map_set(&reply, "ok", z_obj_uint32(0));
-		z_map_set(&reply, "error", z_obj_str("dns: busy with another resolution"));
-		z_msg_new_send(req_pid, Z_NET_DNS_RESOLVE_REPLY, tag, reply);
+		send_reply(req_pid, tag, 0, "dns: busy with another resolution");
 		return;
 	}
 
 	if (!nameserver_ip) {
-		z_obj_t reply = z_obj_map(2);
-		z_map_set(&reply, "ok", z_obj_uint32(0));
-		z_map_set(&reply, "error", z_obj_str("dns: no nameserver configured"));
-		z_msg_new_send(req_pid, Z_NET_DNS_RESOLVE_REPLY, tag, reply);
+		send_reply(req_pid, tag, 0, "dns: no nameserver configured");
 		return;
 	}
 
 	uint32_t hlen = hostname ? strlen(hostname) : 0;
 	if (hlen == 0 || hlen > DNS_MAX_HOSTNAME_LEN) {
-		z_obj_t reply = z_obj_map(2);
-		z_map_set(&reply, "ok", z_obj_uint32(0));
-		z_map_set(&reply, "error", z_obj_str(hlen == 0 ?
-			"dns: empty hostname" : "dns: hostname too long"));
-		z_msg_new_send(req_pid, Z_NET_DNS_RESOLVE_REPLY, tag, reply);
+		send_reply(req_pid, tag, 0, hlen == 0 ?
+			"dns: empty hostname" : "dns: hostname too long");
 		return;
 	}
 
@@ -351,10 +355,7 @@ void dns_resolve_start(const char *hostname, uint32_t req_pid, uint32_t tag) {
 
 	uint16_t plen = build_query(our_qid, hostname, last_pkt);
 	if (plen == 0) {
-		z_obj_t reply = z_obj_map(2);
-		z_map_set(&reply, "ok", z_obj_uint32(0));
-		z_map_set(&reply, "error", z_obj_str("dns: malformed hostname"));
-		z_msg_new_send(req_pid, Z_NET_DNS_RESOLVE_REPLY, tag, reply);
+		send_reply(req_pid, tag, 0, "dns: malformed hostname");
 		return;
 	}
 
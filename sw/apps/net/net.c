@@ -179,20 +179,35 @@ static uint32_t telnet_client_pid;	// valid once state != TN_IDLE
 #define TELNET_CONN_ID 1			// only one connection ever -- no
 									// need to hand out distinct ids
 
+// messages pulled per z_msg_read_n() in main()'s loop -- kept small,
+// the array lives on net's own stack
+#define NET_MSG_BATCH 4
+
 static void print_ip(uint32_t ip) {
 	printf("%ld.%ld.%ld.%ld",
 		(long)((ip >> 24) & 0xFF), (long)((ip >> 16) & 0xFF),
 		(long)((ip >> 8) & 0xFF), (long)(ip & 0xFF));
 }
 
-static void reply_error(uint32_t to, uint32_t subject, uint32_t tag, const char *msg) {
-	z_obj_t reply = z_obj_map(2);
-	z_map_set(&reply, "ok", z_obj_uint32(0));
-	z_map_set(&reply, "error", z_obj_str(msg));
-	z_msg_new_send(to, subject, tag, reply);
-	// note: `reply` intentionally never freed -- same borrowed-reply
-	// tradeoff documented throughout (see docs/messaging.md); a
-	// one-shot message, not a per-chunk one, so the cost is bounded
+// a Z_MAP{"ok":1} reply, or {"ok":0, "error":err} if err is given --
+// built in a small arena on the stack and copy-sent (zmsg.h), so it
+// costs nothing on net's heap and nothing is left borrowed once the
+// send returns. Every requester hands the copy back with
+// z_msg_release() once it's read it.
+#define REPLY_ARENA_SIZE 256
+
+static void send_reply(uint32_t to, uint32_t subject, uint32_t tag, const char *err) {
+	void *buf[REPLY_ARENA_SIZE / sizeof(void *)];
+	z_arena_t a;
+	z_arena_init(&a, buf, sizeof(buf));
+	z_msg_t reply;
+	reply.to = to;
+	reply.subject = subject;
+	reply.tag = tag;
+	reply.obj = z_arena_map(&a, 2);
+	z_arena_map_set(&a, &reply.obj, "ok", z_obj_uint32(err ? 0 : 1));
+	if (err) z_arena_map_set(&a, &reply.obj, "error", z_arena_str(&a, err));
+	z_msg_send_copy(&reply);
 }
 
 // a Z_STREAM_OPEN arriving at net always means "start a TFTP GET" --
@@ -231,7 +246,7 @@ static void handle_stream_open(z_msg_t *msg) {
 static void handle_tftp_put_request(z_msg_t *msg) {
 
 	if (transfer_active) {
-		reply_error(msg->from, Z_NET_TFTP_PUT_REPLY, msg->tag, "net is busy with another transfer");
+		send_reply(msg->from, Z_NET_TFTP_PUT_REPLY, msg->tag, "net is busy with another transfer");
 		return;
 	}
 
@@ -239,7 +254,7 @@ static void handle_tftp_put_request(z_msg_t *msg) {
 	z_obj_t *fn_obj = z_map_find(&msg->obj, "filename");
 
 	if (!ip_obj || ip_obj->type != Z_UINT32 || !fn_obj || fn_obj->type != Z_STR) {
-		reply_error(msg->from, Z_NET_TFTP_PUT_REPLY, msg->tag, "bad request");
+		send_reply(msg->from, Z_NET_TFTP_PUT_REPLY, msg->tag, "bad request");
 		return;
 	}
 
@@ -268,24 +283,22 @@ static void handle_tftp_put_request(z_msg_t *msg) {
 // -- telnet: tcp.c/telnet.c event callbacks --
 
 // the TCP handshake (started from handle_telnet_port_connect() below)
-// completed -- only now do we tell the waiting `term` it's connected,
-// mirroring what z_port_accept() does internally (zport.c). Can't
-// call z_port_accept() itself here since it needs the original
-// z_msg_t, which is long gone by the time an async TCP handshake
+// completed -- only now do we tell the waiting `term` it's connected.
+// z_port_accept_pid() rather than z_port_accept(), since the original
+// CONNECT z_msg_t is long gone by the time an async TCP handshake
 // resolves -- telnet_client_pid (captured at CONNECT time) is all it
 // would have given us anyway.
 static void telnet_on_established(void) {
-	telnet_port.peer_pid = telnet_client_pid;
-	telnet_port.conn_id = TELNET_CONN_ID;
-	telnet_port.connected = true;
 	telnet_state = TN_ACTIVE;
-	z_msg_new_send(telnet_client_pid, Z_PORT_CONNECTED, 0, z_obj_uint32(TELNET_CONN_ID));
+	z_port_accept_pid(&telnet_port, telnet_client_pid, TELNET_CONN_ID);
 	printf("net: telnet connected, relaying to pid %ld\n", (long)telnet_client_pid);
 }
 
 static void telnet_on_data(const uint8_t *data, uint16_t len) {
 	if (telnet_state != TN_ACTIVE) return;
-	z_port_send(&telnet_port, data, len);
+	// flushed once per pass of main()'s loop -- a remote that sends
+	// a screenful as many small segments is still one DATA to term
+	z_port_write(&telnet_port, data, len);
 }
 
 // covers both "the handshake itself never completed" (state was
@@ -370,14 +383,17 @@ static void handle_telnet_port_connect(const z_msg_t *msg) {
 
 }
 
+// `msg` NULL: just the channel's ring, from main()'s loop every pass
+// -- see z_port_recv() (zport.h)
 static void handle_telnet_port_data(const z_msg_t *msg) {
 
 	if (telnet_state == TN_ACTIVE && telnet_port.connected &&
-		msg->tag == telnet_port.conn_id) {
+		(!msg || msg->tag == telnet_port.conn_id)) {
 
-		uint32_t len = z_blob_len(&msg->obj);
-		void *data = z_blob_data(&msg->obj);
-		if (data && len) telnet_send((const uint8_t *)data, (uint16_t)len);
+		const uint8_t *data;
+		uint32_t len;
+		while ((len = z_port_recv(&telnet_port, msg, &data)) > 0)
+			telnet_send(data, (uint16_t)len);
 		// telnet_send() returning false here (its own outbound queue
 		// is full) just drops these bytes -- the same accepted
 		// fire-and-forget flow-control gap docs/ports.md already
@@ -386,18 +402,16 @@ static void handle_telnet_port_data(const z_msg_t *msg) {
 
 	}
 
-	// tells `term` it's now safe to free its own z_obj_blob()
-	// allocation for this message -- see z_port_send_ack()'s own
-	// comment (zport.h) for why this has to come after the branch
-	// above has genuinely finished reading `data` (telnet_send()
-	// already copied whatever it needed via queue_bytes()'s own
-	// memcpy(), telnet.c, before returning). Sent unconditionally,
-	// even when the guard above didn't match and `data` was never
-	// touched at all -- that's still a message `net` will never look
-	// at again, and `term`'s own pending-sends slot for it
-	// (Z_PORT_MAX_PENDING_SENDS, zport.h) needs an ack to ever be
-	// freed regardless of whether `net` did anything useful with it.
-	z_port_send_ack(msg);
+	// hands the kernel's copy of `data` back -- see
+	// z_port_data_done()'s own comment (zport.h) for why this has to
+	// come after the branch above has genuinely finished reading
+	// `data` (telnet_send() already copied whatever it needed via
+	// queue_bytes()'s own memcpy(), telnet.c, before returning). Done
+	// unconditionally, even when the guard above didn't match and
+	// `data` was never touched at all -- that's still a message `net`
+	// will never look at again, and its copy would otherwise hold up
+	// net's own mailbox arena.
+	if (msg) z_port_data_done(msg);
 
 }
 
@@ -406,7 +420,7 @@ static void handle_telnet_port_close(const z_msg_t *msg) {
 	if (telnet_state != TN_ACTIVE || !telnet_port.connected ||
 		msg->tag != telnet_port.conn_id) return;
 
-	telnet_port.connected = false;
+	z_port_closed(&telnet_port);
 	telnet_abort();	// term already left -- no reason to wait out a
 						// graceful FIN exchange with the remote server
 	telnet_state = TN_IDLE;
@@ -421,10 +435,8 @@ static void handle_telnet_port_close(const z_msg_t *msg) {
 static void handle_dns_resolve(const z_msg_t *msg) {
 
 	if (msg->obj.type != Z_STR || !msg->obj.val.str) {
-		z_obj_t reply = z_obj_map(2);
-		z_map_set(&reply, "ok", z_obj_uint32(0));
-		z_map_set(&reply, "error", z_obj_str("dns: bad request (expected a hostname string)"));
-		z_msg_new_send(msg->from, Z_NET_DNS_RESOLVE_REPLY, msg->tag, reply);
+		send_reply(msg->from, Z_NET_DNS_RESOLVE_REPLY, msg->tag,
+			"dns: bad request (expected a hostname string)");
 		return;
 	}
 
@@ -452,18 +464,13 @@ static void check_tftp_progress(void) {
 		return;
 	}
 
-	z_obj_t reply = z_obj_map(2);
-
-	if (r == TFTP_RESULT_OK) {
+	if (r == TFTP_RESULT_OK)
 		printf("net: tftp put complete, %ld bytes\n", (long)len);
-		z_map_set(&reply, "ok", z_obj_uint32(1));
-	} else {
+	else
 		printf("net: tftp put failed: %s\n", err);
-		z_map_set(&reply, "ok", z_obj_uint32(0));
-		z_map_set(&reply, "error", z_obj_str(err));
-	}
 
-	z_msg_new_send(pending_to, Z_NET_TFTP_PUT_REPLY, pending_tag, reply);
+	send_reply(pending_to, Z_NET_TFTP_PUT_REPLY, pending_tag,
+		r == TFTP_RESULT_OK ? NULL : err);
 	printf("net: tftp put reply sent to pid %ld\n", (long)pending_to);
 
 }
@@ -522,10 +529,12 @@ int main(void) {
 	tcp_init(0);
 
 	uint32_t use_ip, use_netmask, use_gateway, use_dns = 0;
+	bool use_dhcp = false;
 
 #if NET_DHCP
 	if (dhcp_acquire(our_mac, &use_ip, &use_netmask, &use_gateway, &use_dns)) {
 		printf("net: using dhcp-assigned address\n");
+		use_dhcp = true;
 	} else {
 		printf("net: dhcp unavailable, falling back to static "
 			"config (see this file's header comment)\n");
@@ -575,6 +584,17 @@ int main(void) {
 	print_ip(use_netmask);
 	printf(", listening (arp + icmp echo + tftp + telnet + dns)\n");
 
+	// znet.h's Z_NET_TOPIC_LINK -- copied out to each subscriber by
+	// the kernel, so `link` is freed straight after
+	z_obj_t link = z_obj_map(5);
+	z_map_set(&link, "ip", z_obj_uint32(use_ip));
+	z_map_set(&link, "netmask", z_obj_uint32(use_netmask));
+	z_map_set(&link, "gateway", z_obj_uint32(use_gateway));
+	z_map_set(&link, "dns", z_obj_uint32(use_dns));
+	z_map_set(&link, "dhcp", z_obj_uint32(use_dhcp ? 1 : 0));
+	z_msg_publish(Z_NET_TOPIC_LINK, 0, link);
+	z_obj_free(&link);
+
 	while (1) {
 
 		eth_poll();
@@ -586,16 +606,26 @@ int main(void) {
 		// than waiting for some later point in this same loop.
 		ip_poll();
 
-		z_msg_t msg;
-		while (z_msg_read(&msg) == Z_OK) {
-			if (msg.subject == Z_STREAM_OPEN) handle_stream_open(&msg);
-			else if (msg.subject == Z_NET_TFTP_PUT) handle_tftp_put_request(&msg);
-			else if (msg.subject == Z_NET_DNS_RESOLVE) handle_dns_resolve(&msg);
-			else if (msg.subject == Z_PORT_CONNECT) handle_telnet_port_connect(&msg);
-			else if (msg.subject == Z_PORT_DATA) handle_telnet_port_data(&msg);
-			else if (msg.subject == Z_PORT_DATA_ACK) z_port_handle_ack(&telnet_port, &msg);
-			else if (msg.subject == Z_PORT_CLOSE) handle_telnet_port_close(&msg);
-			else tftp_handle_stream_msg(&msg);
+		// drained NET_MSG_BATCH messages per syscall (z_msg_read_n())
+		// -- a TFTP transfer or a busy telnet session keeps several
+		// stream/port messages queued at once. none of the handlers
+		// below read messages themselves, so a plain local batch is
+		// enough (compare wm's shared inbox, which has to cope with
+		// nesting).
+		z_msg_t batch[NET_MSG_BATCH];
+		uint32_t got;
+		while ((got = z_msg_read_n(batch, NET_MSG_BATCH)) > 0) {
+			for (uint32_t i = 0; i < got; i++) {
+				z_msg_t *msg = &batch[i];
+				if (msg->subject == Z_STREAM_OPEN) handle_stream_open(msg);
+				else if (msg->subject == Z_NET_TFTP_PUT) handle_tftp_put_request(msg);
+				else if (msg->subject == Z_NET_DNS_RESOLVE) handle_dns_resolve(msg);
+				else if (msg->subject == Z_PORT_CONNECT) handle_telnet_port_connect(msg);
+				else if (msg->subject == Z_PORT_DATA) handle_telnet_port_data(msg);
+				else if (msg->subject == Z_PORT_CLOSE) handle_telnet_port_close(msg);
+				else tftp_handle_stream_msg(msg);
+			}
+			if (got < NET_MSG_BATCH) break;
 		}
 
 		check_tftp_progress();
@@ -603,6 +633,9 @@ int main(void) {
 		telnet_poll();
 		dns_poll();
 
+		handle_telnet_port_data(NULL);
+		if (telnet_state == TN_ACTIVE) z_port_flush(&telnet_port);
+
 		for (volatile int i = 0; i < 500; i++) ; // light throttle
 
 	}
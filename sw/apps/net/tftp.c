@@ -44,16 +44,18 @@ static uint16_t last_pkt_len;
 static char err_msg[64];
 
 // GET: this process is the zstream producer -- each block received
-// from the server is held (see held_* below) until the receiver
-// pulls it, then delivered and (only then) ACKed to the server. This
-// keeps buffering bounded to exactly one block regardless of how the
-// receiver's own pace compares to the network's -- a receiver slower
-// than the network just means the server's own retransmits of the
-// still-unacked block get ignored (see handle_packet()) until we
-// catch up, rather than us needing to buffer ahead of what's been
-// delivered.
+// from the server is held (see held_* below) until the stream's
+// window has room for it, then delivered and (only then) ACKed to
+// the server. With the receiver's window (zstream_accept_window(),
+// up to ZSTREAM_WINDOW_MAX) that's usually straight away: a block is
+// ACKed as soon as it arrives instead of after a pull round trip
+// through two context switches. Buffering stays bounded regardless of
+// how the receiver's own pace compares to the network's -- one held
+// block here plus the window's chunks in flight -- and a receiver
+// slower than that just means the server's own retransmits of the
+// still-unacked block get ignored (see handle_packet()) until it
+// catches up.
 static zstream_producer_t out_stream;
-static bool pull_pending;	// receiver has an outstanding pull we haven't satisfied yet
 
 // PUT: this process is the zstream consumer -- pulls chunks from the
 // sender and forwards each to the server as the previous block gets
@@ -157,17 +159,16 @@ static void fail(const char *msg) {
 }
 
 // GET: called whenever there's both a block held (received from the
-// server) and a pull outstanding (requested by the receiver) --
-// delivers it and ACKs the server, only now that delivery is
-// confirmed successful.
+// server) and room in the receiver's window (a pull outstanding, for
+// a window of 1) -- delivers it and ACKs the server, only now that
+// delivery is confirmed successful.
 static void try_deliver_get(void) {
 
-	if (!held_valid || !pull_pending) return;
+	if (!held_valid || !zstream_can_send(&out_stream)) return;
 
 	zstream_send_chunk(&out_stream, held_data, held_len);
 	block = block + 1;	// held_data was always block+1 by construction (see handle_packet())
 	buf_len += held_len;
-	pull_pending = false;
 
 	uint16_t delivered_len = held_len;
 	held_valid = false;
@@ -301,10 +302,11 @@ bool tftp_get_start(uint32_t server_ip, const char *filename,
 	buf_len = 0;
 	block = 0;
 	retries = 0;
-	pull_pending = false;
 	held_valid = false;
 
-	zstream_accept(&out_stream, receiver_pid, open_tag);
+	// the last GET's stream, if its receiver never pulled its EOF
+	if (out_stream.active) zstream_producer_close(&out_stream);
+	zstream_accept_window(&out_stream, receiver_pid, open_tag, ZSTREAM_WINDOW_MAX);
 
 	udp_listen(local_port, handle_packet);
 	send_rrq_wrq(TFTP_OP_RRQ, filename);
@@ -417,10 +419,13 @@ bool tftp_handle_stream_msg(z_msg_t *msg) {
 
 		case Z_STREAM_PULL:
 		case Z_STREAM_ABORT: {
-			if (state != T_GET) return false;
+			// a finished GET's stream still takes the receiver's
+			// last pull -- that's what frees the chunks it was still
+			// reading when the EOF went out (zstream_send_eof())
+			if (!is_get || !out_stream.active) return false;
 			zstream_event_t ev = zstream_producer_handle(&out_stream, msg);
+			if (state != T_GET) return true;
 			if (ev == ZSTREAM_EVENT_PULL) {
-				pull_pending = true;
 				try_deliver_get();
 			} else if (ev == ZSTREAM_EVENT_ABORT) {
 				fail("receiver aborted");
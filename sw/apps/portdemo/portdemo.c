@@ -68,29 +68,25 @@ int main(void) {
 			} else if (msg.subject == Z_PORT_DATA) {
 
 				if (conn.connected && msg.tag == conn.conn_id) {
-					uint32_t len = z_blob_len(&msg.obj);
-					void *data = z_blob_data(&msg.obj);
-					if (data && len) z_port_send(&conn, data, len);
+					const uint8_t *data;
+					uint32_t len;
+					while ((len = z_port_recv(&conn, &msg, &data)) > 0)
+						z_port_send(&conn, data, len);
 				}
-				// tells the client it's now safe to free its own
-				// z_obj_blob() allocation -- see z_port_send_ack()'s
-				// own comment (sw/common/zport.h) for why this has to
-				// come after the echo z_port_send() above has already
-				// copied whatever it needed out of `data` (it has --
-				// z_obj_blob(), zobj.c, memcpy()s up front). Sent
+				// hands the kernel's copy of `data` back -- see
+				// z_port_data_done()'s own comment (sw/common/zport.h)
+				// for why this has to come after the echo z_port_send()
+				// above has already finished with `data` (it has --
+				// z_port_send() copies it before returning). Done
 				// unconditionally, even when the guard above didn't
 				// match -- that's still a message this process will
 				// never look at again.
-				z_port_send_ack(&msg);
-
-			} else if (msg.subject == Z_PORT_DATA_ACK) {
-
-				z_port_handle_ack(&conn, &msg);
+				z_port_data_done(&msg);
 
 			} else if (msg.subject == Z_PORT_CLOSE) {
 
 				if (conn.connected && msg.tag == conn.conn_id) {
-					conn.connected = false;
+					z_port_closed(&conn);
 					printf("portdemo: client disconnected\n");
 				}
 
@@ -98,6 +94,14 @@ int main(void) {
 
 		}
 
+		// the channel's ring, doorbell or not -- see z_port_recv()
+		if (conn.connected) {
+			const uint8_t *data;
+			uint32_t len;
+			while ((len = z_port_recv(&conn, NULL, &data)) > 0)
+				z_port_send(&conn, data, len);
+		}
+
 	}
 
 	return 0;
@@ -108,9 +108,9 @@ typedef struct {
 	// handle_data() routes this connection's bytes straight to
 	// te_bridge_feed() instead of the normal z_line_feed()/
 	// dispatch_line() path below. Relies on zero-initialized .bss,
-	// same as z_port_t's own fields already do (see zport.h's comment
-	// on `pending` for why that's a safe assumption for every app
-	// binary here).
+	// same as z_port_t's own fields already do (each app's Makefile
+	// zero-pads its .bin up through `_end` -- see docs/networking.md's
+	// "objcopy truncation bug").
 	bool		in_editor;
 } repl_conn_t;
 
@@ -671,7 +671,7 @@ static void conn_send_str(repl_conn_t *c, const char *s) {
 	// for v1") -- log it rather than silently dropping the bytes with
 	// no trace anywhere, same as this file already does for TFTP-style
 	// failures elsewhere in the codebase.
-	if (z_port_send(&c->port, s, len) != Z_OK)
+	if (z_port_write(&c->port, s, len) != Z_OK)
 		printf("repl: conn_send_str failed (%lu bytes) to pid %ld\n",
 			(unsigned long)len, (long)c->port.peer_pid);
 }
@@ -708,119 +708,126 @@ static repl_conn_t *find_conn_by_tag(uint32_t tag) {
 	return NULL;
 }
 
-static void handle_data(const z_msg_t *msg) {
-
-	repl_conn_t *c = find_conn_by_tag(msg->tag);
-
-	if (c) {
-
-		uint32_t len = z_blob_len(&msg->obj);
-		uint8_t *data = (uint8_t *)z_blob_data(&msg->obj);
-
-		if (data && len) {
-
-			// a single DATA message is usually one keystroke (see this
-			// file's own header comment), but feed every byte through
-			// in order regardless -- correct either way, and doesn't
-			// assume anything about how many bytes a future, non-term
-			// client might bundle into one message (e.g. a pasted
-			// block, or -- the common case for this specific check --
-			// a multi-byte VT100 escape sequence like an arrow key
-			// while this connection is in the `te` editor below).
-			for (uint32_t i = 0; i < len; i++) {
-
-				// while this connection owns the live `te` session
-				// (te_bridge.h), every byte goes straight to it,
-				// bypassing the normal line-editing/dispatch path
-				// entirely -- bytes from any OTHER connection still
-				// go through that path below regardless, so repl
-				// stays responsive to its other windows while one is
-				// editing. This check is per-BYTE, not per-message,
-				// for the same reason z_line_feed() below needs
-				// bytes fed one at a time.
-				if (c->in_editor) {
-
-					if (!te_bridge_feed(data[i])) {
-						// Esc :q just ended the session -- clear the
-						// screen (te's own last redraw is still up)
-						// and drop this connection back into normal
-						// line mode.
-						c->in_editor = false;
-						conn_send_str(c,
-							"\r\n" VT100_ERASE_SCREEN VT100_CURSOR_HOME
-							"te: session ended\r\n");
-						conn_send_str(c, PROMPT);
-						z_line_reset(&c->line);
-					}
-
-					continue;
-
+// feeds whatever `c` has waiting through the line editor/dispatch --
+// `msg`'s bytes and the channel's ring, or (msg NULL) just the ring,
+// which main()'s loop does every pass, doorbell or not (see
+// z_port_recv(), zport.h)
+static void conn_recv(repl_conn_t *c, const z_msg_t *msg) {
+
+	const uint8_t *data;
+	uint32_t len;
+	bool quit = false;
+
+	while (!quit && (len = z_port_recv(&c->port, msg, &data)) > 0) {
+
+		// a single DATA message is usually one keystroke (see this
+		// file's own header comment), but feed every byte through
+		// in order regardless -- correct either way, and doesn't
+		// assume anything about how many bytes a future, non-term
+		// client might bundle into one message (e.g. a pasted
+		// block, or -- the common case for this specific check --
+		// a multi-byte VT100 escape sequence like an arrow key
+		// while this connection is in the `te` editor below).
+		for (uint32_t i = 0; i < len; i++) {
+
+			// while this connection owns the live `te` session
+			// (te_bridge.h), every byte goes straight to it,
+			// bypassing the normal line-editing/dispatch path
+			// entirely -- bytes from any OTHER connection still
+			// go through that path below regardless, so repl
+			// stays responsive to its other windows while one is
+			// editing. This check is per-BYTE, not per-message,
+			// for the same reason z_line_feed() below needs
+			// bytes fed one at a time.
+			if (c->in_editor) {
+
+				if (!te_bridge_feed(data[i])) {
+					// Esc :q just ended the session -- clear the
+					// screen (te's own last redraw is still up)
+					// and drop this connection back into normal
+					// line mode.
+					c->in_editor = false;
+					conn_send_str(c,
+						"\r\n" VT100_ERASE_SCREEN VT100_CURSOR_HOME
+						"te: session ended\r\n");
+					conn_send_str(c, PROMPT);
+					z_line_reset(&c->line);
 				}
 
-				char echo[Z_LINE_ECHO_MAX];
-				uint32_t echo_len;
-				int complete =
-					z_line_feed(&c->line, data[i], echo, &echo_len, sizeof(echo));
-
-				if (echo_len) {
-					// see conn_send_str()'s own comment above -- same
-					// reasoning applies here.
-					if (z_port_send(&c->port, echo, echo_len) != Z_OK)
-						printf("repl: echo z_port_send failed (%lu bytes) to pid %ld\n",
-							(unsigned long)echo_len, (long)c->port.peer_pid);
-				}
+				continue;
 
-				if (!complete) continue;
+			}
 
-				char out[Z_REPL_EVAL_REPLY_MAX];
-				bool wants_quit =
-					dispatch_line(c->line.buf, out, sizeof(out), c);
+			char echo[Z_LINE_ECHO_MAX];
+			uint32_t echo_len;
+			int complete =
+				z_line_feed(&c->line, data[i], echo, &echo_len, sizeof(echo));
+
+			if (echo_len) {
+				// see conn_send_str()'s own comment above -- same
+				// reasoning applies here.
+				if (z_port_write(&c->port, echo, echo_len) != Z_OK)
+					printf("repl: echo z_port_write failed (%lu bytes) to pid %ld\n",
+						(unsigned long)echo_len, (long)c->port.peer_pid);
+			}
 
-				if (out[0]) {
-					conn_send_str(c, out);
-					conn_send_str(c, "\r\n");
-				}
+			if (!complete) continue;
 
-				if (wants_quit) {
-					z_port_close(&c->port);
-					// c->port.connected is now false -- if more bytes
-					// from this same peer are still queued behind this
-					// DATA message (unlikely, but not impossible), the
-					// tag won't match a connected slot anymore and
-					// find_conn_by_tag() will just drop them next
-					// time, same as any other post-close stray DATA.
-					break;
-				}
+			char out[Z_REPL_EVAL_REPLY_MAX];
+			bool wants_quit =
+				dispatch_line(c->line.buf, out, sizeof(out), c);
 
-				z_line_reset(&c->line);
+			if (out[0]) {
+				conn_send_str(c, out);
+				conn_send_str(c, "\r\n");
+			}
 
-				if (c->in_editor) {
-					// dispatch_line() just started a `te` session on
-					// this connection (the "te <filename>" command
-					// above) -- it already sent the editor's own
-					// first screen, so don't ALSO print the normal
-					// PROMPT on top of it.
-					continue;
-				}
+			if (wants_quit) {
+				z_port_close(&c->port);
+				quit = true;
+				// c->port.connected is now false -- if more bytes
+				// from this same peer are still queued behind this
+				// DATA message (unlikely, but not impossible), the
+				// tag won't match a connected slot anymore and
+				// find_conn_by_tag() will just drop them next
+				// time, same as any other post-close stray DATA.
+				break;
+			}
 
-				conn_send_str(c, PROMPT);
+			z_line_reset(&c->line);
 
+			if (c->in_editor) {
+				// dispatch_line() just started a `te` session on
+				// this connection (the "te <filename>" command
+				// above) -- it already sent the editor's own
+				// first screen, so don't ALSO print the normal
+				// PROMPT on top of it.
+				continue;
 			}
 
+			conn_send_str(c, PROMPT);
+
 		}
 
 	}
 
-	// tells whoever sent this it's now safe to free its own
-	// z_obj_blob() allocation -- see z_port_send_ack()'s own comment
-	// (zport.h) for why this has to come after every branch above has
-	// genuinely finished reading `data` (it's a safe no-op for a
-	// stale/unrecognized connection, or an empty/malformed payload --
-	// neither of those branches ever touch `data` at all). One call
-	// site covering every way this function can finish, on purpose,
-	// rather than one per early exit, so it can't accidentally get
-	// missed if this function's control flow changes later.
-	z_port_send_ack(msg);
+}
+
+static void handle_data(const z_msg_t *msg) {
+
+	repl_conn_t *c = find_conn_by_tag(msg->tag);
+	if (c) conn_recv(c, msg);
+
+	// hands the kernel's copy of `data` back -- see
+	// z_port_data_done()'s own comment (zport.h) for why this has to
+	// come after every branch above has genuinely finished reading
+	// `data` (and still happen for a stale/unrecognized connection, or
+	// an empty/malformed payload -- neither of those branches ever
+	// touch `data` at all). One call site covering every way this
+	// function can finish, on purpose, rather than one per early exit,
+	// so it can't accidentally get missed if this function's control
+	// flow changes later.
+	z_port_data_done(msg);
 
 }
 
@@ -840,7 +847,7 @@ static void handle_close(const z_msg_t *msg) {
 		te_bridge_abort();
 		c->in_editor = false;
 	}
-	c->port.connected = false;
+	z_port_closed(&c->port);
 	printf("repl: connection closed by peer\n");
 }
 
@@ -952,9 +959,6 @@ int main(void) {
 				handle_connect(&msg);
 			} else if (msg.subject == Z_PORT_DATA) {
 				handle_data(&msg);
-			} else if (msg.subject == Z_PORT_DATA_ACK) {
-				repl_conn_t *c = find_conn_by_tag(msg.tag);
-				if (c) z_port_handle_ack(&c->port, &msg);
 			} else if (msg.subject == Z_PORT_CLOSE) {
 				handle_close(&msg);
 			} else if (msg.subject == Z_REPL_EVAL) {
@@ -976,6 +980,16 @@ int main(void) {
 
 		}
 
+		// each connection's channel ring, whether or not its doorbell
+		// made it here
+		for (int i = 0; i < Z_REPL_MAX_CONNS; i++)
+			if (conns[i].port.connected) conn_recv(&conns[i], NULL);
+
+		// the echo, output and prompt conn_send_str() gathered for
+		// each connection while the mailbox drained -- one DATA each
+		for (int i = 0; i < Z_REPL_MAX_CONNS; i++)
+			if (conns[i].port.connected) z_port_flush(&conns[i].port);
+
 	}
 
 	return 0;
@@ -35,8 +35,8 @@
  *   currently owns the live session, and batching every write into
  *   one z_port_send() per input byte processed (te.c's own
  *   te_redraw() issues many small printf()-equivalent calls per
- *   keystroke -- sending each individually would either blow
- *   Z_PORT_MAX_PENDING_SENDS or just be needlessly chatty; see
+ *   keystroke -- sending each individually would fill the
+ *   receiver's mailbox arena or just be needlessly chatty; see
  *   zport.h's own "Flow control" notes).
  */
 
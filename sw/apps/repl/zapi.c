@@ -492,7 +492,10 @@ static bool zapi_msg_wait_timeout(z_msg_t *msg, uint32_t subject, uint32_t tag,
 		if (z_msg_read(msg) != Z_OK) continue;
 		if (msg->subject == subject && msg->tag == tag) return true;
 		// not the one we're waiting for -- discard, same as
-		// z_msg_wait()'s own documented behavior
+		// z_msg_wait()'s own documented behavior, including handing
+		// back a kernel copy (a copy-sent DATA) so it doesn't hold
+		// up every later one behind it
+		z_msg_release(msg);
 	}
 
 	return false;
@@ -527,9 +530,12 @@ static ms_val *zapi_msg_wait(ms_val *args) {
 	}
 
 	if (!found) return ms_mk_bool(false);
-	if (msg.obj.type != Z_STR || !msg.obj.val.str) return ms_mk_bool(false);
 
-	char *s = strdup(msg.obj.val.str);
+	// copied out (or not wanted) either way -- the kernel's copy goes
+	// back before returning
+	char *s = (msg.obj.type == Z_STR && msg.obj.val.str) ?
+		strdup(msg.obj.val.str) : NULL;
+	z_msg_release(&msg);
 	if (!s) return ms_mk_bool(false);
 
 	return ms_mk_str(s);
@@ -601,15 +607,18 @@ static ms_val *zapi_tget(ms_val *args) {
 	if (!z_resolve_host(ip_str, &ip, err, sizeof(err)))
 		ms_log(MS_PANIC, "tget: %s", err);
 
-	z_obj_t req = z_obj_map(2);
-	z_map_set(&req, "ip", z_obj_uint32(ip));
-	z_map_set(&req, "filename", z_obj_str(remote));
-	// note: `req` intentionally never freed -- same borrowed-payload
-	// reasoning docs/messaging.md documents throughout, and sh.c's
-	// own tget already relies on for this exact call.
+	// on the stack (z_arena_t, zobj.h) -- net has read it by the time
+	// it answers the open, which we wait for right here
+	void *req_buf[32];
+	z_arena_t req_arena;
+	z_arena_init(&req_arena, req_buf, sizeof(req_buf));
+	z_obj_t req = z_arena_map(&req_arena, 2);
+	z_arena_map_set(&req_arena, &req, "ip", z_obj_uint32(ip));
+	z_arena_map_set(&req_arena, &req, "filename", z_arena_str(&req_arena, remote));
 
 	zstream_consumer_t cons;
-	if (!zstream_open(&cons, zapi_resolve_net_pid(), req, err, sizeof(err)))
+	if (!zstream_open_window(&cons, zapi_resolve_net_pid(), req,
+		ZSTREAM_WINDOW_DEFAULT, err, sizeof(err)))
 		ms_log(MS_PANIC, "tget: failed to open: %s", err);
 
 	int handle = fs_open_write(local);
@@ -618,33 +627,13 @@ static ms_val *zapi_tget(ms_val *args) {
 		ms_log(MS_PANIC, "tget: failed to open '%s' for writing", local);
 	}
 
-	uint32_t total = 0;
-
-	while (1) {
-
-		const uint8_t *data;
-		uint32_t len;
-		zstream_result_t r = zstream_pull(&cons, &data, &len, err, sizeof(err));
-
-		if (r == ZSTREAM_EOF) break;
-
-		if (r == ZSTREAM_ERROR) {
-			fs_close_handle(handle);
-			ms_log(MS_PANIC, "tget: %s", err);
-		}
-
-		if (fs_write_chunk(handle, data, (int)len) != (int)len) {
-			fs_close_handle(handle);
-			zstream_abort(&cons);
-			ms_log(MS_PANIC, "tget: local write failed");
-		}
-
-		total += len;
-
-	}
-
+	// the kernel pulls the rest and writes each chunk straight from
+	// net's blob (fs_splice_in(), zfsapp.h)
+	int total = fs_splice_in(handle, &cons, ZAPI_TFTP_TIMEOUT_TICKS, err, sizeof(err));
 	fs_close_handle(handle);
 
+	if (total < 0) ms_log(MS_PANIC, "tget: %s", err);
+
 	return ms_mk_num(total);
 
 }
@@ -673,65 +662,48 @@ static ms_val *zapi_tput(ms_val *args) {
 	if (handle < 0)
 		ms_log(MS_PANIC, "tput: failed to open '%s' for reading", local);
 
+	// on the stack, as in `tget` above -- net has read it by the time
+	// it opens its stream back to us
 	uint32_t tag = zapi_next_tftp_tag();
-	z_obj_t req = z_obj_map(2);
-	z_map_set(&req, "ip", z_obj_uint32(ip));
-	z_map_set(&req, "filename", z_obj_str(remote));
+	void *req_buf[32];
+	z_arena_t req_arena;
+	z_arena_init(&req_arena, req_buf, sizeof(req_buf));
+	z_obj_t req = z_arena_map(&req_arena, 2);
+	z_arena_map_set(&req_arena, &req, "ip", z_obj_uint32(ip));
+	z_arena_map_set(&req_arena, &req, "filename", z_arena_str(&req_arena, remote));
 	z_msg_new_send(zapi_resolve_net_pid(), Z_NET_TFTP_PUT, tag, req);
-	// note: `req` intentionally never freed -- same reasoning as
-	// `tget` above.
 
 	// act as a zstream *producer* now -- net is about to open a
-	// stream back to us to pull this file's bytes. We have nothing
-	// else to do while this runs (this whole call already blocks
-	// repl), so a simple loop reading our own mailbox directly is
-	// fine here -- exactly sh.c's own tput, down to reusing the same
-	// timeout duration (ZAPI_TFTP_TIMEOUT_TICKS above).
+	// stream back to us to pull this file's bytes. Once it has, the
+	// kernel answers its pulls straight from the file
+	// (fs_splice_out(), zfsapp.h); until then a simple loop reading
+	// our own mailbox directly is fine -- exactly sh.c's own tput,
+	// down to reusing the same timeout duration
+	// (ZAPI_TFTP_TIMEOUT_TICKS above).
 	zstream_producer_t prod;
 	bool have_stream = false;
-	bool producer_ok = true;
-	uint8_t chunk[ZSTREAM_CHUNK_SIZE_DEFAULT];
+	bool producer_ok = false;
 	uint32_t start = z_uptime_ticks();
 
 	while (z_uptime_ticks() - start < ZAPI_TFTP_TIMEOUT_TICKS) {
-
 		z_msg_t msg;
 		if (z_msg_read(&msg) != Z_OK) continue;
-
-		if (!have_stream) {
-			if (msg.subject != Z_STREAM_OPEN) continue;	// discard anything else while waiting to start
-			zstream_accept(&prod, msg.from, msg.tag);
-			have_stream = true;
-			start = z_uptime_ticks();
+		if (msg.subject != Z_STREAM_OPEN) {
+			z_msg_release(&msg);	// discard anything else while waiting to start
 			continue;
 		}
+		zstream_accept(&prod, msg.from, msg.tag);
+		z_msg_release(&msg);
+		have_stream = true;
+		break;
+	}
 
-		if (msg.subject == Z_STREAM_ABORT) {
-			producer_ok = false;
-			break;
-		}
-
-		if (msg.subject != Z_STREAM_PULL) continue;
-
-		if (zstream_producer_handle(&prod, &msg) != ZSTREAM_EVENT_PULL)
-			continue;	// stale/retry pull, already handled internally
-
-		int n = fs_read_chunk(handle, chunk, sizeof(chunk));
-
-		if (n < 0) {
-			zstream_send_error(&prod, "local read failed");
-			producer_ok = false;
-			break;
-		}
-
-		if (n == 0) {
-			zstream_send_eof(&prod);
-			break;	// our part is done -- net finishes talking to the server on its own
-		}
-
-		zstream_send_chunk(&prod, chunk, (uint32_t)n);
-		start = z_uptime_ticks();
-
+	if (have_stream) {
+		// static: the last (short) chunk is still lent to net after
+		// the splice returns, until net's reply below
+		static z_fs_splice_chunk_t chunk;
+		producer_ok = fs_splice_out(handle, &prod, &chunk,
+			ZAPI_TFTP_TIMEOUT_TICKS, err, sizeof(err)) >= 0;
 	}
 
 	fs_close_handle(handle);
@@ -740,18 +712,24 @@ static ms_val *zapi_tput(ms_val *args) {
 		ms_log(MS_PANIC, "tput: no reply from net after 10s -- is it running? (`run net`)");
 
 	if (!producer_ok)
-		ms_log(MS_PANIC, "tput: failed sending local data");
+		ms_log(MS_PANIC, "tput: failed sending local data: %s", err);
 
 	z_msg_t reply;
 	if (!zapi_msg_wait_timeout(&reply, Z_NET_TFTP_PUT_REPLY, tag, ZAPI_TFTP_TIMEOUT_TICKS))
 		ms_log(MS_PANIC, "tput: no reply from net after 10s -- is it running? (`run net`)");
 
+	// net copy-sends its replies -- hand this one back before either
+	// way out (ms_log(MS_PANIC, ...) doesn't return)
 	z_obj_t *ok = z_map_find(&reply.obj, "ok");
-	if (ok && ok->val.uint32) return ms_mk_bool(true);
-
+	bool done = ok && ok->val.uint32;
 	z_obj_t *e = z_map_find(&reply.obj, "error");
-	ms_log(MS_PANIC, "tput: failed: %s",
-		(e && e->type == Z_STR && e->val.str) ? e->val.str : "unknown error");
+	strncpy(err, (e && e->type == Z_STR && e->val.str) ? e->val.str : "unknown error",
+		sizeof(err) - 1);
+	err[sizeof(err) - 1] = 0;
+	z_msg_release(&reply);
+
+	if (done) return ms_mk_bool(true);
+	ms_log(MS_PANIC, "tput: failed: %s", err);
 
 	return ms_mk_bool(false);	// unreachable -- ms_log(MS_PANIC, ...) never returns
 
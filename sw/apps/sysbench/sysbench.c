@@ -0,0 +1,119 @@
+/*
+ * Zeitlos OS
+ * Copyright (c) 2025 Lone Dynamics Corporation. All rights reserved.
+ *
+ * sysbench -- per-call cost of the ordinary z_obj_t syscall path vs.
+ * the register-based fast path (sw/common/fastcalls.def), in CPU
+ * cycles, for the calls that have both. `run sysbench` from the
+ * kernel shell; prints one line per syscall.
+ *
+ * Cycles come from rdcycle (PicoRV32's ENABLE_COUNTERS, on by default
+ * in rtl/sysctl.v's instance). Each figure is the best of SB_ROUNDS
+ * rounds of SB_CALLS back-to-back calls, minus the same loop with no
+ * call in it -- "best of" because a KTIMER interrupt (scheduler swap,
+ * ~732Hz) landing inside a round inflates that round by however long
+ * the other processes ran, and the minimum is the round that didn't
+ * get hit. Run it with as little else going as possible anyway.
+ *
+ * The simulator (sim/) reads rdcycle as 0 and has no fast entry, so
+ * this only means anything on real hardware.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "../../common/zeitlos.h"
+
+#define SB_CALLS	256	// power of two -- the per-call divide is a shift
+#define SB_CALLS_SHIFT	8
+#define SB_ROUNDS	16
+
+static inline uint32_t rdcycle(void) {
+	uint32_t c;
+	__asm__ volatile ("rdcycle %0" : "=r"(c));
+	return c;
+}
+
+// the ordinary path, spelled out here rather than going through
+// zeitlos.c's wrappers -- those take the fast path themselves now
+// whenever the kernel has one.
+static uint32_t slow_call(uint32_t id, int32_t arg) {
+	z_kernel_ptr_t z_kernel_ptr = (z_kernel_ptr_t)(uintptr_t)(reg_kernel);
+	z_obj_t obj;
+	obj.type = Z_INT32;
+	obj.val.int32 = arg;
+	z_kernel_ptr(id, (uint32_t *)&obj, 0);
+	return obj.val.uint32;
+}
+
+static uint32_t slow_msg_read(z_msg_t *msg) {
+	z_kernel_ptr_t z_kernel_ptr = (z_kernel_ptr_t)(uintptr_t)(reg_kernel);
+	z_obj_t *rv = (z_obj_t *)z_kernel_ptr(Z_SYS_MSG_READ, (uint32_t *)msg, 0);
+	return rv->val.uint32;
+}
+
+typedef enum { SB_EMPTY, SB_SLOW, SB_FAST } sb_mode_t;
+
+static z_msg_t sb_msg;
+static volatile uint32_t sb_sink;
+
+static uint32_t sb_round(sb_mode_t mode, uint32_t id, z_kernel_fast_ptr_t fast) {
+	uint32_t acc = 0;
+	uint32_t start = rdcycle();
+	for (int i = 0; i < SB_CALLS; i++) {
+		if (mode == SB_SLOW) {
+			acc += (id == Z_SYS_MSG_READ) ? slow_msg_read(&sb_msg) : slow_call(id, 0);
+		} else if (mode == SB_FAST) {
+			acc += fast(id, (id == Z_SYS_MSG_READ) ?
+				(uint32_t)(uintptr_t)&sb_msg : 0, 0, 0);
+		} else {
+			__asm__ volatile ("" ::: "memory");
+		}
+	}
+	uint32_t elapsed = rdcycle() - start;
+	sb_sink = acc;
+	return elapsed;
+}
+
+static uint32_t sb_best(sb_mode_t mode, uint32_t id, z_kernel_fast_ptr_t fast) {
+	uint32_t best = 0xffffffff;
+	for (int r = 0; r < SB_ROUNDS; r++) {
+		uint32_t c = sb_round(mode, id, fast);
+		if (c < best) best = c;
+	}
+	return best;
+}
+
+static void sb_run(const char *name, uint32_t id, z_kernel_fast_ptr_t fast, uint32_t base) {
+	uint32_t slow = (sb_best(SB_SLOW, id, fast) - base) >> SB_CALLS_SHIFT;
+	uint32_t quick = (sb_best(SB_FAST, id, fast) - base) >> SB_CALLS_SHIFT;
+	printf(" %-14s slow: %4ld  fast: %4ld  saved: %4ld cycles/call\n",
+		name, (long)slow, (long)quick, (long)slow - (long)quick);
+}
+
+int main() {
+
+	printf("sysbench: %i calls x %i rounds, best round shown\n",
+		SB_CALLS, SB_ROUNDS);
+
+	z_kernel_fast_ptr_t fast = z_fast_entry();
+	if (!fast) {
+		printf("sysbench: no fast syscall entry (old kernel or simulator)\n");
+		return 1;
+	}
+
+	// drain anything already queued so MSG_READ measures the empty
+	// mailbox case
+	while (slow_msg_read(&sb_msg) == Z_OK) ;
+
+	uint32_t base = sb_best(SB_EMPTY, 0, fast);
+
+	sb_run("UPTIME", Z_SYS_UPTIME, fast, base);
+	sb_run("GETPID", Z_SYS_GETPID, fast, base);
+	sb_run("UART_TX_FULL", Z_SYS_UART_TX_FULL, fast, base);
+	sb_run("UART_RX_EMPTY", Z_SYS_UART_RX_EMPTY, fast, base);
+	sb_run("MSG_READ/empty", Z_SYS_MSG_READ, fast, base);
+
+	return 0;
+
+}
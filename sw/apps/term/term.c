@@ -455,7 +455,9 @@ static void handle_key_event(uint32_t packed) {
 	if (len <= 0) return;
 
 	if (port.connected) {
-		z_port_send(&port, buf, (uint32_t)len);
+		// gathered until the end of this pass of main()'s loop, so a
+		// burst of keys (a paste, key repeat) goes as one DATA
+		z_port_write(&port, buf, (uint32_t)len);
 		return;
 	}
 
@@ -560,26 +562,22 @@ int main(void) {
 				handle_key_event(msg.obj.val.uint32);
 			} else if (msg.subject == Z_PORT_DATA) {
 				if (port.connected && msg.tag == port.conn_id) {
-					uint32_t len = z_blob_len(&msg.obj);
-					void *data = z_blob_data(&msg.obj);
-					if (data && len) vt_feed(&vt, (const uint8_t *)data, len);
+					const uint8_t *data;
+					uint32_t len;
+					while ((len = z_port_recv(&port, &msg, &data)) > 0)
+						vt_feed(&vt, data, len);
 				}
-				// tells whoever sent this it's now safe to free its own
-				// z_obj_blob() allocation -- see z_port_send_ack()'s own
-				// comment (zport.h) for why this has to come AFTER
-				// vt_feed() actually finishes reading `data`, not right
-				// after z_msg_read() produced `msg`. Sent unconditionally,
-				// even when the guard above didn't match -- that's still
-				// a message this process will never look at again, and
-				// the sender's own pending-sends slot for it
-				// (Z_PORT_MAX_PENDING_SENDS, zport.h) needs an ack to
-				// ever be freed regardless.
-				z_port_send_ack(&msg);
-			} else if (msg.subject == Z_PORT_DATA_ACK) {
-				z_port_handle_ack(&port, &msg);
+				// hands the kernel's copy of `data` back -- see
+				// z_port_data_done()'s own comment (zport.h) for why
+				// this has to come AFTER vt_feed() actually finishes
+				// reading `data`, not right after z_msg_read() produced
+				// `msg`. Done unconditionally, even when the guard above
+				// didn't match -- that's still a message this process
+				// will never look at again.
+				z_port_data_done(&msg);
 			} else if (msg.subject == Z_PORT_CLOSE) {
 				if (port.connected && msg.tag == port.conn_id) {
-					port.connected = false;
+					z_port_closed(&port);
 					printf("term: port closed by peer -- local echo only from here on\n");
 				}
 			} else if (msg.subject == Z_TERM_SET_PORT) {
@@ -617,6 +615,18 @@ int main(void) {
 			}
 		}
 
+		// the channel's ring, whether or not its doorbell made it
+		// here -- see z_port_recv() (zport.h)
+		if (port.connected) {
+			const uint8_t *data;
+			uint32_t len;
+			while ((len = z_port_recv(&port, NULL, &data)) > 0)
+				vt_feed(&vt, data, len);
+		}
+
+		// every keystroke handled above, in one go
+		if (port.connected) z_port_flush(&port);
+
 		if (got_redraw) {
 			// the framebuffer under/around this window may have
 			// changed entirely (a move, or another window that used
@@ -115,7 +115,7 @@ static int dock_idx = -1;
 // (Left/Right/Up/Down while the dock itself has focus -- see
 // dock_handle_key() below), or -1 before the dock has ever had
 // keyboard focus. Only actually drawn (as a selection ring, see
-// draw_dock()) while the dock IS focused -- see dispatch_keys()'s own
+// draw_dock()) while the dock IS focused -- see handle_key()'s own
 // `focused == dock_idx` check -- so this can stay set to wherever it
 // last was even after focus moves elsewhere, and picks up right where
 // it left off next time.
@@ -128,8 +128,9 @@ static int dock_selected = -1;
 // dock_launch()). Cleared either when the launched process (matched
 // by pid, dock_launching_pid[]) creates its first window (handle_
 // message()'s Z_WM_CREATE_WINDOW case) or after DOCK_LAUNCH_TIMEOUT_
-// ITERS main-loop iterations with no window (main()'s own loop) --
-// see that constant's own comment for why a timeout exists at all.
+// TICKS with no window (main()'s own loop) -- see that constant's own
+// comment for why a timeout exists at all. dock_launching_ticks[] is
+// when the launch started, in z_uptime_ticks().
 static bool dock_launching[DOCK_APP_COUNT];
 static uint32_t dock_launching_pid[DOCK_APP_COUNT];
 static uint32_t dock_launching_ticks[DOCK_APP_COUNT];
@@ -149,6 +150,8 @@ static uint32_t my_pid;
 static uint8_t zorder[WM_MAX_WINDOWS];	// back-to-front; zorder[count-1] is frontmost
 static uint8_t zorder_count = 0;
 static int focused = -1;		// index into windows[], or -1
+// last value published on Z_WM_TOPIC_FOCUS (zwm.h) -- see main()
+static uint32_t focus_published = Z_WM_FOCUS_NONE;
 static int dragging = -1;		// index into windows[], or -1
 static int drag_off_x = 0, drag_off_y = 0;
 // bounding box swept by the dragged window since the drag started --
@@ -159,7 +162,7 @@ static int drag_min_x, drag_min_y, drag_max_x, drag_max_y;
 static void send_win_rect(uint32_t to, uint32_t subject, uint32_t tag, int idx);
 static void handle_message(z_msg_t *msg);
 // forward-declared so the keyboard hotkey handlers (alt_tab()/
-// alt_move_focused(), defined ahead of dispatch_keys() further down --
+// alt_move_focused(), defined ahead of handle_key() further down --
 // see their own comments) can reuse the exact same focus/z-order/
 // screen-repair machinery the mouse path already uses, rather than
 // duplicating it -- these three are otherwise only defined later in
@@ -467,32 +470,144 @@ static void fill_rect(int x, int y, int w, int h, int color) {
 // and moving on. not a precise time unit -- see docs/window_manager.md.
 #define REDRAW_ACK_TIMEOUT   500
 
-// blocks until `pid` sends Z_WM_REDRAW_DONE, or the timeout above is
-// hit. keeps servicing every other message normally while waiting
-// (via handle_message()) rather than discarding them -- unlike
-// z_msg_wait(), which would drop any other app's requests that
-// arrived during the wait.
-static void wait_for_redraw_done(uint32_t pid) {
+// -- inbox --
+//
+// the mailbox is drained WM_INBOX_BATCH messages per syscall
+// (z_msg_read_n()) into inbox[], and everything that reads messages
+// -- main()'s loop and the redraw-ack waits below -- takes them from
+// here in order. Shared rather than one batch per reader because
+// handle_message() can nest (a request can trigger repair_region(),
+// whose ack wait handles further requests): a nested reader has to
+// carry on from the outer one's unhandled leftovers, or a later
+// request from some app could get handled before an earlier one.
+// While any handler is running on an inbox[] entry (inbox_busy), the
+// array can't be refilled underneath it -- resolved payloads point
+// into the entry itself -- so a reader that finds it empty then falls
+// back to plain one-at-a-time z_msg_read() into its own spare.
+
+#define WM_INBOX_BATCH	8
+
+static z_msg_t inbox[WM_INBOX_BATCH];
+static uint32_t inbox_len = 0;
+static uint32_t inbox_pos = 0;
+static int inbox_busy = 0;
+
+static z_msg_t *inbox_next(z_msg_t *spare) {
+	if (inbox_pos < inbox_len) return &inbox[inbox_pos++];
+	if (!inbox_busy) {
+		inbox_pos = 0;
+		inbox_len = z_msg_read_n(inbox, WM_INBOX_BATCH);
+		return inbox_len ? &inbox[inbox_pos++] : NULL;
+	}
+	return (z_msg_read(spare) == Z_OK) ? spare : NULL;
+}
+
+static void inbox_handle(z_msg_t *msg) {
+	inbox_busy++;
+	handle_message(msg);
+	inbox_busy--;
+}
+
+// blocks until every pid in `pids` (a bitmask) has sent
+// Z_WM_REDRAW_DONE, or the timeout above is hit. keeps servicing
+// every other message normally while waiting (via handle_message())
+// rather than discarding them -- unlike z_msg_wait(), which would
+// drop any other app's requests that arrived during the wait.
+static void wait_for_redraw_acks(uint32_t pids) {
 
 	for (int waited = 0; waited < REDRAW_ACK_TIMEOUT; waited++) {
 
-		z_msg_t msg;
-		bool got_ack = false;
+		z_msg_t spare, *msg;
 
-		while (z_msg_read(&msg) == Z_OK) {
-			if (msg.subject == Z_WM_REDRAW_DONE && msg.from == pid)
-				got_ack = true;
+		while ((msg = inbox_next(&spare)) != NULL) {
+			if (msg->subject == Z_WM_REDRAW_DONE && msg->from < 32 &&
+				(pids & (1u << msg->from)))
+				pids &= ~(1u << msg->from);
 			else
-				handle_message(&msg);
+				inbox_handle(msg);
 		}
 
-		if (got_ack) return;
+		if (!pids) return;
 
 		for (volatile int i = 0; i < 2000; i++);
 
 	}
 
-	printf("wm: timed out waiting for pid %ld to ack a redraw\n", (long)pid);
+	printf("wm: timed out waiting for redraw acks (pids 0x%lx)\n", (unsigned long)pids);
+
+}
+
+static void wait_for_redraw_done(uint32_t pid) {
+	if (pid < 32) wait_for_redraw_acks(1u << pid);
+}
+
+// -- redraw waves --
+//
+// repair_region() has to get overlapping windows' content redrawn
+// strictly back-to-front (see its own comment) -- but windows in the
+// region that DON'T overlap each other can all redraw at once. So
+// windows are collected, in z-order, into a "wave" of mutually
+// non-overlapping windows with distinct owners (acks are matched by
+// pid); the first window that overlaps something already in the
+// wave, or whose owner already has a window in it, flushes the wave
+// first: one z_msg_send_n() fan-out of Z_WM_REDRAW to the lot, then
+// one wait for all their acks. Overlapping windows still land in
+// separate waves, in order, so nothing can show through anything in
+// front of it -- a desktop of side-by-side windows just stops paying
+// one full ack round trip per window.
+
+#define WM_REDRAW_WAVE_MAX	8
+
+static int redraw_wave[WM_REDRAW_WAVE_MAX];
+static int redraw_wave_n = 0;
+
+// the focused window's outline sits 1px outside its own bounds
+// (draw_window_box()), so overlap here is checked on the grown rects
+static bool wave_conflicts(int idx) {
+	if (redraw_wave_n == WM_REDRAW_WAVE_MAX) return true;
+	wm_window_t *w = &windows[idx];
+	for (int i = 0; i < redraw_wave_n; i++) {
+		wm_window_t *o = &windows[redraw_wave[i]];
+		if (o->owner_pid == w->owner_pid) return true;
+		if (rects_overlap((int)w->x - 1, (int)w->y - 1, (int)w->w + 2, (int)w->h + 2,
+			(int)o->x - 1, (int)o->y - 1, (int)o->w + 2, (int)o->h + 2))
+			return true;
+	}
+	return false;
+}
+
+static void flush_redraw_wave(void) {
+
+	// static: by the time a nested repair_region() (from a request
+	// handled during the ack wait below) reaches here again, this
+	// wave's sends are long done with the array
+	static z_msg_t msgs[WM_REDRAW_WAVE_MAX];
+	int n = redraw_wave_n;
+	int idxs[WM_REDRAW_WAVE_MAX];
+
+	// taken out of redraw_wave[] first -- a nested repair_region()
+	// during the wait starts (and flushes) its own wave
+	for (int i = 0; i < n; i++) idxs[i] = redraw_wave[i];
+	redraw_wave_n = 0;
+	if (!n) return;
+
+	for (int i = 0; i < n; i++) {
+		int idx = idxs[i];
+		msgs[i].to = windows[idx].owner_pid;
+		msgs[i].subject = Z_WM_REDRAW;
+		msgs[i].tag = 0;
+		msgs[i].obj = z_obj_uint32(Z_WM_PACK_XY(idx, windows[idx].x, windows[idx].y));
+	}
+
+	uint32_t failed = 0;
+	z_msg_send_n(msgs, n, &failed);
+
+	// only wait on the ones that actually went out
+	uint32_t pids = 0;
+	for (int i = 0; i < n; i++)
+		if (!(failed & (1u << i)) && msgs[i].to < 32) pids |= 1u << msgs[i].to;
+
+	if (pids) wait_for_redraw_acks(pids);
 
 }
 
@@ -503,7 +618,7 @@ static void wait_for_redraw_done(uint32_t pid) {
 // + redraw-everyone approach, which meant any window changing (even a
 // click that only changed focus) made every other window on screen
 // flash, whether or not it was anywhere near the change. the
-// back-to-front ordering (via wait_for_redraw_done()) is what
+// back-to-front ordering (via the redraw waves above) is what
 // actually keeps a window's content from momentarily showing through
 // a window that's supposed to be in front of it -- without it, each
 // app redraws whenever its process happens to get scheduled, with no
@@ -516,7 +631,7 @@ static void wait_for_redraw_done(uint32_t pid) {
 // window's owner is still blocked waiting for Z_WM_WINDOW_CREATED at
 // this point, so it isn't listening for Z_WM_REDRAW yet and couldn't
 // possibly reply, which would otherwise stall every window creation
-// for the full wait_for_redraw_done() timeout.
+// for the full redraw-ack timeout.
 static void repair_region(int rx, int ry, int rw, int rh, int exclude_idx) {
 
 	// expand by 1px on every side before clearing/redrawing -- the
@@ -540,21 +655,29 @@ static void repair_region(int rx, int ry, int rw, int rh, int exclude_idx) {
 
 	fill_rect(rx, ry, rw, rh, 0);
 
+	// a nested call (see flush_redraw_wave()) must start its own wave
+	redraw_wave_n = 0;
+
 	for (int i = 0; i < zorder_count; i++) {
 		int idx = zorder[i];
 		wm_window_t *w = &windows[idx];
 		if (!rects_overlap(rx, ry, rw, rh,
 			(int)w->x, (int)w->y, (int)w->w, (int)w->h))
 			continue;
+		// anything behind this window that's still waiting to redraw
+		// has to finish first -- including before this window's own
+		// chrome goes on top of it
+		if (redraw_wave_n && wave_conflicts(idx)) flush_redraw_wave();
 		draw_window_box(w, idx == focused, 1);
 		draw_titlebar_content(w);
 		if (idx == dock_idx) draw_dock();
 		if (w->owner_pid == my_pid) continue;
 		if (idx == exclude_idx) continue;
-		send_redraw(w->owner_pid, idx);
-		wait_for_redraw_done(w->owner_pid);
+		redraw_wave[redraw_wave_n++] = idx;
 	}
 
+	flush_redraw_wave();
+
 }
 
 // -- mouse --
@@ -587,33 +710,39 @@ static inline int mouse_port(void) {
 	return 0;
 }
 
-static inline int get_cursor_x(void) {
-	uint32_t cursor = (mouse_port() == 0) ? reg_usb0_cursor : reg_usb1_cursor;
+// the mouse port's cursor register, polled -- only used when wm
+// couldn't subscribe to HID input (see main()); otherwise the same
+// value arrives in each Z_HID_MSG_MOUSE message instead.
+static inline uint32_t poll_cursor(void) {
+	return (mouse_port() == 0) ? reg_usb0_cursor : reg_usb1_cursor;
+}
+
+static inline int cursor_x(uint32_t cursor) {
 	return cursor & 0x3FF;
 }
 
-static inline int get_cursor_y(void) {
-	uint32_t cursor = (mouse_port() == 0) ? reg_usb0_cursor : reg_usb1_cursor;
+static inline int cursor_y(uint32_t cursor) {
 	return (cursor >> 10) & 0x3FF;
 }
 
-static inline uint8_t get_mouse_btn(void) {
-	uint32_t cursor = (mouse_port() == 0) ? reg_usb0_cursor : reg_usb1_cursor;
+static inline uint8_t cursor_btn(uint32_t cursor) {
 	return (cursor >> 20) & 0x0F;
 }
 
 // -- dock launching (shared by mouse click and keyboard Enter) --
 
-// how many main-loop iterations dock_launching[] is allowed to stay
+// how long (in ticks, ~732Hz) dock_launching[] is allowed to stay
 // set before wm gives up waiting and clears it anyway (see the
 // timeout check in main()'s own loop) -- a safety net for an app that
 // starts but never creates a window at all (crashes early, isn't a
 // GUI app, etc), so a single bad launch can't leave that icon
-// permanently stuck inverted and unrelaunchable. Not a precise time
-// unit -- same caveat REDRAW_ACK_TIMEOUT's own comment gives -- just
-// generously past how long even a slow-loading GUI app should ever
-// take to get as far as its first z_win_create() call.
-#define DOCK_LAUNCH_TIMEOUT_ITERS   5000
+// permanently stuck inverted and unrelaunchable. Generously past how
+// long even a slow-loading GUI app should ever take to get as far as
+// its first z_win_create() call. Used to be a count of main-loop
+// iterations (5000, roughly this long), which stopped meaning
+// anything once the loop started sleeping between input events --
+// see main().
+#define DOCK_LAUNCH_TIMEOUT_TICKS   (732 * 10)
 
 // launches dock_apps[slot], same as a mouse click on that icon (see
 // dock_click() below, which now just maps a click to a slot and calls
@@ -647,7 +776,7 @@ static void dock_launch(int slot) {
 	// whichever process the CPU happens to be running at the time.
 	dock_launching[slot] = true;
 	dock_launching_pid[slot] = 0;	// not known yet -- see below
-	dock_launching_ticks[slot] = 0;
+	dock_launching_ticks[slot] = z_uptime_ticks();
 
 	if (dock_idx >= 0)
 		repair_region(windows[dock_idx].x, windows[dock_idx].y,
@@ -682,14 +811,14 @@ static void dock_launch(int slot) {
 }
 
 // handles one keysym while the dock itself has keyboard focus (see
-// dispatch_keys()'s own `focused == dock_idx` check) -- Left/Up moves
+// handle_key()'s own `focused == dock_idx` check) -- Left/Up moves
 // the selection to the previous icon, Right/Down to the next (both
 // wrapping around), Enter launches the selected one via dock_launch()
 // above. Returns true if this keysym was one the dock actually
 // consumes (regardless of `pressed` -- a matching key-release is
 // swallowed too, same as a matching key-press, since there's nothing
 // useful to do with either once handled here); false for anything
-// else, which falls through to dispatch_keys()'s normal forward-or-
+// else, which falls through to handle_key()'s normal forward-or-
 // drop handling (in practice always dropped for the dock, since its
 // owner_pid is wm's own -- see that check -- but returning false
 // keeps this function honest about which keys it actually owns rather
@@ -731,7 +860,7 @@ static bool dock_handle_key(uint32_t keysym, bool pressed) {
 // -- global keyboard hotkeys (Alt+Tab, Alt+Arrow) --
 //
 // handled entirely here, by wm itself, and NEVER forwarded to any
-// app's own Z_WM_KEY stream -- see dispatch_keys()'s own comment on
+// app's own Z_WM_KEY stream -- see handle_key()'s own comment on
 // why these are intercepted before the normal forward-to-focused-
 // window path. This is what makes Zeitlos usable keyboard-only: every
 // OTHER piece of window management (focus, moving, launching apps) is
@@ -849,13 +978,16 @@ static void alt_move_focused(uint32_t keysym) {
 
 // -- keyboard --
 //
-// unlike the mouse above, keyboard capture is interrupt-driven, not
-// polled -- see sw/os/hid.c. hid_read_key() pops one already-decoded
-// press/release edge event at a time from the kernel's small event
-// ring, drawn from BOTH usb ports (hid.c decides per-port; this side
-// just gets a merged stream). wm drains all of them every main-loop
-// iteration (there can be more than one queued since the last time we
-// got scheduled).
+// keyboard capture is interrupt-driven, not polled -- see
+// sw/os/hid.c. Events are already-decoded press/release edges, drawn
+// from BOTH usb ports (hid.c decides per-port; this side just gets a
+// merged stream), and arrive one of two ways: as Z_HID_MSG_KEY
+// messages, once wm has subscribed to HID input (the normal case --
+// see main() and the input queue below), or, failing that, popped
+// one at a time with hid_read_key() from the kernel's small event
+// ring, which dispatch_keys() drains every main-loop iteration (there
+// can be more than one queued since the last time we got scheduled).
+// Either way each event ends up in handle_key().
 //
 // Global hotkeys (Alt+Tab, Alt+Arrow -- see alt_tab()/
 // alt_move_focused() above) and dock navigation (dock_handle_key()
@@ -865,47 +997,95 @@ static void alt_move_focused(uint32_t keysym) {
 // usage code to a keysym (zkbd.h) first. Demo windows (owned by wm
 // itself, see main() below) have no app to notify, same as
 // notify_moved()'s check below.
-static void dispatch_keys(void) {
+static void handle_key(int32_t ev) {
+
+	uint8_t usage     = (ev >> 1) & 0xFF;
+	uint8_t modifiers = (ev >> 9) & 0xFF;
+	bool    pressed   = (ev & 1) != 0;
+
+	uint32_t keysym = z_kbd_usage_to_keysym(usage, modifiers);
+	if (keysym == Z_KEY_NONE) return;   // bare modifier change, or
+	                                     // an unmapped usage code
+
+	// -- global hotkeys -- act on press only; the matching
+	// release is silently dropped (nothing to do with it, and it
+	// must not fall through to being forwarded as a Tab/arrow
+	// keystroke to whatever's focused).
+	if ((modifiers & Z_KBD_MOD_ALT) && keysym == '\t') {
+		if (pressed) alt_tab();
+		return;
+	}
+	if ((modifiers & Z_KBD_MOD_ALT) &&
+		(keysym == Z_KEY_LEFT || keysym == Z_KEY_RIGHT ||
+		 keysym == Z_KEY_UP   || keysym == Z_KEY_DOWN)) {
+		if (pressed) alt_move_focused(keysym);
+		return;
+	}
 
-	int32_t ev;
-	while ((ev = hid_read_key()) >= 0) {
-
-		uint8_t usage     = (ev >> 1) & 0xFF;
-		uint8_t modifiers = (ev >> 9) & 0xFF;
-		bool    pressed   = (ev & 1) != 0;
-
-		uint32_t keysym = z_kbd_usage_to_keysym(usage, modifiers);
-		if (keysym == Z_KEY_NONE) continue;   // bare modifier change, or
-		                                       // an unmapped usage code
-
-		// -- global hotkeys -- act on press only; the matching
-		// release is silently dropped (nothing to do with it, and it
-		// must not fall through to being forwarded as a Tab/arrow
-		// keystroke to whatever's focused).
-		if ((modifiers & Z_KBD_MOD_ALT) && keysym == '\t') {
-			if (pressed) alt_tab();
-			continue;
-		}
-		if ((modifiers & Z_KBD_MOD_ALT) &&
-			(keysym == Z_KEY_LEFT || keysym == Z_KEY_RIGHT ||
-			 keysym == Z_KEY_UP   || keysym == Z_KEY_DOWN)) {
-			if (pressed) alt_move_focused(keysym);
-			continue;
-		}
+	// -- the dock, while focused, owns plain arrows/Enter for its
+	// own icon navigation -- see dock_handle_key()'s own comment
+	// on exactly which keys it consumes and why.
+	if (focused == dock_idx && dock_handle_key(keysym, pressed)) return;
 
-		// -- the dock, while focused, owns plain arrows/Enter for its
-		// own icon navigation -- see dock_handle_key()'s own comment
-		// on exactly which keys it consumes and why.
-		if (focused == dock_idx && dock_handle_key(keysym, pressed)) continue;
+	if (focused < 0) return;
+	if (windows[focused].owner_pid == my_pid) return;
 
-		if (focused < 0) continue;
-		if (windows[focused].owner_pid == my_pid) continue;
+	uint32_t packed = Z_WM_PACK_KEY(keysym, modifiers, pressed);
+	z_msg_new_send(windows[focused].owner_pid, Z_WM_KEY, 0, z_obj_uint32(packed));
 
-		uint32_t packed = Z_WM_PACK_KEY(keysym, modifiers, pressed);
-		z_msg_new_send(windows[focused].owner_pid, Z_WM_KEY, 0, z_obj_uint32(packed));
+}
 
+static void dispatch_keys(void) {
+	int32_t ev;
+	while ((ev = hid_read_key()) >= 0)
+		handle_key(ev);
+}
+
+// -- input queue --
+//
+// with a HID subscription, key/mouse events arrive as ordinary
+// messages, and handle_message() can be reached from deep inside
+// something else -- wait_for_redraw_done(), called from
+// repair_region(), called from a click or a drag step. Acting on
+// input right there would mean handling a click in the middle of
+// handling another one, so handle_message() only queues it here and
+// main()'s loop works through the queue at the top level, in order.
+// Same merging rule as the kernel's (hid.c): a motion report with the
+// same buttons as the last one queued just replaces it.
+#define WM_INPUT_QUEUE   32
+#define WM_IDLE_TICKS    (732 / 4)	// longest main() ever sleeps, ~250ms
+
+static uint32_t input_subject[WM_INPUT_QUEUE];
+static uint32_t input_val[WM_INPUT_QUEUE];
+static uint32_t input_head = 0, input_count = 0;
+
+static void input_queue(uint32_t subject, uint32_t val) {
+
+	if (input_count > 0) {
+		uint32_t last = (input_head + input_count - 1) % WM_INPUT_QUEUE;
+		if (subject == Z_HID_MSG_MOUSE && input_subject[last] == Z_HID_MSG_MOUSE &&
+			((input_val[last] ^ val) & Z_HID_MOUSE_KEEP_MASK) == 0) {
+			input_val[last] = val;
+			return;
+		}
 	}
 
+	if (input_count == WM_INPUT_QUEUE) return;	// dropped, like hid.c's own ring
+
+	uint32_t slot = (input_head + input_count) % WM_INPUT_QUEUE;
+	input_subject[slot] = subject;
+	input_val[slot] = val;
+	input_count++;
+
+}
+
+static bool input_pop(uint32_t *subject, uint32_t *val) {
+	if (input_count == 0) return false;
+	*subject = input_subject[input_head];
+	*val = input_val[input_head];
+	input_head = (input_head + 1) % WM_INPUT_QUEUE;
+	input_count--;
+	return true;
 }
 
 // -- window table --
@@ -1107,7 +1287,7 @@ static void handle_close_click(int idx) {
 		// windows owned by wm itself (the dock, or the commented-out
 		// demo windows in main()) would never actually reach here in
 		// practice -- neither sets Z_WIN_FLAG_CLOSE_ICON -- but this
-		// guard exists for the same reason dispatch_keys()/
+		// guard exists for the same reason handle_key()/
 		// notify_moved() already have one: wm killing ITSELF here
 		// would be a self-inflicted, hard-to-debug way to go down.
 		if (owner != my_pid) z_proc_kill(owner);
@@ -1285,6 +1465,17 @@ static void handle_message(z_msg_t *msg) {
 
 			break;
 
+		// HID subscription input -- only ever from the kernel itself
+		// (pid 0); queued, not acted on here -- see the input queue's
+		// own comment for why.
+		case Z_HID_MSG_KEY:
+		case Z_HID_MSG_MOUSE:
+
+			if (msg->from == 0 && msg->obj.type == Z_UINT32)
+				input_queue(msg->subject, msg->obj.val.uint32);
+
+			break;
+
 		default:
 			break;
 
@@ -1357,6 +1548,149 @@ static void repair_drag(int dragged_idx) {
 
 }
 
+// -- mouse, one cursor sample at a time --
+//
+// `cursor` is the mouse port's reg_usbN_cursor value -- either from a
+// Z_HID_MSG_MOUSE message (one per report, see the input queue above)
+// or polled (poll_cursor()) when wm has no HID subscription. Clicks
+// and releases are edges against the previous sample's buttons.
+static uint8_t mouse_last_btn = 0;
+
+static void handle_mouse(int port, uint32_t cursor) {
+
+	int cx = cursor_x(cursor);
+	int cy = cursor_y(cursor);
+	uint8_t btn = cursor_btn(cursor);
+	bool btn_down = (btn & 1) != 0;
+	bool btn_was_down = (mouse_last_btn & 1) != 0;
+
+	if (btn_down && !btn_was_down) {
+
+		int hit = hit_test(cx, cy);
+
+		// temporary debug instrumentation -- see docs/window_manager.md
+		// "cursor calibration" note. remove once the coordinate mapping
+		// is confirmed against real hardware. raw is the cursor
+		// register value cx/cy were computed from.
+		printf("wm: click port=%d raw=0x%08lx cx=%d cy=%d", port,
+			(unsigned long)cursor, cx, cy);
+		if (hit >= 0) {
+			printf(" -> hit win %d (x=%ld y=%ld w=%ld h=%ld) titlebar=%d\n",
+				hit, (long)windows[hit].x, (long)windows[hit].y,
+				(long)windows[hit].w, (long)windows[hit].h,
+				hit_titlebar(hit, cy));
+		} else {
+			printf(" -> no hit\n");
+		}
+
+		if (dock_idx >= 0 && hit == dock_idx) {
+
+			// dock click: never changes focus, z-order, or
+			// starts a drag (hit_titlebar() would say no anyway,
+			// since no_titlebar is set -- see its own comment) --
+			// just figure out which icon slot, if any, was
+			// clicked, and launch that app. see dock_click() below.
+			dock_click(cx, cy);
+
+		} else if (hit >= 0 && hit_close_icon(hit, cx, cy)) {
+
+			// close icon click: checked BEFORE the general
+			// focus/drag handling below, so it never also starts
+			// a drag or reorders anything -- see
+			// handle_close_click()'s own comment for what happens
+			// next (which itself may destroy this window, so
+			// nothing below this branch may assume windows[hit]
+			// is still valid).
+			handle_close_click(hit);
+
+		} else if (hit >= 0) {
+
+			bool focus_changed = (focused != hit);
+			int old_focused = focused;
+			if (focus_changed) focused = hit;
+
+			bool reordered = bring_to_front(hit);
+
+			// keep the dock frontmost -- see its own comment
+			// where this same call appears in handle_message().
+			if (dock_idx >= 0) bring_to_front(dock_idx);
+
+			if (focus_changed && old_focused >= 0)
+				repair_region(windows[old_focused].x, windows[old_focused].y,
+					windows[old_focused].w, windows[old_focused].h, -1);
+
+			if (focus_changed || reordered)
+				repair_region(windows[hit].x, windows[hit].y,
+					windows[hit].w, windows[hit].h, -1);
+
+			if (hit_titlebar(hit, cy)) {
+				dragging = hit;
+				drag_off_x = cx - windows[hit].x;
+				drag_off_y = cy - windows[hit].y;
+				drag_min_x = windows[hit].x;
+				drag_min_y = windows[hit].y;
+				drag_max_x = windows[hit].x + windows[hit].w;
+				drag_max_y = windows[hit].y + windows[hit].h;
+			}
+
+		}
+
+	}
+
+	if (btn_down && dragging >= 0) {
+
+		int32_t nx = cx - drag_off_x;
+		int32_t ny = cy - drag_off_y;
+
+		if (nx < 0) nx = 0;
+		if (ny < 0) ny = 0;
+		if (nx + (int32_t)windows[dragging].w > WM_SCREEN_W)
+			nx = WM_SCREEN_W - windows[dragging].w;
+		if (ny + (int32_t)windows[dragging].h > WM_SCREEN_H)
+			ny = WM_SCREEN_H - windows[dragging].h;
+
+		if ((uint32_t)nx != windows[dragging].x ||
+			(uint32_t)ny != windows[dragging].y) {
+
+			// wireframe drag: move just this window's own border,
+			// cheaply, instead of a full-screen clear+redraw+
+			// content-notify on every step -- that was queuing up
+			// redraw messages faster than apps could drain them,
+			// which is what made content look like it was playing
+			// back in slow motion after the fact. content (this
+			// window's own, and anything underneath the border's
+			// old position) is left alone until the drag
+			// completes, at which point one repair_region() over
+			// everywhere the window passed through puts it all
+			// back correctly. see docs/window_manager.md.
+			draw_window_box(&windows[dragging], dragging == focused, 0);
+			windows[dragging].x = nx;
+			windows[dragging].y = ny;
+			draw_window_box(&windows[dragging], dragging == focused, 1);
+
+			if (nx < drag_min_x) drag_min_x = nx;
+			if (ny < drag_min_y) drag_min_y = ny;
+			if (nx + (int32_t)windows[dragging].w > drag_max_x)
+				drag_max_x = nx + (int32_t)windows[dragging].w;
+			if (ny + (int32_t)windows[dragging].h > drag_max_y)
+				drag_max_y = ny + (int32_t)windows[dragging].h;
+
+		}
+
+	}
+
+	if (!btn_down && btn_was_down && dragging >= 0) {
+		printf("wm: drag release win %d final x=%ld y=%ld\n",
+			dragging, (long)windows[dragging].x, (long)windows[dragging].y);
+		notify_moved(dragging);
+		repair_drag(dragging);
+		dragging = -1;
+	}
+
+	mouse_last_btn = btn;
+
+}
+
 // -- main loop --
 
 int main(void) {
@@ -1448,7 +1782,14 @@ int main(void) {
 		repair_region(windows[dock_idx].x, windows[dock_idx].y,
 			windows[dock_idx].w, windows[dock_idx].h, -1);
 
-	uint8_t last_btn = 0;
+	// input straight from the HID interrupt, as messages -- see the
+	// input queue above. With it, the loop below sleeps in
+	// z_msg_block() whenever there's nothing to do instead of spinning
+	// on the cursor registers, and a click or keystroke wakes it the
+	// moment it happens. Without it (another process got there first,
+	// or an older kernel), the old polling.
+	bool hid_subscribed = (z_hid_subscribe(true) == Z_OK);
+	printf("wm: input: %s\n", hid_subscribed ? "HID subscription" : "polling");
 
 	// diagnostic: prints whenever either USB HID port's device type
 	// changes (rtl/ext/usb_hid_host/src/usb_hid_host.v's `typ`
@@ -1475,16 +1816,30 @@ int main(void) {
 			last_hid_typ1 = hid_typ1;
 		}
 
-		// -- drain incoming requests (non-blocking) --
-		z_msg_t msg;
-		while (z_msg_read(&msg) == Z_OK)
-			handle_message(&msg);
+		// -- drain incoming requests (non-blocking), a batch per
+		// syscall -- see the inbox above --
+		z_msg_t spare, *msg;
+		while ((msg = inbox_next(&spare)) != NULL)
+			inbox_handle(msg);
+
+		// -- focus topic (zwm.h's Z_WM_TOPIC_FOCUS) -- checked once per
+		// pass rather than at every place `focused` is assigned
+		// (clicks, alt_tab(), create/destroy), so none of them can be
+		// missed, and a burst of changes within one pass only
+		// publishes where focus actually ended up.
+		uint32_t focus_now = (focused >= 0 && windows[focused].used) ?
+			Z_WM_PACK_FOCUS(focused, windows[focused].owner_pid) :
+			Z_WM_FOCUS_NONE;
+		if (focus_now != focus_published) {
+			z_msg_publish(Z_WM_TOPIC_FOCUS, 0, z_obj_uint32(focus_now));
+			focus_published = focus_now;
+		}
 
-		// -- dock launch timeout -- see DOCK_LAUNCH_TIMEOUT_ITERS'
-		// own comment below for why this exists at all.
+		// -- dock launch timeout -- see DOCK_LAUNCH_TIMEOUT_TICKS'
+		// own comment above for why this exists at all.
 		for (int di = 0; di < DOCK_APP_COUNT; di++) {
 			if (!dock_launching[di]) continue;
-			if (++dock_launching_ticks[di] < DOCK_LAUNCH_TIMEOUT_ITERS) continue;
+			if (z_uptime_ticks() - dock_launching_ticks[di] < DOCK_LAUNCH_TIMEOUT_TICKS) continue;
 			printf("wm: dock: gave up waiting for '%s' (pid %ld) to create a window\n",
 				dock_apps[di].name, (long)dock_launching_pid[di]);
 			dock_launching[di] = false;
@@ -1493,145 +1848,29 @@ int main(void) {
 					windows[dock_idx].w, windows[dock_idx].h, -1);
 		}
 
-		// -- keyboard (interrupt-captured, drained here) --
-		dispatch_keys();
-
-		// -- mouse --
-		int cx = get_cursor_x();
-		int cy = get_cursor_y();
-		uint8_t btn = get_mouse_btn();
-		bool btn_down = (btn & 1) != 0;
-		bool btn_was_down = (last_btn & 1) != 0;
-
-		if (btn_down && !btn_was_down) {
-
-			int hit = hit_test(cx, cy);
-
-			// temporary debug instrumentation -- see docs/window_manager.md
-			// "cursor calibration" note. remove once the coordinate mapping
-			// is confirmed against real hardware. raw comes from
-			// whichever port mouse_port() decided is the mouse, same as
-			// the cx/cy computed from it.
-			int mp = mouse_port();
-			printf("wm: click port=%d raw=0x%08lx cx=%d cy=%d", mp,
-				(unsigned long)(mp == 0 ? reg_usb0_cursor : reg_usb1_cursor), cx, cy);
-			if (hit >= 0) {
-				printf(" -> hit win %d (x=%ld y=%ld w=%ld h=%ld) titlebar=%d\n",
-					hit, (long)windows[hit].x, (long)windows[hit].y,
-					(long)windows[hit].w, (long)windows[hit].h,
-					hit_titlebar(hit, cy));
-			} else {
-				printf(" -> no hit\n");
-			}
-
-			if (dock_idx >= 0 && hit == dock_idx) {
-
-				// dock click: never changes focus, z-order, or
-				// starts a drag (hit_titlebar() would say no anyway,
-				// since no_titlebar is set -- see its own comment) --
-				// just figure out which icon slot, if any, was
-				// clicked, and launch that app. see dock_click() below.
-				dock_click(cx, cy);
-
-			} else if (hit >= 0 && hit_close_icon(hit, cx, cy)) {
-
-				// close icon click: checked BEFORE the general
-				// focus/drag handling below, so it never also starts
-				// a drag or reorders anything -- see
-				// handle_close_click()'s own comment for what happens
-				// next (which itself may destroy this window, so
-				// nothing below this branch may assume windows[hit]
-				// is still valid).
-				handle_close_click(hit);
-
-			} else if (hit >= 0) {
-
-				bool focus_changed = (focused != hit);
-				int old_focused = focused;
-				if (focus_changed) focused = hit;
-
-				bool reordered = bring_to_front(hit);
-
-				// keep the dock frontmost -- see its own comment
-				// where this same call appears in handle_message().
-				if (dock_idx >= 0) bring_to_front(dock_idx);
-
-				if (focus_changed && old_focused >= 0)
-					repair_region(windows[old_focused].x, windows[old_focused].y,
-						windows[old_focused].w, windows[old_focused].h, -1);
-
-				if (focus_changed || reordered)
-					repair_region(windows[hit].x, windows[hit].y,
-						windows[hit].w, windows[hit].h, -1);
-
-				if (hit_titlebar(hit, cy)) {
-					dragging = hit;
-					drag_off_x = cx - windows[hit].x;
-					drag_off_y = cy - windows[hit].y;
-					drag_min_x = windows[hit].x;
-					drag_min_y = windows[hit].y;
-					drag_max_x = windows[hit].x + windows[hit].w;
-					drag_max_y = windows[hit].y + windows[hit].h;
-				}
-
+		// -- keyboard and mouse --
+		if (hid_subscribed) {
+			uint32_t subject, val;
+			while (input_pop(&subject, &val)) {
+				if (subject == Z_HID_MSG_KEY) handle_key((int32_t)val);
+				else handle_mouse((val >> 24) & 1, val);
 			}
-
-		}
-
-		if (btn_down && dragging >= 0) {
-
-			int32_t nx = cx - drag_off_x;
-			int32_t ny = cy - drag_off_y;
-
-			if (nx < 0) nx = 0;
-			if (ny < 0) ny = 0;
-			if (nx + (int32_t)windows[dragging].w > WM_SCREEN_W)
-				nx = WM_SCREEN_W - windows[dragging].w;
-			if (ny + (int32_t)windows[dragging].h > WM_SCREEN_H)
-				ny = WM_SCREEN_H - windows[dragging].h;
-
-			if ((uint32_t)nx != windows[dragging].x ||
-				(uint32_t)ny != windows[dragging].y) {
-
-				// wireframe drag: move just this window's own border,
-				// cheaply, instead of a full-screen clear+redraw+
-				// content-notify on every step -- that was queuing up
-				// redraw messages faster than apps could drain them,
-				// which is what made content look like it was playing
-				// back in slow motion after the fact. content (this
-				// window's own, and anything underneath the border's
-				// old position) is left alone until the drag
-				// completes, at which point one repair_region() over
-				// everywhere the window passed through puts it all
-				// back correctly. see docs/window_manager.md.
-				draw_window_box(&windows[dragging], dragging == focused, 0);
-				windows[dragging].x = nx;
-				windows[dragging].y = ny;
-				draw_window_box(&windows[dragging], dragging == focused, 1);
-
-				if (nx < drag_min_x) drag_min_x = nx;
-				if (ny < drag_min_y) drag_min_y = ny;
-				if (nx + (int32_t)windows[dragging].w > drag_max_x)
-					drag_max_x = nx + (int32_t)windows[dragging].w;
-				if (ny + (int32_t)windows[dragging].h > drag_max_y)
-					drag_max_y = ny + (int32_t)windows[dragging].h;
-
-			}
-
+		} else {
+			dispatch_keys();
+			handle_mouse(mouse_port(), poll_cursor());
 		}
 
-		if (!btn_down && btn_was_down && dragging >= 0) {
-			printf("wm: drag release win %d final x=%ld y=%ld\n",
-				dragging, (long)windows[dragging].x, (long)windows[dragging].y);
-			notify_moved(dragging);
-			repair_drag(dragging);
-			dragging = -1;
+		// -- idle -- WM_IDLE_TICKS caps the sleep so the device-type
+		// diagnostics and dock launch timeout above still get looked
+		// at now and then with no input at all. input_count can be
+		// nonzero here if something above waited on a redraw ack and
+		// queued more input meanwhile -- go straight round again then.
+		if (hid_subscribed) {
+			if (input_count == 0) z_msg_block(WM_IDLE_TICKS);
+		} else {
+			for (volatile int i = 0; i < 2000; i++); // light throttle
 		}
 
-		last_btn = btn;
-
-		for (volatile int i = 0; i < 2000; i++); // light throttle
-
 	}
 
 }
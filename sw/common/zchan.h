@@ -0,0 +1,160 @@
+#ifndef ZCHAN_H
+#define ZCHAN_H
+
+/*
+ * Zeitlos
+ * Copyright (c) 2025 Lone Dynamics Corporation. All rights reserved.
+ *
+ * Channels -- a pair of single-producer/single-consumer byte rings in
+ * memory both ends can reach, for a stream of bytes between exactly
+ * two processes (zport.h's connections are the first user). Moving
+ * bytes is then a memcpy and a store to an index, with no syscall and
+ * no per-chunk message: the kernel is only involved when a side has
+ * to sleep or be woken.
+ *
+ * Every process's memory is already reachable by everyone (zmsg.h's
+ * header comment), so the rings could live in either process's heap --
+ * but then the owner exiting would leave its peer writing into memory
+ * that's since been handed to somebody else. So the KERNEL allocates
+ * the block (k_chan() in sw/os/msg.c), hands its physical address to
+ * the process that opened it, and only frees it once both ends have
+ * closed it or exited.
+ *
+ * Each ring has exactly one writer and one reader. `head` only ever
+ * moves on the writer's side and `tail` only on the reader's, both
+ * free-running (they wrap at 2^32, not at the ring size -- head - tail
+ * is always the number of bytes waiting), so neither side ever writes
+ * a word the other writes and no lock is needed. PicoRV32 has no
+ * caches and doesn't reorder stores, so "copy the bytes, then move
+ * head" is all the ordering there is to get right.
+ *
+ * Waking the other side:
+ *
+ *  - reader: the writer sends it an ordinary (empty) message, but only
+ *    when `notified` was clear -- once per burst, not once per write.
+ *    The reader clears `notified` when it finds the ring empty, then
+ *    looks ONCE more, so bytes that landed in between aren't stranded.
+ *    A wakeup that finds nothing waiting is harmless.
+ *
+ *  - writer: a full ring parks it in the kernel (Z_CHAN_WAIT) until
+ *    there's room; the reader sees `writer_waiting` after moving tail
+ *    and asks the kernel to wake it (Z_CHAN_WAKE). The kernel checks
+ *    for room itself before sleeping, so a tail moved in between is
+ *    never missed.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#define Z_CHAN_MAGIC		0x4E414843	// "CHAN"
+#define Z_CHAN_RING_SIZE	8192		// bytes per direction, power of two
+#define Z_CHAN_MAX		8		// open channels, system-wide
+
+typedef struct {
+
+	uint32_t		magic;
+	uint32_t		size;		// Z_CHAN_RING_SIZE
+	volatile uint32_t	head;		// bytes ever written -- writer only
+	volatile uint32_t	tail;		// bytes ever read -- reader only
+	volatile uint32_t	notified;	// a wakeup is on its way to the reader
+	volatile uint32_t	writer_waiting;	// writer is (about to be) parked on a full ring
+	volatile uint32_t	closed;		// either end has closed the channel
+	uint32_t		_reserved;
+	uint8_t			data[Z_CHAN_RING_SIZE];
+
+} z_chan_t;
+
+// what Z_CHAN_OPEN hands out: ring[0] carries bytes from whoever
+// opened the channel to its peer, ring[1] the other way
+typedef struct {
+
+	z_chan_t	ring[2];
+
+} z_chan_pair_t;
+
+#define Z_CHAN_OPEN	1	// peer: who the other end is; OUT: pair
+#define Z_CHAN_WAIT	2	// pair, need, timeout: sleep until our ring has room
+#define Z_CHAN_WAKE	3	// pair: wake the other end
+#define Z_CHAN_CLOSE	4	// pair: drop our end
+
+// Z_SYS_CHAN's argument -- see z_chan_open() and friends in zeitlos.h
+typedef struct {
+
+	uint32_t	op;		// Z_CHAN_*
+	uint32_t	peer;		// OPEN
+	z_chan_pair_t	*pair;		// OPEN: OUT; everything else: IN
+	uint32_t	need;		// WAIT: free bytes wanted
+	uint32_t	timeout;	// WAIT: ticks, 0 = wait forever
+
+} z_chan_args_t;
+
+// the ring this end writes into / reads from. `opener` is true on the
+// side that called z_chan_open().
+static inline z_chan_t *z_chan_tx(z_chan_pair_t *pair, bool opener) {
+	return &pair->ring[opener ? 0 : 1];
+}
+
+static inline z_chan_t *z_chan_rx(z_chan_pair_t *pair, bool opener) {
+	return &pair->ring[opener ? 1 : 0];
+}
+
+static inline uint32_t z_chan_used(const z_chan_t *ch) {
+	return ch->head - ch->tail;
+}
+
+static inline uint32_t z_chan_room(const z_chan_t *ch) {
+	return ch->size - (ch->head - ch->tail);
+}
+
+// writer side: copies as much of data[0..len-1] as fits and returns
+// how much that was -- possibly 0, on a full ring
+static inline uint32_t z_chan_write(z_chan_t *ch, const void *data, uint32_t len) {
+
+	uint32_t room = z_chan_room(ch);
+	if (len > room) len = room;
+	if (!len) return 0;
+
+	uint32_t head = ch->head;
+	uint32_t off = head & (ch->size - 1);
+	uint32_t first = ch->size - off;
+	if (first > len) first = len;
+
+	memcpy(&ch->data[off], data, first);
+	if (len > first) memcpy(ch->data, (const uint8_t *)data + first, len - first);
+
+	ch->head = head + len;	// only after the bytes are in place
+	return len;
+
+}
+
+// reader side: points *data at the longest run of waiting bytes that
+// doesn't wrap and returns its length (0 if the ring is empty). The
+// bytes stay put -- and stay valid -- until z_chan_consume().
+static inline uint32_t z_chan_peek(const z_chan_t *ch, const uint8_t **data) {
+
+	uint32_t used = z_chan_used(ch);
+	if (!used) return 0;
+
+	uint32_t off = ch->tail & (ch->size - 1);
+	uint32_t span = ch->size - off;
+	if (span > used) span = used;
+
+	*data = &ch->data[off];
+	return span;
+
+}
+
+// reader side: hands n peeked bytes back to the writer. Returns true
+// if the writer was waiting for room -- the caller then owes it a
+// z_chan_wake().
+static inline bool z_chan_consume(z_chan_t *ch, uint32_t n) {
+
+	ch->tail += n;
+	if (!ch->writer_waiting) return false;
+	ch->writer_waiting = 0;
+	return true;
+
+}
+
+#endif
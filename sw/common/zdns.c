@@ -17,11 +17,9 @@
 // comment ("Why this builds into both an app and the kernel
 // unmodified"), same reasoning zstream.c already documents for
 // itself. Both the app runtime (zeitlos.c) and the kernel's own
-// msg.c/pidreg.c provide matching signatures for all five of these.
-z_rv z_msg_send(z_msg_t *msg);
-z_rv z_msg_read(z_msg_t *msg);
-z_rv z_msg_new_send(uint32_t to, uint32_t subject, uint32_t tag, z_obj_t obj);
-uint32_t z_uptime_ticks(void);
+// msg.c/pidreg.c provide matching signatures for all three of these.
+z_rv z_msg_call(z_msg_t *msg, uint32_t timeout_ticks);
+z_rv z_msg_release(z_msg_t *msg);
 bool z_pid_lookup(const char *name, uint32_t *pid);
 
 // ~5s -- generous relative to dns.c's own retry budget
@@ -103,21 +101,23 @@ bool z_dns_resolve(const char *hostname, uint32_t *out_ip,
 	uint32_t net_pid = resolve_net_pid();
 	uint32_t tag = next_dns_tag();
 
-	z_msg_new_send(net_pid, Z_NET_DNS_RESOLVE, tag, z_obj_str(hostname));
-
-	uint32_t start = z_uptime_ticks();
-
-	while ((z_uptime_ticks() - start) < ZDNS_TIMEOUT_TICKS) {
-
-		z_msg_t msg;
-		if (z_msg_read(&msg) != Z_OK) continue;
-
-		if (msg.subject != Z_NET_DNS_RESOLVE_REPLY || msg.tag != tag)
-			continue;	// not a reply to THIS request -- discard and
-						// keep waiting, same as zport.c's own
-						// connect-timeout loop does for anything that
-						// isn't the reply it's waiting for
-
+	// z_msg_call() (zeitlos.h / the kernel's own msg.c): sleeps
+	// until net's reply with this tag arrives, leaving anything else
+	// that turns up meanwhile queued for the caller's own main loop
+	// instead of discarding it the way the old read-and-skip loop
+	// here did. `hostname` is borrowed by net until it replies -- as
+	// is, not a z_obj_str() copy, which nothing would ever free.
+	z_msg_t msg;
+	msg.to = net_pid;
+	msg.subject = Z_NET_DNS_RESOLVE;
+	msg.tag = tag;
+	msg.obj.type = Z_STR;
+	msg.obj.val.str = (char *)hostname;
+
+	if (z_msg_call(&msg, ZDNS_TIMEOUT_TICKS) == Z_OK &&
+		msg.subject == Z_NET_DNS_RESOLVE_REPLY) {
+
+		bool ok = false;
 		z_obj_t *ok_obj = z_map_find(&msg.obj, "ok");
 
 		if (!ok_obj || ok_obj->type != Z_UINT32 || !ok_obj->val.uint32) {
@@ -126,17 +126,18 @@ bool z_dns_resolve(const char *hostname, uint32_t *out_ip,
 				set_err(err, err_len, err_obj->val.str);
 			else
 				set_err(err, err_len, "dns: resolve failed");
-			return false;
-		}
-
-		z_obj_t *ip_obj = z_map_find(&msg.obj, "ip");
-		if (!ip_obj || ip_obj->type != Z_UINT32) {
-			set_err(err, err_len, "dns: malformed reply from net");
-			return false;
+		} else {
+			z_obj_t *ip_obj = z_map_find(&msg.obj, "ip");
+			if (!ip_obj || ip_obj->type != Z_UINT32) {
+				set_err(err, err_len, "dns: malformed reply from net");
+			} else {
+				*out_ip = ip_obj->val.uint32;
+				ok = true;
+			}
 		}
 
-		*out_ip = ip_obj->val.uint32;
-		return true;
+		z_msg_release(&msg);
+		return ok;
 
 	}
 
@@ -56,7 +56,9 @@ bool z_parse_ipv4(const char *s, uint32_t *out);
 // with its own bounded timeout (ZDNS_TIMEOUT_TICKS, zdns.c) -- same
 // "there's nothing else useful to do meanwhile, so just wait"
 // reasoning z_port_connect_arg_timeout() (zport.c) and zstream.c's
-// own open/pull calls already use elsewhere in this codebase. A
+// own open/pull calls already use elsewhere in this codebase. The
+// wait is a z_msg_call() (zeitlos.h), so messages for the caller
+// that arrive meanwhile stay queued rather than being dropped. A
 // caller on a message loop that ALSO needs to keep servicing other
 // concurrent work while this blocks (repl.c's telnet command is a
 // real example -- see its own comment at the call site) should know
@@ -32,7 +32,32 @@ int16_t uart_getc(void);
 
 void print_hex32(uint32_t val);
 
+// -- fast syscalls -- see fastcalls.def and docs/app_runtime.md --
+//
+// 0 = not asked yet, 1 = asked, kernel has none (older kernel.bin,
+// or the simulator -- sim/machine.c leaves obj untouched for ids it
+// doesn't implement), anything else = z_kernel_fast_entry()'s
+// address. asked lazily, on the first wrapper call that wants it,
+// rather than from a startup hook this runtime doesn't have.
+static uint32_t z_fast_ptr = 0;
+
+z_kernel_fast_ptr_t z_fast_entry(void) {
+	if (z_fast_ptr == 0) {
+		z_kernel_ptr_t z_kernel_ptr = (z_kernel_ptr_t)(uintptr_t)(reg_kernel);
+		z_obj_t obj;
+		obj.type = Z_UINT32;
+		obj.val.uint32 = 0;
+		// result read from obj only, never from the returned pointer --
+		// the simulator returns NULL
+		z_kernel_ptr(Z_SYS_FAST_ENTRY, (uint32_t *)&obj, 0);
+		z_fast_ptr = (obj.type == Z_UINT32 && obj.val.uint32) ? obj.val.uint32 : 1;
+	}
+	return (z_fast_ptr == 1) ? NULL : (z_kernel_fast_ptr_t)(uintptr_t)z_fast_ptr;
+}
+
 bool uart_rx_empty(void) {
+	z_kernel_fast_ptr_t z_fast = z_fast_entry();
+	if (z_fast) return (bool)z_fast(Z_SYS_UART_RX_EMPTY, 0, 0, 0);
 	z_kernel_ptr_t z_kernel_ptr = (z_kernel_ptr_t)(uintptr_t)(reg_kernel);
 	z_obj_t obj;
 	z_kernel_ptr(Z_SYS_UART_RX_EMPTY, (uint32_t *)&obj, 0);
@@ -40,6 +65,8 @@ bool uart_rx_empty(void) {
 }
 
 bool uart_tx_full(void) {
+	z_kernel_fast_ptr_t z_fast = z_fast_entry();
+	if (z_fast) return (bool)z_fast(Z_SYS_UART_TX_FULL, 0, 0, 0);
 	z_kernel_ptr_t z_kernel_ptr = (z_kernel_ptr_t)(uintptr_t)(reg_kernel);
 	z_obj_t obj;
 	z_kernel_ptr(Z_SYS_UART_TX_FULL, (uint32_t *)&obj, 0);
@@ -47,13 +74,42 @@ bool uart_tx_full(void) {
 }
 
 void uart_putc(char c) {
+	z_kernel_fast_ptr_t z_fast = z_fast_entry();
+	if (z_fast) { z_fast(Z_SYS_UART_PUTC, (uint8_t)c, 0, 0); return; }
 	z_kernel_ptr_t z_kernel_ptr = (z_kernel_ptr_t)(uintptr_t)(reg_kernel);
 	z_obj_t obj;
 	obj.val.int32 = c;
 	z_kernel_ptr(Z_SYS_UART_PUTC, (uint32_t *)&obj, 0);
 }
 
+uint32_t uart_write(const void *buf, uint32_t len) {
+	if (!len) return 0;
+	z_kernel_fast_ptr_t z_fast = z_fast_entry();
+	if (z_fast) {
+		uint32_t written = z_fast(Z_SYS_UART_WRITE, (uint32_t)(uintptr_t)buf, len, 0);
+		if (written != Z_FAST_NOSYS) return written;
+	} else {
+		z_kernel_ptr_t z_kernel_ptr = (z_kernel_ptr_t)(uintptr_t)(reg_kernel);
+		z_uart_write_args_t a;
+		a.buf = buf;
+		a.len = len;
+		a.written = 0;
+		z_kernel_ptr(Z_SYS_UART_WRITE, (uint32_t *)&a, 0);
+		if (a.written) return a.written;
+	}
+	// older kernel with no Z_SYS_UART_WRITE (on either entry) -- the
+	// old way, per byte
+	const uint8_t *p = buf;
+	for (uint32_t i = 0; i < len; i++) {
+		while (uart_tx_full()) /* wait */;
+		uart_putc(p[i]);
+	}
+	return len;
+}
+
 int16_t uart_getc(void) {
+	z_kernel_fast_ptr_t z_fast = z_fast_entry();
+	if (z_fast) return (int16_t)z_fast(Z_SYS_UART_GETC, 0, 0, 0);
 	z_kernel_ptr_t z_kernel_ptr = (z_kernel_ptr_t)(uintptr_t)(reg_kernel);
 	z_obj_t obj;
 	z_kernel_ptr(Z_SYS_UART_GETC, (uint32_t *)&obj, 0);
@@ -67,12 +123,23 @@ int16_t uart_getc(void) {
 // bits16:9 = modifier byte -- see sw/os/hid.c's HID_EVENT() macro
 // and sw/common/zkbd.h for turning the usage code into a keysym.
 int32_t hid_read_key(void) {
+	z_kernel_fast_ptr_t z_fast = z_fast_entry();
+	if (z_fast) return (int32_t)z_fast(Z_SYS_HID_READ_KEY, 0, 0, 0);
 	z_kernel_ptr_t z_kernel_ptr = (z_kernel_ptr_t)(uintptr_t)(reg_kernel);
 	z_obj_t obj;
 	z_kernel_ptr(Z_SYS_HID_READ_KEY, (uint32_t *)&obj, 0);
 	return obj.val.int32;
 }
 
+z_rv z_hid_subscribe(bool on) {
+	z_kernel_ptr_t z_kernel_ptr = (z_kernel_ptr_t)(uintptr_t)(reg_kernel);
+	z_obj_t obj;
+	obj.type = Z_UINT32;
+	obj.val.uint32 = on ? 1 : 0;
+	z_obj_t *rv = (z_obj_t *)z_kernel_ptr(Z_SYS_HID_SUBSCRIBE, (uint32_t *)&obj, 0);
+	return rv->val.uint32;
+}
+
 // -- messaging --
 
 z_rv z_msg_send(z_msg_t *msg) {
@@ -81,7 +148,145 @@ z_rv z_msg_send(z_msg_t *msg) {
 	return rv->val.uint32;
 }
 
+z_rv z_msg_send_copy(z_msg_t *msg) {
+	z_kernel_ptr_t z_kernel_ptr = (z_kernel_ptr_t)(uintptr_t)(reg_kernel);
+	z_obj_t *rv = (z_obj_t *)z_kernel_ptr(Z_SYS_MSG_SEND_COPY, (uint32_t *)msg, 0);
+	return rv->val.uint32;
+}
+
+// skips the syscall entirely for the (common) borrowed case
+z_rv z_msg_release(z_msg_t *msg) {
+	if (!msg->_kbuf) return Z_OK;
+	z_kernel_ptr_t z_kernel_ptr = (z_kernel_ptr_t)(uintptr_t)(reg_kernel);
+	z_obj_t *rv = (z_obj_t *)z_kernel_ptr(Z_SYS_MSG_RELEASE, (uint32_t *)msg, 0);
+	return rv->val.uint32;
+}
+
+z_rv z_msg_call(z_msg_t *msg, uint32_t timeout_ticks) {
+	z_kernel_ptr_t z_kernel_ptr = (z_kernel_ptr_t)(uintptr_t)(reg_kernel);
+	z_msg_call_args_t args;
+	args.msg = msg;
+	args.timeout = timeout_ticks;
+	z_obj_t *rv = (z_obj_t *)z_kernel_ptr(Z_SYS_MSG_CALL, (uint32_t *)&args, 0);
+	return rv->val.uint32;
+}
+
+static z_rv msg_topic_op(uint32_t op, uint32_t topic, uint32_t depth, uint32_t *dropped) {
+	z_kernel_ptr_t z_kernel_ptr = (z_kernel_ptr_t)(uintptr_t)(reg_kernel);
+	z_msg_topic_args_t args;
+	args.op = op;
+	args.topic = topic;
+	args.depth = depth;
+	args.dropped = 0;
+	z_obj_t *rv = (z_obj_t *)z_kernel_ptr(Z_SYS_MSG_SUBSCRIBE, (uint32_t *)&args, 0);
+	if (dropped) *dropped = args.dropped;
+	return rv->val.uint32;
+}
+
+z_rv z_msg_subscribe(uint32_t topic, uint32_t depth) {
+	return msg_topic_op(Z_MSG_TOPIC_SUBSCRIBE, topic, depth, NULL);
+}
+
+z_rv z_msg_unsubscribe(uint32_t topic) {
+	return msg_topic_op(Z_MSG_TOPIC_UNSUBSCRIBE, topic, 0, NULL);
+}
+
+uint32_t z_msg_topic_dropped(uint32_t topic) {
+	uint32_t dropped = 0;
+	msg_topic_op(Z_MSG_TOPIC_STATUS, topic, 0, &dropped);
+	return dropped;
+}
+
+z_rv z_msg_publish(uint32_t topic, uint32_t tag, z_obj_t obj) {
+	z_kernel_ptr_t z_kernel_ptr = (z_kernel_ptr_t)(uintptr_t)(reg_kernel);
+	z_msg_t msg;
+	msg.to = 0;
+	msg.subject = topic;
+	msg.tag = tag;
+	msg.obj = obj;
+	z_msg_publish_args_t args;
+	args.msg = &msg;
+	z_obj_t *rv = (z_obj_t *)z_kernel_ptr(Z_SYS_MSG_PUBLISH, (uint32_t *)&args, 0);
+	return rv->val.uint32;
+}
+
+uint32_t z_msg_read_n(z_msg_t *msgs, uint32_t max) {
+	z_kernel_ptr_t z_kernel_ptr = (z_kernel_ptr_t)(uintptr_t)(reg_kernel);
+	z_msg_batch_args_t args;
+	args.msgs = msgs;
+	args.n = max;
+	args.count = 0;
+	z_kernel_ptr(Z_SYS_MSG_READ_N, (uint32_t *)&args, 0);
+	return args.count;
+}
+
+uint32_t z_msg_send_n(z_msg_t *msgs, uint32_t n, uint32_t *failed) {
+	z_kernel_ptr_t z_kernel_ptr = (z_kernel_ptr_t)(uintptr_t)(reg_kernel);
+	z_msg_batch_args_t args;
+	args.msgs = msgs;
+	args.n = n;
+	args.count = 0;
+	args.failed = 0;
+	z_kernel_ptr(Z_SYS_MSG_SEND_N, (uint32_t *)&args, 0);
+	if (failed) *failed = args.failed;
+	return args.count;
+}
+
+static z_rv msg_send_wait(z_msg_t *msg, uint32_t timeout_ticks, uint32_t copy) {
+	z_kernel_ptr_t z_kernel_ptr = (z_kernel_ptr_t)(uintptr_t)(reg_kernel);
+	z_msg_send_wait_args_t args;
+	args.msg = msg;
+	args.timeout = timeout_ticks;
+	args.copy = copy;
+	z_obj_t *rv = (z_obj_t *)z_kernel_ptr(Z_SYS_MSG_SEND_WAIT, (uint32_t *)&args, 0);
+	return rv->val.uint32;
+}
+
+z_rv z_msg_send_wait(z_msg_t *msg, uint32_t timeout_ticks) {
+	return msg_send_wait(msg, timeout_ticks, 0);
+}
+
+z_rv z_msg_send_copy_wait(z_msg_t *msg, uint32_t timeout_ticks) {
+	return msg_send_wait(msg, timeout_ticks, 1);
+}
+
+z_rv z_msg_stats(uint32_t pid, z_msg_stats_t *stats) {
+	z_kernel_ptr_t z_kernel_ptr = (z_kernel_ptr_t)(uintptr_t)(reg_kernel);
+	stats->pid = pid;
+	z_obj_t *rv = (z_obj_t *)z_kernel_ptr(Z_SYS_MSG_STATS, (uint32_t *)stats, 0);
+	return rv->val.uint32;
+}
+
+static z_rv chan_op(z_chan_args_t *args) {
+	z_kernel_ptr_t z_kernel_ptr = (z_kernel_ptr_t)(uintptr_t)(reg_kernel);
+	z_obj_t *rv = (z_obj_t *)z_kernel_ptr(Z_SYS_CHAN, (uint32_t *)args, 0);
+	return rv->val.uint32;
+}
+
+z_chan_pair_t *z_chan_open(uint32_t peer) {
+	z_chan_args_t args = { .op = Z_CHAN_OPEN, .peer = peer };
+	return (chan_op(&args) == Z_OK) ? args.pair : NULL;
+}
+
+z_rv z_chan_wait(z_chan_pair_t *pair, uint32_t need, uint32_t timeout_ticks) {
+	z_chan_args_t args = { .op = Z_CHAN_WAIT, .pair = pair, .need = need,
+		.timeout = timeout_ticks };
+	return chan_op(&args);
+}
+
+void z_chan_wake(z_chan_pair_t *pair) {
+	z_chan_args_t args = { .op = Z_CHAN_WAKE, .pair = pair };
+	chan_op(&args);
+}
+
+void z_chan_close(z_chan_pair_t *pair) {
+	z_chan_args_t args = { .op = Z_CHAN_CLOSE, .pair = pair };
+	chan_op(&args);
+}
+
 z_rv z_msg_read(z_msg_t *msg) {
+	z_kernel_fast_ptr_t z_fast = z_fast_entry();
+	if (z_fast) return z_fast(Z_SYS_MSG_READ, (uint32_t)(uintptr_t)msg, 0, 0);
 	z_kernel_ptr_t z_kernel_ptr = (z_kernel_ptr_t)(uintptr_t)(reg_kernel);
 	z_obj_t *rv = (z_obj_t *)z_kernel_ptr(Z_SYS_MSG_READ, (uint32_t *)msg, 0);
 	return rv->val.uint32;
@@ -96,17 +301,50 @@ z_rv z_msg_new_send(uint32_t to, uint32_t subject, uint32_t tag, z_obj_t obj) {
 	return z_msg_send(&msg);
 }
 
+z_rv z_msg_send_flat(uint32_t to, uint32_t subject, uint32_t tag, const z_obj_t *obj) {
+	z_msg_t msg;
+	msg.to = to;
+	msg.subject = subject;
+	msg.tag = tag;
+	msg.obj = z_obj_flat(obj);
+	if (msg.obj.type != Z_BLOB) return Z_FAIL;
+	z_rv rv = z_msg_send_copy(&msg);
+	z_obj_free(&msg.obj);
+	return rv;
+}
+
+z_obj_t *z_msg_flat(z_msg_t *msg) {
+	return z_obj_unflatten(z_blob_data(&msg->obj), z_blob_len(&msg->obj));
+}
+
+z_rv z_msg_block(uint32_t timeout_ticks) {
+	z_kernel_ptr_t z_kernel_ptr = (z_kernel_ptr_t)(uintptr_t)(reg_kernel);
+	z_obj_t obj;
+	obj.type = Z_UINT32;
+	obj.val.uint32 = timeout_ticks;
+	z_obj_t *rv = (z_obj_t *)z_kernel_ptr(Z_SYS_MSG_BLOCK, (uint32_t *)&obj, 0);
+	return rv->val.uint32;
+}
+
 z_rv z_msg_wait(z_msg_t *msg, uint32_t subject, uint32_t tag) {
 	while (1) {
 		if (z_msg_read(msg) == Z_OK) {
 			if (msg->subject == subject && msg->tag == tag)
 				return Z_OK;
 			// not the message we're waiting for -- discard and keep going
+			z_msg_release(msg);
+		} else {
+			// nothing queued -- sleep instead of spinning (an older
+			// kernel without Z_SYS_MSG_BLOCK returns at once, which
+			// just makes this the old busy loop again)
+			z_msg_block(0);
 		}
 	}
 }
 
 uint32_t z_uptime_ticks(void) {
+	z_kernel_fast_ptr_t z_fast = z_fast_entry();
+	if (z_fast) return z_fast(Z_SYS_UPTIME, 0, 0, 0);
 	z_obj_t obj = {0};
 	z_kernel_ptr_t z_kernel_ptr = (z_kernel_ptr_t)(uintptr_t)(reg_kernel);
 	z_kernel_ptr(Z_SYS_UPTIME, (uint32_t *)&obj, 0);
@@ -163,6 +401,8 @@ bool z_pid_lookup(const char *name, uint32_t *pid) {
 }
 
 uint32_t z_getpid(void) {
+	z_kernel_fast_ptr_t z_fast = z_fast_entry();
+	if (z_fast) return z_fast(Z_SYS_GETPID, 0, 0, 0);
 	z_obj_t obj = {0};
 	z_kernel_ptr_t z_kernel_ptr = (z_kernel_ptr_t)(uintptr_t)(reg_kernel);
 	z_kernel_ptr(Z_SYS_GETPID, (uint32_t *)&obj, 0);
@@ -194,6 +434,19 @@ void z_proc_kill(uint32_t pid) {
 	z_kernel_ptr(Z_SYS_PROC_KILL, (uint32_t *)&obj, 0);
 }
 
+uint32_t z_klog_read(uint32_t *seq, z_klog_entry_t *buf, uint32_t max) {
+	z_kernel_ptr_t z_kernel_ptr = (z_kernel_ptr_t)(uintptr_t)(reg_kernel);
+	z_klog_read_args_t a;
+	a.seq = *seq;
+	a.buf = buf;
+	a.max = max;
+	a.count = 0;
+	a.lost = 0;
+	z_kernel_ptr(Z_SYS_KLOG_READ, (uint32_t *)&a, 0);
+	*seq = a.seq;
+	return a.count;
+}
+
 // --
 
 void rt_delay() {
@@ -262,6 +515,11 @@ void readline(char *buf, int maxlen) {
 	int c;
 	int pl = 0;
 
+	// stdout is line-buffered (see _fstat()) and the echo below goes
+	// straight to the UART, so push out any prompt still sitting in
+	// the buffer first
+	fflush(stdout);
+
 	memset(buf, 0x00, maxlen + 1);
 
 	while (1) {
@@ -292,17 +550,26 @@ void readline(char *buf, int maxlen) {
 
 }
 
+// stdout is line-buffered by newlib (see _fstat() below), so this
+// normally sees one whole line per call. LF->CRLF happens here, into
+// a small stack chunk, and each chunk is a single uart_write() syscall
+// -- instead of the two syscalls (uart_tx_full() + uart_putc()) per
+// byte, plus two more per newline, this used to cost.
+#define Z_WRITE_CHUNK 64
 ssize_t _write(int fd, const void *ptr, size_t len)
 {
 	const unsigned char *p = ptr;
-	for (int i = 0; i < len; i++) {
-		if (p[i] == 0x0a) {
-			while (uart_tx_full()) /* wait */;
-			uart_putc(0x0d);
+	char chunk[Z_WRITE_CHUNK];
+	uint32_t n = 0;
+	for (size_t i = 0; i < len; i++) {
+		if (p[i] == 0x0a) chunk[n++] = 0x0d;
+		chunk[n++] = p[i];
+		if (n >= Z_WRITE_CHUNK - 1) {
+			uart_write(chunk, n);
+			n = 0;
 		}
-		while (uart_tx_full()) /* wait */;
-		uart_putc(p[i]);
 	}
+	if (n) uart_write(chunk, n);
 	return len;
 }
 
@@ -315,7 +582,17 @@ int _close(int fd) {
 	return 0;
 }
 
+// fds 0-2 are the console: reporting them as character devices is
+// what makes newlib's __smakebuf() consult _isatty() and line-buffer
+// stdout (its default for a tty) instead of fully buffering it, or
+// -- with fstat failing outright, as it used to here -- not knowing
+// what it is at all. see _write() above.
 int _fstat(int fd, struct stat *st) {
+	if (fd >= 0 && fd <= 2) {
+		memset(st, 0, sizeof(*st));
+		st->st_mode = S_IFCHR;
+		return 0;
+	}
 	errno = ENOENT;
 	return -1;
 }
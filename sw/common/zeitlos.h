@@ -5,9 +5,20 @@
 #include <stdbool.h>
 #include "zobj.h"
 #include "zmsg.h"
+#include "zchan.h"
+#include "zklog.h"
 
 typedef uint32_t *(*z_kernel_ptr_t)(uint32_t, uint32_t *, uint32_t);
 
+// the register-based fast entry point (see fastcalls.def and
+// docs/app_runtime.md, "Fast syscalls") -- a0 = Z_SYS_* id,
+// a1..a3 = arguments, result in a0. not at a fixed address like
+// reg_kernel; ask for it with z_fast_entry() below.
+typedef uint32_t (*z_kernel_fast_ptr_t)(uint32_t, uint32_t, uint32_t, uint32_t);
+
+// what z_kernel_fast_entry() returns for an id with no fast handler
+#define Z_FAST_NOSYS 0xffffffff
+
 #define reg_kernel (*(volatile uint32_t*)0x0000000c)
 
 #define reg_uart0_data (*(volatile uint8_t*)0xf0000000)
@@ -68,6 +79,21 @@ typedef uint32_t *(*z_kernel_ptr_t)(uint32_t, uint32_t *, uint32_t);
 
 #define reg_sdcard (*(volatile uint32_t*)0xb0000000)
 
+// SD card SPI master (rtl/spisd.v) -- only there when the CSRs report
+// Z_FEATURE_SPI_SDCARD_HW (sw/common/zsoc.h); reg_sdcard above is
+// still its word 0. Bit layout: see spisd.v's header comment.
+#define reg_sdcard_status (*(volatile uint32_t*)0xb0000004)
+#define reg_sdcard_ctrl   (*(volatile uint32_t*)0xb0000008)
+#define reg_sdcard_data8  (*(volatile uint32_t*)0xb000000c)
+#define reg_sdcard_data32 (*(volatile uint32_t*)0xb0000010)
+
+#define Z_SDCARD_BUSY       0x01
+#define Z_SDCARD_TX_FULL    0x02
+#define Z_SDCARD_RX_EMPTY   0x04
+#define Z_SDCARD_RX_LEVEL(s) (((s) >> 16) & 0xff)
+#define Z_SDCARD_DISCARD    (1u << 16)
+#define Z_SDCARD_FIFO_DEPTH 16
+
 #define gpu_x0 (*(volatile uint32_t*)0xa0000000)
 #define gpu_y0 (*(volatile uint32_t*)0xa0000004)
 #define gpu_x1 (*(volatile uint32_t*)0xa0000008)
@@ -192,6 +218,20 @@ static inline uint32_t maskirq(uint32_t new_mask) {
 
 int getch(void);
 void readline(char *buf, int maxlen);
+
+// Z_SYS_UART_WRITE's argument block (ordinary path -- the fast path
+// passes buf/len in a1/a2 instead, see fastcalls.def). written comes
+// back as the number of bytes queued, 0 on failure.
+typedef struct {
+	const uint8_t	*buf;
+	uint32_t	len;
+	uint32_t	written;
+} z_uart_write_args_t;
+
+// queues `len` raw bytes (no LF->CRLF) for the console UART in one
+// syscall, blocking only while the kernel's TX FIFO is full. stdout
+// (_write()) goes through this; returns bytes written.
+uint32_t uart_write(const void *buf, uint32_t len);
 void echo(void);
 void noecho(void);
 
@@ -202,21 +242,139 @@ void noecho(void);
 // mouse.
 int32_t hid_read_key(void);
 
+// -- HID subscription (sw/os/hid.c) --
+//
+// z_hid_subscribe(true) makes the caller THE input process: from then
+// on the kernel's HID interrupt queues input straight into its
+// mailbox, from pid 0, instead of holding it for hid_read_key():
+//
+//   Z_HID_MSG_KEY    obj Z_UINT32, exactly hid_read_key()'s event
+//   Z_HID_MSG_MOUSE  obj Z_UINT32, the mouse port's reg_usbN_cursor as
+//                    of that report (x = bits 9:0, y = bits 19:10,
+//                    buttons = bits 23:20) plus the port in bit 24.
+//                    Motion with unchanged buttons replaces a
+//                    still-unread Z_HID_MSG_MOUSE rather than queuing
+//                    behind it, so there's never a backlog of stale
+//                    positions to chew through.
+//
+// Only one subscriber at a time -- returns Z_FAIL if another process
+// already is. Released automatically when the subscriber exits.
+#define Z_HID_MSG_KEY		500
+#define Z_HID_MSG_MOUSE		501
+#define Z_HID_MOUSE_KEEP_MASK	0x01F00000	// buttons + port: never merged
+z_rv z_hid_subscribe(bool on);
+
 // --
 
 // send a pre-built message
 z_rv z_msg_send(z_msg_t *msg);
 
+// same, but the kernel copies the payload before returning, so the
+// caller may free or reuse it immediately -- see zmsg.h. Z_FAIL if
+// the receiver's mailbox or copy arena is full (nothing was sent).
+z_rv z_msg_send_copy(z_msg_t *msg);
+
+// hands a received message's kernel-owned payload back (a no-op for
+// an ordinary, borrowed one) -- call once done with msg->obj
+z_rv z_msg_release(z_msg_t *msg);
+
 // build and send a message in one call
 z_rv z_msg_new_send(uint32_t to, uint32_t subject, uint32_t tag, z_obj_t obj);
 
+// send a list/map tree of any size: flattens obj (zobj.h) into a
+// single Z_BLOB and copy-sends it (z_msg_send_copy()), so obj itself
+// is still the caller's to free straight away. Z_FAIL if it couldn't
+// be flattened or the copy-send failed.
+z_rv z_msg_send_flat(uint32_t to, uint32_t subject, uint32_t tag, const z_obj_t *obj);
+
+// the receiving end: the tree inside a received flattened payload,
+// relocated in place, or NULL if msg->obj isn't one. Lives in the
+// message's payload -- valid until z_msg_release(msg), never freed.
+z_obj_t *z_msg_flat(z_msg_t *msg);
+
 // pop the next available message, if any (non-blocking)
 z_rv z_msg_read(z_msg_t *msg);
 
+// pop up to `max` messages into msgs[] in one syscall, oldest first --
+// the same as that many z_msg_read()s, for draining a burst. Returns
+// how many were read (0 = mailbox empty). Non-blocking.
+uint32_t z_msg_read_n(z_msg_t *msgs, uint32_t max);
+
+// z_msg_send() each of msgs[0..n-1] in one syscall, e.g. the same
+// notification to several pids. Carries on past a failed send;
+// returns how many were sent, and if `failed` is non-NULL sets bit i
+// in it for each msgs[i] (i < 32) that wasn't.
+uint32_t z_msg_send_n(z_msg_t *msgs, uint32_t n, uint32_t *failed);
+
+// z_msg_send()/z_msg_send_copy(), but a full receiver (mailbox, or
+// arena for the copy) parks the caller until it reads or releases
+// something instead of failing straight away -- backpressure rather
+// than a drop. Z_FAIL if timeout_ticks (0 = none) pass first, or for
+// anything waiting wouldn't fix (no such process, payload too big).
+z_rv z_msg_send_wait(z_msg_t *msg, uint32_t timeout_ticks);
+z_rv z_msg_send_copy_wait(z_msg_t *msg, uint32_t timeout_ticks);
+
+// snapshot of pid's mailbox: depth, messages waiting, the most ever
+// waiting at once, and sends refused because it was full (zmsg.h's
+// z_msg_stats_t). Z_FAIL if there's no process in that slot.
+z_rv z_msg_stats(uint32_t pid, z_msg_stats_t *stats);
+
+// channels (zchan.h) -- opens a pair of byte rings shared with `peer`
+// and returns where they are (a physical address, reachable from
+// either process), or NULL if there's no such process or no room.
+// The peer learns the address however the two agree on (zport.h
+// sends it in a Z_PORT_CHAN message) and uses it as-is.
+z_chan_pair_t *z_chan_open(uint32_t peer);
+
+// sleeps until the ring this end writes into has `need` bytes free,
+// the channel is closed, or timeout_ticks (0 = none) pass -- Z_OK
+// only for the first. Set the ring's writer_waiting before checking
+// it's full, so the reader knows to wake us.
+z_rv z_chan_wait(z_chan_pair_t *pair, uint32_t need, uint32_t timeout_ticks);
+
+// wakes the other end out of z_chan_wait() -- see z_chan_consume()
+void z_chan_wake(z_chan_pair_t *pair);
+
+// drops this end: marks both rings closed and wakes the other end.
+// The memory goes back to the kernel once both ends have closed (or
+// exited), so don't touch `pair` after this.
+void z_chan_close(z_chan_pair_t *pair);
+
 // block until a message matching subject/tag arrives, discarding
 // anything else that shows up in the meantime
 z_rv z_msg_wait(z_msg_t *msg, uint32_t subject, uint32_t tag);
 
+// RPC in one call: sends msg (same fields as z_msg_send()), then
+// sleeps until a reply from msg->to with the same tag arrives, and
+// reads it into msg. Anything else that arrives meanwhile stays
+// queued for the next z_msg_read(). Z_FAIL if the send fails or
+// timeout_ticks (0 = none) pass first. Pick a tag the callee can't
+// be using for anything else it sends you -- the reply's subject
+// isn't checked, so a callee can answer with more than one.
+z_rv z_msg_call(z_msg_t *msg, uint32_t timeout_ticks);
+
+// topics (zmsg.h): subscribe to `topic`, allowing up to `depth` (0 =
+// Z_MSG_TOPIC_DEPTH) of its messages to sit unread in the mailbox at
+// once -- past that they're dropped and counted. Published messages
+// arrive with subject = topic and a kernel-owned payload, so
+// z_msg_release() them once done. Z_FAIL if the system's out of
+// topic slots.
+z_rv z_msg_subscribe(uint32_t topic, uint32_t depth);
+z_rv z_msg_unsubscribe(uint32_t topic);
+// messages dropped for this process on `topic` since it subscribed
+// (0 if it isn't subscribed)
+uint32_t z_msg_topic_dropped(uint32_t topic);
+// one copy of obj to every subscriber of `topic` -- fire and forget,
+// the caller may free obj straight away. Z_OK even if nobody's
+// listening.
+z_rv z_msg_publish(uint32_t topic, uint32_t tag, z_obj_t obj);
+
+// sleep until the mailbox is non-empty (Z_OK) or timeout_ticks pass
+// (Z_FAIL; 0 = no timeout) without reading anything -- the scheduler
+// doesn't run this process at all in between. Follow with
+// z_msg_read(). Returns Z_FAIL at once on a kernel that predates it.
+z_rv z_msg_block(uint32_t timeout_ticks);
+
 // ticks since boot, ~732Hz (the KTIMER IRQ rate -- see
 // rtl/sysctl.v's rtc_ctr). for elapsed-time measurement; not
 // wall-clock/calendar time.
@@ -264,6 +422,19 @@ uint32_t z_proc_run(const char *name);
 // its titlebar close icon is clicked with that flag set.
 void z_proc_kill(uint32_t pid);
 
+// the kernel's fast syscall entry point (asked for once via
+// Z_SYS_FAST_ENTRY, then cached), or NULL if this kernel -- or the
+// simulator -- doesn't have one. zeitlos.c's own wrappers for the
+// calls in fastcalls.def already use it when available; exposed
+// mainly for sw/apps/sysbench, which times both paths.
+z_kernel_fast_ptr_t z_fast_entry(void);
+
+// copies up to `max` kernel log entries (`dmesg`, sw/os/klog.h) into
+// `buf`, starting from *seq (0 = the oldest still kept), and advances
+// *seq past them -- call again with the same *seq to pick up only
+// what's new. Returns how many were copied.
+uint32_t z_klog_read(uint32_t *seq, z_klog_entry_t *buf, uint32_t max);
+
 // NOTE: app-facing filesystem access (fs_size()/fs_mallocfile()/
 // fs_write_file(), backed by the new Z_SYS_FS_SIZE/_READ/_WRITE
 // syscalls) is DELIBERATELY NOT declared here, even though this file
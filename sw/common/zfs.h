@@ -2,6 +2,7 @@
 #define ZFS_H
 
 #include <stdint.h>
+#include "zobj.h"
 
 /*
  * Zeitlos
@@ -101,9 +102,36 @@ typedef struct {
 
 #define Z_FS_MAX_OPEN 4
 
+// topic (z_msg_subscribe(), zmsg.h) -- the kernel publishes here
+// whenever a file is changed through these syscalls: after a
+// successful Z_SYS_FS_WRITE or Z_SYS_FS_UNLINK, and on Z_SYS_FS_CLOSE
+// of a handle opened for writing. obj is the filename as a Z_STR (as
+// the writer passed it, up to Z_FS_CHANGED_NAME_MAX - 1 chars for
+// the chunked case), tag is Z_FS_CHANGED_*, and `from` is the process
+// that made the change. The shell's own direct fs.c calls (tget, cp
+// and friends) don't go through here and aren't published.
+#define Z_FS_TOPIC_CHANGED	200
+
+#define Z_FS_CHANGED_WRITE	1	// created, or rewritten
+#define Z_FS_CHANGED_UNLINK	2
+
+#define Z_FS_CHANGED_NAME_MAX	64
+
+// FS_OPEN_WRITE's size_hint is what the caller expects to write, if
+// it knows (0 if not): the kernel then tries to give the file that
+// many bytes of contiguous clusters up front (f_expand()) and trims
+// whatever wasn't written at close. Both opens build a cluster link
+// map (FatFs's fast seek) when the file is in few enough fragments --
+// Z_FS_LINKMAP_LEN DWORDs per handle, (Z_FS_LINKMAP_LEN - 1) / 2
+// fragments -- so reading or writing it never has to go back to the
+// FAT. Neither changes what the caller sees; a file that can't have
+// either is just read/written the ordinary way.
+#define Z_FS_LINKMAP_LEN	32
+
 typedef struct {
 	char		*name;
 	int32_t		handle;		// OUT: >= 0 on success, -1 on failure
+	uint32_t	size_hint;	// FS_OPEN_WRITE: expected size in bytes, 0 = unknown
 } z_fs_open_args_t;
 
 typedef struct {
@@ -126,4 +154,133 @@ typedef struct {
 	int32_t		handle;
 } z_fs_close_args_t;
 
+/*
+ * Splice -- FS_SPLICE moves a whole zstream.h stream into or out of
+ * an open handle inside the kernel, instead of the caller pulling
+ * each chunk into its own memory and handing it straight back with
+ * FS_WRITE_CHUNK (or the reverse, for a PUT). The kernel drives the
+ * stream's side of the protocol as the calling process, so the
+ * producer on the other end can't tell the difference -- but a
+ * CHUNK's bytes go from the producer's blob to f_write() without ever
+ * being copied, and the caller makes one syscall per transfer rather
+ * than two per chunk.
+ *
+ * IN:  stream -> file. `stream` is a zstream_consumer_t the caller
+ *      already opened (zstream_open()/zstream_open_window()).
+ * OUT: file -> stream. `stream` is a zstream_producer_t the caller
+ *      already accepted with plain zstream_accept() -- a window of 1.
+ *      Each chunk is read straight into the caller's `chunk` and lent
+ *      to the consumer from there, exactly as zstream_send_chunk()
+ *      would lend a blob, so it has to be caller memory: a borrowed
+ *      payload is resolved against its sender's view (msg.c's
+ *      z_translate()), and the sender is the caller. With one chunk in
+ *      flight, the next PULL is what frees it for the next read. A
+ *      short chunk is the end of the file, and the end of the splice:
+ *      a TFTP PUT's consumer stops pulling there, so `chunk` has to
+ *      stay put until the consumer is done with it (net's PUT reply).
+ *
+ * Returns once the stream has ended either way: &z_ok after EOF (IN:
+ * received, OUT: sent, or the short last chunk), &z_fail otherwise, with `err` filled in. The
+ * caller's stream struct is left ended -- IN aborts the stream itself
+ * if the write fails. `bytes` is what made it into (or out of) the
+ * file either way.
+ */
+
+#define Z_FS_SPLICE_IN		1
+#define Z_FS_SPLICE_OUT		2
+
+#define Z_FS_SPLICE_CHUNK	512	// OUT's chunk size -- one TFTP block
+
+typedef struct {
+	z_blob_t	blob;
+	uint8_t		data[Z_FS_SPLICE_CHUNK];
+} z_fs_splice_chunk_t;
+
+typedef struct {
+	uint32_t	op;		// Z_FS_SPLICE_*
+	int32_t		handle;		// opened for writing (IN) / reading (OUT)
+	void		*stream;	// zstream_consumer_t * (IN) / zstream_producer_t * (OUT)
+	z_fs_splice_chunk_t *chunk;	// OUT: caller-owned staging, unused for IN
+	uint32_t	timeout;	// ticks to wait for the peer's next message, 0 = forever
+	char		*err;		// caller-owned, may be NULL
+	uint32_t	err_len;
+	uint32_t	bytes;		// OUT
+} z_fs_splice_args_t;
+
+/*
+ * Asynchronous requests -- FS_ASYNC queues the same work FS_READ,
+ * FS_WRITE and FS_LIST do (a whole file into or out of a caller
+ * buffer, or a directory listing) and returns straight away with a
+ * request id, instead of the caller sitting in FatFs for the whole
+ * transfer. The kernel's own process (pid 0) works through the queue,
+ * oldest first, whenever the shell is idle at its prompt -- it's
+ * preemptible like any other process, so the caller (and everyone
+ * else) keeps running meanwhile -- and sends each caller a
+ * Z_FS_ASYNC_DONE message, tagged with the id, when its request is
+ * finished. Its obj is a Z_INT32: bytes read (READ), bytes written
+ * (WRITE) or entries listed (LIST, with Z_FS_ASYNC_TRUNCATED or'ed in
+ * if the listing didn't fit), or -1 if the request failed.
+ *
+ * `name` is copied at submit time (up to Z_FS_ASYNC_NAME_MAX - 1
+ * chars; longer is refused), but `buf` is used in place: it has to
+ * stay put, and READ/LIST's must be left alone, until the completion
+ * arrives. A process that exits has its queued requests dropped; one
+ * that's killed while its request is actually being serviced isn't
+ * reaped -- its memory isn't freed -- until the kernel is done with
+ * that request's buffer.
+ *
+ * A WRITE is published on Z_FS_TOPIC_CHANGED like FS_WRITE's, but
+ * from pid 0 (the kernel did the writing), not from the requester.
+ */
+
+#define Z_FS_ASYNC_READ		1	// name, buf, len = buf's capacity
+#define Z_FS_ASYNC_WRITE	2	// name, buf, len = bytes to write
+#define Z_FS_ASYNC_LIST		3	// name = directory (NULL = root), buf, len: as FS_LIST's out/out_cap
+
+#define Z_FS_ASYNC_DONE		201	// subject of the completion message
+
+#define Z_FS_ASYNC_TRUNCATED	0x40000000	// LIST result: more entries than fit
+
+#define Z_FS_ASYNC_MAX		8	// requests queued, system-wide
+#define Z_FS_ASYNC_NAME_MAX	64
+
+typedef struct {
+	uint32_t	op;		// Z_FS_ASYNC_*
+	char		*name;
+	void		*buf;		// caller-owned, untouched until Z_FS_ASYNC_DONE
+	uint32_t	len;
+	uint32_t	id;		// OUT: the completion's tag, 0 if not queued
+} z_fs_async_args_t;
+
+/*
+ * Shared read-only file mappings -- FS_MAP loads a whole file into
+ * kernel-allocated RAM once and hands every process that maps the
+ * same (unchanged) file the same copy, by physical address: main RAM
+ * below the 0x8000_0000 mirror is reachable from any process as-is
+ * (zchan.h's rings work the same way), so there's no copy into each
+ * caller. Meant for static assets several processes -- or several
+ * instances of one app -- would otherwise each load or carry their own
+ * copy of: fonts, icons, Scheme libraries.
+ *
+ * Read-only by contract only: nothing stops a process writing through
+ * the pointer (there's no memory protection on this hardware), and
+ * doing so changes what everyone sharing the mapping sees.
+ *
+ * Each MAP takes a reference, owned by the calling process; UNMAP (with
+ * the address MAP returned) or the process exiting gives it back, and
+ * the memory is freed as soon as nobody holds one. A file written or
+ * deleted while mapped keeps its existing mappings as they were -- the
+ * next MAP of that name loads the new contents as a separate copy.
+ */
+
+#define Z_FS_MAP		1	// name; OUT: addr, size
+#define Z_FS_UNMAP		2	// addr
+
+typedef struct {
+	uint32_t	op;		// Z_FS_MAP/Z_FS_UNMAP
+	char		*name;		// MAP
+	const void	*addr;		// MAP: OUT (physical, NULL on failure); UNMAP: IN
+	uint32_t	size;		// MAP: OUT, bytes
+} z_fs_map_args_t;
+
 #endif
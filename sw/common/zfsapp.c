@@ -161,12 +161,17 @@ char **fs_list(const char *path, uint32_t max_entries, uint32_t *count) {
 }
 
 int fs_open_write(const char *filename) {
+	return fs_open_write_sized(filename, 0);
+}
+
+int fs_open_write_sized(const char *filename, uint32_t size) {
 
 	if (!filename) return -1;
 
 	z_fs_open_args_t args;
 	args.name = (char *)filename;
 	args.handle = -1;
+	args.size_hint = size;
 
 	z_kernel_ptr_t z_kernel_ptr = (z_kernel_ptr_t)(uintptr_t)(reg_kernel);
 	z_obj_t *rv = (z_obj_t *)z_kernel_ptr(Z_SYS_FS_OPEN_WRITE, (uint32_t *)&args, 0);
@@ -183,6 +188,7 @@ int fs_open_read(const char *filename) {
 	z_fs_open_args_t args;
 	args.name = (char *)filename;
 	args.handle = -1;
+	args.size_hint = 0;
 
 	z_kernel_ptr_t z_kernel_ptr = (z_kernel_ptr_t)(uintptr_t)(reg_kernel);
 	z_obj_t *rv = (z_obj_t *)z_kernel_ptr(Z_SYS_FS_OPEN_READ, (uint32_t *)&args, 0);
@@ -241,3 +247,115 @@ int fs_close_handle(int handle) {
 	return (rv->val.uint32 == Z_OK) ? 1 : 0;
 
 }
+
+static int fs_splice(z_fs_splice_args_t *args) {
+
+	z_kernel_ptr_t z_kernel_ptr = (z_kernel_ptr_t)(uintptr_t)(reg_kernel);
+	z_obj_t *rv = (z_obj_t *)z_kernel_ptr(Z_SYS_FS_SPLICE, (uint32_t *)args, 0);
+	if (rv->val.uint32 != Z_OK) return -1;
+
+	return (int)args->bytes;
+
+}
+
+int fs_splice_in(int handle, zstream_consumer_t *cons, uint32_t timeout,
+	char *err, uint32_t err_len) {
+
+	if (handle < 0 || !cons) return -1;
+
+	z_fs_splice_args_t args;
+	memset(&args, 0, sizeof(args));
+	args.op = Z_FS_SPLICE_IN;
+	args.handle = handle;
+	args.stream = cons;
+	args.timeout = timeout;
+	args.err = err;
+	args.err_len = err_len;
+
+	return fs_splice(&args);
+
+}
+
+int fs_splice_out(int handle, zstream_producer_t *prod, z_fs_splice_chunk_t *chunk,
+	uint32_t timeout, char *err, uint32_t err_len) {
+
+	if (handle < 0 || !prod || !chunk) return -1;
+
+	z_fs_splice_args_t args;
+	memset(&args, 0, sizeof(args));
+	args.op = Z_FS_SPLICE_OUT;
+	args.handle = handle;
+	args.stream = prod;
+	args.chunk = chunk;
+	args.timeout = timeout;
+	args.err = err;
+	args.err_len = err_len;
+
+	return fs_splice(&args);
+
+}
+
+static uint32_t fs_async(uint32_t op, const char *name, void *buf, uint32_t len) {
+
+	z_fs_async_args_t args;
+	args.op = op;
+	args.name = (char *)name;
+	args.buf = buf;
+	args.len = len;
+	args.id = 0;
+
+	z_kernel_ptr_t z_kernel_ptr = (z_kernel_ptr_t)(uintptr_t)(reg_kernel);
+	z_obj_t *rv = (z_obj_t *)z_kernel_ptr(Z_SYS_FS_ASYNC, (uint32_t *)&args, 0);
+	if (rv->val.uint32 != Z_OK) return 0;
+
+	return args.id;
+
+}
+
+uint32_t fs_async_read(const char *filename, void *buf, uint32_t maxlen) {
+	return fs_async(Z_FS_ASYNC_READ, filename, buf, maxlen);
+}
+
+uint32_t fs_async_write(const char *filename, const void *buf, uint32_t len) {
+	return fs_async(Z_FS_ASYNC_WRITE, filename, (void *)buf, len);
+}
+
+uint32_t fs_async_list(const char *path, char *out, uint32_t out_cap) {
+	return fs_async(Z_FS_ASYNC_LIST, path, out, out_cap);
+}
+
+const void *fs_map(const char *filename, uint32_t *size) {
+
+	if (size) *size = 0;
+	if (!filename) return NULL;
+
+	z_fs_map_args_t args;
+	args.op = Z_FS_MAP;
+	args.name = (char *)filename;
+	args.addr = NULL;
+	args.size = 0;
+
+	z_kernel_ptr_t z_kernel_ptr = (z_kernel_ptr_t)(uintptr_t)(reg_kernel);
+	z_obj_t *rv = (z_obj_t *)z_kernel_ptr(Z_SYS_FS_MAP, (uint32_t *)&args, 0);
+	if (rv->val.uint32 != Z_OK) return NULL;
+
+	if (size) *size = args.size;
+	return args.addr;
+
+}
+
+int fs_unmap(const void *addr) {
+
+	if (!addr) return 0;
+
+	z_fs_map_args_t args;
+	args.op = Z_FS_UNMAP;
+	args.name = NULL;
+	args.addr = addr;
+	args.size = 0;
+
+	z_kernel_ptr_t z_kernel_ptr = (z_kernel_ptr_t)(uintptr_t)(reg_kernel);
+	z_obj_t *rv = (z_obj_t *)z_kernel_ptr(Z_SYS_FS_MAP, (uint32_t *)&args, 0);
+	return rv->val.uint32 == Z_OK;
+
+}
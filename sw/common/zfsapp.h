@@ -2,6 +2,8 @@
 #define ZFSAPP_H
 
 #include <stdint.h>
+#include "zfs.h"
+#include "zstream.h"
 
 /*
  * Zeitlos
@@ -91,6 +93,12 @@ char **fs_list(const char *path, uint32_t max_entries, uint32_t *count);
 int fs_open_write(const char *filename);
 int fs_open_read(const char *filename);
 
+// fs_open_write() for a caller that knows how many bytes it's about to
+// write: the kernel lays the file out as one contiguous run when it
+// can, so the chunks go out at the card's multi-sector speed. Writing
+// less (or more) than `size` is fine -- see zfs.h.
+int fs_open_write_sized(const char *filename, uint32_t size);
+
 // reads up to `maxlen` bytes into `buf`, returning the number
 // actually read -- 0 means end-of-file (NOT an error, same
 // convention the kernel-native fs_read_chunk(), sw/os/fs/fs.c,
@@ -108,4 +116,47 @@ int fs_write_chunk(int handle, const void *buf, int len);
 // you don't (a leaked slot in a small, bounded kernel-side table).
 int fs_close_handle(int handle);
 
+// -- splice -- hands a whole stream to the kernel to move into (or out
+// of) an open handle, rather than looping over the chunk calls above:
+// one syscall for the whole transfer, and the chunks never pass
+// through this process's own memory. See zfs.h for the details. Both
+// return the number of bytes moved, or -1 (with `err` filled in, if
+// given) if the stream ended any other way than a clean EOF; `timeout`
+// is how long to wait on the peer for each message, 0 = forever.
+//
+// fs_splice_in(): `cons` already opened with zstream_open_window() (or
+// zstream_open()), `handle` from fs_open_write().
+int fs_splice_in(int handle, zstream_consumer_t *cons, uint32_t timeout,
+	char *err, uint32_t err_len);
+
+// fs_splice_out(): `prod` already accepted with zstream_accept(),
+// `handle` from fs_open_read(). `chunk` is where each chunk is staged
+// while the consumer has it -- this process's own memory, left alone
+// until the consumer is done (the last chunk can still be lent out
+// after this returns, see zfs.h).
+int fs_splice_out(int handle, zstream_producer_t *prod, z_fs_splice_chunk_t *chunk,
+	uint32_t timeout, char *err, uint32_t err_len);
+
+// -- asynchronous -- queue a whole-file read or write, or a listing,
+// for the kernel to do in the background, and get on with something
+// else. Each returns the request's id, or 0 if it couldn't be queued
+// (bad arguments, a name too long, or Z_FS_ASYNC_MAX requests already
+// waiting). When it's done a Z_FS_ASYNC_DONE message arrives tagged
+// with that id -- e.g. z_msg_wait(&msg, Z_FS_ASYNC_DONE, id) -- whose
+// obj.val.int32 is the byte (or entry) count, or -1 on failure. `buf`
+// / `out` stays in use until then. See zfs.h for the details.
+uint32_t fs_async_read(const char *filename, void *buf, uint32_t maxlen);
+uint32_t fs_async_write(const char *filename, const void *buf, uint32_t len);
+uint32_t fs_async_list(const char *path, char *out, uint32_t out_cap);
+
+// -- shared read-only mappings -- the whole file, loaded once and
+// shared with every other process that maps it (see zfs.h). Returns
+// its address (readable directly, no copy) and sets *size, or NULL if
+// it couldn't be mapped (not found, empty, out of memory or mapping
+// slots). Don't write through the pointer. fs_unmap() gives the
+// mapping back -- 1 on success, 0 if `addr` isn't one of this
+// process's -- and exiting gives back any that are left.
+const void *fs_map(const char *filename, uint32_t *size);
+int fs_unmap(const void *addr);
+
 #endif
@@ -0,0 +1,47 @@
+#ifndef ZKLOG_H
+#define ZKLOG_H
+
+#include <stdint.h>
+
+/*
+ * Zeitlos
+ * Copyright (c) 2025 Lone Dynamics Corporation. All rights reserved.
+ *
+ * Wire shape for the kernel log ring (sw/os/klog.h, `dmesg` in sh.c)
+ * and Z_SYS_KLOG_READ -- shared between the kernel side and the
+ * app-facing z_klog_read() wrapper (zeitlos.c), same role zfs.h plays
+ * for the filesystem syscalls.
+ */
+
+// levels -- lower is more important. The ring keeps everything; only
+// entries at or below the console level (K_LOG_INFO by default, see
+// klog.h) are also echoed to the UART.
+#define K_LOG_ERR	0
+#define K_LOG_WARN	1
+#define K_LOG_INFO	2
+#define K_LOG_DEBUG	3
+
+#define Z_KLOG_TEXT_MAX	52	// per entry, NOT NUL-terminated -- see len
+
+typedef struct {
+	uint32_t	seq;		// 1, 2, 3, ... in write order (0 = unused slot)
+	uint32_t	ticks;		// z_kernel_ticks when written
+	uint8_t		level;		// K_LOG_*
+	uint8_t		pid;		// z_pid when written (0 = kernel/shell)
+	uint8_t		len;		// bytes used in text[]
+	uint8_t		_pad;
+	char		text[Z_KLOG_TEXT_MAX];
+} z_klog_entry_t;
+
+typedef struct {
+	uint32_t	seq;		// IN: first seq wanted (0 = oldest still
+					// in the ring); OUT: seq to pass next time
+	z_klog_entry_t	*buf;		// caller-owned, >= max entries
+	uint32_t	max;
+	uint32_t	count;		// OUT: entries copied into buf
+	uint32_t	lost;		// OUT: entries between IN seq and the
+					// oldest one still kept, overwritten
+					// before this call could copy them
+} z_klog_read_args_t;
+
+#endif
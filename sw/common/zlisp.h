@@ -89,10 +89,10 @@
 // forever, same reasoning as z_port_connect()'s own timeout: `lisp`
 // isn't guaranteed to be running, and unlike z_win_create()'s RPC to
 // `wm` (which the whole system depends on staying up), a caller here
-// should be able to give up cleanly. Like z_port_connect(), call this
-// before your own message loop is also expecting other messages --
-// any unrelated message that arrives while waiting is discarded, same
-// accepted limitation.
+// should be able to give up cleanly. Built on z_msg_call()
+// (zeitlos.h), so any unrelated message that arrives while waiting
+// stays queued for your own message loop -- safe to call from inside
+// one.
 //
 // returns Z_OK if `lisp` replied at all (check *is_error to tell
 // LISP_RESULT from LISP_ERROR -- `out` holds the reply text either
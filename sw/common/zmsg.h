@@ -42,6 +42,17 @@
  * to keep or modify the data, make your own copy first with
  * z_obj_copy() -- that allocates fresh memory on your own heap, same
  * as it does for any other z_obj_t.
+ *
+ * The exception is z_msg_send_copy() (zeitlos.h): the kernel copies
+ * the whole payload into a small arena belonging to the RECEIVER's
+ * mailbox before the call returns, so the sender can free or reuse
+ * its own buffers straight away -- no ack round trip needed to know
+ * when that's safe. Such a message arrives with msg._kbuf set, its
+ * payload stays valid until the receiver hands it back with
+ * z_msg_release(), and it must be handed back (z_msg_release() is a
+ * no-op for an ordinary message, so calling it on everything is
+ * fine) -- the arena is a FIFO, so one message never released holds
+ * up reuse of everything queued after it.
  */
 
 #include <stdint.h>
@@ -72,15 +83,29 @@ typedef uint32_t z_rv;
 // minimum that happened to pass initial testing; the actual required
 // depth depends on typing speed vs. how fast a receiver's own main
 // loop drains its mailbox between key events, which varies per app,
-// so this errs generous. Costs ~24 bytes per envelope * Z_PROCS_MAX
-// process slots * (new - old) depth in additional kernel .bss
-// (msg.c's z_mailboxes[]) -- a few KB, negligible against this
-// board's overall memory budget.
-#define Z_MAILBOX_DEPTH   32
+// so this errs generous.
+//
+// That's now the DEFAULT depth rather than everyone's: each process
+// gets its own depth when it's created (kernel.h's
+// z_proc_mailbox_depth_for(), same per-name policy as its stack
+// size) -- wm and net, which take bursts from every other process,
+// get LARGE; the single-window graphics demos, which hardly hear from
+// anyone, get SMALL. Mailbox rings are carved out of one shared
+// kernel pool (msg.c) of Z_MAILBOX_POOL envelopes -- the same .bss a
+// fixed 32-deep ring per process slot used to take, so the SMALL
+// ones are what pay for the LARGE ones. A process whose depth doesn't
+// fit what's left gets the biggest smaller one that does (down to
+// SMALL), rather than failing to start.
+#define Z_MAILBOX_DEPTH		32
+#define Z_MAILBOX_DEPTH_SMALL	8
+#define Z_MAILBOX_DEPTH_LARGE	64
+#define Z_MAILBOX_POOL		(Z_MAILBOX_DEPTH * 16)	// * Z_PROCS_MAX (kernel.h)
 
 // scratch budget used by z_msg_read() to resolve Z_LIST/Z_MAP
 // payloads (see the big comment above). enough for a small, flat
-// argument map; raise these if you need more.
+// argument map. Anything bigger should go flattened
+// (z_msg_send_flat() in zeitlos.h) rather than raising these -- every
+// z_msg_t anywhere pays for this scratch space.
 #define Z_MSG_MAX_TABLES   4
 #define Z_MSG_MAX_ITEMS    16
 
@@ -89,6 +114,37 @@ typedef uint32_t z_rv;
 // UDP packet's worth of data), maybe two if nested in a small map.
 #define Z_MSG_MAX_BLOBS    2
 
+// per-mailbox arena for z_msg_send_copy() payloads (see above) --
+// allocated from the kernel's pool the first time something is
+// copy-sent to that process, freed when it exits. k_mem_alloc()'s
+// smallest block (mem.h's Z_MEM_MIN_BLOCK_SIZE) anyway.
+#define Z_MSG_ARENA_SIZE   32768
+
+// -- topics (publish/subscribe) --
+//
+// a topic is just a subject number that more than one process wants
+// to hear about -- focus changes, link state, and the like. Processes
+// subscribe to it with z_msg_subscribe(); the producer calls
+// z_msg_publish() once and the kernel queues a copy (copy-send, see
+// above -- a broadcast can't wait on every subscriber to be done with
+// a borrowed payload) to every subscriber. The message arrives with
+// subject = the topic and from = the publisher, so a subscriber's
+// ordinary dispatch-on-subject loop handles it like anything else.
+//
+// Each subscriber says how many of a topic's messages it's willing to
+// have waiting unread at once (its depth); beyond that, and whenever
+// its mailbox or arena is full, further publishes to it are dropped
+// and counted rather than blocking the publisher or crowding out
+// everything else in the mailbox. Subscriptions go away on their own
+// when a process exits.
+
+#define Z_MSG_TOPICS_MAX	16	// distinct topics with subscribers, system-wide
+#define Z_MSG_TOPIC_DEPTH	4	// default per-subscriber depth
+
+#define Z_MSG_TOPIC_SUBSCRIBE	1
+#define Z_MSG_TOPIC_UNSUBSCRIBE	2
+#define Z_MSG_TOPIC_STATUS	3	// just fills in `dropped`
+
 // a message as seen by a process.
 typedef struct {
 
@@ -104,6 +160,10 @@ typedef struct {
 	z_obj_t		_items[Z_MSG_MAX_ITEMS];
 	z_blob_t	_blobs[Z_MSG_MAX_BLOBS];
 
+	// nonzero: the payload is a kernel-owned copy (z_msg_send_copy())
+	// to hand back with z_msg_release(). set by z_msg_read().
+	uint32_t	_kbuf;
+
 } z_msg_t;
 
 // the lightweight envelope actually queued in a process's kernel-owned
@@ -117,7 +177,73 @@ typedef struct {
 	uint32_t	subject;
 	uint32_t	tag;
 	z_obj_t		obj;
+	uint32_t	kbuf;	// arena block holding obj's copy, 0 if borrowed
+	uint32_t	topic;	// topic slot + 1 if published (k_msg_publish()), else 0
 
 } z_msg_envelope_t;
 
+// Z_SYS_MSG_CALL's argument -- see z_msg_call() in zeitlos.h. msg is
+// the request going in (to/subject/tag/obj, same as z_msg_send()) and
+// the reply coming back out, read straight into the same z_msg_t.
+typedef struct {
+
+	z_msg_t		*msg;
+	uint32_t	timeout;	// ticks, 0 = wait forever
+
+} z_msg_call_args_t;
+
+// Z_SYS_MSG_READ_N / Z_SYS_MSG_SEND_N's argument -- see
+// z_msg_read_n()/z_msg_send_n() in zeitlos.h
+typedef struct {
+
+	z_msg_t		*msgs;
+	uint32_t	n;		// READ_N: capacity of msgs; SEND_N: messages to send
+	uint32_t	count;		// OUT: messages read / sent
+	uint32_t	failed;		// OUT, SEND_N only: bit i set if msgs[i]
+					// (i < 32) couldn't be sent
+
+} z_msg_batch_args_t;
+
+// Z_SYS_MSG_SUBSCRIBE's argument -- see z_msg_subscribe() in zeitlos.h
+typedef struct {
+
+	uint32_t	op;		// Z_MSG_TOPIC_*
+	uint32_t	topic;
+	uint32_t	depth;		// SUBSCRIBE: 0 = Z_MSG_TOPIC_DEPTH
+	uint32_t	dropped;	// OUT: this subscriber's drops so far
+
+} z_msg_topic_args_t;
+
+// Z_SYS_MSG_PUBLISH's argument. msg->subject is the topic; msg->to
+// is ignored.
+typedef struct {
+
+	z_msg_t		*msg;
+	uint32_t	delivered;	// OUT: subscribers it was queued for
+	uint32_t	dropped;	// OUT: subscribers it was dropped for
+
+} z_msg_publish_args_t;
+
+// Z_SYS_MSG_SEND_WAIT's argument -- see z_msg_send_wait() in
+// zeitlos.h
+typedef struct {
+
+	z_msg_t		*msg;
+	uint32_t	timeout;	// ticks, 0 = wait forever
+	uint32_t	copy;		// nonzero: copy-send (z_msg_send_copy())
+
+} z_msg_send_wait_args_t;
+
+// Z_SYS_MSG_STATS's argument -- a snapshot of one process's mailbox,
+// see z_msg_stats() in zeitlos.h
+typedef struct {
+
+	uint32_t	pid;		// IN
+	uint32_t	depth;		// capacity, chosen when it was created
+	uint32_t	count;		// messages waiting right now
+	uint32_t	high_water;	// most ever waiting at once
+	uint32_t	dropped;	// sends refused because it was full
+
+} z_msg_stats_t;
+
 #endif
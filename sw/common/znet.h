@@ -60,7 +60,8 @@
 // (Z_STR) holds a message. Sent once the whole transfer -- including
 // the remote server's handling of the final block -- completes, not
 // when the requester finishes producing chunks (those two can finish
-// at different times).
+// at different times). Copy-sent, like every reply from net -- hand it
+// back with z_msg_release() once read.
 #define Z_NET_TFTP_PUT_REPLY   303
 
 // requester -> net: Z_STR (the hostname to resolve, e.g.
@@ -87,7 +88,15 @@
 // "ok" (Z_UINT32, 0 or 1). If ok, "ip" (Z_UINT32) holds the resolved
 // address. If not ok, "error" (Z_STR) holds a short reason (no
 // nameserver configured, NXDOMAIN/no A record, timeout, busy with
-// another resolution, etc).
+// another resolution, etc). Copy-sent -- z_msg_release() it.
 #define Z_NET_DNS_RESOLVE_REPLY  305
 
+// topic (z_msg_subscribe(), zmsg.h) -- net publishes its IP
+// configuration here once it's settled at startup (DHCP lease or the
+// static fallback): Z_MAP with "ip", "netmask", "gateway", "dns" (all
+// Z_UINT32, dns 0 = none) and "dhcp" (Z_UINT32, 1 if the lease came
+// from DHCP). Published once, not retained -- a process that
+// subscribes after net is up has missed it.
+#define Z_NET_TOPIC_LINK         306
+
 #endif
@@ -61,6 +61,8 @@ z_obj_t z_obj_list(uint32_t len) {
     t->len = len;
     t->a = calloc(len, sizeof(z_obj_t));
     t->b = NULL;
+    t->flags = 0;
+    t->count = 0;
 
     z_obj_t obj = { .type = Z_LIST };
     obj.val.ptr = t;
@@ -72,6 +74,36 @@ z_obj_t z_obj_map(uint32_t len) {
     t->len = len;
     t->a = calloc(len, sizeof(z_obj_t)); // keys
     t->b = calloc(len, sizeof(z_obj_t)); // values
+    t->flags = 0;
+    t->count = 0;
+    z_obj_t obj = { .type = Z_MAP };
+    obj.val.ptr = t;
+    return obj;
+}
+
+// smallest power of two (at least 4) that holds len keys at no more
+// than 3/4 full
+static uint32_t hmap_capacity(uint32_t len) {
+    uint32_t cap = 4;
+    while (cap * 3 < len * 4 && cap < 0x40000000u) cap <<= 1;
+    return cap;
+}
+
+z_obj_t z_obj_hmap(uint32_t len) {
+    uint32_t cap = hmap_capacity(len);
+    z_obj_table_t *t = malloc(sizeof(z_obj_table_t));
+    if (!t) return z_obj_none();
+    t->a = calloc(cap, sizeof(z_obj_t));
+    t->b = calloc(cap, sizeof(z_obj_t));
+    if (!t->a || !t->b) {
+        free(t->a);
+        free(t->b);
+        free(t);
+        return z_obj_none();
+    }
+    t->len = cap;
+    t->flags = Z_TABLE_HASHED;
+    t->count = 0;
     z_obj_t obj = { .type = Z_MAP };
     obj.val.ptr = t;
     return obj;
@@ -326,6 +358,8 @@ z_obj_t z_obj_copy(const z_obj_t *src) {
             for (uint32_t i = 0; i < src_table->len; i++) {
                 new_table->a[i] = z_obj_copy(&src_table->a[i]);
             }
+            new_table->flags = src_table->flags;
+            new_table->count = src_table->count;
             
             return new_list;
         }
@@ -341,6 +375,10 @@ z_obj_t z_obj_copy(const z_obj_t *src) {
                 new_table->a[i] = z_obj_copy(&src_table->a[i]);
                 new_table->b[i] = z_obj_copy(&src_table->b[i]);
             }
+            // slot for slot, so a hashed map's keys are still where
+            // their hashes say
+            new_table->flags = src_table->flags;
+            new_table->count = src_table->count;
             
             return new_map;
         }
@@ -445,6 +483,94 @@ uint32_t z_obj_size(const z_obj_t *obj) {
     }
 }
 
+// MAP LOOKUP
+//
+// see zobj.h for hashed maps
+
+#define SLOT_NONE   UINT32_MAX
+
+// FNV-1a
+static uint32_t map_hash(const char *s) {
+    uint32_t h = 2166136261u;
+    while (*s) {
+        h ^= (uint8_t)*s++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static int map_key_is(const z_obj_t *k, const char *key) {
+    return k->type == Z_STR && k->val.str && strcmp(k->val.str, key) == 0;
+}
+
+// the slot holding key in t -- or, if it isn't there, the slot it
+// would go in (SLOT_NONE if the map is full). *found says which.
+static uint32_t map_slot(const z_obj_table_t *t, const char *key, int *found) {
+
+    *found = 0;
+
+    if (t->flags & Z_TABLE_HASHED) {
+        // len is a power of two; bounded by len anyway, so a full (or
+        // mangled) table can't make this spin
+        if (!t->len) return SLOT_NONE;
+        uint32_t mask = t->len - 1;
+        uint32_t i = map_hash(key) & mask;
+        for (uint32_t n = 0; n < t->len; n++, i = (i + 1) & mask) {
+            if (t->a[i].type == Z_NONE) return i;
+            if (map_key_is(&t->a[i], key)) {
+                *found = 1;
+                return i;
+            }
+        }
+        return SLOT_NONE;
+    }
+
+    uint32_t empty = SLOT_NONE;
+    for (uint32_t i = 0; i < t->len; i++) {
+        if (map_key_is(&t->a[i], key)) {
+            *found = 1;
+            return i;
+        }
+        if (empty == SLOT_NONE && t->a[i].type == Z_NONE) empty = i;
+    }
+    return empty;
+
+}
+
+// doubles a hashed map's columns and re-places every key; the key and
+// value objects themselves just move, nothing is copied
+static int map_grow(z_obj_table_t *t) {
+
+    uint32_t cap = t->len * 2;
+    if (cap <= t->len) return 0;
+
+    z_obj_t *na = calloc(cap, sizeof(z_obj_t));
+    z_obj_t *nb = calloc(cap, sizeof(z_obj_t));
+    if (!na || !nb) {
+        free(na);
+        free(nb);
+        return 0;
+    }
+
+    for (uint32_t i = 0; i < t->len; i++) {
+        z_obj_t *k = &t->a[i];
+        if (k->type == Z_NONE) continue;
+        const char *ks = (k->type == Z_STR && k->val.str) ? k->val.str : "";
+        uint32_t j = map_hash(ks) & (cap - 1);
+        while (na[j].type != Z_NONE) j = (j + 1) & (cap - 1);
+        na[j] = *k;
+        nb[j] = t->b[i];
+    }
+
+    free(t->a);
+    free(t->b);
+    t->a = na;
+    t->b = nb;
+    t->len = cap;
+    return 1;
+
+}
+
 // Find a value in a map by string key
 z_obj_t *z_map_find(z_obj_t *map, const char *key) {
     if (!map || map->type != Z_MAP || !key) return NULL;
@@ -452,16 +578,9 @@ z_obj_t *z_map_find(z_obj_t *map, const char *key) {
     z_obj_table_t *table = (z_obj_table_t *)map->val.ptr;
     if (!table) return NULL;
     
-    for (uint32_t i = 0; i < table->len; i++) {
-        z_obj_t *map_key = &table->a[i];
-        if (map_key->type == Z_STR && 
-            map_key->val.str && 
-            strcmp(map_key->val.str, key) == 0) {
-            return &table->b[i];
-        }
-    }
-    
-    return NULL;
+    int found;
+    uint32_t i = map_slot(table, key, &found);
+    return found ? &table->b[i] : NULL;
 }
 
 // Append an item to a list (dynamic growth)
@@ -491,27 +610,385 @@ int z_map_set(z_obj_t *map, const char *key, z_obj_t value) {
     z_obj_table_t *t = (z_obj_table_t *)map->val.ptr;
     if (!t) return 0;
     
-    // First, try to find existing key
-    for (uint32_t i = 0; i < t->len; i++) {
-        z_obj_t *map_key = &t->a[i];
-        if (map_key->type == Z_STR && 
-            map_key->val.str && 
-            strcmp(map_key->val.str, key) == 0) {
-            // Key exists, update value
-            z_obj_free(&t->b[i]);
-            t->b[i] = z_obj_copy(&value);
-            return 1;
+    int found;
+    uint32_t i = map_slot(t, key, &found);
+
+    if (found) {
+        // Key exists, update value
+        z_obj_free(&t->b[i]);
+        t->b[i] = z_obj_copy(&value);
+        return 1;
+    }
+
+    // a hashed map grows before it gets more than 3/4 full, so probe
+    // runs stay short
+    if ((t->flags & Z_TABLE_HASHED) && (t->count + 1) * 4 > t->len * 3) {
+        if (!map_grow(t)) return 0;
+        i = map_slot(t, key, &found);
+    }
+
+    if (i == SLOT_NONE) return 0; // No space available
+
+    z_obj_t k = z_obj_str(key);
+    if (k.type != Z_STR) return 0;
+    t->a[i] = k;
+    t->b[i] = z_obj_copy(&value);
+    if (t->flags & Z_TABLE_HASHED) t->count++;
+    return 1;
+}
+
+// FLATTENED OBJECTS
+//
+// see zobj.h. Layout, in the order z_obj_flatten() writes it: the
+// header (holding the root), then everything else depth-first -- a
+// list/map's z_obj_table_t, its item array(s), then whatever its
+// items point to; a blob's z_blob_t, then its bytes; a string's bytes
+// including the NUL. Every chunk starts pointer-aligned, so the
+// decoded structs are safe to read in place.
+
+#define FLAT_ALIGN(n)	(((n) + sizeof(void *) - 1) & ~(uint32_t)(sizeof(void *) - 1))
+
+// bytes needed for whatever obj points to (not obj itself), or
+// UINT32_MAX if nested too deep
+static uint32_t flat_extra(const z_obj_t *obj, int depth) {
+
+    switch (obj->type) {
+
+        case Z_STR:
+            return obj->val.str ? FLAT_ALIGN(strlen(obj->val.str) + 1) : 0;
+
+        case Z_BLOB: {
+            z_blob_t *b = (z_blob_t *)obj->val.ptr;
+            if (!b) return 0;
+            return FLAT_ALIGN(sizeof(z_blob_t)) + FLAT_ALIGN(b->len);
         }
+
+        case Z_LIST:
+        case Z_MAP: {
+            z_obj_table_t *t = (z_obj_table_t *)obj->val.ptr;
+            if (!t) return 0;
+            if (depth >= Z_OBJ_FLAT_MAX_DEPTH) return UINT32_MAX;
+            uint32_t n = FLAT_ALIGN(sizeof(z_obj_table_t));
+            uint32_t arrays = (obj->type == Z_MAP && t->b) ? 2 : 1;
+            n += arrays * t->len * sizeof(z_obj_t);
+            for (uint32_t i = 0; i < t->len; i++) {
+                uint32_t e = flat_extra(&t->a[i], depth + 1);
+                if (e == UINT32_MAX) return e;
+                n += e;
+                if (arrays == 2) {
+                    e = flat_extra(&t->b[i], depth + 1);
+                    if (e == UINT32_MAX) return e;
+                    n += e;
+                }
+            }
+            return n;
+        }
+
+        default:
+            return 0;
+
     }
-    
-    // Key doesn't exist, find empty slot
-    for (uint32_t i = 0; i < t->len; i++) {
-        if (t->a[i].type == Z_NONE) {
-            t->a[i] = z_obj_str(key);
-            t->b[i] = z_obj_copy(&value);
-            return 1;
+
+}
+
+uint32_t z_obj_flat_size(const z_obj_t *obj) {
+    if (!obj) return 0;
+    uint32_t e = flat_extra(obj, 0);
+    if (e == UINT32_MAX) return 0;
+    return FLAT_ALIGN(sizeof(z_obj_flat_t)) + e;
+}
+
+// writes what src points to at buf + *pos, and points dst (already a
+// copy of src) at it -- as an offset from buf. sizes were checked up
+// front by z_obj_flatten(), so there's no bounds checking in here.
+static void flat_write(uint8_t *buf, uint32_t *pos, const z_obj_t *src, z_obj_t *dst) {
+
+    switch (src->type) {
+
+        case Z_STR: {
+            if (!src->val.str) return;
+            uint32_t len = strlen(src->val.str) + 1;
+            memcpy(buf + *pos, src->val.str, len);
+            dst->val.ptr = (void *)(uintptr_t)*pos;
+            *pos += FLAT_ALIGN(len);
+            return;
+        }
+
+        case Z_BLOB: {
+            z_blob_t *b = (z_blob_t *)src->val.ptr;
+            if (!b) return;
+            z_blob_t *fb = (z_blob_t *)(buf + *pos);
+            dst->val.ptr = (void *)(uintptr_t)*pos;
+            *pos += FLAT_ALIGN(sizeof(z_blob_t));
+            fb->len = b->len;
+            fb->data = (uint8_t *)(uintptr_t)*pos;
+            if (b->len && b->data) memcpy(buf + *pos, b->data, b->len);
+            *pos += FLAT_ALIGN(b->len);
+            return;
+        }
+
+        case Z_LIST:
+        case Z_MAP: {
+            z_obj_table_t *t = (z_obj_table_t *)src->val.ptr;
+            if (!t) return;
+            bool two = (src->type == Z_MAP && t->b);
+
+            z_obj_table_t *ft = (z_obj_table_t *)(buf + *pos);
+            dst->val.ptr = (void *)(uintptr_t)*pos;
+            *pos += FLAT_ALIGN(sizeof(z_obj_table_t));
+
+            ft->len = t->len;
+            ft->flags = t->flags;
+            ft->count = t->count;
+            z_obj_t *fa = (z_obj_t *)(buf + *pos);
+            ft->a = (z_obj_t *)(uintptr_t)*pos;
+            *pos += t->len * sizeof(z_obj_t);
+            z_obj_t *fbv = NULL;
+            ft->b = NULL;
+            if (two) {
+                fbv = (z_obj_t *)(buf + *pos);
+                ft->b = (z_obj_t *)(uintptr_t)*pos;
+                *pos += t->len * sizeof(z_obj_t);
+            }
+
+            // item arrays first, then what the items point to -- the
+            // arrays have to be contiguous
+            for (uint32_t i = 0; i < t->len; i++) {
+                fa[i] = t->a[i];
+                flat_write(buf, pos, &t->a[i], &fa[i]);
+                if (two) {
+                    fbv[i] = t->b[i];
+                    flat_write(buf, pos, &t->b[i], &fbv[i]);
+                }
+            }
+            return;
         }
+
+        default:
+            return;
+
     }
-    
-    return 0; // No space available
+
+}
+
+uint32_t z_obj_flatten(const z_obj_t *obj, void *buf, uint32_t size) {
+
+    uint32_t need = z_obj_flat_size(obj);
+    if (!need || !buf || need > size) return 0;
+
+    z_obj_flat_t *h = (z_obj_flat_t *)buf;
+    h->magic = Z_OBJ_FLAT_MAGIC;
+    h->size = need;
+    h->base = 0;
+    h->root = *obj;
+
+    uint32_t pos = FLAT_ALIGN(sizeof(z_obj_flat_t));
+    flat_write((uint8_t *)buf, &pos, obj, &h->root);
+
+    return need;
+
+}
+
+z_obj_t z_obj_flat(const z_obj_t *obj) {
+
+    uint32_t need = z_obj_flat_size(obj);
+    if (!need) return z_obj_none();
+
+    // built directly inside the blob's own buffer rather than
+    // flattened somewhere else and copied in by z_obj_blob()
+    z_obj_t blob = z_obj_blob(NULL, need);
+    if (blob.type != Z_BLOB) return blob;
+    z_obj_flatten(obj, z_blob_data(&blob), need);
+    return blob;
+
+}
+
+// moves one pointer from the old base to the new one, checking it
+// lands inside the buffer (with room for `n` bytes). NULL stays NULL.
+static bool flat_reloc(void **p, uintptr_t old_base, uint8_t *buf, uint32_t len, uint32_t n) {
+    if (!*p) return true;
+    uintptr_t off = (uintptr_t)*p - old_base;
+    if (off < sizeof(z_obj_flat_t) || off > len || n > len - off) return false;
+    *p = buf + off;
+    return true;
+}
+
+static bool flat_relocate(z_obj_t *obj, uintptr_t old_base, uint8_t *buf, uint32_t len, int depth) {
+
+    switch (obj->type) {
+
+        case Z_STR: {
+            if (!flat_reloc(&obj->val.ptr, old_base, buf, len, 1)) return false;
+            // must be terminated inside the buffer
+            return !obj->val.str ||
+                memchr(obj->val.str, 0, len - ((uint8_t *)obj->val.str - buf)) != NULL;
+        }
+
+        case Z_BLOB: {
+            if (!flat_reloc(&obj->val.ptr, old_base, buf, len, sizeof(z_blob_t))) return false;
+            z_blob_t *b = (z_blob_t *)obj->val.ptr;
+            if (!b) return true;
+            return flat_reloc((void **)&b->data, old_base, buf, len, b->len);
+        }
+
+        case Z_LIST:
+        case Z_MAP: {
+            if (depth >= Z_OBJ_FLAT_MAX_DEPTH) return false;
+            if (!flat_reloc(&obj->val.ptr, old_base, buf, len, sizeof(z_obj_table_t))) return false;
+            z_obj_table_t *t = (z_obj_table_t *)obj->val.ptr;
+            if (!t) return true;
+            if (t->len > len / sizeof(z_obj_t)) return false;
+            uint32_t bytes = t->len * sizeof(z_obj_t);
+            if (!flat_reloc((void **)&t->a, old_base, buf, len, bytes)) return false;
+            if (!flat_reloc((void **)&t->b, old_base, buf, len, bytes)) return false;
+            for (uint32_t i = 0; i < t->len; i++) {
+                if (t->a && !flat_relocate(&t->a[i], old_base, buf, len, depth + 1)) return false;
+                if (t->b && !flat_relocate(&t->b[i], old_base, buf, len, depth + 1)) return false;
+            }
+            return true;
+        }
+
+        default:
+            return true;
+
+    }
+
+}
+
+z_obj_t *z_obj_unflatten(void *buf, uint32_t len) {
+
+    z_obj_flat_t *h = (z_obj_flat_t *)buf;
+    if (!h || len < sizeof(z_obj_flat_t)) return NULL;
+    if (h->magic != Z_OBJ_FLAT_MAGIC || h->size < sizeof(z_obj_flat_t) || h->size > len)
+        return NULL;
+
+    // already relocated to right here
+    if (h->base == (uintptr_t)buf) return &h->root;
+
+    // a half-relocated buffer is useless, so mark it invalid up front
+    // and only restore the magic once every pointer checked out
+    uintptr_t old_base = h->base;
+    h->magic = 0;
+    if (!flat_relocate(&h->root, old_base, (uint8_t *)buf, h->size, 0)) return NULL;
+    h->base = (uintptr_t)buf;
+    h->magic = Z_OBJ_FLAT_MAGIC;
+
+    return &h->root;
+
+}
+
+// ARENAS
+//
+// see zobj.h
+
+#define ARENA_ALIGN(n)	(((n) + sizeof(void *) - 1) & ~(uint32_t)(sizeof(void *) - 1))
+
+void z_arena_init(z_arena_t *a, void *buf, uint32_t size) {
+    a->buf = (uint8_t *)buf;
+    a->size = buf ? size : 0;
+    a->used = 0;
+    a->owned = 0;
+}
+
+int z_arena_create(z_arena_t *a, uint32_t size) {
+    void *buf = malloc(size ? size : 1);
+    z_arena_init(a, buf, size);
+    if (!buf) return 0;
+    a->owned = 1;
+    return 1;
+}
+
+void z_arena_reset(z_arena_t *a) {
+    a->used = 0;
+}
+
+void z_arena_destroy(z_arena_t *a) {
+    if (a->owned) free(a->buf);
+    z_arena_init(a, NULL, 0);
+}
+
+void *z_arena_alloc(z_arena_t *a, uint32_t n) {
+    uint32_t need = ARENA_ALIGN(n ? n : 1);
+    if (need < n || need > a->size - a->used) return NULL;
+    void *p = a->buf + a->used;
+    a->used += need;
+    return p;
+}
+
+z_obj_t z_arena_str(z_arena_t *a, const char *s) {
+    uint32_t len = s ? strlen(s) : 0;
+    char *copy = z_arena_alloc(a, len + 1);
+    if (!copy) return z_obj_none();
+    if (len) memcpy(copy, s, len);
+    copy[len] = '\0';
+    return (z_obj_t){ .type = Z_STR, .val.str = copy };
+}
+
+z_obj_t z_arena_blob(z_arena_t *a, const void *data, uint32_t len) {
+    z_blob_t *b = z_arena_alloc(a, sizeof(z_blob_t));
+    uint8_t *bytes = z_arena_alloc(a, len);
+    if (!b || !bytes) return z_obj_none();  // what's left over just
+                                            // stays unused until reset
+    b->len = len;
+    b->data = bytes;
+    if (data && len) memcpy(bytes, data, len);
+    z_obj_t obj = { .type = Z_BLOB };
+    obj.val.ptr = b;
+    return obj;
+}
+
+// a table of `len` zeroed slots -- `b` too for a map
+static z_obj_t arena_table(z_arena_t *a, z_type_t type, uint32_t len, uint32_t flags) {
+    z_obj_table_t *t = z_arena_alloc(a, sizeof(z_obj_table_t));
+    uint32_t bytes = len * sizeof(z_obj_t);
+    z_obj_t *ka = (len && t) ? z_arena_alloc(a, bytes) : NULL;
+    z_obj_t *kb = (len && t && type == Z_MAP) ? z_arena_alloc(a, bytes) : NULL;
+    if (!t || (len && !ka) || (len && type == Z_MAP && !kb)) return z_obj_none();
+    if (ka) memset(ka, 0, bytes);
+    if (kb) memset(kb, 0, bytes);
+    t->len = len;
+    t->a = ka;
+    t->b = kb;
+    t->flags = flags;
+    t->count = 0;
+    z_obj_t obj = { .type = type };
+    obj.val.ptr = t;
+    return obj;
+}
+
+z_obj_t z_arena_list(z_arena_t *a, uint32_t len) {
+    return arena_table(a, Z_LIST, len, 0);
+}
+
+z_obj_t z_arena_map(z_arena_t *a, uint32_t len) {
+    return arena_table(a, Z_MAP, len, 0);
+}
+
+z_obj_t z_arena_hmap(z_arena_t *a, uint32_t len) {
+    return arena_table(a, Z_MAP, hmap_capacity(len), Z_TABLE_HASHED);
+}
+
+int z_arena_map_set(z_arena_t *a, z_obj_t *map, const char *key, z_obj_t value) {
+    if (!map || map->type != Z_MAP || !key) return 0;
+
+    z_obj_table_t *t = (z_obj_table_t *)map->val.ptr;
+    if (!t) return 0;
+
+    int found;
+    uint32_t i = map_slot(t, key, &found);
+    if (found) {
+        t->b[i] = value;  // the old value just stays in the arena
+        return 1;
+    }
+
+    // no growing in an arena: a hashed one was sized for its keys up
+    // front, and may fill past 3/4 rather than fail
+    if (i == SLOT_NONE) return 0; // No space available
+
+    z_obj_t k = z_arena_str(a, key);
+    if (k.type != Z_STR) return 0;
+    t->a[i] = k;
+    t->b[i] = value;
+    if (t->flags & Z_TABLE_HASHED) t->count++;
+    return 1;
 }
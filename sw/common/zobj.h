@@ -33,8 +33,14 @@ typedef struct {
     uint32_t len;
     z_obj_t *a;
     z_obj_t *b;
+    uint32_t flags;     // Z_TABLE_* -- 0 for an ordinary list/map
+    uint32_t count;     // Z_TABLE_HASHED: keys in use
 } z_obj_table_t;
 
+// a map built by z_obj_hmap()/z_arena_hmap(): keys sit where their
+// hash puts them rather than in insertion order (see below)
+#define Z_TABLE_HASHED  0x01
+
 // used by blobs (Z_BLOB) -- val.ptr points to one of these
 typedef struct {
     uint32_t len;
@@ -53,6 +59,7 @@ z_obj_t z_obj_float32(float f);
 z_obj_t z_obj_str(const char *s);
 z_obj_t z_obj_list(uint32_t len);
 z_obj_t z_obj_map(uint32_t len);
+z_obj_t z_obj_hmap(uint32_t len);   // hashed, room for len keys before it grows
 z_obj_t z_obj_blob(const void *data, uint32_t len);   // copies data
 
 // blob accessors -- return 0/NULL if obj isn't a Z_BLOB
@@ -81,4 +88,129 @@ z_obj_t *z_map_find(z_obj_t *map, const char *key);
 int z_list_append(z_obj_t *list, z_obj_t item);
 int z_map_set(z_obj_t *map, const char *key, z_obj_t value);
 
+// -- hashed maps --
+//
+// An ordinary map is a key column searched front to back, which is
+// the right thing for the handful of keys most messages carry, but
+// makes every z_map_find() on a big one a strcmp() per key. A map
+// made with z_obj_hmap() has the same two columns, sized to a power
+// of two and at most 3/4 full: a key goes in the slot its FNV-1a hash
+// picks, or the next free one after it, so z_map_find() usually looks
+// at one or two keys whatever the size. z_map_set() doubles the
+// columns and re-places every key once a new key would push it past
+// 3/4.
+//
+// Keys hash by their characters, not by anything process-local, and
+// empty slots are just Z_NONE keys -- so a hashed map is still a valid
+// map to everything that walks it by index (z_map_get_key(),
+// z_obj_free(), z_obj_print(), ...), and anything that copies a map
+// slot for slot (z_obj_copy(), z_obj_flatten(), the kernel translating
+// or copying a message) keeps it hashed and findable. Don't put keys
+// in a hashed map by writing the columns directly; go through
+// z_map_set()/z_arena_map_set().
+
+// -- flattened objects --
+//
+// A whole z_obj_t tree serialized into one contiguous buffer: a
+// z_obj_flat_t header, then every table, item array, blob header and
+// string the tree reaches, laid out in exactly the in-memory format
+// the rest of this API already reads -- except that every pointer is
+// stored relative to `base` (0 when freshly flattened, i.e. a plain
+// byte offset from the start of the buffer; 0 is still NULL, since
+// the header always occupies offset 0).
+//
+// z_obj_unflatten() relocates those pointers in place to wherever
+// the buffer now actually is -- one linear pass, no allocation -- and
+// returns the root, an ordinary tree that z_list_get()/z_map_find()
+// and friends work on directly. Doing it again at the same address
+// is free (base already matches); moving the buffer and doing it
+// again just re-relocates. Never z_obj_free() anything inside it:
+// the whole tree lives in the buffer, and goes away with it.
+//
+// This is what lets a message carry arbitrarily large structured
+// data -- see z_msg_send_flat() in zeitlos.h: a flattened tree travels
+// as a single Z_BLOB, which the kernel translates with one pointer,
+// instead of hitting zmsg.h's per-message table/item scratch limits.
+
+#define Z_OBJ_FLAT_MAGIC	0x544C465Au	// "ZFLT"
+#define Z_OBJ_FLAT_MAX_DEPTH	16	// list/map nesting limit
+
+typedef struct {
+    uint32_t magic;
+    uint32_t size;      // whole buffer, header included
+    uintptr_t base;     // what the pointers below are currently relative to
+    z_obj_t root;
+} z_obj_flat_t;
+
+// bytes z_obj_flatten() needs for obj, or 0 if it can't be flattened
+// (nested deeper than Z_OBJ_FLAT_MAX_DEPTH)
+uint32_t z_obj_flat_size(const z_obj_t *obj);
+
+// flattens obj into buf; returns the bytes used, or 0 if it doesn't
+// fit in `size` (or can't be flattened at all). buf must be aligned
+// for a pointer.
+uint32_t z_obj_flatten(const z_obj_t *obj, void *buf, uint32_t size);
+
+// allocates a Z_BLOB holding obj's flattened form (Z_NONE on failure)
+z_obj_t z_obj_flat(const z_obj_t *obj);
+
+// relocates a flattened buffer in place (see above); returns its root,
+// or NULL if buf isn't a valid flattened object of at most len bytes
+z_obj_t *z_obj_unflatten(void *buf, uint32_t len);
+
+// -- arenas --
+//
+// A bump allocator for building a z_obj_t tree somewhere other than
+// the heap: every z_arena_*() constructor below carves its tables,
+// item arrays, strings and blobs out of one buffer, and the whole
+// tree goes away at once with z_arena_reset() -- no per-node free(),
+// no heap fragmentation, and a hard, known bound on what a request
+// or reply can cost. The buffer is either the caller's own (a static
+// or a stack array -- z_arena_init(), no malloc() at all, so kernel
+// code can use it too) or one heap chunk (z_arena_create()).
+//
+// The result is an ordinary tree for everything that only reads it
+// (z_map_find(), z_msg_send(), z_obj_flatten(), ...). Never
+// z_obj_free() anything in it, and don't grow it with z_map_set()/
+// z_list_append() -- they copy onto the heap; use z_arena_map_set()
+// or set list items directly. As with any borrowed payload (zmsg.h),
+// don't reset an arena a sent message still points into until the
+// receiver is done with it.
+//
+// Running out of room fails the same way malloc() failing does:
+// constructors return Z_NONE, z_arena_map_set() returns 0.
+
+typedef struct {
+    uint8_t *buf;
+    uint32_t size;
+    uint32_t used;
+    uint32_t owned;     // buf came from z_arena_create()
+} z_arena_t;
+
+// an arena over the caller's own buffer (aligned for a pointer)
+void z_arena_init(z_arena_t *a, void *buf, uint32_t size);
+
+// an arena over one malloc()'d chunk; returns 0 if that fails
+int z_arena_create(z_arena_t *a, uint32_t size);
+
+// drops everything built in the arena, keeping the buffer
+void z_arena_reset(z_arena_t *a);
+
+// drops everything and frees the chunk, if z_arena_create() made it
+void z_arena_destroy(z_arena_t *a);
+
+// n bytes, pointer-aligned, or NULL if the arena is full
+void *z_arena_alloc(z_arena_t *a, uint32_t n);
+
+z_obj_t z_arena_str(z_arena_t *a, const char *s);
+z_obj_t z_arena_blob(z_arena_t *a, const void *data, uint32_t len);   // copies data
+z_obj_t z_arena_list(z_arena_t *a, uint32_t len);
+z_obj_t z_arena_map(z_arena_t *a, uint32_t len);
+z_obj_t z_arena_hmap(z_arena_t *a, uint32_t len);  // hashed, for up to len keys -- never grows
+
+// z_map_set() for a map built in `a`: the key is copied into the
+// arena, the value is stored as-is -- a scalar, or something already
+// built in the same arena
+int z_arena_map_set(z_arena_t *a, z_obj_t *map, const char *key, z_obj_t value);
+
 #endif
@@ -6,6 +6,7 @@
  */
 
 #include <stdio.h>
+#include <string.h>
 #include <stdint.h>
 #include <stdbool.h>
 
@@ -30,6 +31,22 @@
 // per-call override), and term.c's connect_port() for where the
 // telnet-specific call actually uses it.
 
+static void port_io_reset(z_port_t *port) {
+	port->chan = NULL;
+	port->tx = port->rx = NULL;
+	port->rx_taken = 0;
+	port->rx_blob = false;
+	port->tx_len = 0;
+	port->tx_unrung = false;
+}
+
+// done with this connection's channel, if it has one -- the kernel
+// frees it once the other end lets go too
+static void port_chan_release(z_port_t *port) {
+	if (port->chan) z_chan_close(port->chan);
+	port_io_reset(port);
+}
+
 z_rv z_port_connect(z_port_t *port, uint32_t provider_pid) {
 	return z_port_connect_arg(port, provider_pid, z_obj_none());
 }
@@ -48,6 +65,11 @@ z_rv z_port_connect_arg_timeout(z_port_t *port, uint32_t provider_pid,
 	port->peer_pid = provider_pid;
 	port->conn_id = 0;
 	port->connected = false;
+	port_io_reset(port);
+
+	// the provider's channel, if it opened one -- only used once
+	// CONNECTED confirms the connection is really ours
+	z_chan_pair_t *chan = NULL;
 
 	z_msg_new_send(provider_pid, Z_PORT_CONNECT, 0, arg);
 
@@ -58,9 +80,20 @@ z_rv z_port_connect_arg_timeout(z_port_t *port, uint32_t provider_pid,
 		z_msg_t msg;
 		if (z_msg_read(&msg) != Z_OK) continue;
 
+		if (msg.subject == Z_PORT_CHAN && msg.tag == 0 &&
+			msg.from == provider_pid && msg.obj.type == Z_UINT32) {
+			chan = (z_chan_pair_t *)(uintptr_t)msg.obj.val.uint32;
+			continue;
+		}
+
 		if (msg.subject == Z_PORT_CONNECTED && msg.tag == 0) {
 			port->conn_id = msg.obj.val.uint32;
 			port->connected = true;
+			if (chan && chan->ring[0].magic == Z_CHAN_MAGIC) {
+				port->chan = chan;
+				port->tx = z_chan_tx(chan, false);
+				port->rx = z_chan_rx(chan, false);
+			}
 			return Z_OK;
 		}
 
@@ -81,160 +114,241 @@ z_rv z_port_connect_arg_timeout(z_port_t *port, uint32_t provider_pid,
 			else
 				printf("zport: connect to pid %ld refused (no reason given)\n",
 					(long)provider_pid);
+			if (chan) z_chan_close(chan);
 			return Z_FAIL;
 		}
 
 		// not a reply to our CONNECT -- discard and keep waiting, same
 		// as z_msg_wait() (zeitlos.c) does for any RPC-style exchange
+		z_msg_release(&msg);
 
 	}
 
 	printf("zport: connect to pid %ld timed out after %ld ticks -- "
 		"provider never replied\n",
 		(long)provider_pid, (long)timeout_ticks);
+	if (chan) z_chan_close(chan);	// offered after all -- ours to drop
 	return Z_FAIL;	// timed out -- provider likely isn't running
 
 }
 
+// lets the peer know there's something in its ring, unless it
+// already has a wakeup coming that it hasn't acted on yet. Only a
+// hint: the peer drains its ring every pass of its loop whether or
+// not this arrives (z_port_recv() with no message, zport.h), so a
+// doorbell some other wait loop threw away costs latency, not data --
+// that drain is also what clears `notified` again.
+static void chan_ring(z_port_t *port) {
+
+	z_chan_t *tx = port->tx;
+	if (tx->notified) return;
+	tx->notified = 1;
+
+	z_msg_t bell;
+	bell.to = port->peer_pid;
+	bell.subject = Z_PORT_DATA;
+	bell.tag = port->conn_id;
+	bell.obj = z_obj_none();
+	if (z_msg_send_wait(&bell, Z_PORT_SEND_TIMEOUT_TICKS) != Z_OK)
+		tx->notified = 0;	// the next send rings again
+
+}
+
+// writes len bytes into the connection's channel, waiting for room
+// (up to Z_PORT_SEND_TIMEOUT_TICKS each time the ring fills) rather
+// than failing on a full ring -- a chunk bigger than the whole ring
+// just goes in ring-sized pieces as the peer drains it. `ring` false
+// leaves the doorbell for z_port_flush() (unless the ring fills
+// first -- then the peer has to hear about it to make room).
+static z_rv chan_send(z_port_t *port, const uint8_t *data, uint32_t len, bool ring) {
+
+	z_chan_t *tx = port->tx;
+
+	while (len) {
+
+		if (tx->closed) break;
+
+		uint32_t n = z_chan_write(tx, data, len);
+		data += n;
+		len -= n;
+		if (!len) break;
+
+		// full: make sure the peer knows there's something to drain,
+		// then ask to be woken before sleeping -- z_chan_wait()
+		// re-checks for room itself, so a reader that drained the
+		// ring in between doesn't leave us asleep
+		chan_ring(port);
+		uint32_t need = (len < tx->size) ? len : tx->size;
+		tx->writer_waiting = 1;
+		if (z_chan_room(tx) >= need) continue;
+		if (z_chan_wait(port->chan, need, Z_PORT_SEND_TIMEOUT_TICKS) != Z_OK) {
+			tx->writer_waiting = 0;
+			break;
+		}
+
+	}
+
+	// whatever did fit is still delivered
+	if (ring) chan_ring(port);
+	else port->tx_unrung = true;
+	return len ? Z_FAIL : Z_OK;
+
+}
+
+// one DATA message carrying data[0..len-1] as a kernel-copied blob
+static z_rv msg_send(z_port_t *port, const void *data, uint32_t len) {
+
+	// a blob header on the stack, pointing at the caller's own bytes
+	// -- the kernel copies both into the peer's arena (see zport.h), so
+	// neither has to outlive this call
+	z_blob_t blob = { .len = len, .data = (uint8_t *)data };
+
+	z_msg_t msg;
+	msg.to = port->peer_pid;
+	msg.subject = Z_PORT_DATA;
+	msg.tag = port->conn_id;
+	msg.obj.type = Z_BLOB;
+	msg.obj.val.ptr = &blob;
+
+	return z_msg_send_copy_wait(&msg, Z_PORT_SEND_TIMEOUT_TICKS);
+
+}
+
 z_rv z_port_send(z_port_t *port, const void *data, uint32_t len) {
 
 	if (!port->connected) return Z_FAIL;
 
-	// backpressure BEFORE allocating anything -- see zport.h's own
-	// Z_PORT_MAX_PENDING_SENDS/`pending` comments. A peer that's
-	// stopped acking (crashed, or has just fallen far behind) makes
-	// z_port_send() itself refuse further sends this way, rather than
-	// letting them leak without bound the way this function used to --
-	// see this function's own header comment (zport.h) for the full
-	// before/after story.
-	if (port->pending_count >= Z_PORT_MAX_PENDING_SENDS) return Z_FAIL;
-
-	z_obj_t obj = z_obj_blob(data, len);
-
-	// z_obj_blob() (zobj.c) returns Z_NONE instead of a broken object
-	// when its internal malloc() fails (see that function's own
-	// comment), but z_msg_send() below would still report Z_OK for a
-	// Z_NONE payload -- from the caller's perspective this call would
-	// look like it "succeeded" while silently sending nothing at all.
-	// Surface it here instead of leaving it invisible -- this is what
-	// caught a real Z_PROC_STACK_SIZE-too-small bug (sw/os/kernel.c)
-	// on real hardware, where even a 2-byte allocation failed.
-	if (obj.type != Z_BLOB) {
-		if (len > 0)
-			printf("zport: z_obj_blob() failed to allocate %lu bytes -- "
-				"heap likely exhausted\n", (unsigned long)len);
-		return Z_FAIL;
-	}
+	// anything z_port_write() still has goes first, so bytes stay in
+	// the order they were written
+	z_rv rv = z_port_flush(port);
+	if (port->tx) return chan_send(port, (const uint8_t *)data, len, true);
+	if (rv != Z_OK) return rv;
+	return msg_send(port, data, len);
 
-	z_rv rv = z_msg_new_send(port->peer_pid, Z_PORT_DATA, port->conn_id, obj);
-
-	if (rv != Z_OK) {
-		// never delivered (most likely: the peer's mailbox is full) --
-		// no ack will ever arrive for this one, so free it right here
-		// instead of leaking it forever. The one case
-		// z_port_handle_ack() can't cover on its own -- see that
-		// function's own comment. Deliberately NOT pushed onto
-		// `pending` below -- pushing it would leave a permanent gap
-		// in the FIFO with no ack ever coming to pop it, misaligning
-		// every later entry.
-		z_obj_free(&obj);
-		return rv;
-	}
+}
+
+z_rv z_port_write(z_port_t *port, const void *data, uint32_t len) {
+
+	if (!port->connected) return Z_FAIL;
+	if (port->tx) return chan_send(port, (const uint8_t *)data, len, false);
+
+	if (port->tx_len + len > Z_PORT_COALESCE_SIZE && z_port_flush(port) != Z_OK)
+		return Z_FAIL;
 
-	// pushed onto the TAIL of *port's own FIFO -- z_port_handle_ack()
-	// pops from the HEAD, on the strength of the ordering guarantee
-	// its own comment (zport.h) explains, once the peer's own
-	// z_port_send_ack() (called from ITS handler for this exact
-	// Z_PORT_DATA, once it's genuinely done reading the payload)
-	// reports it's safe to.
-	z_blob_t *b = (z_blob_t *)obj.val.ptr;
-	uint32_t tail = (port->pending_head + port->pending_count) % Z_PORT_MAX_PENDING_SENDS;
-	port->pending[tail].header = b;
-	port->pending_count++;
+	// too big to be worth buffering at all
+	if (len > Z_PORT_COALESCE_SIZE) return msg_send(port, data, len);
 
+	memcpy(&port->tx_buf[port->tx_len], data, len);
+	port->tx_len += len;
 	return Z_OK;
 
 }
 
+z_rv z_port_flush(z_port_t *port) {
+
+	if (!port->connected) return Z_FAIL;
+
+	if (port->tx) {
+		if (port->tx_unrung) {
+			port->tx_unrung = false;
+			chan_ring(port);
+		}
+		return Z_OK;
+	}
+
+	if (!port->tx_len) return Z_OK;
+	uint32_t len = port->tx_len;
+	port->tx_len = 0;	// sent or dropped -- either way, not again
+	return msg_send(port, port->tx_buf, len);
+
+}
+
 void z_port_close(z_port_t *port) {
 	if (!port->connected) return;
+	z_port_flush(port);
 	z_msg_new_send(port->peer_pid, Z_PORT_CLOSE, port->conn_id, z_obj_none());
 	port->connected = false;
+	port_chan_release(port);
 }
 
-// bounded retry window for z_port_send_ack() below -- short on
-// purpose, see that function's own header comment (zport.h) for why:
-// the only realistic failure mode is the receiving mailbox being
-// transiently busy, which resolves within a scheduling slice or two,
-// not something worth a long wait over. Same ~732Hz tick rate used
-// throughout this codebase (docs/networking.md's "z_uptime_ticks()").
-#define Z_PORT_ACK_RETRY_TICKS (732 / 2)	// ~0.5s
-
-void z_port_send_ack(const z_msg_t *data_msg) {
-
-	if (data_msg->obj.type != Z_BLOB) return;	// nothing to ack -- malformed DATA
-
-	uint32_t start = z_uptime_ticks();
-
-	do {
+void z_port_closed(z_port_t *port) {
+	port->connected = false;
+	port_chan_release(port);
+}
 
-		if (z_msg_new_send(data_msg->from, Z_PORT_DATA_ACK, data_msg->tag,
-			z_obj_none()) == Z_OK) return;
+uint32_t z_port_recv(z_port_t *port, const z_msg_t *data_msg, const uint8_t **data) {
 
-		// z_msg_send() failing here means data_msg->from's own mailbox
-		// is full right now -- retrying immediately (rather than
-		// giving up, the way z_port_send() itself does for the
-		// original DATA send) is deliberate: see this function's own
-		// header comment (zport.h) for why a lost ack is a much worse
-		// failure than a lost DATA message. No explicit yield needed
-		// between attempts -- this system schedules preemptively
-		// (sw/os/kernel.c, KTIMER-driven round-robin), so even a tight
-		// retry loop like this one gets interrupted regularly, giving
-		// the peer real chances to drain its own mailbox in between.
+	// a plain DATA message: its blob, once. NULL (the per-pass poll)
+	// only ever looks at the ring.
+	if (data_msg && !port->rx_blob && data_msg->obj.type == Z_BLOB) {
+		port->rx_blob = true;
+		uint32_t len = z_blob_len(&data_msg->obj);
+		*data = (const uint8_t *)z_blob_data(&data_msg->obj);
+		if (*data && len) return len;
+	}
 
-	} while ((z_uptime_ticks() - start) < Z_PORT_ACK_RETRY_TICKS);
+	z_chan_t *rx = port->rx;
 
-	// still failing after a genuine retry window -- something worse
-	// than transient congestion is going on. z_port_send()'s own
-	// backpressure (Z_PORT_MAX_PENDING_SENDS) is the correct backstop
-	// from here, same as it already is for a peer that's stopped
-	// acking entirely -- nothing more productive to do on this side.
-	printf("zport: failed to deliver ack to pid %ld after retrying for "
-		"%ld ticks -- its mailbox may be stuck\n",
-		(long)data_msg->from, (long)Z_PORT_ACK_RETRY_TICKS);
+	if (!rx) {
+		port->rx_blob = false;	// ready for the next message
+		return 0;
+	}
 
-}
+	// the span handed out last time is finished with now
+	if (port->rx_taken) {
+		if (z_chan_consume(rx, port->rx_taken)) z_chan_wake(port->chan);
+		port->rx_taken = 0;
+	}
 
-void z_port_handle_ack(z_port_t *port, const z_msg_t *msg) {
+	uint32_t len = z_chan_peek(rx, data);
 
-	if (!port->connected || msg->tag != port->conn_id) return;
-	if (port->pending_count == 0) return;	// stale/duplicate ack -- nothing outstanding
+	if (!len) {
+		// empty: the writer has to ring again for whatever it writes
+		// next -- then one more look, for bytes that landed after the
+		// peek above but before it saw `notified` go clear
+		rx->notified = 0;
+		len = z_chan_peek(rx, data);
+	}
 
-	// pops the OLDEST outstanding entry, unconditionally -- see
-	// z_port_t's own comment on `pending` for why this is correct:
-	// mailboxes are FIFO per sender/receiver pair, every current DATA
-	// receiver acks exactly once, in read order, and z_port_send_ack()
-	// itself guarantees that ack reliably arrives -- so the Nth ack
-	// back always corresponds to the Nth still-outstanding send.
-	uint32_t i = port->pending_head;
+	if (!len) {
+		port->rx_blob = false;
+		return 0;
+	}
 
-	// reuses zobj.c's own general-purpose Z_BLOB destructor (frees
-	// both the header and its ->data) rather than duplicating that
-	// logic here -- port->pending[i].header is exactly the val.ptr
-	// z_obj_blob() originally returned.
-	z_obj_t blob = { .type = Z_BLOB, .val.ptr = port->pending[i].header };
-	z_obj_free(&blob);
+	port->rx_taken = len;
+	return len;
 
-	port->pending_head = (port->pending_head + 1) % Z_PORT_MAX_PENDING_SENDS;
-	port->pending_count--;
+}
 
+void z_port_data_done(const z_msg_t *data_msg) {
+	// const only in the handlers' view -- every DATA is a z_msg_t the
+	// receiver read into its own (writable) memory, and the release
+	// does clear its _kbuf, so a second call is a no-op
+	z_msg_release((z_msg_t *)data_msg);
 }
 
 void z_port_accept(z_port_t *out_port, const z_msg_t *connect_msg, uint32_t conn_id) {
-	out_port->peer_pid = connect_msg->from;
+	z_port_accept_pid(out_port, connect_msg->from, conn_id);
+}
+
+void z_port_accept_pid(z_port_t *out_port, uint32_t client_pid, uint32_t conn_id) {
+	out_port->peer_pid = client_pid;
 	out_port->conn_id = conn_id;
 	out_port->connected = true;
-	z_msg_new_send(connect_msg->from, Z_PORT_CONNECTED, 0, z_obj_uint32(conn_id));
+	port_io_reset(out_port);
+	// no channel (none left, or no memory) just means plain DATA
+	// messages for this connection, which both ends still understand
+	z_chan_pair_t *chan = z_chan_open(client_pid);
+	if (chan) {
+		out_port->chan = chan;
+		out_port->tx = z_chan_tx(chan, true);
+		out_port->rx = z_chan_rx(chan, true);
+		// before CONNECTED, so the client has it by the time it
+		// knows it's connected
+		z_msg_new_send(client_pid, Z_PORT_CHAN, 0,
+			z_obj_uint32((uint32_t)(uintptr_t)chan));
+	}
+	z_msg_new_send(client_pid, Z_PORT_CONNECTED, 0, z_obj_uint32(conn_id));
 }
 
 void z_port_refuse(const z_msg_t *connect_msg, const char *reason) {
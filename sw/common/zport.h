@@ -22,46 +22,47 @@
  * client pair doesn't (yet) use.
  *
  *   CONNECT   client -> provider   tag=0         obj=Z_NONE
+ *   CHAN      provider -> client   tag=0         obj=Z_UINT32(channel address)
  *   CONNECTED provider -> client   tag=0         obj=Z_UINT32(conn_id)
  *   REFUSED   provider -> client   tag=0         obj=Z_STR(reason)
- *   DATA      either direction     tag=conn_id   obj=Z_BLOB
- *   DATA_ACK  either direction     tag=conn_id   obj=Z_NONE
+ *   DATA      either direction     tag=conn_id   obj=Z_BLOB (kernel-owned copy),
+ *                                                or Z_NONE (channel doorbell)
  *   CLOSE     either direction     tag=conn_id   obj=Z_NONE
  *
  * DATA/CLOSE aren't wrapped in a blocking helper -- a connected app's
  * own message loop should recognize Z_PORT_DATA/Z_PORT_CLOSE by
  * subject directly (same as it already does for e.g. Z_WM_KEY),
- * using z_blob_data()/z_blob_len() (zobj.h) on a DATA message's
- * payload, and msg.tag to find which z_port_t it belongs to (matters
+ * using z_port_recv() below to get at the bytes, and msg.tag to find
+ * which z_port_t it belongs to (matters
  * for a provider juggling more than one connection; a client with
  * exactly one connection can just check msg.tag == port.conn_id, or
  * skip the check if there's genuinely only ever one).
  *
- * DATA_ACK: sent by whichever side just finished READING a DATA
- * message's payload, back to whoever sent it -- see
- * z_port_send_ack()/z_port_handle_ack() below, and docs/messaging.md's
- * "Known limitations" for the full design writeup: why this exists
- * (z_port_send()'s own z_obj_blob() allocation used to just leak,
- * forever, on every call -- see that function's own comment), why it
- * has to be sent by the receiving app's own code once it's genuinely
- * done reading the payload rather than automatically the moment
- * z_msg_read() returns, and why the sender matches an incoming ack to
- * a pending send by FIFO ORDER (the oldest still-outstanding one),
- * not by any value the ack carries -- a pointer isn't safely
- * comparable across the process boundary here (see z_port_t's own
- * comment on `pending` for exactly why). The payload is just Z_NONE:
- * nothing needs identifying, since which specific send an ack "is
- * for" is never actually in question -- it's whichever one's oldest.
- * What that DOES depend on -- that an ack, once sent, reliably
- * arrives -- z_port_send_ack() itself guarantees with a short bounded
- * retry, since this is the one place a lost message would silently
- * break that ordering guarantee (see its own comment for the
- * real-hardware bug that motivated this).
- * Every current DATA sender/receiver in this codebase (`sw/apps/net`'s
- * telnet relay, `repl`, `term`, `portdemo`) sends/handles this now --
- * a future DATA consumer should too, or z_port_send() to it will
- * eventually backpressure (see Z_PORT_MAX_PENDING_SENDS below) once
- * enough sends go unacked.
+ * DATA is sent with z_msg_send_copy() (zmsg.h): the kernel copies the
+ * bytes into the receiver's mailbox arena, so z_port_send() has
+ * nothing of its own left to free once it returns, and the receiver
+ * hands the copy back with z_port_data_done() once it has genuinely
+ * finished reading it -- which is also what lets a z_port_send()
+ * parked on a full arena carry on. This replaced DATA_ACK -- a message back to the
+ * sender for every DATA, so it knew when its own z_obj_blob() copy
+ * could be freed, with a FIFO of outstanding sends on each side and a
+ * retry loop to make sure no ack ever got lost (docs/messaging.md's
+ * "Known limitations" has that history). Every current DATA receiver
+ * (`sw/apps/net`'s telnet relay, `repl`, `term`, `portdemo`) calls
+ * z_port_data_done(); a future one has to as well, or the arena fills
+ * and z_port_send() to it starts failing.
+ *
+ * Channels: z_port_accept() also opens a channel (zchan.h) to the
+ * client when it can and sends its address (CHAN) just ahead of
+ * CONNECTED. From then on z_port_send() copies bytes straight into
+ * the channel's ring -- no syscall, no kernel copy -- and DATA is only
+ * a doorbell, sent when the peer wasn't already expecting one: a burst
+ * of sends costs one message, not one each. z_port_recv() reads from
+ * whichever the connection has, so receivers don't care which --
+ * except that a doorbell is only a hint, so they also drain the ring
+ * every pass of their loop (see z_port_recv() below). A
+ * provider that's out of channels (Z_CHAN_MAX system-wide) just
+ * leaves that connection on plain DATA messages.
  */
 
 #include <stdint.h>
@@ -70,13 +71,15 @@
 #include "zeitlos.h"
 #include "zobj.h"
 #include "zmsg.h"
+#include "zchan.h"
 
 #define Z_PORT_CONNECT    120
 #define Z_PORT_CONNECTED  121
 #define Z_PORT_REFUSED    122
 #define Z_PORT_DATA       123
 #define Z_PORT_CLOSE      124
-#define Z_PORT_DATA_ACK   125
+#define Z_PORT_DATA_ACK   125	// retired (see above) -- not reused
+#define Z_PORT_CHAN       126
 
 // fallback pid for the demo virtual port (sw/apps/portdemo) if name
 // lookup ("portdemo0") fails -- same convention as Z_PID_WM (zwm.h) /
@@ -93,18 +96,10 @@
 // convention itself, just not a live guarantee right now.
 #define Z_PID_PORTDEMO   3
 
-// how many z_port_send() calls can be outstanding (sent, not yet
-// acked) at once, per connection -- see z_port_send()/
-// z_port_handle_ack() (zport.c). Small and fixed on purpose: once
-// full, z_port_send() itself refuses new sends (returns Z_FAIL)
-// rather than growing this without bound -- see that function's own
-// comment for why. In practice this rarely holds more than one or two
-// entries at a time: a receiver like `term` consumes a DATA message's
-// bytes synchronously, in the very call that reads it (vt_feed(),
-// term.c), so the matching ack is usually only a scheduling slice or
-// two behind the send -- this headroom is for a peer that's fallen
-// further behind than that, not the common case.
-#define Z_PORT_MAX_PENDING_SENDS 8
+// how much z_port_write() gathers into one DATA message, on a
+// connection without a channel, before it sends without waiting for
+// z_port_flush() -- a line or two of terminal output, or a short paste
+#define Z_PORT_COALESCE_SIZE 256
 
 typedef struct {
 	uint32_t peer_pid;	// who DATA/CLOSE go to -- the provider if
@@ -114,43 +109,20 @@ typedef struct {
 	uint32_t conn_id;	// used as the message tag for DATA/CLOSE
 	bool connected;
 
-	// z_port_send()'s own outstanding-blob bookkeeping -- a genuine
-	// FIFO queue, freed in the order it was sent, on the strength of
-	// two guarantees this codebase already provides: mailboxes are a
-	// strict FIFO ring per sender/receiver pair (sw/os/msg.c), and
-	// every current DATA receiver acks exactly once, in read order.
-	// So the Nth ack to arrive always corresponds to the Nth still-
-	// outstanding send -- "just free the oldest pending entry on any
-	// ack" is correct without needing to identify which one by any
-	// transmitted value at all (deliberately not by the payload's own
-	// pointer: a pointer z_obj_blob() returns is only meaningful in
-	// the SENDING process's own address space -- P.base + (vaddr -
-	// 0x80000000) in physical terms, sw/os/msg.c's own header comment
-	// -- and there's no way for the sender to redo that translation
-	// itself later to check an ack against). The one thing this
-	// approach genuinely depends on -- that an ack, once its receiver
-	// decides to send one, actually arrives -- is z_port_send_ack()'s
-	// own job to guarantee; see its comment for how. Not meant to be
-	// read or written directly by callers, same as peer_pid/conn_id
-	// aren't -- this table starts correctly empty the same way they
-	// start correctly zeroed: every current caller relies on plain
-	// `static`/global `z_port_t` storage (portdemo.c's `conn`,
-	// term.c's `port`, each of repl.c's `conns[].port`) getting
-	// zero-initialized `.bss`, confirmed reliable for every app binary
-	// here (each one's own Makefile zero-pads its `.bin` up through
-	// `_end` -- see docs/networking.md's "objcopy truncation bug" for
-	// the one place that assumption was ever actually false, and why
-	// it isn't anymore).
-	struct {
-		void *header;	// the z_blob_t* z_obj_blob() returned via
-						// obj.val.ptr at send time -- the only thing
-						// actually needed to free it (z_obj_free()
-						// derives ->data from this itself)
-	} pending[Z_PORT_MAX_PENDING_SENDS];
-	uint32_t pending_head;	// index of the OLDEST outstanding entry --
-							// only meaningful while pending_count > 0
-	uint32_t pending_count;	// how many entries are currently queued,
-							// 0..Z_PORT_MAX_PENDING_SENDS
+	// the connection's channel (NULL: plain DATA messages) and the
+	// ring in it this end writes / reads -- set up by z_port_connect()
+	// and z_port_accept(), dropped by z_port_close()/z_port_closed()
+	z_chan_pair_t *chan;
+	z_chan_t *tx;
+	z_chan_t *rx;
+	uint32_t rx_taken;	// bytes z_port_recv() last handed out
+	bool rx_blob;		// z_port_recv() has had this DATA's blob
+
+	// z_port_write()'s side: bytes not yet sent as a DATA (no
+	// channel), or written into the ring without a doorbell yet
+	uint8_t tx_buf[Z_PORT_COALESCE_SIZE];
+	uint32_t tx_len;
+	bool tx_unrung;
 
 } z_port_t;
 
@@ -219,115 +191,86 @@ z_rv z_port_connect_arg_timeout(z_port_t *port, uint32_t provider_pid,
 
 // -- client OR provider side, once connected --
 
-// sends a chunk of data. fire-and-forget from the CALLER's
-// perspective -- see docs/ports.md's "Flow control: an explicit,
-// deliberate gap for v1" for why this still doesn't wait for
-// anything or retry on its own; a caller with nothing better to do on
-// Z_FAIL can just drop the chunk, same as before.
-//
-// Internally builds a Z_BLOB (z_obj_blob(), zobj.c -- a real heap
-// copy of `data`) and tracks it in *port's own small pending-sends
-// table until the peer's own z_port_send_ack() (called once ITS
-// handler for the resulting Z_PORT_DATA has genuinely finished
-// reading the payload) reports it's safe to free -- see
-// z_port_handle_ack() below for the other half of this, and
-// docs/messaging.md's "Known limitations" for the full design
-// writeup, including why an earlier "just free the previous call's
-// blob at the start of the next one" scheme was tried and reverted
-// (a real, confirmed-on-hardware corruption bug: that assumption
-// broke whenever a caller made several sends back-to-back with
-// nothing in between to force a scheduler switch, e.g. `repl`'s own
-// handle_connect() sending a banner then a prompt immediately).
+// how long z_port_send() waits for room at a peer that's fallen
+// behind, ~1/8 second -- long enough to ride out a burst (a paste, a
+// screenful of output), short enough that two peers each stuck
+// sending to the other, both full, only stall that long rather than
+// for good.
+#define Z_PORT_SEND_TIMEOUT_TICKS (732 / 8)
+
+// sends a chunk of data. If the peer's mailbox or copy arena is full,
+// waits (z_msg_send_copy_wait(), zeitlos.h) up to
+// Z_PORT_SEND_TIMEOUT_TICKS for it to catch up instead of failing
+// straight away -- see docs/ports.md's "Flow control". Z_FAIL, with
+// nothing sent, only if it still hasn't by then (or the peer's gone);
+// a caller with nothing better to do can just drop the chunk. Over a
+// channel it's the ring that fills instead, with the same wait --
+// but there a Z_FAIL may have delivered the start of the chunk.
 //
-// Returns Z_FAIL, and doesn't even attempt the send, if the pending
-// table is already full (Z_PORT_MAX_PENDING_SENDS) -- a real, if
-// rarely hit, backpressure case: it means the peer has fallen far
-// enough behind on acking that letting this grow further would just
-// reproduce the original unbounded-leak problem under a different
-// name. Also frees the blob immediately, right here, if the
-// underlying z_msg_send() itself fails (peer's mailbox full) -- that
-// message was never delivered, so no ack for it will ever arrive; see
-// z_port_handle_ack()'s own comment for why this is the one case that
-// mechanism can't cover on its own.
+// `data` is copied (by the kernel, z_msg_send_copy() in zmsg.h, or
+// into the channel's ring) before this returns, so the caller can
+// reuse it straight away and nothing is allocated on this side at all.
 z_rv z_port_send(z_port_t *port, const void *data, uint32_t len);
 
+// z_port_send(), but coalesced: small writes pile up -- in tx_buf, or
+// straight in the channel's ring -- and go to the peer as ONE DATA
+// message (or doorbell) at the next z_port_flush(), or as soon as
+// Z_PORT_COALESCE_SIZE bytes are waiting. For output produced a
+// fragment at a time -- an echo, then the result, then a prompt; a
+// burst of keystrokes -- where one message per fragment would be
+// mostly overhead for the peer's mailbox. Z_FAIL only if a send it had
+// to make on the way failed (see z_port_send()).
+z_rv z_port_write(z_port_t *port, const void *data, uint32_t len);
+
+// sends whatever z_port_write() has gathered. Call it once per pass
+// of your message loop, after handling everything that was waiting
+// -- that's the flush interval: nothing sits in the buffer past the
+// point where you'd go back to waiting for input. z_port_send() and
+// z_port_close() flush first themselves, so bytes never reorder.
+z_rv z_port_flush(z_port_t *port);
+
 // tells the peer this connection is done. does not wait for any
 // acknowledgment.
 void z_port_close(z_port_t *port);
 
-// call once your own handler for a received Z_PORT_DATA message has
-// GENUINELY finished reading its payload -- not right after
-// z_msg_read() returns. Those aren't the same moment: z_msg_read()
-// only resolves the pointer, it doesn't mean your own handler code
-// has actually read through the bytes yet, and under this system's
-// preemptive scheduling (sw/os/kernel.c, KTIMER-driven round-robin)
-// your handler could in principle be interrupted mid-read -- if the
-// ORIGINAL SENDER got scheduled next and freed on an ack sent that
-// early, it could free memory your own handler hasn't finished
-// reading, reintroducing the exact corruption class z_port_send()'s
-// own header comment describes. Call this at the point your handler
-// would otherwise just return -- e.g. right after term.c's vt_feed()
-// call, not right after the z_msg_read() that produced `data_msg`.
+// call from your handler for the PEER's Z_PORT_CLOSE instead of just
+// clearing port->connected yourself -- this also lets go of the
+// connection's channel, which is otherwise only freed when this
+// process exits.
+void z_port_closed(z_port_t *port);
+
+// the bytes a received Z_PORT_DATA brought, a run at a time: points
+// *data at the next run and returns its length, 0 once there's
+// nothing more. Call it in a loop until it returns 0, then
+// z_port_data_done():
 //
-// Retries internally, with a short bounded timeout, if the underlying
-// send fails -- unlike z_port_send() itself, this one CAN'T just give
-// up and drop it. z_port_handle_ack() (below) trusts that every DATA
-// message eventually gets exactly one ack, in order, to know which
-// pending send to free -- a lost ack isn't just one missed
-// notification, it permanently shifts that ordering for every send
-// after it, since there's no longer a 1:1 correspondence between
-// sends and acks for the sender to fall back on. Confirmed on real
-// hardware: `z_port_send_ack()` originally didn't check its own
-// z_msg_new_send() call's return value at all, and a receiver's
-// mailbox being momentarily full (the same kind of keystroke burst
-// documented in docs/ports.md's "Flow control" section) could drop an
-// ack silently -- from that point on, every later ack the sender
-// received got matched against the WRONG pending entry, compounding
-// rather than self-correcting, and eventually reproducing the
-// original unbounded-backpressure problem by a different path (each
-// lost ack permanently costs one slot of Z_PORT_MAX_PENDING_SENDS,
-// forever, even though nothing was actually still outstanding). The
-// retry here is short and bounded on purpose -- an ack is tiny (no
-// allocation at all, see below), and its only realistic failure mode
-// is the receiving mailbox being transiently busy, which resolves
-// within the receiver's own next scheduling slice or two, not
-// something worth a long wait over. If it's still failing once the
-// timeout's up, something worse than transient congestion is going
-// on -- this logs it and gives up, at which point z_port_send()'s own
-// backpressure (Z_PORT_MAX_PENDING_SENDS) is the correct backstop,
-// same as it already is for a peer that's stopped acking entirely.
+//	while ((len = z_port_recv(&port, &msg, &data)) > 0)
+//		vt_feed(&vt, data, len);
+//	z_port_data_done(&msg);
 //
-// Payload is just Z_NONE -- nothing needs to be identified (see
-// z_port_handle_ack()'s own comment for why), so there's nothing to
-// send beyond the bare fact that an ack happened.
+// Over a channel, a run points straight into the ring, so it's only
+// valid until the next call -- which hands its space back to the
+// writer. Only call it for a DATA whose tag matches this port.
 //
-// Safe to call for a zero-length or malformed DATA message too (a
-// no-op in that case, nothing to ack).
-void z_port_send_ack(const z_msg_t *data_msg);
+// A channel's DATA is only a doorbell, and one can go missing: any
+// loop that waits for one particular reply (z_msg_wait(), zstream's
+// waits, a splice) discards whatever else arrives meanwhile. So also
+// call it with `data_msg` NULL -- just the ring, no message -- once
+// per pass of your message loop, for every connected port, the same
+// way you call z_port_flush(); it returns 0 straight away for a port
+// with no channel.
+uint32_t z_port_recv(z_port_t *port, const z_msg_t *data_msg, const uint8_t **data);
 
-// call from your own message loop when msg->subject ==
-// Z_PORT_DATA_ACK, with the z_port_t the ack is for. If you're
-// juggling more than one connection (e.g. repl.c's conns[]), find the
-// right one by msg->tag == port->conn_id first -- same lookup
-// Z_PORT_DATA/Z_PORT_CLOSE already need.
-//
-// Frees the OLDEST still-outstanding z_obj_blob() allocation *port's
-// own earlier z_port_send() calls made -- a genuine FIFO queue (see
-// z_port_t's own comment on `pending`), not matched against anything
-// the ack itself carries. This works because mailboxes are FIFO per
-// sender/receiver pair, every current DATA receiver acks exactly
-// once, in the order it read each message, AND z_port_send_ack()
-// itself guarantees that ack reliably arrives (its own comment
-// explains why that last part specifically had to be guaranteed, not
-// just assumed) -- so the Nth ack to arrive back always corresponds
-// to the Nth still-outstanding send, with no need to identify which
-// one by value at all.
-//
-// Safe to call defensively any time this subject shows up, not just
-// when you're sure it's fresh and valid: a no-op if the port isn't
-// connected, the tag doesn't match, or nothing is currently pending
-// (a stale/duplicate ack).
-void z_port_handle_ack(z_port_t *port, const z_msg_t *msg);
+// call once your own handler for a received Z_PORT_DATA message has
+// GENUINELY finished reading its payload -- not right after
+// z_msg_read() returns -- e.g. right after term.c's vt_feed() call.
+// Hands the kernel's copy of the bytes back (z_msg_release(), zmsg.h);
+// `data_msg`'s payload is gone after this. Call it for every DATA
+// message you read, including ones you end up ignoring (stale
+// connection, malformed payload) -- an unreleased one holds up reuse
+// of the arena space behind it. Safe on any message (a no-op on one
+// that isn't a kernel-owned copy).
+void z_port_data_done(const z_msg_t *data_msg);
 
 // -- provider side --
 
@@ -338,6 +281,12 @@ void z_port_handle_ack(z_port_t *port, const z_msg_t *msg);
 // this connection from here on, in both directions.
 void z_port_accept(z_port_t *out_port, const z_msg_t *connect_msg, uint32_t conn_id);
 
+// z_port_accept() for a provider that only decides to accept some
+// time after the CONNECT arrived, once that message is gone -- e.g.
+// sw/apps/net's telnet port, which waits for its TCP handshake first.
+// client_pid is the CONNECT's msg.from.
+void z_port_accept_pid(z_port_t *out_port, uint32_t client_pid, uint32_t conn_id);
+
 // call instead of z_port_accept() to decline a connection (e.g. a
 // provider that only supports one client at a time, already in use).
 void z_port_refuse(const z_msg_t *connect_msg, const char *reason);
@@ -28,37 +28,41 @@ z_rv z_repl_eval(uint32_t repl_pid, const char *code,
 
 	uint32_t tag = next_tag++;
 
-	z_msg_new_send(repl_pid, Z_REPL_EVAL, tag, z_obj_str(code));
-
-	uint32_t start = z_uptime_ticks();
-
-	while ((z_uptime_ticks() - start) < timeout_ticks) {
-
-		z_msg_t msg;
-		if (z_msg_read(&msg) != Z_OK) continue;
-
-		if (msg.tag != tag) continue; // not a reply to our request
-
-		if (msg.subject == Z_REPL_RESULT || msg.subject == Z_REPL_ERROR) {
-
-			*is_error = (msg.subject == Z_REPL_ERROR);
-
-			if (msg.obj.type == Z_STR && msg.obj.val.str) {
-				snprintf(out, out_cap, "%s", msg.obj.val.str);
-			} else {
-				out[0] = 0;
-			}
-
-			return Z_OK;
-
+	// 0 has always meant "don't wait at all" here, where to
+	// z_msg_call() it means "forever"
+	if (!timeout_ticks) return Z_FAIL;
+
+	// one z_msg_call() (zeitlos.h): sleeps until repl's reply with
+	// this tag arrives, leaving anything else that turns up meanwhile
+	// in our mailbox for the caller's own loop rather than discarding
+	// it. `code` is borrowed by repl until it replies, which is
+	// exactly as long as we're blocked here.
+	z_msg_t msg;
+	msg.to = repl_pid;
+	msg.subject = Z_REPL_EVAL;
+	msg.tag = tag;
+	msg.obj = z_obj_str(code);
+
+	if (z_msg_call(&msg, timeout_ticks) != Z_OK)
+		return Z_FAIL; // timed out -- repl likely isn't running
+
+	z_rv rv = Z_FAIL;
+
+	if (msg.subject == Z_REPL_RESULT || msg.subject == Z_REPL_ERROR) {
+
+		*is_error = (msg.subject == Z_REPL_ERROR);
+
+		if (msg.obj.type == Z_STR && msg.obj.val.str) {
+			snprintf(out, out_cap, "%s", msg.obj.val.str);
+		} else {
+			out[0] = 0;
 		}
 
-		// not a reply to our request -- discard and keep waiting,
-		// same as z_port_connect()/z_msg_wait() do for any RPC-style
-		// exchange
+		rv = Z_OK;
 
 	}
 
-	return Z_FAIL; // timed out -- repl likely isn't running
+	z_msg_release(&msg);
+	return rv;
 
 }
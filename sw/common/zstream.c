@@ -18,12 +18,13 @@
 // readline()/echo()/noecho(), which collide with kruntime.c's own
 // definitions in the kernel build (the same reason sh.c has its own
 // separate msg.c instead of linking zeitlos.c). declaring just the
-// four functions this file actually needs keeps it buildable into
+// five functions this file actually needs keeps it buildable into
 // either an app (linking zeitlos.o) or the kernel (linking msg.o)
 // unmodified -- both provide matching signatures (see msg.h's
 // comment on z_msg_send for why).
 z_rv z_msg_send(z_msg_t *msg);
 z_rv z_msg_read(z_msg_t *msg);
+z_rv z_msg_release(z_msg_t *msg);
 z_rv z_msg_new_send(uint32_t to, uint32_t subject, uint32_t tag, z_obj_t obj);
 uint32_t z_uptime_ticks(void);
 
@@ -45,22 +46,49 @@ static void set_err(char *err, uint32_t err_len, const char *msg) {
 static uint32_t next_stream_id = 1;	// 0 reserved as "no stream" (see
 					// zstream_reject())
 
-static uint32_t next_seq(zstream_producer_t *st) {
+static uint32_t next_seq(const zstream_producer_t *st) {
 	return (st->seq == UINT32_MAX) ? 0 : (st->seq + 1);
 }
 
+// frees the held chunks for seqs [from, to)
+static void release_held(zstream_producer_t *st, uint32_t from, uint32_t to) {
+	for (uint32_t seq = from; seq != to; seq++) {
+		z_obj_t *chunk = &st->held[seq % ZSTREAM_WINDOW_MAX];
+		if (chunk->type == Z_BLOB) z_obj_free(chunk);
+		*chunk = z_obj_none();
+	}
+}
+
 void zstream_accept(zstream_producer_t *st, uint32_t consumer_pid, uint32_t open_tag) {
+	zstream_accept_window(st, consumer_pid, open_tag, 1);
+}
+
+void zstream_accept_window(zstream_producer_t *st, uint32_t consumer_pid,
+	uint32_t open_tag, uint32_t max_window) {
 
 	memset(st, 0, sizeof(*st));
-	st->stream_id = next_stream_id++;
-	if (next_stream_id == 0) next_stream_id = 1;	// skip 0 on wrap
+	st->stream_id = next_stream_id;
+	next_stream_id = (next_stream_id + 1) & 0xffff;	// it has to fit
+	if (next_stream_id == 0) next_stream_id = 1;	// in a tag; skip 0
 	st->consumer_pid = consumer_pid;
 	st->seq = UINT32_MAX;		// no chunk sent yet
 	st->active = true;
-	st->last_chunk = z_obj_none();
+	for (int i = 0; i < ZSTREAM_WINDOW_MAX; i++)
+		st->held[i] = z_obj_none();
+
+	uint32_t window = ZSTREAM_OPEN_TAG_WINDOW(open_tag);
+	if (window > max_window) window = max_window;
+	if (window > ZSTREAM_WINDOW_MAX) window = ZSTREAM_WINDOW_MAX;
+	if (window == 0) window = 1;
+	st->window = window;
+
+	// a consumer that didn't ask for a window gets a bare stream_id,
+	// exactly as before windows existed
+	uint32_t reply = st->stream_id;
+	if (window > 1) reply |= window << 16;
 
 	z_msg_new_send(consumer_pid, Z_STREAM_OPEN_REPLY, open_tag,
-		z_obj_uint32(st->stream_id));
+		z_obj_uint32(reply));
 
 }
 
@@ -74,6 +102,10 @@ void zstream_reject(uint32_t consumer_pid, uint32_t open_tag, const char *error)
 	z_msg_new_send(consumer_pid, Z_STREAM_OPEN_REPLY, open_tag, z_obj_str(error));
 }
 
+bool zstream_can_send(const zstream_producer_t *st) {
+	return st->active && !st->done && next_seq(st) - st->acked < st->window;
+}
+
 zstream_event_t zstream_producer_handle(zstream_producer_t *st, z_msg_t *msg) {
 
 	if (!st->active) return ZSTREAM_EVENT_NONE;
@@ -81,35 +113,56 @@ zstream_event_t zstream_producer_handle(zstream_producer_t *st, z_msg_t *msg) {
 	uint32_t stream_id = ZSTREAM_TAG_STREAM_ID(msg->tag);
 	if (stream_id != (st->stream_id & 0xffff)) return ZSTREAM_EVENT_NONE;
 
-	if (msg->subject == Z_STREAM_ABORT)
+	if (msg->subject == Z_STREAM_ABORT) {
+		// sending ABORT means the consumer's done with everything it
+		// was sent -- no pull is coming to free it
+		release_held(st, st->acked, next_seq(st));
+		st->acked = next_seq(st);
 		return ZSTREAM_EVENT_ABORT;
+	}
 
 	if (msg->subject != Z_STREAM_PULL) return ZSTREAM_EVENT_NONE;
 
-	uint32_t seq = ZSTREAM_TAG_SEQ(msg->tag);
-	uint32_t expect_next = next_seq(st);
-
-	if (seq == expect_next) {
-		// fresh pull -- this arriving is itself proof the consumer
-		// already has the chunk we sent last time, so it's safe to
-		// free now (see zstream.h's big comment on why this is the
-		// only place a chunk ever gets freed)
-		if (st->last_chunk.type == Z_BLOB) z_obj_free(&st->last_chunk);
-		st->last_chunk = z_obj_none();
-		return ZSTREAM_EVENT_PULL;
+	// the tag only carries the low 16 bits of seq -- widen it back
+	// out relative to the last pull, which it can't be far from
+	uint32_t next = next_seq(st);
+	uint32_t seq = st->acked + ((ZSTREAM_TAG_SEQ(msg->tag) - st->acked) & 0xffff);
+
+	if (seq == st->acked && st->pulled && next != st->acked) {
+		// retry of the latest pull, whose chunks already went out --
+		// still have them all, resend directly rather than bothering
+		// the caller for data it may not have handy anymore
+		for (uint32_t s = st->acked; s != next; s++) {
+			z_obj_t chunk = st->held[s % ZSTREAM_WINDOW_MAX];
+			if (chunk.type != Z_BLOB) continue;	// the EOF/ERROR slot
+			z_msg_new_send(st->consumer_pid, Z_STREAM_CHUNK,
+				ZSTREAM_TAG(st->stream_id, s), chunk);
+		}
+		return ZSTREAM_EVENT_NONE;
+	}
+
+	if (seq - st->acked > next - st->acked) {
+		// stale (behind the latest pull) or past anything we've sent
+		// -- ignore
+		return ZSTREAM_EVENT_NONE;
 	}
 
-	if (st->seq != UINT32_MAX && seq == st->seq) {
-		// retry of the chunk we just sent -- still have it, resend
-		// directly rather than bothering the caller for data it may
-		// not have handy anymore
-		z_msg_new_send(st->consumer_pid, Z_STREAM_CHUNK,
-			ZSTREAM_TAG(st->stream_id, st->seq), st->last_chunk);
+	// fresh pull -- this arriving is itself proof the consumer
+	// already has every chunk before seq, so they're safe to free now
+	// (see zstream.h's big comment on why this is the only place a
+	// chunk ever gets freed mid-stream)
+	release_held(st, st->acked, seq);
+	st->acked = seq;
+	st->pulled = true;
+
+	if (st->done) {
+		// the pull for the EOF/ERROR itself: nothing of ours is
+		// left in the consumer's hands, and nothing more is coming
+		if (seq == st->seq) st->active = false;
 		return ZSTREAM_EVENT_NONE;
 	}
 
-	// stale/invalid seq -- ignore
-	return ZSTREAM_EVENT_NONE;
+	return zstream_can_send(st) ? ZSTREAM_EVENT_PULL : ZSTREAM_EVENT_NONE;
 
 }
 
@@ -118,23 +171,28 @@ void zstream_send_chunk(zstream_producer_t *st, const void *data, uint32_t len)
 	z_obj_t chunk = z_obj_blob(data, len);
 	z_msg_new_send(st->consumer_pid, Z_STREAM_CHUNK,
 		ZSTREAM_TAG(st->stream_id, seq), chunk);
-	st->last_chunk = chunk;	// kept alive until the next pull frees it
+	// kept alive until a pull past it frees it
+	st->held[seq % ZSTREAM_WINDOW_MAX] = chunk;
 	st->seq = seq;
 }
 
+// EOF/ERROR don't free chunks the consumer hasn't pulled past yet --
+// with a window it may still be reading them. Its pull for the
+// EOF/ERROR's own seq (zstream_pull() sends it before it ever sees
+// the reply) frees them and ends the stream; so does an ABORT, or
+// zstream_producer_close().
+
 void zstream_send_eof(zstream_producer_t *st) {
-	if (st->last_chunk.type == Z_BLOB) z_obj_free(&st->last_chunk);
-	st->last_chunk = z_obj_none();
 	uint32_t seq = next_seq(st);
+	st->done = true;
 	z_msg_new_send(st->consumer_pid, Z_STREAM_EOF,
 		ZSTREAM_TAG(st->stream_id, seq), z_obj_none());
 	st->seq = seq;
 }
 
 void zstream_send_error(zstream_producer_t *st, const char *msg) {
-	if (st->last_chunk.type == Z_BLOB) z_obj_free(&st->last_chunk);
-	st->last_chunk = z_obj_none();
 	uint32_t seq = next_seq(st);
+	st->done = true;
 	// terminal, one-shot message for this stream -- same small,
 	// one-time cost as zstream_reject() above, never repeated.
 	z_msg_new_send(st->consumer_pid, Z_STREAM_ERROR,
@@ -143,20 +201,38 @@ void zstream_send_error(zstream_producer_t *st, const char *msg) {
 }
 
 void zstream_producer_close(zstream_producer_t *st) {
-	if (st->last_chunk.type == Z_BLOB) z_obj_free(&st->last_chunk);
+	release_held(st, st->acked, next_seq(st));
+	st->acked = next_seq(st);
 	st->active = false;
 }
 
 // -- consumer side --
 
+// an OPEN_REPLY's Z_UINT32: stream_id, plus the window granted in
+// the top half if it's more than 1
+static void consumer_opened(zstream_consumer_t *st, uint32_t reply) {
+	st->stream_id = reply & 0xffff;
+	st->window = (reply >> 16) ? (reply >> 16) : 1;
+	st->seq = 0;	// next seq we'll pull
+	st->active = true;
+}
+
 bool zstream_open(zstream_consumer_t *st, uint32_t producer_pid,
 	z_obj_t open_payload, char *err, uint32_t err_len) {
+	return zstream_open_window(st, producer_pid, open_payload, 1, err, err_len);
+}
+
+bool zstream_open_window(zstream_consumer_t *st, uint32_t producer_pid,
+	z_obj_t open_payload, uint32_t window, char *err, uint32_t err_len) {
 
 	memset(st, 0, sizeof(*st));
 	st->producer_pid = producer_pid;
 
+	if (window > ZSTREAM_WINDOW_MAX) window = ZSTREAM_WINDOW_MAX;
+
 	static uint32_t next_open_tag = 1;
-	uint32_t open_tag = next_open_tag++;
+	uint32_t open_tag = ZSTREAM_OPEN_TAG(next_open_tag, window > 1 ? window : 0);
+	next_open_tag = (next_open_tag + 1) & 0xffffff;
 	if (next_open_tag == 0) next_open_tag = 1;
 
 	z_msg_new_send(producer_pid, Z_STREAM_OPEN, open_tag, open_payload);
@@ -167,23 +243,24 @@ bool zstream_open(zstream_consumer_t *st, uint32_t producer_pid,
 	while (z_uptime_ticks() - start < ZSTREAM_TIMEOUT_TICKS) {
 
 		if (z_msg_read(&reply) != Z_OK) continue;
-		if (reply.subject != Z_STREAM_OPEN_REPLY || reply.tag != open_tag)
-			continue;	// not our reply -- discard, keep waiting
-
-		if (reply.obj.type == Z_UINT32) {
-			st->stream_id = reply.obj.val.uint32;
-			st->seq = 0;	// next seq we'll pull
-			st->active = true;
-			return true;
+		if (reply.subject != Z_STREAM_OPEN_REPLY || reply.tag != open_tag) {
+			// not our reply -- discard, keep waiting. Released, so
+			// a kernel-copied one doesn't hold up our copy arena.
+			z_msg_release(&reply);
+			continue;
 		}
 
-		if (reply.obj.type == Z_STR && reply.obj.val.str) {
+		bool opened = false;
+		if (reply.obj.type == Z_UINT32) {
+			consumer_opened(st, reply.obj.val.uint32);
+			opened = true;
+		} else if (reply.obj.type == Z_STR && reply.obj.val.str) {
 			set_err(err, err_len, reply.obj.val.str);
-			return false;
+		} else {
+			set_err(err, err_len, "malformed open reply");
 		}
-
-		set_err(err, err_len, "malformed open reply");
-		return false;
+		z_msg_release(&reply);
+		return opened;
 
 	}
 
@@ -209,8 +286,14 @@ zstream_result_t zstream_pull(zstream_consumer_t *st, const uint8_t **data,
 	while (z_uptime_ticks() - start < ZSTREAM_TIMEOUT_TICKS) {
 
 		if (z_msg_read(&msg) != Z_OK) continue;
-		if (msg.tag != tag) continue;	// not for this pull -- discard
+		if (msg.tag != tag) {
+			z_msg_release(&msg);	// not for this pull -- discard
+			continue;
+		}
 
+		// a chunk's blob is lent by the producer (zstream_send_chunk()),
+		// never a kernel copy, so there's nothing to release for it --
+		// and *data has to stay valid past this return anyway
 		if (msg.subject == Z_STREAM_CHUNK) {
 			if (msg.obj.type != Z_BLOB) {
 				st->active = false;
@@ -225,6 +308,7 @@ zstream_result_t zstream_pull(zstream_consumer_t *st, const uint8_t **data,
 
 		if (msg.subject == Z_STREAM_EOF) {
 			st->active = false;
+			z_msg_release(&msg);
 			return ZSTREAM_EOF;
 		}
 
@@ -234,11 +318,13 @@ zstream_result_t zstream_pull(zstream_consumer_t *st, const uint8_t **data,
 				set_err(err, err_len, msg.obj.val.str);
 			else
 				set_err(err, err_len, "producer reported an error");
+			z_msg_release(&msg);
 			return ZSTREAM_ERROR;
 		}
 
 		// anything else matching this tag shouldn't happen -- ignore,
 		// keep waiting rather than treat it as fatal
+		z_msg_release(&msg);
 
 	}
 
@@ -264,7 +350,8 @@ void zstream_open_async(zstream_consumer_t *st, uint32_t producer_pid,
 	st->producer_pid = producer_pid;
 
 	static uint32_t next_open_tag = 1;
-	st->open_tag = next_open_tag++;
+	st->open_tag = next_open_tag;
+	next_open_tag = (next_open_tag + 1) & 0xffffff;
 	if (next_open_tag == 0) next_open_tag = 1;
 
 	z_msg_new_send(producer_pid, Z_STREAM_OPEN, st->open_tag, open_payload);
@@ -289,9 +376,7 @@ zstream_consumer_event_t zstream_consumer_handle(zstream_consumer_t *st,
 			return ZSTREAM_CEVENT_NONE;
 
 		if (msg->obj.type == Z_UINT32) {
-			st->stream_id = msg->obj.val.uint32;
-			st->seq = 0;
-			st->active = true;
+			consumer_opened(st, msg->obj.val.uint32);
 			return ZSTREAM_CEVENT_OPENED;
 		}
 
@@ -18,6 +18,15 @@
  * more than one chunk in flight, and the request/reply rhythm *is*
  * the flow control -- no separate credit/window scheme needed.
  *
+ * That rhythm costs a full PULL/CHUNK round trip -- two context
+ * switches -- per chunk, so a consumer can ask for a window of up to
+ * ZSTREAM_WINDOW_MAX chunks at OPEN instead. The producer grants what
+ * it's willing to hold (it may say less, or 1), and may then run that
+ * many chunks ahead of the consumer's latest PULL -- each PULL now
+ * also hands back a credit for the chunk before it. Still pull-based,
+ * still bounded: at most `window` chunks in flight and held, and a
+ * window of 1 is exactly the original protocol.
+ *
  * Just as important: the producer side never blocks. It's fed
  * messages the caller's own loop already read (see
  * zstream_producer_handle() below) rather than doing its own
@@ -36,13 +45,13 @@
  * frees the top-level object it hands to z_msg_send() -- fine for a
  * single one-shot reply, not fine repeated per-chunk across a stream
  * that might be thousands of chunks long. The pull protocol itself
- * gives us the fix for free: the producer keeps exactly one
- * outstanding chunk (the last one it sent) alive, and frees it the
- * moment the *next* pull arrives -- receipt of that next pull is
- * itself proof the consumer already has the previous chunk, satisfying
- * zmsg.h's "valid until your own next send" rule with no separate ack.
- * Net effect: exactly one chunk's worth of heap allocation outstanding
- * at any moment, on either side, for a stream of any length.
+ * gives us the fix for free: the producer keeps each chunk it sent
+ * alive until a pull for a LATER seq arrives -- receipt of that pull
+ * is itself proof the consumer already has (and is done with) the
+ * chunk, satisfying zmsg.h's "valid until your own next send" rule
+ * with no separate ack. Net effect: at most one window's worth of
+ * chunks outstanding at any moment (one, without a window), for a
+ * stream of any length.
  *
  * Wire protocol, all built from ordinary z_msg_t messages:
  *
@@ -50,26 +59,32 @@
  *                 (opaque to zstream -- e.g. TFTP's existing GET/PUT
  *                 request shape. zstream doesn't know or care what's
  *                 inside; the producer application interprets it.)
- *   OPEN_REPLY  producer -> consumer  tag=nonce   obj=Z_UINT32(stream_id) on
- *                 success, or Z_STR(error) on failure (stream_id left at 0)
+ *                 The nonce's top 8 bits are the window asked for
+ *                 (ZSTREAM_OPEN_TAG() -- 0 means 1).
+ *   OPEN_REPLY  producer -> consumer  tag=nonce   obj=Z_UINT32(stream_id |
+ *                 window << 16) on success -- the window granted, only
+ *                 when it's more than 1 -- or Z_STR(error) on failure
+ *                 (stream_id left at 0)
  *
  *   from here on, every message's tag is (stream_id<<16 | seq&0xffff)
  *   -- packs both into the existing tag field for free, ordinary
  *   subject+tag matching demultiplexes everything with no extra
  *   allocation and no wrapper object needed.
  *
- *   PULL        consumer -> producer  obj=Z_NONE   "send me chunk seq"
+ *   PULL        consumer -> producer  obj=Z_NONE   "send me chunk seq" --
+ *                 and "I'm done with everything before it", which is
+ *                 what moves a window along
  *   CHUNK       producer -> consumer  obj=Z_BLOB    the chunk's data
  *   EOF         producer -> consumer  obj=Z_NONE    no more chunks, done
  *   ERROR       producer -> consumer  obj=Z_STR     stream failed, done
  *   ABORT       consumer -> producer  obj=Z_NONE    consumer giving up early
  *
- * A pull for the same seq as the last chunk already sent is treated
- * as a retry (the producer still has that chunk's blob on hand) and
- * gets the same data resent, rather than being treated as an error --
- * cheap robustness against a lost reply, though on purely local,
- * in-memory messaging this is expected to be rare to never in
- * practice.
+ * A pull repeating the latest one, once its chunk has already gone
+ * out, is treated as a retry (the producer still has every chunk from
+ * there on, up to a window's worth, on hand) and gets them resent,
+ * rather than being treated as an error -- cheap robustness against a
+ * lost reply, though on purely local, in-memory messaging this is
+ * expected to be rare to never in practice.
  *
  * This header defines the wire protocol and constants shared by both
  * sides, plus the producer API (below) which is fed messages by the
@@ -114,10 +129,24 @@
 #define ZSTREAM_TAG_STREAM_ID(tag)  (((uint32_t)(tag) >> 16) & 0xffff)
 #define ZSTREAM_TAG_SEQ(tag)        ((uint32_t)(tag) & 0xffff)
 
+// most chunks a window can have in flight -- the producer holds this
+// many at most (each a malloc'd blob), and the consumer's mailbox has
+// to be able to queue them all, so no more than Z_MAILBOX_DEPTH_SMALL
+#define ZSTREAM_WINDOW_MAX          8
+// what the shell's tget asks for -- enough to keep a TFTP GET from
+// ever waiting on a pull round trip, without hogging a small mailbox
+#define ZSTREAM_WINDOW_DEFAULT      4
+
+// an OPEN's tag: a 24-bit nonce plus the window the consumer wants
+#define ZSTREAM_OPEN_TAG(nonce, window) \
+	((((uint32_t)(window) & 0xff) << 24) | ((uint32_t)(nonce) & 0xffffff))
+#define ZSTREAM_OPEN_TAG_WINDOW(tag) (((uint32_t)(tag) >> 24) & 0xff)
+
 typedef enum {
 	ZSTREAM_EVENT_NONE = 0,	// msg wasn't a stream-protocol msg for this stream
 	ZSTREAM_EVENT_PULL,	// consumer wants the next chunk -- caller should now
-				// call zstream_send_chunk/eof/error
+				// call zstream_send_chunk/eof/error (with a
+				// window: while zstream_can_send() says so)
 	ZSTREAM_EVENT_ABORT	// consumer gave up -- caller should clean up and
 				// stop producing
 } zstream_event_t;
@@ -146,8 +175,17 @@ typedef struct {
 					// UINT32_MAX before the first chunk)
 	bool		active;
 
-	z_obj_t		last_chunk;	// kept alive until the next pull
-					// proves the consumer has it
+	uint32_t	window;		// chunks we may run ahead, granted at OPEN
+	uint32_t	acked;		// seq of the latest pull -- everything
+					// before it is done with
+	bool		pulled;		// any pull seen yet (so the first one
+					// is never taken for a retry)
+	bool		done;		// EOF/ERROR sent -- only its pull left
+
+	z_obj_t		held[ZSTREAM_WINDOW_MAX];	// chunks acked..seq,
+					// by seq % ZSTREAM_WINDOW_MAX, kept alive
+					// until a later pull proves the consumer
+					// has them
 
 } zstream_producer_t;
 
@@ -160,6 +198,17 @@ typedef struct {
 void zstream_accept(zstream_producer_t *st, uint32_t consumer_pid, uint32_t open_tag);
 void zstream_reject(uint32_t consumer_pid, uint32_t open_tag, const char *error);
 
+// zstream_accept(), granting the consumer's window up to max_window
+// (capped at ZSTREAM_WINDOW_MAX) -- zstream_accept() itself grants
+// 1, for a producer loop that only ever sends on a PULL. With more
+// than 1, send whenever zstream_can_send() says so, not just on
+// ZSTREAM_EVENT_PULL: a chunk can go out before any pull at all.
+void zstream_accept_window(zstream_producer_t *st, uint32_t consumer_pid,
+	uint32_t open_tag, uint32_t max_window);
+
+// true while the window has room for another chunk
+bool zstream_can_send(const zstream_producer_t *st);
+
 // feed each message your own loop reads to this. if it's a
 // stream-protocol message for *this* stream (matched by stream_id,
 // pulled from the message's tag), handles the bookkeeping (freeing
@@ -175,8 +224,11 @@ void zstream_send_chunk(zstream_producer_t *st, const void *data, uint32_t len);
 void zstream_send_eof(zstream_producer_t *st);
 void zstream_send_error(zstream_producer_t *st, const char *msg);
 
-// release any held chunk and mark the stream inactive. call after
-// EOF/error/abort, or if you're giving up on the stream yourself.
+// release any held chunks and mark the stream inactive. call if
+// you're giving up on the stream yourself, or before reusing `st`
+// for a new one while it may still be active -- a stream that ended
+// normally has already cleaned up after itself once the consumer
+// pulled its EOF/ERROR (st->active goes false).
 void zstream_producer_close(zstream_producer_t *st);
 
 // -- consumer side --
@@ -197,6 +249,8 @@ typedef struct {
 	uint32_t	open_tag;	// used only while opening (before
 					// stream_id exists) to match
 					// OPEN_REPLY -- see zstream_open_async()
+	uint32_t	window;		// granted by the producer, 1 if it
+					// didn't grant a bigger one
 
 } zstream_consumer_t;
 
@@ -208,6 +262,15 @@ typedef struct {
 bool zstream_open(zstream_consumer_t *st, uint32_t producer_pid,
 	z_obj_t open_payload, char *err, uint32_t err_len);
 
+// zstream_open(), asking for a window of up to `window` chunks in
+// flight (ZSTREAM_WINDOW_MAX at most) -- the producer decides how many
+// it actually grants (st->window). Nothing else changes on this side:
+// zstream_pull() works the same, it just mostly finds its chunk
+// already waiting. Just make sure your mailbox can hold `window`
+// chunks on top of whatever else it queues.
+bool zstream_open_window(zstream_consumer_t *st, uint32_t producer_pid,
+	z_obj_t open_payload, uint32_t window, char *err, uint32_t err_len);
+
 // blocking pull of the next chunk. on ZSTREAM_CHUNK, *data/*len point
 // into the message's own borrowed storage -- per zmsg.h's usual
 // borrowing rule, valid only until your next zstream_pull() call (or
@@ -72,29 +72,44 @@ z_rv z_win_create_ex(z_win_t *win, const char *title, uint32_t w, uint32_t h,
 z_rv z_win_create_flags(z_win_t *win, const char *title, uint32_t w, uint32_t h,
 	int32_t x, int32_t y, uint32_t flags) {
 
-	z_obj_t args = z_obj_map(6);
-	z_map_set(&args, "title", z_obj_str(title ? title : ""));
-	if (w) z_map_set(&args, "w", z_obj_uint32(w));
-	if (h) z_map_set(&args, "h", z_obj_uint32(h));
+	// built on the stack (z_arena_t, zobj.h) rather than the heap --
+	// see the z_msg_call() below for why that's long enough
+	void *args_buf[64];
+	z_arena_t arena;
+	z_arena_init(&arena, args_buf, sizeof(args_buf));
+	z_obj_t args = z_arena_map(&arena, 6);
+	z_arena_map_set(&arena, &args, "title", z_arena_str(&arena, title ? title : ""));
+	if (w) z_arena_map_set(&arena, &args, "w", z_obj_uint32(w));
+	if (h) z_arena_map_set(&arena, &args, "h", z_obj_uint32(h));
 	if (x >= 0 && y >= 0) {
-		z_map_set(&args, "x", z_obj_uint32((uint32_t)x));
-		z_map_set(&args, "y", z_obj_uint32((uint32_t)y));
+		z_arena_map_set(&arena, &args, "x", z_obj_uint32((uint32_t)x));
+		z_arena_map_set(&arena, &args, "y", z_obj_uint32((uint32_t)y));
 	}
 	// omitted entirely when 0 (no flags), same "missing key falls
 	// back to a default" convention every other optional key here
 	// already follows (zwm.h's own Z_WM_CREATE_WINDOW comment) --
 	// not required for correctness (wm treats a missing "flags" the
 	// same as an explicit 0), just consistent with the others.
-	if (flags) z_map_set(&args, "flags", z_obj_uint32(flags));
-
-	z_msg_new_send(resolve_wm_pid(), Z_WM_CREATE_WINDOW, 0, args);
-	// note: `args` is intentionally never freed here -- same accepted
-	// leak/lifetime tradeoff documented in docs/messaging.md. we're
-	// about to block on the reply below, so it's still valid for the
-	// wm to read for as long as it needs.
+	if (flags) z_arena_map_set(&arena, &args, "flags", z_obj_uint32(flags));
+
+	// one z_msg_call() (zeitlos.h): the wm echoes the request's tag
+	// back on Z_WM_WINDOW_CREATED, and everything else it sends us
+	// uses tag 0, so a fresh nonzero tag picks out exactly this reply
+	// -- anything else arriving meanwhile (another window's redraw,
+	// say) stays queued for the app's own loop instead of being
+	// thrown away. we're blocked until the reply, so `args` is still
+	// valid for the wm to read for as long as it needs, and gone with
+	// this stack frame afterwards -- nothing to free.
+	static uint32_t create_tag = 0;
+	if (++create_tag == 0) create_tag = 1;
 
 	z_msg_t reply;
-	if (z_msg_wait(&reply, Z_WM_WINDOW_CREATED, 0) != Z_OK) {
+	reply.to = resolve_wm_pid();
+	reply.subject = Z_WM_CREATE_WINDOW;
+	reply.tag = create_tag;
+	reply.obj = args;
+
+	if (z_msg_call(&reply, 0) != Z_OK || reply.subject != Z_WM_WINDOW_CREATED) {
 		win->id = -1;
 		return Z_FAIL;
 	}
@@ -142,6 +142,19 @@
 // expected -- same convention as Z_WM_REDRAW/Z_WM_KEY.
 #define Z_WM_CLOSE               107
 
+// topic (z_msg_subscribe(), zmsg.h) -- wm publishes here whenever
+// keyboard focus moves to a different window, or to none. obj is a
+// Z_UINT32: Z_WM_PACK_FOCUS(window id, owner pid), or
+// Z_WM_FOCUS_NONE. Anyone can subscribe; wm doesn't know or care who
+// does. Only changes are published -- a subscriber that needs the
+// current focus before the next change has no way to ask yet.
+#define Z_WM_TOPIC_FOCUS         108
+
+#define Z_WM_FOCUS_NONE            0xFFFFFFFF
+#define Z_WM_PACK_FOCUS(id, pid)   ((((uint32_t)(pid) & 0xFF) << 8) | ((uint32_t)(id) & 0xFF))
+#define Z_WM_UNPACK_FOCUS_ID(v)    ((v) & 0xFF)
+#define Z_WM_UNPACK_FOCUS_PID(v)   (((v) >> 8) & 0xFF)
+
 // keysym: 0x0000-0x7fff (see zkbd.h -- ASCII in 0x00-0x7f, named keys
 // like arrows in 0x100+). modifiers: the raw USB HID modifier byte
 // (zkbd.h's Z_KBD_MOD_* bits) at the time of this event. pressed: 1 =
@@ -0,0 +1,257 @@
+/*
+ * Zeitlos OS
+ * Copyright (c) 2025 Lone Dynamics Corporation. All rights reserved.
+ *
+ * Shared read-only file mappings. See fmap.h.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "kernel.h"
+#include "mem.h"
+#include "fmap.h"
+#include "imgcache.h"
+#include "fs/fs.h"
+#include "../common/zfs.h"
+
+typedef struct {
+	bool		used;
+	bool		loading;	// claimed, file still being read in
+	uint32_t	loader;		// pid doing the reading, while loading
+	char		name[Z_FMAP_NAME_MAX];	// normalized; empty once stale
+	uint32_t	size;
+	uint16_t	fdate;
+	uint16_t	ftime;
+	void		*mem;
+	uint32_t	refs;		// sum of pid_refs[]
+	uint8_t		pid_refs[Z_PROCS_MAX];
+} z_fmap_entry_t;
+
+static __attribute__((section(".bss"))) z_fmap_entry_t z_fmap[Z_FMAP_MAX];
+
+void k_fmap_init(void) {
+	memset(z_fmap, 0, sizeof(z_fmap));
+}
+
+// caller holds maskirq()
+static void fmap_drop(int e) {
+	if (z_fmap[e].mem) k_mem_free(z_fmap[e].mem);
+	memset(&z_fmap[e], 0, sizeof(z_fmap[e]));
+}
+
+// caller holds maskirq(). Frees an entry nobody holds any more --
+// unless it's still being loaded, in which case the loader hands it
+// out when it's done.
+static void fmap_unref(int e, uint32_t pid, uint32_t n) {
+	z_fmap[e].pid_refs[pid] -= n;
+	z_fmap[e].refs -= n;
+	if (!z_fmap[e].refs && !z_fmap[e].loading) fmap_drop(e);
+}
+
+static bool fmap_alive(uint32_t pid) {
+	return (z_procs[pid].flags & (Z_PROC_FLAG_ACTIVE | Z_PROC_FLAG_DIE)) ==
+		Z_PROC_FLAG_ACTIVE;
+}
+
+static bool fmap_settled(uint32_t pid) {
+	(void)pid;
+	for (int e = 0; e < Z_FMAP_MAX; e++)
+		if (z_fmap[e].used && z_fmap[e].loading && fmap_alive(z_fmap[e].loader))
+			return false;
+	return true;
+}
+
+// reads the whole file into the entry's memory -- false if it isn't
+// the size it was when it was stat'ed (changed in between), or FatFs
+// fails
+static bool fmap_load(void *mem, char *name, uint32_t size) {
+	FIL f;
+	UINT br = 0;
+	if (f_open(&f, name, FA_READ | FA_OPEN_EXISTING) != FR_OK) return false;
+	FRESULT res = (f_size(&f) == size) ? f_read(&f, mem, (UINT)size, &br) : FR_DENIED;
+	f_close(&f);
+	return res == FR_OK && br == size;
+}
+
+static z_obj_t *fmap_map(z_fs_map_args_t *a) {
+
+	a->addr = NULL;
+	a->size = 0;
+
+	uint32_t pid = z_pid;
+	if (!a->name || pid >= Z_PROCS_MAX) return (&z_fail);
+
+	FILINFO fno;
+	if (f_stat(a->name, &fno) != FR_OK || (fno.fattrib & AM_DIR) || !fno.fsize)
+		return (&z_fail);
+
+	char norm[Z_FMAP_NAME_MAX];
+	fs_name_norm(norm, a->name, Z_FMAP_NAME_MAX);
+
+	uint32_t old_mask;
+	int e;
+
+	for (;;) {
+
+		old_mask = maskirq(0xFFFFFFFF);
+
+		for (e = 0; e < Z_FMAP_MAX; e++)
+			if (z_fmap[e].used && z_fmap[e].name[0] && !strcmp(z_fmap[e].name, norm))
+				break;
+		if (e == Z_FMAP_MAX) e = -1;
+
+		if (e >= 0 && z_fmap[e].loading) {
+			if (fmap_alive(z_fmap[e].loader)) {
+				// someone else is reading it in -- wait for that
+				// rather than loading a second copy
+				maskirq(old_mask);
+				k_proc_block(fmap_settled, 1);
+				continue;
+			}
+			// its loader died part way through
+			if (z_fmap[e].refs) z_fmap[e].name[0] = 0;
+			else fmap_drop(e);
+			e = -1;
+		}
+
+		if (e >= 0 && (z_fmap[e].size != (uint32_t)fno.fsize ||
+			z_fmap[e].fdate != fno.fdate || z_fmap[e].ftime != fno.ftime)) {
+			// changed on disk since it was loaded -- whoever already
+			// has it keeps it, the rest of us get the new one
+			z_fmap[e].name[0] = 0;
+			e = -1;
+		}
+
+		if (e >= 0) {
+			if (z_fmap[e].pid_refs[pid] == UINT8_MAX) {
+				maskirq(old_mask);
+				return (&z_fail);
+			}
+			z_fmap[e].pid_refs[pid]++;
+			z_fmap[e].refs++;
+			a->addr = z_fmap[e].mem;
+			a->size = z_fmap[e].size;
+			maskirq(old_mask);
+			return (&z_ok);
+		}
+
+		for (e = 0; e < Z_FMAP_MAX && z_fmap[e].used; e++);
+		if (e == Z_FMAP_MAX) {
+			maskirq(old_mask);
+			return (&z_fail);
+		}
+
+		memset(&z_fmap[e], 0, sizeof(z_fmap[e]));
+		z_fmap[e].used = true;
+		z_fmap[e].loading = true;
+		z_fmap[e].loader = pid;
+		strcpy(z_fmap[e].name, norm);
+		z_fmap[e].size = (uint32_t)fno.fsize;
+		z_fmap[e].fdate = fno.fdate;
+		z_fmap[e].ftime = fno.ftime;
+		// in the entry straight away, so fmap_drop() frees it if this
+		// process dies before it's loaded
+		z_fmap[e].mem = k_imgcache_alloc(z_fmap[e].size);
+
+		maskirq(old_mask);
+		break;
+
+	}
+
+	// unmasked -- the whole file over the SD card
+	bool ok = z_fmap[e].mem && fmap_load(z_fmap[e].mem, a->name, z_fmap[e].size);
+
+	old_mask = maskirq(0xFFFFFFFF);
+	z_fmap[e].loading = false;
+	if (!ok) {
+		fmap_drop(e);
+		maskirq(old_mask);
+		return (&z_fail);
+	}
+	z_fmap[e].pid_refs[pid]++;
+	z_fmap[e].refs++;
+	a->addr = z_fmap[e].mem;
+	a->size = z_fmap[e].size;
+	maskirq(old_mask);
+
+	return (&z_ok);
+
+}
+
+static z_obj_t *fmap_unmap(z_fs_map_args_t *a) {
+
+	uint32_t pid = z_pid;
+	if (!a->addr || pid >= Z_PROCS_MAX) return (&z_fail);
+
+	uint32_t old_mask = maskirq(0xFFFFFFFF);
+	for (int e = 0; e < Z_FMAP_MAX; e++) {
+		if (!z_fmap[e].used || z_fmap[e].mem != a->addr || !z_fmap[e].pid_refs[pid])
+			continue;
+		fmap_unref(e, pid, 1);
+		maskirq(old_mask);
+		return (&z_ok);
+	}
+	maskirq(old_mask);
+
+	return (&z_fail);
+
+}
+
+z_obj_t *k_fs_map(z_obj_t *args) {
+
+	z_fs_map_args_t *a = (z_fs_map_args_t *)args;
+	if (!a) return (&z_fail);
+
+	switch (a->op) {
+		case Z_FS_MAP: return fmap_map(a);
+		case Z_FS_UNMAP: return fmap_unmap(a);
+	}
+
+	return (&z_fail);
+
+}
+
+void k_fmap_release_all(uint32_t pid) {
+	if (pid >= Z_PROCS_MAX) return;
+	uint32_t old_mask = maskirq(0xFFFFFFFF);
+	for (int e = 0; e < Z_FMAP_MAX; e++)
+		if (z_fmap[e].used && z_fmap[e].pid_refs[pid])
+			fmap_unref(e, pid, z_fmap[e].pid_refs[pid]);
+	maskirq(old_mask);
+}
+
+void k_fmap_invalidate(const char *name) {
+
+	if (!name) return;
+
+	char norm[Z_FMAP_NAME_MAX];
+	fs_name_norm(norm, name, Z_FMAP_NAME_MAX);
+
+	uint32_t old_mask = maskirq(0xFFFFFFFF);
+	for (int e = 0; e < Z_FMAP_MAX; e++)
+		if (z_fmap[e].used && z_fmap[e].name[0] && !strcmp(z_fmap[e].name, norm))
+			z_fmap[e].name[0] = 0;
+	maskirq(old_mask);
+
+}
+
+// see fmap.h -- plain printf(), only ever called from sh.c
+z_rv k_fmap_dump(void) {
+	int shown = 0;
+	for (int e = 0; e < Z_FMAP_MAX; e++) {
+		if (!z_fmap[e].used) continue;
+		printf(" slot: %i name: %-12s size: %7ld at: %.8lx refs: %ld%s pids:",
+			e, z_fmap[e].name[0] ? z_fmap[e].name : "(stale)",
+			(long)z_fmap[e].size, (uint32_t)(uintptr_t)z_fmap[e].mem,
+			(long)z_fmap[e].refs, z_fmap[e].loading ? " (loading)" : "");
+		for (int p = 0; p < Z_PROCS_MAX; p++)
+			if (z_fmap[e].pid_refs[p]) printf(" %i", p);
+		printf("\n");
+		shown++;
+	}
+	if (!shown) printf(" (empty)\n");
+	return Z_OK;
+}
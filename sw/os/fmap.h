@@ -0,0 +1,60 @@
+#ifndef Z_FMAP_H
+#define Z_FMAP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "kernel.h"
+
+/*
+ * Zeitlos OS
+ * Copyright (c) 2025 Lone Dynamics Corporation. All rights reserved.
+ *
+ * Shared read-only file mappings -- the kernel side of Z_SYS_FS_MAP
+ * (z_fs_map_args_t, sw/common/zfs.h, which has the app-facing
+ * contract). A small table of whole files, each loaded once into a
+ * k_mem_alloc() block and shared by physical address between every
+ * process that maps it, with a reference count per process.
+ *
+ * Same shape as the app image cache (imgcache.h), and for the same
+ * reasons: entries are keyed by fs_name_norm()'d name, a mapping is
+ * only shared if the file on disk still has the size and FAT date/time
+ * it was loaded with, and because ffconf.h's FF_FS_NORTC gives every
+ * file written on the board the same timestamp, every kernel-side
+ * write/delete path calls k_fmap_invalidate() next to its
+ * k_imgcache_invalidate(). The difference is lifetime: an image is
+ * spare-RAM cache that's given back whenever something else wants the
+ * memory, while a mapping is in use by somebody until it's unmapped --
+ * so it's never evicted while referenced, and freed the moment it
+ * isn't. Its memory comes from k_imgcache_alloc(), so cached images
+ * make room for it rather than the other way round.
+ *
+ * Loading happens outside the table's critical section (it's a whole
+ * file over the SD card): the entry is claimed first and marked
+ * `loading`, and a second process mapping the same file meanwhile
+ * sleeps until it's there rather than loading its own copy.
+ */
+
+#define Z_FMAP_MAX       8   // distinct mapped files at once
+#define Z_FMAP_NAME_MAX  32  // same bound as the image cache's
+
+// zeroes the table -- called once from kernel.c's main(), alongside
+// k_imgcache_init(), for the same not-reliably-zero-.bss reason.
+void k_fmap_init(void);
+
+// Z_SYS_FS_MAP -- z_fs_map_args_t, see zfs.h.
+z_obj_t *k_fs_map(z_obj_t *args);
+
+// drops every reference pid holds, freeing whatever that leaves
+// unreferenced -- from the scheduler's reap path, alongside
+// k_msg_release_all().
+void k_fmap_release_all(uint32_t pid);
+
+// the next MAP of `name` loads it afresh; existing mappings are left
+// as they are -- see the header comment for who calls this.
+void k_fmap_invalidate(const char *name);
+
+// prints every mapping and who holds it -- `fm` in sh.c.
+z_rv k_fmap_dump(void);
+
+#endif
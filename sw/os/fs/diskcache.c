@@ -0,0 +1,247 @@
+/*
+ * Zeitlos OS
+ * Copyright (c) 2025 Lone Dynamics Corporation. All rights reserved.
+ *
+ * Sector cache / FatFs disk_*() glue. See diskcache.h.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "diskcache.h"
+#include "fs.h"
+#include "../mem.h"
+#include "../imgcache.h"
+
+#define SECTOR_SIZE	512
+
+typedef struct {
+	bool		valid;
+	bool		dirty;		// newer than the card
+	bool		pinned;		// a FAT sector -- not evicted
+	LBA_t		sector;
+	uint32_t	last_used;	// z_diskcache_clock at the last access
+} z_diskcache_slot_t;
+
+static __attribute__((section(".bss"))) z_diskcache_slot_t z_diskcache[Z_DISKCACHE_SLOTS];
+static __attribute__((section(".bss"))) uint8_t *z_diskcache_data;	// SLOTS * 512, see diskcache.h
+static __attribute__((section(".bss"))) uint32_t z_diskcache_clock;	// per access, not per tick --
+									// a tick can see dozens
+static __attribute__((section(".bss"))) uint32_t z_diskcache_pins;
+static __attribute__((section(".bss"))) struct {
+	uint32_t hits, misses, writebacks, bypassed;
+} z_diskcache_stats;
+
+void k_diskcache_init(void) {
+	memset(z_diskcache, 0, sizeof(z_diskcache));
+	memset(&z_diskcache_stats, 0, sizeof(z_diskcache_stats));
+	z_diskcache_data = NULL;
+	z_diskcache_clock = 0;
+	z_diskcache_pins = 0;
+}
+
+static uint8_t *slot_data(int i) {
+	return z_diskcache_data + (uint32_t)i * SECTOR_SIZE;
+}
+
+static int slot_find(LBA_t sector) {
+	for (int i = 0; i < Z_DISKCACHE_SLOTS; i++)
+		if (z_diskcache[i].valid && z_diskcache[i].sector == sector)
+			return i;
+	return -1;
+}
+
+static void slot_touch(int i) {
+	z_diskcache[i].last_used = ++z_diskcache_clock;
+}
+
+static bool slot_writeback(int i) {
+	if (!z_diskcache[i].dirty) return true;
+	if (mmc_disk_write(0, slot_data(i), z_diskcache[i].sector, 1) != RES_OK)
+		return false;
+	z_diskcache[i].dirty = false;
+	z_diskcache_stats.writebacks++;
+	return true;
+}
+
+static void slot_drop(int i) {
+	if (z_diskcache[i].pinned) z_diskcache_pins--;
+	z_diskcache[i].valid = false;
+	z_diskcache[i].dirty = false;
+	z_diskcache[i].pinned = false;
+}
+
+// a free slot for `sector`, evicting the least recently used unpinned
+// one (written back first if dirty) if there's none. -1 if the victim
+// couldn't be written back -- the caller then goes to the card itself.
+static int slot_claim(LBA_t sector) {
+
+	int victim = -1;
+	for (int i = 0; i < Z_DISKCACHE_SLOTS; i++) {
+		if (!z_diskcache[i].valid) { victim = i; break; }
+		if (z_diskcache[i].pinned) continue;
+		if (victim < 0 || (int32_t)(z_diskcache[i].last_used - z_diskcache[victim].last_used) < 0)
+			victim = i;
+	}
+
+	if (victim < 0) return -1;
+	if (z_diskcache[victim].valid) {
+		if (!slot_writeback(victim)) return -1;
+		slot_drop(victim);
+	}
+
+	LBA_t fat_start;
+	DWORD fat_count;
+	z_diskcache[victim].valid = true;
+	z_diskcache[victim].dirty = false;
+	z_diskcache[victim].pinned = false;
+	z_diskcache[victim].sector = sector;
+	if (z_diskcache_pins < Z_DISKCACHE_PIN_MAX && fs_fat_range(&fat_start, &fat_count) &&
+		sector >= fat_start && sector - fat_start < fat_count) {
+		z_diskcache[victim].pinned = true;
+		z_diskcache_pins++;
+	}
+	slot_touch(victim);
+	return victim;
+
+}
+
+// -- FatFs's diskio.h interface --
+
+DSTATUS disk_status(BYTE drv) {
+	return mmc_disk_status(drv);
+}
+
+DSTATUS disk_initialize(BYTE drv) {
+
+	// a (re)mount -- the card may not be the one the cache was filled
+	// from, so nothing in it is trusted any more
+	for (int i = 0; i < Z_DISKCACHE_SLOTS; i++) slot_drop(i);
+
+	// a remount after boot can find RAM full of cached images -- see
+	// imgcache.h
+	if (!z_diskcache_data)
+		z_diskcache_data = k_imgcache_alloc(Z_DISKCACHE_SLOTS * SECTOR_SIZE);
+
+	return mmc_disk_initialize(drv);
+
+}
+
+DRESULT disk_read(BYTE drv, BYTE *buff, LBA_t sector, UINT count) {
+
+	if (drv || !z_diskcache_data) return mmc_disk_read(drv, buff, sector, count);
+
+	if (count == 1) {
+
+		int i = slot_find(sector);
+		if (i >= 0) {
+			z_diskcache_stats.hits++;
+			slot_touch(i);
+			memcpy(buff, slot_data(i), SECTOR_SIZE);
+			return RES_OK;
+		}
+
+		z_diskcache_stats.misses++;
+		i = slot_claim(sector);
+		if (i < 0) return mmc_disk_read(drv, buff, sector, 1);
+
+		DRESULT res = mmc_disk_read(drv, slot_data(i), sector, 1);
+		if (res != RES_OK) {
+			slot_drop(i);
+			return res;
+		}
+		memcpy(buff, slot_data(i), SECTOR_SIZE);
+		return RES_OK;
+
+	}
+
+	// multi-sector: one command for the whole run, then any sectors
+	// the cache already holds laid over it -- a dirty one is newer
+	// than what the card just returned
+	z_diskcache_stats.bypassed++;
+	DRESULT res = mmc_disk_read(drv, buff, sector, count);
+	if (res != RES_OK) return res;
+
+	for (int i = 0; i < Z_DISKCACHE_SLOTS; i++) {
+		if (!z_diskcache[i].valid) continue;
+		LBA_t off = z_diskcache[i].sector - sector;
+		if (z_diskcache[i].sector < sector || off >= count) continue;
+		memcpy(buff + off * SECTOR_SIZE, slot_data(i), SECTOR_SIZE);
+	}
+
+	return RES_OK;
+
+}
+
+DRESULT disk_write(BYTE drv, const BYTE *buff, LBA_t sector, UINT count) {
+
+	if (drv || !z_diskcache_data) return mmc_disk_write(drv, buff, sector, count);
+
+	if (count == 1) {
+
+		int i = slot_find(sector);
+		if (i < 0) i = slot_claim(sector);
+		if (i < 0) return mmc_disk_write(drv, buff, sector, 1);
+
+		memcpy(slot_data(i), buff, SECTOR_SIZE);
+		z_diskcache[i].dirty = true;
+		slot_touch(i);
+		return RES_OK;
+
+	}
+
+	// multi-sector: straight to the card, then bring any cached copies
+	// up to date -- clean, since the card now has the same bytes
+	z_diskcache_stats.bypassed++;
+	DRESULT res = mmc_disk_write(drv, buff, sector, count);
+	if (res != RES_OK) return res;
+
+	for (int i = 0; i < Z_DISKCACHE_SLOTS; i++) {
+		if (!z_diskcache[i].valid) continue;
+		LBA_t off = z_diskcache[i].sector - sector;
+		if (z_diskcache[i].sector < sector || off >= count) continue;
+		memcpy(slot_data(i), buff + off * SECTOR_SIZE, SECTOR_SIZE);
+		z_diskcache[i].dirty = false;
+	}
+
+	return RES_OK;
+
+}
+
+DRESULT disk_ioctl(BYTE drv, BYTE ctrl, void *buff) {
+
+	if (ctrl == CTRL_SYNC && !drv && !k_diskcache_flush())
+		return RES_ERROR;
+
+	return mmc_disk_ioctl(drv, ctrl, buff);
+
+}
+
+bool k_diskcache_flush(void) {
+	bool ok = true;
+	if (!z_diskcache_data) return ok;
+	for (int i = 0; i < Z_DISKCACHE_SLOTS; i++)
+		if (z_diskcache[i].valid && !slot_writeback(i)) ok = false;
+	return ok;
+}
+
+z_rv k_diskcache_dump(void) {
+	int shown = 0;
+	if (!z_diskcache_data) printf(" (not allocated -- passing through)\n");
+	for (int i = 0; i < Z_DISKCACHE_SLOTS; i++) {
+		if (!z_diskcache[i].valid) continue;
+		printf(" slot: %2i sector: %8ld%s%s age: %ld\n", i, (long)z_diskcache[i].sector,
+			z_diskcache[i].dirty ? " dirty" : "      ",
+			z_diskcache[i].pinned ? " pinned" : "       ",
+			(long)(z_diskcache_clock - z_diskcache[i].last_used));
+		shown++;
+	}
+	if (!shown) printf(" (empty)\n");
+	printf(" hits: %ld misses: %ld writebacks: %ld bypassed: %ld pinned: %ld/%d\n",
+		(long)z_diskcache_stats.hits, (long)z_diskcache_stats.misses,
+		(long)z_diskcache_stats.writebacks, (long)z_diskcache_stats.bypassed,
+		(long)z_diskcache_pins, Z_DISKCACHE_PIN_MAX);
+	return Z_OK;
+}
@@ -0,0 +1,79 @@
+#ifndef Z_DISKCACHE_H
+#define Z_DISKCACHE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "fatfs/ff.h"
+#include "fatfs/diskio.h"
+#include "../kernel.h"
+
+/*
+ * Zeitlos OS
+ * Copyright (c) 2025 Lone Dynamics Corporation. All rights reserved.
+ *
+ * Sector cache between FatFs and the SD card driver. FatFs's own
+ * one-sector window (FATFS.win) only remembers the last FAT or
+ * directory sector it touched, so `fs_size()` then `fs_load()` of the
+ * same file walks the same directory sectors twice, `ls` rescans them
+ * every time, and following a cluster chain re-reads FAT sectors it
+ * just had. This file provides FatFs's disk_*() (diskio.h) and keeps
+ * Z_DISKCACHE_SLOTS recently used 512-byte sectors in front of
+ * sdmm.c's mmc_disk_*():
+ *
+ *  - single-sector reads and writes -- FAT, directory entries, the
+ *    partial sectors at either end of a file read -- go through the
+ *    cache. Writes are write-back: the slot is marked dirty and only
+ *    reaches the card when it's evicted, or when FatFs asks for
+ *    CTRL_SYNC (f_sync(), f_close() of a written file, f_mkdir(), ...).
+ *
+ *  - multi-sector transfers -- the whole-sector middle of a big
+ *    f_read()/f_write(), which FatFs hands over straight into/out of
+ *    the caller's buffer -- go to the card as one CMD18/CMD25 and are
+ *    NOT admitted: streaming an app image through would otherwise
+ *    flush every FAT and directory sector out of the cache for data
+ *    that's read exactly once. Any of their sectors already cached
+ *    are kept coherent (a read takes the cached copy, a write
+ *    updates it).
+ *
+ *  - replacement is LRU, except that FAT sectors of the mounted
+ *    volume (fs_fat_range(), fs.c) are pinned -- never evicted -- up
+ *    to Z_DISKCACHE_PIN_MAX of them, since every launch, listing and
+ *    cluster-chain walk comes back to the same few.
+ *
+ * The slot buffers are one k_imgcache_alloc() at the first
+ * disk_initialize() (the f_mount() in sh.c) -- not static, which
+ * would grow kernel.bin (padded out to _end) by the whole cache, and
+ * not at k_diskcache_init() time, which runs before process zero has
+ * claimed its own memory. If that allocation fails the cache just
+ * passes everything straight through.
+ *
+ * It has no lock of its own: every disk_*() call comes from inside
+ * FatFs, which (ffconf.h: FF_FS_REENTRANT=1) holds the volume lock --
+ * ff_req_grant()/ff_rel_grant() in fs.c -- around each one, so the
+ * cache only ever sees one caller at a time.
+ */
+
+#define Z_DISKCACHE_SLOTS    32  // 512-byte sectors -- 16KB
+#define Z_DISKCACHE_PIN_MAX  8   // of those, at most this many pinned FAT sectors
+
+// sdmm.c's driver entry points (renamed from disk_*())
+DSTATUS mmc_disk_initialize(BYTE drv);
+DSTATUS mmc_disk_status(BYTE drv);
+DRESULT mmc_disk_read(BYTE drv, BYTE *buff, LBA_t sector, UINT count);
+DRESULT mmc_disk_write(BYTE drv, const BYTE *buff, LBA_t sector, UINT count);
+DRESULT mmc_disk_ioctl(BYTE drv, BYTE ctrl, void *buff);
+
+// empties the slot table -- called once from kernel.c's main(),
+// alongside k_imgcache_init(), for the same not-reliably-zero-.bss
+// reason.
+void k_diskcache_init(void);
+
+// writes every dirty slot back to the card. false if any write failed
+// (those slots stay dirty).
+bool k_diskcache_flush(void);
+
+// prints the slot table and counters -- `dc` in sh.c.
+z_rv k_diskcache_dump(void);
+
+#endif
@@ -36,6 +36,8 @@
 /*-------------------------------------------------------------------------*/
 
 #include "zeitlos.h"		/* Include device specific declareation file here */
+#include "zsoc.h"
+#include "../diskcache.h"
 
 #define DO_INIT()						/* Initialize port for MMC DO as input */
 #define DO			(reg_sdcard &	0x01)	/* Test for MMC DO ('H':true, 'L':false) */
@@ -100,6 +102,91 @@ DSTATUS Stat = STA_NOINIT;	/* Disk status */
 static
 BYTE CardType;			/* b0:MMC, b1:SDv1, b2:SDv2, b3:Block addressing */
 
+/* Zeitlos: the bitstream has rtl/spisd.v's SPI master, so bytes go
+   through its FIFOs instead of being bit-banged through reg_sdcard.
+   CS is driven through reg_sdcard either way (CS_H()/CS_L() above). */
+static
+BYTE HwSpi;
+
+static
+DWORD HwDiv;			/* reg_sdcard_ctrl's divider field */
+
+#define HW_DIV_INIT	63		/* SCK = clk / (2 * (div + 1)): ~375kHz at 48MHz for init */
+#define HW_DIV_FAST	1		/* ~12MHz at 48MHz, once the card is up */
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Transmit/receive bytes through the SPI master (Zeitlos)               */
+/*-----------------------------------------------------------------------*/
+
+/* Queues everything as 32-bit transfers where it can and single bytes
+   for the rest, with received bits discarded, then waits for the last
+   one to finish shifting -- so CS can't move under it. */
+static
+void hw_xmit_mmc (
+	const BYTE* buff,	/* Data to be sent */
+	UINT bc				/* Number of bytes to send */
+)
+{
+	reg_sdcard_ctrl = Z_SDCARD_DISCARD | HwDiv;
+
+	while (bc) {
+		while (reg_sdcard_status & Z_SDCARD_TX_FULL) ;
+		if (bc >= 4) {
+			reg_sdcard_data32 = ((DWORD)buff[0] << 24) | ((DWORD)buff[1] << 16) |
+				((DWORD)buff[2] << 8) | buff[3];
+			buff += 4; bc -= 4;
+		} else {
+			reg_sdcard_data8 = *buff++;
+			bc--;
+		}
+	}
+
+	while (reg_sdcard_status & Z_SDCARD_BUSY) ;
+}
+
+/* Clocks out 0xFF while keeping at most a FIFO's worth of transfers
+   outstanding, so the engine never stalls on a full RX FIFO for long.
+   Transfers are sized by position (a word while 4+ bytes are left,
+   then bytes), so the n-th one popped is always the n-th one queued. */
+static
+void hw_rcvr_mmc (
+	BYTE *buff,	/* Pointer to read buffer */
+	UINT bc		/* Number of bytes to receive */
+)
+{
+	UINT req = 0, got = 0, inflight = 0;
+	DWORD w, s;
+
+
+	reg_sdcard_ctrl = HwDiv;
+
+	while (got < bc) {
+		while (req < bc && inflight < Z_SDCARD_FIFO_DEPTH) {
+			if (bc - req >= 4) {
+				reg_sdcard_data32 = 0xFFFFFFFF; req += 4;
+			} else {
+				reg_sdcard_data8 = 0xFF; req++;
+			}
+			inflight++;
+		}
+		s = reg_sdcard_status;
+		for (s = Z_SDCARD_RX_LEVEL(s); s; s--) {
+			w = reg_sdcard_data32;
+			if (bc - got >= 4) {
+				buff[got++] = (BYTE)(w >> 24);
+				buff[got++] = (BYTE)(w >> 16);
+				buff[got++] = (BYTE)(w >> 8);
+				buff[got++] = (BYTE)w;
+			} else {
+				buff[got++] = (BYTE)w;
+			}
+			inflight--;
+		}
+	}
+}
+
 
 
 /*-----------------------------------------------------------------------*/
@@ -115,6 +202,11 @@ void xmit_mmc (
 	BYTE d;
 
 
+	if (HwSpi) {
+		hw_xmit_mmc(buff, bc);
+		return;
+	}
+
 	do {
 		d = *buff++;	/* Get a byte to be sent */
 		if (d & 0x80) DI_H(); else DI_L();	/* bit7 */
@@ -151,6 +243,11 @@ void rcvr_mmc (
 	BYTE r;
 
 
+	if (HwSpi) {
+		hw_rcvr_mmc(buff, bc);
+		return;
+	}
+
 	DI_H();	/* Send 0xFF */
 
 	do {
@@ -246,10 +343,15 @@ int rcvr_datablock (	/* 1:OK, 0:Failed */
 	UINT tmr;
 
 
-	for (tmr = 1000; tmr; tmr--) {	/* Wait for data packet in timeout of 100ms */
+	/* Wait for data packet in timeout of 100ms. Zeitlos: poll back to
+	   back for the first few bytes before backing off -- inside a
+	   CMD18 the next block's token usually turns up within a few byte
+	   times, and a 100us sleep on every miss was a sizable slice of
+	   each 512-byte block at bit-banged speed. */
+	for (tmr = 1000 + 64; tmr; tmr--) {
 		rcvr_mmc(d, 1);
 		if (d[0] != 0xFF) break;
-		dly_us(100);
+		if (tmr <= 1000) dly_us(100);
 	}
 	if (d[0] != 0xFE) return 0;		/* If not valid data token, return with error */
 
@@ -346,12 +448,15 @@ BYTE send_cmd (		/* Returns command response (bit7==1:Send failed)*/
 
 ---------------------------------------------------------------------------*/
 
+/* Zeitlos: named mmc_disk_*() rather than disk_*() -- FatFs's disk_*()
+   are fs/diskcache.c's, which keeps a sector cache in front of these. */
+
 
 /*-----------------------------------------------------------------------*/
 /* Get Disk Status                                                       */
 /*-----------------------------------------------------------------------*/
 
-DSTATUS disk_status (
+DSTATUS mmc_disk_status (
 	BYTE drv			/* Drive number (always 0) */
 )
 {
@@ -366,7 +471,7 @@ DSTATUS disk_status (
 /* Initialize Disk Drive                                                 */
 /*-----------------------------------------------------------------------*/
 
-DSTATUS disk_initialize (
+DSTATUS mmc_disk_initialize (
 	BYTE drv		/* Physical drive nmuber (0) */
 )
 {
@@ -377,6 +482,12 @@ DSTATUS disk_initialize (
 
 	if (drv) return RES_NOTRDY;
 
+	/* Zeitlos: the init sequence runs at <400kHz on either path --
+	   bit-banging is slower than that anyway, the SPI master is
+	   slowed down until the card is up */
+	HwSpi = z_soc_has_feature(Z_FEATURE_SPI_SDCARD_HW);
+	HwDiv = HW_DIV_INIT;
+
 	dly_us(10000);			/* 10ms */
 	CS_INIT(); CS_H();		/* Initialize port pin tied to CS */
 	CK_INIT(); CK_L();		/* Initialize port pin tied to SCLK */
@@ -416,6 +527,7 @@ DSTATUS disk_initialize (
 	CardType = ty;
 	s = ty ? 0 : STA_NOINIT;
 	Stat = s;
+	if (ty) HwDiv = HW_DIV_FAST;
 
 	deselect();
 
@@ -428,7 +540,7 @@ DSTATUS disk_initialize (
 /* Read Sector(s)                                                        */
 /*-----------------------------------------------------------------------*/
 
-DRESULT disk_read (
+DRESULT mmc_disk_read (
 	BYTE drv,			/* Physical drive nmuber (0) */
 	BYTE *buff,			/* Pointer to the data buffer to store read data */
 	LBA_t sector,		/* Start sector number (LBA) */
@@ -439,7 +551,7 @@ DRESULT disk_read (
 	DWORD sect = (DWORD)sector;
 
 
-	if (disk_status(drv) & STA_NOINIT) return RES_NOTRDY;
+	if (mmc_disk_status(drv) & STA_NOINIT) return RES_NOTRDY;
 	if (!(CardType & CT_BLOCK)) sect *= 512;	/* Convert LBA to byte address if needed */
 
 	cmd = count > 1 ? CMD18 : CMD17;			/*  READ_MULTIPLE_BLOCK : READ_SINGLE_BLOCK */
@@ -461,7 +573,7 @@ DRESULT disk_read (
 /* Write Sector(s)                                                       */
 /*-----------------------------------------------------------------------*/
 
-DRESULT disk_write (
+DRESULT mmc_disk_write (
 	BYTE drv,			/* Physical drive nmuber (0) */
 	const BYTE *buff,	/* Pointer to the data to be written */
 	LBA_t sector,		/* Start sector number (LBA) */
@@ -471,7 +583,7 @@ DRESULT disk_write (
 	DWORD sect = (DWORD)sector;
 
 
-	if (disk_status(drv) & STA_NOINIT) return RES_NOTRDY;
+	if (mmc_disk_status(drv) & STA_NOINIT) return RES_NOTRDY;
 	if (!(CardType & CT_BLOCK)) sect *= 512;	/* Convert LBA to byte address if needed */
 
 	if (count == 1) {	/* Single block write */
@@ -500,7 +612,7 @@ DRESULT disk_write (
 /* Miscellaneous Functions                                               */
 /*-----------------------------------------------------------------------*/
 
-DRESULT disk_ioctl (
+DRESULT mmc_disk_ioctl (
 	BYTE drv,		/* Physical drive nmuber (0) */
 	BYTE ctrl,		/* Control code */
 	void *buff		/* Buffer to send/receive control data */
@@ -511,7 +623,7 @@ DRESULT disk_ioctl (
 	DWORD cs;
 
 
-	if (disk_status(drv) & STA_NOINIT) return RES_NOTRDY;	/* Check if card is in the socket */
+	if (mmc_disk_status(drv) & STA_NOINIT) return RES_NOTRDY;	/* Check if card is in the socket */
 
 	res = RES_ERROR;
 	switch (ctrl) {
@@ -5,18 +5,78 @@
 
 #include "fatfs/ff.h"
 #include "fs.h"
+#include "../imgcache.h"
+#include "../fmap.h"
+#include "../kernel.h"
 
 FATFS sdvol0;
 
+// -- FatFs's volume lock (ffconf.h: FF_FS_REENTRANT) --
+//
+// every f_*() call on the volume takes this for its duration. Held by
+// pid + 1 (0 = free) rather than a plain flag, so a holder that was
+// killed mid-call -- it will never give it back -- can be recognised
+// and skipped. One volume, so FF_SYNC_t is just a dummy; the lock
+// word is zeroed by ff_cre_syncobj() at f_mount() time, before which
+// FatFs never asks for it.
+static volatile uint32_t fs_lock_owner;
+
+static bool fs_lock_free(uint32_t pid) {
+	(void)pid;
+	uint32_t owner = fs_lock_owner;
+	if (!owner) return true;
+	return (z_procs[owner - 1].flags & (Z_PROC_FLAG_ACTIVE | Z_PROC_FLAG_DIE)) !=
+		Z_PROC_FLAG_ACTIVE;
+}
+
+int ff_cre_syncobj(BYTE vol, FF_SYNC_t *sobj) {
+	(void)vol;
+	*sobj = 0;
+	fs_lock_owner = 0;
+	return 1;
+}
+
+int ff_del_syncobj(FF_SYNC_t sobj) {
+	(void)sobj;
+	return 1;
+}
+
+// pid 0 can't sleep (k_proc_block() returns straight away for it), so
+// the shell spins here instead -- the holder still gets its turns
+int ff_req_grant(FF_SYNC_t sobj) {
+	(void)sobj;
+	uint32_t start = z_kernel_ticks;
+	for (;;) {
+		uint32_t old_mask = maskirq(0xFFFFFFFF);
+		if (fs_lock_free(z_pid)) {
+			fs_lock_owner = z_pid + 1;
+			maskirq(old_mask);
+			return 1;
+		}
+		maskirq(old_mask);
+		if (z_kernel_ticks - start >= FF_FS_TIMEOUT) return 0;	// FR_TIMEOUT
+		k_proc_block(fs_lock_free, 1);
+	}
+}
+
+void ff_rel_grant(FF_SYNC_t sobj) {
+	(void)sobj;
+	fs_lock_owner = 0;
+}
+
+// Reads the whole file straight into dst with one f_read(), rather
+// than 1KB at a time through a stack buffer and a memcpy(). FatFs only
+// goes through its one-sector window for a partial sector at either
+// end; every whole sector in between is read by disk_read() directly
+// into dst, a cluster's worth per call, which sdmm.c turns into a
+// single READ_MULTIPLE_BLOCK (CMD18) instead of one command/response/
+// token handshake per sector.
 int fs_load(uint32_t dst, char *path) {
 
 	FIL f;
 	FRESULT res;
 	FSIZE_t sz;
-	UINT br;
-
-	char buf[1024];
-	char *dst_ptr = (char *)dst;
+	UINT br = 0;
 
 	res = f_open(&f, path, FA_READ | FA_OPEN_EXISTING);
 
@@ -27,21 +87,11 @@ int fs_load(uint32_t dst, char *path) {
 
 	// printf("loading %li bytes ...\n", sz);
 
-	int blks = sz / 1024;
-
-	for (int i = 0; i < blks; i++) {
-		res = f_read(&f, buf, 1024, &br);
-		memcpy(dst_ptr, &buf, 1024);
-		dst_ptr += 1024;
-		if (res != FR_OK) return 1;
-	}
-
-	res = f_read(&f, buf, sz - (blks * 1024), &br);
-	memcpy(dst_ptr, &buf, sz - (blks * 1024));
-	if (res != FR_OK) return 1;
-
+	res = f_read(&f, (void *)(uintptr_t)dst, (UINT)sz, &br);
 	f_close(&f);
 
+	if (res != FR_OK || br != sz) return 1;
+
 	return 0;
 
 }
@@ -78,6 +128,8 @@ int fs_touch(char *path) {
 	FIL f;
 	FRESULT res;
 
+	k_imgcache_invalidate(path);	// FA_CREATE_ALWAYS truncates -- see imgcache.h
+	k_fmap_invalidate(path);	// and fmap.h
 	res = f_open(&f, path, FA_WRITE | FA_CREATE_ALWAYS);
 
 	if (res == FR_OK) {
@@ -91,6 +143,13 @@ int fs_touch(char *path) {
 
 }
 
+bool fs_fat_range(LBA_t *start, DWORD *count) {
+	if (!sdvol0.fs_type) return false;	// not mounted (yet) -- f_mount() is lazy
+	*start = sdvol0.fatbase;
+	*count = sdvol0.fsize * sdvol0.n_fats;
+	return true;
+}
+
 int fs_mount(void)
 {
 	FRESULT res;
@@ -166,11 +225,17 @@ int fs_write_file(char *path, char *buf, uint32_t len) {
 	FRESULT res;
 	UINT bw;
 
+	k_imgcache_invalidate(path);	// see imgcache.h
+	k_fmap_invalidate(path);	// and fmap.h
 	res = f_open(&f, path, FA_WRITE | FA_CREATE_ALWAYS);
 
 	if (res == FR_OK) {
 
+		// one contiguous run when there's room for it -- see fs.h
+		fs_preallocate(&f, len);
+		bw = 0;
 		f_write(&f, buf, len, &bw);
+		fs_trim(&f);
 		res = f_close(&f);
 
 		return bw;
@@ -185,6 +250,8 @@ int fs_write_file(char *path, char *buf, uint32_t len) {
 // -- chunked (streaming) read/write -- see fs.h --
 
 int fs_open_write(FIL *f, char *path) {
+	k_imgcache_invalidate(path);	// see imgcache.h
+	k_fmap_invalidate(path);	// and fmap.h
 	FRESULT res = f_open(f, path, FA_WRITE | FA_CREATE_ALWAYS);
 	if (res != FR_OK) {
 		printf("fs_open_write: failed; error code: %i\n", res);
@@ -232,6 +299,43 @@ int fs_close_read(FIL *f) {
 	return (res == FR_OK) ? 1 : 0;
 }
 
+bool fs_preallocate(FIL *f, uint32_t size) {
+	if (!size) return false;
+	return f_expand(f, (FSIZE_t)size, 1) == FR_OK;
+}
+
+void fs_trim(FIL *f) {
+	if (f_tell(f) >= f_size(f)) return;
+	f->cltbl = NULL;	// f_truncate() follows the FAT, not the map
+	f_truncate(f);
+}
+
+bool fs_linkmap(FIL *f, DWORD *tbl, uint32_t len) {
+	tbl[0] = len;
+	f->cltbl = tbl;
+	if (f_lseek(f, CREATE_LINKMAP) == FR_OK) return true;
+	f->cltbl = NULL;	// FR_NOT_ENOUGH_CORE: too fragmented for tbl
+	return false;
+}
+
+void fs_linkmap_write(FIL *f, uint32_t len) {
+	if (f->cltbl && f_tell(f) + len > f_size(f)) f->cltbl = NULL;
+}
+
+// FatFs (no LFN, ffconf.h) is case-insensitive and callers pass
+// whatever path the user typed ("/TERM", "term") -- the kernel's
+// name-keyed caches compare names in this one form: no leading '/',
+// upper case, cut to out_len - 1 chars.
+void fs_name_norm(char *out, const char *name, uint32_t out_len) {
+	while (*name == '/') name++;
+	uint32_t i;
+	for (i = 0; i < out_len - 1 && name[i]; i++) {
+		char c = name[i];
+		out[i] = (c >= 'a' && c <= 'z') ? (c - 'a' + 'A') : c;
+	}
+	out[i] = 0;
+}
+
 int fs_mkdir(char *path) {
 
 	FRESULT res;
@@ -255,6 +359,8 @@ int fs_unlink(char *path) {
 
 	printf("deleting '%s' ...\n", path);
 
+	k_imgcache_invalidate(path);	// see imgcache.h
+	k_fmap_invalidate(path);	// and fmap.h
 	res = f_unlink(path);
 
 	if (res != FR_OK) {
@@ -2,10 +2,15 @@
 #define Z_FS_H
 
 #include <stdint.h>
+#include <stdbool.h>
 
 #include "fatfs/ff.h"
 
 int fs_mount(void);
+
+// the mounted volume's FAT sectors (every copy), for diskcache.c's
+// pinning. false if nothing is mounted yet.
+bool fs_fat_range(LBA_t *start, DWORD *count);
 int fs_format(void);
 uint32_t fs_total(void);
 uint32_t fs_free(void);
@@ -18,6 +23,8 @@ int fs_write_file(char *path, char *buf, uint32_t len);
 int fs_touch(char *path);
 int fs_mkdir(char *path);
 int fs_unlink(char *path);
+// the form imgcache.c and fmap.c key their entries by -- see fs.c
+void fs_name_norm(char *out, const char *name, uint32_t out_len);
 void fs_list_dir(char *path);
 
 // -- chunked (streaming) read/write --
@@ -36,4 +43,29 @@ int fs_open_read(FIL *f, char *path);
 int32_t fs_read_chunk(FIL *f, void *buf, uint32_t maxlen);
 int fs_close_read(FIL *f);
 
+// -- contiguous files and fast seek (ffconf.h: FF_USE_EXPAND,
+// FF_USE_FASTSEEK) --
+//
+// fs_preallocate() gives a just-created (empty) file `size` bytes of
+// contiguous clusters up front with f_expand(), instead of f_write()
+// growing the chain a cluster at a time. The file's size is `size`
+// straight away -- fs_trim() cuts it back to what was actually written
+// before closing. Returns false (and leaves the file as it was) if
+// there's no contiguous run that long; writing then just allocates as
+// usual.
+//
+// fs_linkmap() builds a cluster link map (CLMT) for an open file in
+// the caller's `tbl` of `len` DWORDs, so f_read()/f_write() find each
+// next cluster from the table instead of the FAT. `len` DWORDs cover
+// (len - 1) / 2 fragments; a file in more pieces than that gets no
+// map (false) and works as before. The table has to stay put for as
+// long as the file is open. With a map, FatFs can't write past the
+// mapped clusters, so fs_linkmap_write() drops the map first when a
+// write of `len` bytes would run beyond the end of the file.
+
+bool fs_preallocate(FIL *f, uint32_t size);
+void fs_trim(FIL *f);
+bool fs_linkmap(FIL *f, DWORD *tbl, uint32_t len);
+void fs_linkmap_write(FIL *f, uint32_t len);
+
 #endif
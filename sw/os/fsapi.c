@@ -12,6 +12,23 @@
 #include "kernel.h"
 #include "fsapi.h"
 #include "fs/fs.h"
+#include "imgcache.h"
+#include "fmap.h"
+#include "msg.h"
+#include "mem.h"
+#include "../common/zstream.h"
+
+// zfs.h's Z_FS_TOPIC_CHANGED. Built by hand rather than with
+// z_obj_str(), which would malloc() a copy (see fsapi.h on kernel
+// code and malloc()) -- `name` is still in the calling app's own
+// view, and the publish copies it out for each subscriber before
+// returning anyway.
+static void fs_changed(const char *name, uint32_t what) {
+	z_obj_t obj;
+	obj.type = Z_STR;
+	obj.val.str = (char *)name;
+	z_msg_publish(Z_FS_TOPIC_CHANGED, what, obj);
+}
 
 z_obj_t *k_fs_size(z_obj_t *args) {
 
@@ -82,17 +99,27 @@ z_obj_t *k_fs_write(z_obj_t *args) {
 
 	a->written = 0;
 
+	k_imgcache_invalidate(a->name);	// see imgcache.h
+	k_fmap_invalidate(a->name);	// and fmap.h
+
 	FIL f;
 	FRESULT res = f_open(&f, a->name, FA_WRITE | FA_CREATE_ALWAYS);
 	if (res != FR_OK) return (&z_fail);
 
+	// the whole size is known up front -- one contiguous run when
+	// there's room for it (fs_preallocate(), fs/fs.h), so te's saves
+	// go out as multi-sector writes rather than a cluster at a time
+	fs_preallocate(&f, a->len);
+
 	UINT bw = 0;
 	res = f_write(&f, a->buf, (UINT)a->len, &bw);
+	fs_trim(&f);
 	FRESULT cres = f_close(&f);
 
 	if (res != FR_OK || cres != FR_OK) return (&z_fail);
 
 	a->written = (uint32_t)bw;
+	fs_changed(a->name, Z_FS_CHANGED_WRITE);
 	return (&z_ok);
 
 }
@@ -118,18 +145,106 @@ z_obj_t *k_fs_unlink(z_obj_t *args) {
 	// already has.
 	if (fs_unlink(a->name) != 0) return (&z_fail);
 
+	fs_changed(a->name, Z_FS_CHANGED_UNLINK);
 	return (&z_ok);
 
 }
 
+// -- readahead -- see fsapi.h --
+
+static __attribute__((section(".bss"))) uint8_t *z_fs_ra_pool;
+
+void k_fs_readahead_init(void) {
+	z_fs_ra_pool = NULL;
+}
+
+// the slot's slice of the pool stays the slot's, whoever opens it next
+static void fs_ra_reset(z_fs_readahead_t *ra, uint32_t slot) {
+	ra->slot = slot;
+	ra->buf = z_fs_ra_pool ? z_fs_ra_pool + slot * Z_FS_RA_MAX : NULL;
+	ra->off = ra->len = 0;
+	ra->window = Z_FS_RA_MIN;
+	ra->run = 0;
+}
+
+FRESULT fs_ra_read(FIL *f, z_fs_readahead_t *ra, void *buf, uint32_t len, UINT *br) {
+
+	if (!ra) return f_read(f, buf, (UINT)len, br);
+
+	uint8_t *dst = (uint8_t *)buf;
+	*br = 0;
+
+	// whatever's already read ahead comes first
+	uint32_t have = ra->len - ra->off;
+	if (have) {
+		uint32_t n = (have < len) ? have : len;
+		memcpy(dst, ra->buf + ra->off, n);
+		ra->off += n;
+		dst += n;
+		len -= n;
+		*br += n;
+		if (!len) return FR_OK;
+	}
+
+	UINT n = 0;
+	FRESULT res;
+
+	// a big read, the first small one of a run, or no buffer to be
+	// had: straight through
+	if (len >= Z_FS_RA_MAX) ra->run = 0;
+	else ra->run++;
+
+	if (ra->run >= 2 && !ra->buf) {
+		uint32_t old_mask = maskirq(0xFFFFFFFF);
+		if (!z_fs_ra_pool) z_fs_ra_pool = (uint8_t *)k_imgcache_alloc(Z_FS_MAX_OPEN * Z_FS_RA_MAX);
+		maskirq(old_mask);
+		if (z_fs_ra_pool) ra->buf = z_fs_ra_pool + ra->slot * Z_FS_RA_MAX;
+	}
+
+	if (ra->run < 2 || !ra->buf) {
+		if (!ra->run) ra->window = Z_FS_RA_MIN;
+		res = f_read(f, dst, (UINT)len, &n);
+		*br += n;
+		return res;
+	}
+
+	// refill -- at least this read's worth, so it's never cut short
+	// anywhere but the end of the file
+	while (ra->window < len) ra->window *= 2;
+	res = f_read(f, ra->buf, (UINT)ra->window, &n);
+	if (res != FR_OK) return res;
+	if (ra->window < Z_FS_RA_MAX) ra->window *= 2;
+
+	ra->off = (n < len) ? n : len;
+	ra->len = n;
+	memcpy(dst, ra->buf, ra->off);
+	*br += ra->off;
+	return FR_OK;
+
+}
+
 // see zfs.h's own comment for the full design writeup on why chunked
 // I/O needs a kernel-side handle table at all.
 static struct {
 	bool		used;
 	uint32_t	owner_pid;
 	FIL		fil;
+	// write handles only (empty for reads): what to publish on
+	// Z_FS_TOPIC_CHANGED at close, since FIL doesn't keep the name
+	char		changed[Z_FS_CHANGED_NAME_MAX];
+	// the file's cluster link map while it's open (fil.cltbl points
+	// here when there is one) -- see fs_linkmap(), fs/fs.h
+	DWORD		linkmap[Z_FS_LINKMAP_LEN];
+	z_fs_readahead_t ra;		// read handles only
 } z_fs_handles[Z_FS_MAX_OPEN];
 
+// a write handle's readahead state is whatever the slot's last read
+// handle left there -- a read through one (which FatFs refuses anyway)
+// goes straight to f_read()
+static z_fs_readahead_t *z_fs_handle_ra(int slot) {
+	return z_fs_handles[slot].changed[0] ? NULL : &z_fs_handles[slot].ra;
+}
+
 static int z_fs_alloc_handle(void) {
 	for (int i = 0; i < Z_FS_MAX_OPEN; i++)
 		if (!z_fs_handles[i].used) return i;
@@ -146,11 +261,24 @@ z_obj_t *k_fs_open_write(z_obj_t *args) {
 	int slot = z_fs_alloc_handle();
 	if (slot < 0) return (&z_fail);
 
+	k_imgcache_invalidate(a->name);	// see imgcache.h
+	k_fmap_invalidate(a->name);	// and fmap.h
 	FRESULT res = f_open(&z_fs_handles[slot].fil, a->name, FA_WRITE | FA_CREATE_ALWAYS);
 	if (res != FR_OK) return (&z_fail);
 
+	// a caller that knows how big the file will be gets it in one
+	// contiguous run, mapped, so every chunk after the first goes
+	// straight to its sectors without touching the FAT. No hint, or no
+	// run that long: the file grows a cluster at a time as before.
+	if (fs_preallocate(&z_fs_handles[slot].fil, a->size_hint))
+		fs_linkmap(&z_fs_handles[slot].fil, z_fs_handles[slot].linkmap, Z_FS_LINKMAP_LEN);
+
 	z_fs_handles[slot].used = true;
 	z_fs_handles[slot].owner_pid = z_pid;
+	uint32_t n = strlen(a->name);
+	if (n > Z_FS_CHANGED_NAME_MAX - 1) n = Z_FS_CHANGED_NAME_MAX - 1;
+	memcpy(z_fs_handles[slot].changed, a->name, n);
+	z_fs_handles[slot].changed[n] = 0;
 	a->handle = slot;
 
 	return (&z_ok);
@@ -170,8 +298,14 @@ z_obj_t *k_fs_open_read(z_obj_t *args) {
 	FRESULT res = f_open(&z_fs_handles[slot].fil, a->name, FA_READ | FA_OPEN_EXISTING);
 	if (res != FR_OK) return (&z_fail);
 
+	// best effort: a file in more fragments than the map holds is read
+	// by following the FAT, as it always was
+	fs_linkmap(&z_fs_handles[slot].fil, z_fs_handles[slot].linkmap, Z_FS_LINKMAP_LEN);
+	fs_ra_reset(&z_fs_handles[slot].ra, (uint32_t)slot);
+
 	z_fs_handles[slot].used = true;
 	z_fs_handles[slot].owner_pid = z_pid;
+	z_fs_handles[slot].changed[0] = 0;
 	a->handle = slot;
 
 	return (&z_ok);
@@ -196,7 +330,8 @@ z_obj_t *k_fs_read_chunk(z_obj_t *args) {
 		return (&z_fail);
 
 	UINT br = 0;
-	FRESULT res = f_read(&z_fs_handles[a->handle].fil, a->buf, (UINT)a->maxlen, &br);
+	FRESULT res = fs_ra_read(&z_fs_handles[a->handle].fil, z_fs_handle_ra(a->handle),
+		a->buf, a->maxlen, &br);
 	if (res != FR_OK) return (&z_fail);
 
 	a->len = (uint32_t)br;
@@ -215,6 +350,8 @@ z_obj_t *k_fs_write_chunk(z_obj_t *args) {
 	if (!z_fs_handles[a->handle].used || z_fs_handles[a->handle].owner_pid != z_pid)
 		return (&z_fail);
 
+	fs_linkmap_write(&z_fs_handles[a->handle].fil, a->len);
+
 	UINT bw = 0;
 	FRESULT res = f_write(&z_fs_handles[a->handle].fil, a->buf, (UINT)a->len, &bw);
 	if (res != FR_OK) return (&z_fail);
@@ -232,9 +369,15 @@ z_obj_t *k_fs_close(z_obj_t *args) {
 	if (!z_fs_handles[a->handle].used || z_fs_handles[a->handle].owner_pid != z_pid)
 		return (&z_fail);
 
+	// a preallocated file that got less than its hint gives the rest back
+	if (z_fs_handles[a->handle].changed[0]) fs_trim(&z_fs_handles[a->handle].fil);
+
 	FRESULT res = f_close(&z_fs_handles[a->handle].fil);
 	z_fs_handles[a->handle].used = false;
 
+	if (res == FR_OK && z_fs_handles[a->handle].changed[0])
+		fs_changed(z_fs_handles[a->handle].changed, Z_FS_CHANGED_WRITE);
+
 	return (res == FR_OK) ? (&z_ok) : (&z_fail);
 
 }
@@ -320,3 +463,381 @@ z_obj_t *k_fs_list(z_obj_t *args) {
 	return (&z_ok);
 
 }
+
+// -- splice -- see zfs.h
+
+static void splice_err(char *err, uint32_t err_len, const char *msg) {
+	if (!err || !err_len) return;
+	uint32_t n = strlen(msg);
+	if (n > err_len - 1) n = err_len - 1;
+	memcpy(err, msg, n);
+	err[n] = 0;
+}
+
+// the caller's next message, sleeping on an empty mailbox rather than
+// spinning on it the way zstream_pull() does -- false once `timeout`
+// ticks have passed since `start` with nothing (0 = never)
+static bool splice_next(z_msg_t *msg, uint32_t start, uint32_t timeout) {
+	while (z_msg_read(msg) != Z_OK) {
+		uint32_t waited = z_uptime_ticks() - start;
+		if (timeout && waited >= timeout) return false;
+		z_msg_block(timeout ? timeout - waited : 0);
+	}
+	return true;
+}
+
+bool fs_splice_in(FIL *f, zstream_consumer_t *cons, uint32_t timeout,
+	uint32_t *bytes, char *err, uint32_t err_len) {
+
+	*bytes = 0;
+
+	if (!cons->active) {
+		splice_err(err, err_len, "stream not open");
+		return false;
+	}
+
+	while (1) {
+
+		zstream_pull_async(cons);
+		uint32_t start = z_uptime_ticks();
+
+		while (1) {
+
+			z_msg_t msg;
+			if (!splice_next(&msg, start, timeout)) {
+				zstream_abort(cons);
+				splice_err(err, err_len, "timed out waiting for next chunk");
+				return false;
+			}
+
+			const uint8_t *data;
+			uint32_t len;
+			zstream_consumer_event_t ev =
+				zstream_consumer_handle(cons, &msg, &data, &len, err, err_len);
+
+			if (ev == ZSTREAM_CEVENT_EOF) return true;
+			if (ev == ZSTREAM_CEVENT_ERROR) return false;
+			if (ev != ZSTREAM_CEVENT_CHUNK) {
+				// not this stream's -- nothing else is reading the
+				// caller's mailbox while it's in here
+				z_msg_release(&msg);
+				continue;
+			}
+
+			// `data` is the producer's own blob, resolved to a
+			// physical address by z_msg_read() -- straight to FatFs
+			fs_linkmap_write(f, len);
+			UINT bw = 0;
+			FRESULT res = f_write(f, data, (UINT)len, &bw);
+			*bytes += bw;
+
+			if (res != FR_OK || bw != len) {
+				zstream_abort(cons);
+				splice_err(err, err_len, "local write failed");
+				return false;
+			}
+
+			break;
+
+		}
+
+	}
+
+}
+
+bool fs_splice_out(FIL *f, z_fs_readahead_t *ra, zstream_producer_t *prod,
+	z_fs_splice_chunk_t *chunk, uint32_t timeout, uint32_t *bytes,
+	char *err, uint32_t err_len) {
+
+	*bytes = 0;
+
+	if (!prod->active || prod->window != 1 || !chunk) {
+		splice_err(err, err_len, "stream not open");
+		return false;
+	}
+
+	// lent as-is, like zstream_send_chunk()'s blob, but never put in
+	// prod->held[] -- it isn't ours to free, so retries are answered
+	// below rather than by zstream_producer_handle()
+	z_obj_t obj;
+	obj.type = Z_BLOB;
+	obj.val.ptr = &chunk->blob;
+	chunk->blob.data = chunk->data;
+	chunk->blob.len = 0;
+
+	uint32_t start = z_uptime_ticks();
+
+	while (1) {
+
+		z_msg_t msg;
+		if (!splice_next(&msg, start, timeout)) {
+			zstream_producer_close(prod);
+			splice_err(err, err_len, "timed out waiting for a pull");
+			return false;
+		}
+
+		// a repeat of the pull our chunk already answered
+		if (msg.subject == Z_STREAM_PULL && chunk->blob.len &&
+			ZSTREAM_TAG_STREAM_ID(msg.tag) == (prod->stream_id & 0xffff) &&
+			ZSTREAM_TAG_SEQ(msg.tag) == (prod->seq & 0xffff) &&
+			prod->seq == prod->acked) {
+			z_msg_new_send(prod->consumer_pid, Z_STREAM_CHUNK,
+				ZSTREAM_TAG(prod->stream_id, prod->seq), obj);
+			z_msg_release(&msg);
+			continue;
+		}
+
+		zstream_event_t ev = zstream_producer_handle(prod, &msg);
+		z_msg_release(&msg);
+
+		if (ev == ZSTREAM_EVENT_ABORT) {
+			prod->active = false;
+			splice_err(err, err_len, "consumer aborted");
+			return false;
+		}
+
+		if (ev != ZSTREAM_EVENT_PULL) continue;
+
+		// the pull for the next seq: the consumer is done with the
+		// chunk still sitting in `chunk`
+		UINT br = 0;
+		if (fs_ra_read(f, ra, chunk->data, sizeof(chunk->data), &br) != FR_OK) {
+			// Z_NONE rather than zstream_send_error()'s string, which
+			// z_obj_str() would malloc() (see fsapi.h)
+			uint32_t seq = prod->seq + 1;
+			z_msg_new_send(prod->consumer_pid, Z_STREAM_ERROR,
+				ZSTREAM_TAG(prod->stream_id, seq), z_obj_none());
+			prod->seq = seq;
+			prod->active = false;
+			splice_err(err, err_len, "local read failed");
+			return false;
+		}
+
+		if (br == 0) {
+			zstream_send_eof(prod);
+			return true;	// the consumer's pull for the EOF needs no answer
+		}
+
+		chunk->blob.len = br;
+		uint32_t seq = prod->seq + 1;	// UINT32_MAX before the first
+		z_msg_new_send(prod->consumer_pid, Z_STREAM_CHUNK,
+			ZSTREAM_TAG(prod->stream_id, seq), obj);
+		prod->seq = seq;
+		*bytes += br;
+		start = z_uptime_ticks();
+
+		// f_read() only comes up short at the end of the file, and a
+		// short chunk is already the end of a TFTP PUT -- net won't
+		// pull again (tftp.c), so don't wait on it. The chunk stays
+		// lent from `chunk` until net has sent it on.
+		if (br < sizeof(chunk->data)) return true;
+
+	}
+
+}
+
+z_obj_t *k_fs_splice(z_obj_t *args) {
+
+	z_fs_splice_args_t *a = (z_fs_splice_args_t *)args;
+	if (a) a->bytes = 0;
+
+	if (!a || !a->stream || a->handle < 0 || a->handle >= Z_FS_MAX_OPEN)
+		return (&z_fail);
+
+	if (!z_fs_handles[a->handle].used || z_fs_handles[a->handle].owner_pid != z_pid)
+		return (&z_fail);
+
+	FIL *f = &z_fs_handles[a->handle].fil;
+	bool ok;
+
+	if (a->op == Z_FS_SPLICE_IN)
+		ok = fs_splice_in(f, (zstream_consumer_t *)a->stream, a->timeout,
+			&a->bytes, a->err, a->err_len);
+	else if (a->op == Z_FS_SPLICE_OUT)
+		ok = fs_splice_out(f, z_fs_handle_ra(a->handle), (zstream_producer_t *)a->stream, a->chunk,
+			a->timeout, &a->bytes, a->err, a->err_len);
+	else
+		return (&z_fail);
+
+	return ok ? (&z_ok) : (&z_fail);
+
+}
+
+// -- asynchronous requests -- see zfs.h --
+
+#define Z_FS_ASYNC_GONE		0xFFFFFFFF	// pid of a request whose owner exited
+
+// how long a finished request waits for room in its owner's mailbox
+// before the completion is dropped -- so one process not reading its
+// mail can't hold up everyone queued behind it for good
+#define Z_FS_ASYNC_DELIVER_TICKS	1000
+
+typedef struct {
+	uint32_t	pid;		// who asked, and who hears back
+	uint32_t	id;
+	uint32_t	op;
+	void		*buf;		// physical -- z_translate()d at submit time,
+					// since pid 0 is the one that uses it
+	uint32_t	len;
+	char		name[Z_FS_ASYNC_NAME_MAX];
+	bool		done;		// serviced, completion not yet delivered
+	int32_t		result;
+	uint32_t	done_ticks;
+} z_fs_async_req_t;
+
+// a ring, oldest at z_fs_async_head
+static __attribute__((section(".bss"))) z_fs_async_req_t z_fs_async[Z_FS_ASYNC_MAX];
+static __attribute__((section(".bss"))) uint32_t z_fs_async_head;
+static __attribute__((section(".bss"))) uint32_t z_fs_async_count;
+static __attribute__((section(".bss"))) uint32_t z_fs_async_next_id;
+// pid + 1 of the request being serviced right now (0: none) -- its
+// buffer is that process's memory, see k_fs_async_busy()
+static __attribute__((section(".bss"))) uint32_t z_fs_async_serving;
+
+void k_fs_async_init(void) {
+	memset(z_fs_async, 0, sizeof(z_fs_async));
+	z_fs_async_head = 0;
+	z_fs_async_count = 0;
+	z_fs_async_next_id = 0;
+	z_fs_async_serving = 0;
+}
+
+z_obj_t *k_fs_async(z_obj_t *args) {
+
+	z_fs_async_args_t *a = (z_fs_async_args_t *)args;
+	if (a) a->id = 0;
+
+	if (!a) return (&z_fail);
+
+	switch (a->op) {
+		case Z_FS_ASYNC_READ:
+			if (!a->name || !a->buf || !a->len) return (&z_fail);
+			break;
+		case Z_FS_ASYNC_WRITE:
+			if (!a->name || (!a->buf && a->len)) return (&z_fail);
+			break;
+		case Z_FS_ASYNC_LIST:
+			if (!a->buf || !a->len) return (&z_fail);
+			break;
+		default:
+			return (&z_fail);
+	}
+
+	uint32_t n = a->name ? strlen(a->name) : 0;
+	if (n >= Z_FS_ASYNC_NAME_MAX) return (&z_fail);
+
+	uint32_t old_mask = maskirq(0xFFFFFFFF);
+
+	if (z_fs_async_count == Z_FS_ASYNC_MAX) {
+		maskirq(old_mask);
+		return (&z_fail);
+	}
+
+	z_fs_async_req_t *r = &z_fs_async[(z_fs_async_head + z_fs_async_count) % Z_FS_ASYNC_MAX];
+	if (!++z_fs_async_next_id) ++z_fs_async_next_id;	// 0 means "not queued"
+	r->pid = z_pid;
+	r->id = z_fs_async_next_id;
+	r->op = a->op;
+	r->buf = z_translate(z_pid, a->buf);
+	r->len = a->len;
+	memcpy(r->name, a->name ? a->name : "", n);
+	r->name[n] = 0;
+	r->done = false;
+	r->result = -1;
+	z_fs_async_count++;
+
+	maskirq(old_mask);
+
+	a->id = r->id;
+	return (&z_ok);
+
+}
+
+bool k_fs_async_busy(uint32_t pid) {
+	return z_fs_async_serving == pid + 1;
+}
+
+void k_fs_async_release_all(uint32_t pid) {
+	for (uint32_t i = 0; i < z_fs_async_count; i++) {
+		z_fs_async_req_t *r = &z_fs_async[(z_fs_async_head + i) % Z_FS_ASYNC_MAX];
+		if (r->pid == pid) r->pid = Z_FS_ASYNC_GONE;
+	}
+}
+
+// the synchronous handlers above do the actual work -- running as pid
+// 0 with physical pointers, they can't tell the difference
+static int32_t fs_async_service(z_fs_async_req_t *r) {
+
+	switch (r->op) {
+
+		case Z_FS_ASYNC_READ: {
+			z_fs_read_args_t a = { r->name, r->buf, r->len, 0 };
+			if (k_fs_read((z_obj_t *)&a)->val.uint32 != Z_OK) return -1;
+			return (int32_t)a.len;
+		}
+
+		case Z_FS_ASYNC_WRITE: {
+			z_fs_write_args_t a = { r->name, r->buf, r->len, 0 };
+			if (k_fs_write((z_obj_t *)&a)->val.uint32 != Z_OK) return -1;
+			return (int32_t)a.written;
+		}
+
+		case Z_FS_ASYNC_LIST: {
+			z_fs_list_args_t a = { r->name[0] ? r->name : NULL, r->buf, r->len, 0, 0, 0 };
+			if (k_fs_list((z_obj_t *)&a)->val.uint32 != Z_OK) return -1;
+			return (int32_t)(a.count | (a.truncated ? Z_FS_ASYNC_TRUNCATED : 0));
+		}
+
+	}
+
+	return -1;
+
+}
+
+static bool fs_async_deliver(z_fs_async_req_t *r) {
+
+	if (r->pid == Z_FS_ASYNC_GONE || r->pid >= Z_PROCS_MAX) return true;
+	if ((z_procs[r->pid].flags & (Z_PROC_FLAG_ACTIVE | Z_PROC_FLAG_DIE)) != Z_PROC_FLAG_ACTIVE)
+		return true;
+
+	z_obj_t obj;
+	obj.type = Z_INT32;
+	obj.val.int32 = r->result;
+	if (z_msg_new_send(r->pid, Z_FS_ASYNC_DONE, r->id, obj) == Z_OK) return true;
+
+	return z_kernel_ticks - r->done_ticks >= Z_FS_ASYNC_DELIVER_TICKS;
+
+}
+
+void k_fs_async_poll(void) {
+
+	if (z_pid != 0 || !z_fs_async_count) return;
+
+	z_fs_async_req_t *r = &z_fs_async[z_fs_async_head];
+
+	if (!r->done) {
+		// nobody left to read the buffer back -- or to own it. The
+		// check and the mark are one critical section with the reap
+		// (k_fs_async_release_all()), so once we've started, the
+		// owner's memory stays its own until we're done with it.
+		uint32_t old_mask = maskirq(0xFFFFFFFF);
+		bool live = (r->pid != Z_FS_ASYNC_GONE);
+		if (live) z_fs_async_serving = r->pid + 1;
+		maskirq(old_mask);
+		if (live) r->result = fs_async_service(r);
+		old_mask = maskirq(0xFFFFFFFF);
+		z_fs_async_serving = 0;
+		maskirq(old_mask);
+		r->done_ticks = z_kernel_ticks;
+		r->done = true;
+	}
+
+	// a full mailbox: try again on the next poll
+	if (!fs_async_deliver(r)) return;
+
+	uint32_t old_mask = maskirq(0xFFFFFFFF);
+	z_fs_async_head = (z_fs_async_head + 1) % Z_FS_ASYNC_MAX;
+	z_fs_async_count--;
+	maskirq(old_mask);
+
+}
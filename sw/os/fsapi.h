@@ -4,7 +4,9 @@
 #include <stdint.h>
 
 #include "kernel.h"
+#include "fs/fs.h"
 #include "../common/zfs.h"
+#include "../common/zstream.h"
 
 /*
  * Zeitlos OS
@@ -68,24 +70,17 @@
  * writes its result back into caller-owned storage rather than
  * handing back something kernel-allocated.
  *
- * Concurrency note: FatFs's own internal state (this file's `f` local
- * variables aside, sdmm.c/ff.c keep some of their own statics) isn't
- * re-entrant, and unlike z_mailbox_push()/_pop() (msg.c), these
- * handlers do NOT mask interrupts around the underlying f_open/f_read/
- * f_write/f_close calls -- a KTIMER-driven preemption mid-call, onto a
- * different process that ALSO makes an FS_* syscall before the first
- * one's f_close() runs, is a real (if narrow) window for corruption.
- * This exact class of gap already existed before this file for sh.c's
- * own fs_size()/fs_write_file() calls (kernel-native, but sh.c isn't
- * the only thing that can run in kernel context at Z_SYS_UART_* poll
- * points) -- not introduced here, just now reachable from more call
- * sites. Flagged, not fixed, in this revision -- worth real
- * mutual-exclusion (a simple busy flag + maskirq()-protected
- * check-and-set around the whole open/op/close sequence, not just the
- * mailbox-push style single-instruction-ish critical sections msg.c
- * uses) if concurrent FS access from more than one process ever
- * proves to matter in practice. See docs/editor.md for where this is
- * written up alongside `te`'s own memory-budget caveats.
+ * Concurrency: FatFs's own internal state (this file's `f` local
+ * variables aside, sdmm.c/ff.c and fs/diskcache.c keep statics of
+ * their own) isn't re-entrant, and these handlers run preemptibly in
+ * whichever process called them -- alongside sh.c's own fs.c calls
+ * and, since FS_ASYNC, pid 0 working through queued requests in the
+ * background. FatFs's own volume lock (ffconf.h: FF_FS_REENTRANT,
+ * ff_req_grant()/ff_rel_grant() in fs/fs.c) serializes every f_*()
+ * call: a process that finds it held sleeps (k_proc_block()) until
+ * it's free. Separate FILs don't share anything outside that lock, so
+ * one process's open/op/close sequence interleaving with another's,
+ * call by call, is fine.
  */
 
 // -- syscall handlers, registered in syscalls.def -- args are
@@ -125,4 +120,69 @@ z_obj_t *k_fs_read_chunk(z_obj_t *args);
 z_obj_t *k_fs_write_chunk(z_obj_t *args);
 z_obj_t *k_fs_close(z_obj_t *args);
 
+// -- readahead for read handles --
+//
+// FS_READ_CHUNK and FS_SPLICE OUT are typically fed 512 bytes at a
+// time (a TFTP block), and each of those is otherwise its own f_read()
+// -- a single-sector card command, paid for again on every chunk.
+// Instead, once a handle has seen two small reads in a row, the next
+// one reads a whole window ahead into a buffer of the handle's own and
+// the chunks after it are copied out of that. The window starts at
+// Z_FS_RA_MIN and doubles with every refill the reader keeps up with,
+// up to Z_FS_RA_MAX. There's no seek on a handle, so every read
+// carries on from the last -- "sequential" here just means a run of
+// small reads; a read of Z_FS_RA_MAX or more goes straight to FatFs
+// (which already does it at multi-sector speed) and starts the run
+// over. The buffers are one Z_FS_MAX_OPEN * Z_FS_RA_MAX
+// k_imgcache_alloc() made the first time any handle wants one --
+// exactly k_mem_alloc()'s minimum block -- and kept; if it can't be
+// had, reads just go straight through.
+#define Z_FS_RA_MIN	1024
+#define Z_FS_RA_MAX	8192
+
+typedef struct {
+	uint8_t		*buf;		// Z_FS_RA_MAX bytes of the pool, NULL until needed
+	uint32_t	off, len;	// buf[off..len) is read ahead, not yet handed out
+	uint32_t	window;		// the next refill's size
+	uint32_t	run;		// small reads in a row
+	uint32_t	slot;		// which handle -- and so which slice of the pool
+} z_fs_readahead_t;
+
+// empties the pool pointer -- kernel.c's main(), same
+// not-reliably-zero-.bss reason as k_fs_async_init() below
+void k_fs_readahead_init(void);
+
+// f_read() through `ra` (NULL: a plain f_read()) -- same contract,
+// including coming up short only at the end of the file
+FRESULT fs_ra_read(FIL *f, z_fs_readahead_t *ra, void *buf, uint32_t len, UINT *br);
+
+// Z_SYS_FS_SPLICE -- z_fs_splice_args_t, see zfs.h. The two halves
+// are here on their own, on a FIL, for sh.c: it's kernel code with
+// its own FatFs files rather than handles, and calls them directly.
+// Both act as whoever z_pid is -- the stream's messages go out from,
+// and are read from, that process's mailbox.
+z_obj_t *k_fs_splice(z_obj_t *args);
+bool fs_splice_in(FIL *f, zstream_consumer_t *cons, uint32_t timeout,
+	uint32_t *bytes, char *err, uint32_t err_len);
+// `ra` is the handle's readahead, or NULL (sh.c's own FIL)
+bool fs_splice_out(FIL *f, z_fs_readahead_t *ra, zstream_producer_t *prod,
+	z_fs_splice_chunk_t *chunk, uint32_t timeout, uint32_t *bytes,
+	char *err, uint32_t err_len);
+
+// Z_SYS_FS_ASYNC -- z_fs_async_args_t, see zfs.h. Queues the request
+// and returns; k_fs_async_poll() is what does the work, one request
+// per call, and only as pid 0 (kruntime.c's readline() calls it while
+// the shell waits for a key). k_fs_async_init() empties the queue --
+// from kernel.c's main(), same not-reliably-zero-.bss reason as
+// k_msg_init() -- and k_fs_async_release_all() drops a reaped
+// process's requests, alongside k_msg_release_all().
+// k_fs_async_busy() is true while pid's request is being serviced:
+// FatFs is reading into or writing from its memory, so the scheduler
+// holds off reaping it until that's over, as for k_msg_busy().
+z_obj_t *k_fs_async(z_obj_t *args);
+void k_fs_async_init(void);
+void k_fs_async_poll(void);
+bool k_fs_async_busy(uint32_t pid);
+void k_fs_async_release_all(uint32_t pid);
+
 #endif
@@ -28,9 +28,10 @@
  * are wired straight from their own usb_hid_host.v instance's
  * `report` pulse -- fired for keyboard, mouse, *and* gamepad reports
  * alike (see rtl/ext/usb_hid_host/src/usb_hid_host.v). Both ISRs below
- * only act on typ==1 (keyboard) for their own port; mouse reports
- * still just update reg_usbN_cursor directly in hardware (rtl/usb_hid.v)
- * and are polled by wm.c, which -- like this file -- decides which
+ * act on typ==1 (keyboard) for their own port, and on typ==2 (mouse)
+ * only while someone is subscribed (see the next paragraph); otherwise
+ * mouse reports just update reg_usbN_cursor directly in hardware
+ * (rtl/usb_hid.v) and are polled by wm.c, which -- like this file -- decides which
  * port is currently "the mouse" by reading both ports' own typ field,
  * since there's no fixed port-to-device mapping (see zeitlos.h).
  * rtl/sysctl.v's LATCHED_IRQ marks both these bits as edge-latched
@@ -39,6 +40,16 @@
  * actually runs a handful of (faster-clock) cycles later -- latching
  * captures the edge in hardware regardless.
  *
+ * One process at a time can subscribe instead (Z_SYS_HID_SUBSCRIBE,
+ * k_hid_subscribe() below -- wm does): from then on key events go
+ * straight into ITS mailbox as Z_HID_MSG_KEY messages rather than
+ * into the ring, mouse reports go there too as Z_HID_MSG_MOUSE
+ * (consecutive motion merged into one -- z_mailbox_push_merge(),
+ * msg.c), and the push wakes it if it's blocked in z_msg_block(). So
+ * input reaches the subscriber as soon as the interrupt fires, not
+ * whenever its poll loop next gets round to looking, and it doesn't
+ * need a poll loop at all.
+ *
  * Deliberately raw here: this layer only knows USB HID usage codes,
  * not ASCII/keysyms -- see sw/common/zkbd.h (used by wm.c) for that
  * translation. Keeping it out of the kernel means keyboard layout
@@ -53,6 +64,7 @@
 #include "../common/zeitlos.h"
 #include "../common/zkbd.h"
 #include "kernel.h"
+#include "msg.h"
 #include "hid.h"
 
 #define HID_FIFO_SIZE 32
@@ -80,15 +92,49 @@ typedef struct {
 
 static hid_port_t port0, port1;
 
+// the one process (if any) input goes to as mailbox messages instead
+// of hid_fifo -- see k_hid_subscribe(). 0 = nobody: pid 0 is the
+// shell, which never wants this.
+static volatile uint32_t __attribute__((section(".bss"))) hid_subscriber;
+
 void z_hid_init(void) {
 	port0.modifiers = 0;
 	port0.keys[0] = port0.keys[1] = port0.keys[2] = port0.keys[3] = 0;
 	port1.modifiers = 0;
 	port1.keys[0] = port1.keys[1] = port1.keys[2] = port1.keys[3] = 0;
 	hid_head = hid_tail = 0;
+	hid_subscriber = 0;
+}
+
+// one input message into the subscriber's mailbox, from pid 0 (the
+// kernel). z_mailbox_push() wakes it if it's blocked in
+// z_msg_block(). A full mailbox drops the event, same as hid_fifo
+// does.
+static void hid_deliver(uint32_t subject, uint32_t val) {
+	z_msg_envelope_t env;
+	env.to = hid_subscriber;
+	env.from = 0;
+	env.subject = subject;
+	env.tag = 0;
+	env.obj.type = Z_UINT32;
+	env.obj.val.uint32 = val;
+	env.kbuf = 0;
+	env.topic = 0;
+	if (subject == Z_HID_MSG_MOUSE)
+		// plain motion supersedes any motion still queued -- a reader
+		// that's behind only needs to know where the pointer is NOW.
+		// a button change is never merged away (the envelope before
+		// it had different buttons), so no click gets lost.
+		z_mailbox_push_merge(hid_subscriber, &env, Z_HID_MOUSE_KEEP_MASK);
+	else
+		z_mailbox_push(hid_subscriber, &env);
 }
 
 static void hid_push(uint32_t ev) {
+	if (hid_subscriber) {
+		hid_deliver(Z_HID_MSG_KEY, ev);
+		return;
+	}
 	uint8_t next = (hid_head + 1) % HID_FIFO_SIZE;
 	if (next == hid_tail) return; // FIFO full -- drop the event (same
 	                                // accepted tradeoff as uart.c's RX
@@ -112,7 +158,8 @@ static inline bool key_in_set(const uint8_t *set, uint8_t usage) {
 // interrupt context (not itself preemptible by another IRQ), so
 // unlike k_hid_read_key() below it doesn't need its own maskirq()
 // around the hid_head/hid_tail update.
-static void hid_irq_common(hid_port_t *st, uint32_t info, uint32_t keys) {
+static void hid_irq_common(hid_port_t *st, int port, uint32_t info, uint32_t keys,
+	uint32_t cursor) {
 
 	uint8_t typ = (info >> 24) & 0x3;   // rtl/usb_hid.v: 1=keyboard, 2=mouse, 3=gamepad --
 	                                     // bits[25:24] of the packed info register
@@ -133,6 +180,17 @@ static void hid_irq_common(hid_port_t *st, uint32_t info, uint32_t keys) {
 	// below are ordinary registered state that stays valid between
 	// reports, not the pulse itself.
 
+	// mouse: with a subscriber, every report becomes a Z_HID_MSG_MOUSE
+	// carrying the cursor register as hardware just updated it (plus
+	// which port, in bit 24 -- see zeitlos.h). Without one, nothing to
+	// do here, same as before: wm polls reg_usbN_cursor itself.
+	if (typ == 2) {
+		if (hid_subscriber)
+			hid_deliver(Z_HID_MSG_MOUSE, (cursor & 0x00FFFFFF) |
+				((uint32_t)port << 24));
+		return;
+	}
+
 	if (typ != 1) return; // not a keyboard report on this port
 
 	uint8_t modifiers = info & 0xFF;
@@ -176,12 +234,12 @@ static void hid_irq_common(hid_port_t *st, uint32_t info, uint32_t keys) {
 
 // called from z_kernel_entry() on Z_IRQ_HID (port 0)
 void z_hid_irq0(void) {
-	hid_irq_common(&port0, reg_usb0_info, reg_usb0_keys);
+	hid_irq_common(&port0, 0, reg_usb0_info, reg_usb0_keys, reg_usb0_cursor);
 }
 
 // called from z_kernel_entry() on Z_IRQ_HID1 (port 1)
 void z_hid_irq1(void) {
-	hid_irq_common(&port1, reg_usb1_info, reg_usb1_keys);
+	hid_irq_common(&port1, 1, reg_usb1_info, reg_usb1_keys, reg_usb1_cursor);
 }
 
 int32_t k_hid_read_key(void) {
@@ -211,3 +269,40 @@ z_obj_t *z_hid_read_key(z_obj_t *obj) {
 	obj->val.int32 = k_hid_read_key();
 	return (&z_ok);
 }
+
+// fastcalls.def version of the above
+uint32_t k_fast_hid_read_key(uint32_t a1, uint32_t a2, uint32_t a3) {
+	return (uint32_t)k_hid_read_key();
+}
+
+// Z_SYS_HID_SUBSCRIBE -- args->val.uint32 nonzero subscribes the
+// caller, zero unsubscribes it. One subscriber at a time, first come
+// first served: fails if a different live process already holds it
+// (k_hid_release() frees it again when that process is reaped).
+// Anything still sitting in hid_fifo when a subscription starts is
+// left there for hid_read_key(); from here on, new input only goes to
+// the mailbox.
+z_obj_t *k_hid_subscribe(z_obj_t *args) {
+
+	if (!args || z_pid == 0) return (&z_fail);
+	bool on = args->val.uint32 != 0;
+
+	uint32_t old_mask = maskirq(0xFFFFFFFF);
+	z_obj_t *rv = &z_ok;
+	if (on) {
+		if (hid_subscriber && hid_subscriber != z_pid) rv = &z_fail;
+		else hid_subscriber = z_pid;
+	} else if (hid_subscriber == z_pid) {
+		hid_subscriber = 0;
+	}
+	maskirq(old_mask);
+
+	return rv;
+
+}
+
+void k_hid_release(uint32_t pid) {
+	uint32_t old_mask = maskirq(0xFFFFFFFF);
+	if (hid_subscriber == pid) hid_subscriber = 0;
+	maskirq(old_mask);
+}
@@ -10,5 +10,10 @@ int32_t k_hid_read_key(void);
 // --
 
 z_obj_t *z_hid_read_key(z_obj_t *obj);
+uint32_t k_fast_hid_read_key(uint32_t a1, uint32_t a2, uint32_t a3);	// fastcalls.def
+z_obj_t *k_hid_subscribe(z_obj_t *args);
+
+// drops pid's subscription, if it has one -- the scheduler's reap path
+void k_hid_release(uint32_t pid);
 
 #endif
@@ -0,0 +1,278 @@
+/*
+ * Zeitlos OS
+ * Copyright (c) 2025 Lone Dynamics Corporation. All rights reserved.
+ *
+ * App image cache. See imgcache.h.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "kernel.h"
+#include "mem.h"
+#include "imgcache.h"
+#include "fs/fs.h"
+
+typedef struct {
+	bool		used;
+	uint32_t	pins;		// launches currently memcpy()ing out of `mem`
+	char		name[Z_IMGCACHE_NAME_MAX];	// normalized, see img_name()
+	uint32_t	size;
+	uint16_t	fdate;
+	uint16_t	ftime;
+	void		*mem;
+	uint32_t	last_used;	// z_kernel_ticks of the last hit/admission
+} z_imgcache_entry_t;
+
+static __attribute__((section(".bss"))) z_imgcache_entry_t z_imgcache[Z_IMGCACHE_MAX];
+static __attribute__((section(".bss"))) uint32_t z_imgcache_hits, z_imgcache_misses;
+
+typedef struct {
+	char		name[Z_IMGCACHE_NAME_MAX];
+	uint32_t	size;
+	uint16_t	fdate;
+	uint16_t	ftime;
+} z_imgcache_stat_t;
+
+// what the last k_imgcache_size() call saw on disk -- see imgcache.h.
+// Shared by every launcher, so k_imgcache_load() takes its own copy
+// on entry rather than reading it again after the (unmasked) load.
+static __attribute__((section(".bss"))) z_imgcache_stat_t z_imgcache_stat;
+
+// every launcher passes a bare name, but the invalidation callers in
+// fs.c/fsapi.c see whatever path the user typed -- fs_name_norm()
+// (fs.c) puts both sides in the same form before comparing
+static void img_name(char *out, const char *name) {
+	fs_name_norm(out, name, Z_IMGCACHE_NAME_MAX);
+}
+
+static int img_find(const char *norm) {
+	for (int e = 0; e < Z_IMGCACHE_MAX; e++)
+		if (z_imgcache[e].used && !strcmp(z_imgcache[e].name, norm))
+			return e;
+	return -1;
+}
+
+// caller holds maskirq()
+static void img_drop(int e) {
+	k_mem_free(z_imgcache[e].mem);
+	z_imgcache[e].used = false;
+	z_imgcache[e].mem = NULL;
+	z_imgcache[e].name[0] = 0;
+}
+
+void k_imgcache_init(void) {
+	for (int e = 0; e < Z_IMGCACHE_MAX; e++) {
+		z_imgcache[e].used = false;
+		z_imgcache[e].pins = 0;
+		z_imgcache[e].mem = NULL;
+		z_imgcache[e].name[0] = 0;
+	}
+	z_imgcache_stat.name[0] = 0;
+	z_imgcache_hits = z_imgcache_misses = 0;
+}
+
+// false if `name` isn't there (or is a directory)
+static bool img_stat(char *name, z_imgcache_stat_t *st) {
+
+	FILINFO fno;
+	st->name[0] = 0;
+
+	if (f_stat(name, &fno) != FR_OK || (fno.fattrib & AM_DIR))
+		return false;
+
+	img_name(st->name, name);
+	st->size = (uint32_t)fno.fsize;
+	st->fdate = fno.fdate;
+	st->ftime = fno.ftime;
+	return true;
+
+}
+
+uint32_t k_imgcache_size(char *name) {
+
+	z_imgcache_stat_t st;
+	if (!img_stat(name, &st)) st.size = 0;
+
+	uint32_t old_mask = maskirq(0xFFFFFFFF);
+	z_imgcache_stat = st;
+	maskirq(old_mask);
+
+	return st.size;
+
+}
+
+int k_imgcache_load(uint32_t dst, char *name) {
+
+	char norm[Z_IMGCACHE_NAME_MAX];
+	img_name(norm, name);
+
+	// normally already filled in by the k_imgcache_size() call every
+	// launcher makes first -- re-stat only if this is a different name
+	// (another launcher's since). Ours from here on: a launch running
+	// alongside (wm's k_proc_run() against sh's `run`) can overwrite
+	// the shared one while fs_load() below has IRQs enabled.
+	z_imgcache_stat_t st;
+	uint32_t old_mask = maskirq(0xFFFFFFFF);
+	st = z_imgcache_stat;
+	maskirq(old_mask);
+	if (strcmp(st.name, norm) && !img_stat(name, &st))
+		return 1;
+
+	old_mask = maskirq(0xFFFFFFFF);
+
+	int e = img_find(norm);
+	if (e >= 0 && (z_imgcache[e].size != st.size ||
+		z_imgcache[e].fdate != st.fdate ||
+		z_imgcache[e].ftime != st.ftime)) {
+		// changed on disk since it was cached -- stale. same pinned
+		// handling as k_imgcache_invalidate() below
+		if (z_imgcache[e].pins) z_imgcache[e].name[0] = 0;
+		else img_drop(e);
+		e = -1;
+	}
+
+	if (e >= 0) {
+
+		z_imgcache[e].pins++;
+		z_imgcache[e].last_used = z_kernel_ticks;
+		z_imgcache_hits++;
+		maskirq(old_mask);
+
+		// unmasked -- a large copy, and the pin keeps k_imgcache_evict()
+		// from freeing it underneath us meanwhile
+		memcpy((void *)(uintptr_t)dst, z_imgcache[e].mem, z_imgcache[e].size);
+
+		old_mask = maskirq(0xFFFFFFFF);
+		z_imgcache[e].pins--;
+		maskirq(old_mask);
+		return 0;
+
+	}
+
+	z_imgcache_misses++;
+	maskirq(old_mask);
+
+	if (fs_load(dst, name) != 0)
+		return 1;
+
+	// admission: plain k_mem_alloc(), NOT k_imgcache_alloc() -- only
+	// ever into memory nothing else currently wants, see imgcache.h
+	uint32_t size = st.size;
+	void *mem = k_mem_alloc(size);
+	if (!mem) return 0;
+
+	old_mask = maskirq(0xFFFFFFFF);
+
+	int slot = -1;
+	for (int i = 0; i < Z_IMGCACHE_MAX; i++) {
+		if (!z_imgcache[i].used) { slot = i; break; }
+	}
+	if (slot < 0) {
+		// table full -- recycle the LRU slot rather than skip caching,
+		// the image just loaded is by definition the most recent one
+		uint32_t oldest = 0;
+		for (int i = 0; i < Z_IMGCACHE_MAX; i++) {
+			if (z_imgcache[i].pins) continue;
+			if (slot < 0 || z_kernel_ticks - z_imgcache[i].last_used > oldest) {
+				oldest = z_kernel_ticks - z_imgcache[i].last_used;
+				slot = i;
+			}
+		}
+		if (slot < 0) {
+			maskirq(old_mask);
+			k_mem_free(mem);
+			return 0;
+		}
+		img_drop(slot);
+	}
+
+	z_imgcache[slot].used = true;
+	z_imgcache[slot].pins = 1;	// until the copy below is done
+	strcpy(z_imgcache[slot].name, norm);
+	z_imgcache[slot].size = size;
+	z_imgcache[slot].fdate = st.fdate;
+	z_imgcache[slot].ftime = st.ftime;
+	z_imgcache[slot].mem = mem;
+	z_imgcache[slot].last_used = z_kernel_ticks;
+
+	maskirq(old_mask);
+
+	memcpy(mem, (void *)(uintptr_t)dst, size);
+
+	old_mask = maskirq(0xFFFFFFFF);
+	z_imgcache[slot].pins--;
+	maskirq(old_mask);
+
+	return 0;
+
+}
+
+void k_imgcache_invalidate(const char *name) {
+
+	if (!name) return;
+
+	char norm[Z_IMGCACHE_NAME_MAX];
+	img_name(norm, name);
+
+	uint32_t old_mask = maskirq(0xFFFFFFFF);
+	int e = img_find(norm);
+	// a pinned entry is mid-copy into a launch that already stat'ed
+	// the old file -- renaming it out of the way is enough to stop it
+	// ever matching again, k_imgcache_evict() reclaims it later
+	if (e >= 0) {
+		if (z_imgcache[e].pins) z_imgcache[e].name[0] = 0;
+		else img_drop(e);
+	}
+	if (!strcmp(z_imgcache_stat.name, norm)) z_imgcache_stat.name[0] = 0;
+	maskirq(old_mask);
+
+}
+
+bool k_imgcache_evict(void) {
+
+	uint32_t old_mask = maskirq(0xFFFFFFFF);
+
+	int victim = -1;
+	uint32_t oldest = 0;
+	for (int e = 0; e < Z_IMGCACHE_MAX; e++) {
+		if (!z_imgcache[e].used || z_imgcache[e].pins) continue;
+		uint32_t age = z_kernel_ticks - z_imgcache[e].last_used;
+		if (victim < 0 || age > oldest) {
+			oldest = age;
+			victim = e;
+		}
+	}
+
+	if (victim >= 0) img_drop(victim);
+
+	maskirq(old_mask);
+	return victim >= 0;
+
+}
+
+void *k_imgcache_alloc(uint32_t size) {
+	void *mem;
+	while (!(mem = k_mem_alloc(size)) && k_imgcache_evict())
+		/* try again with one less cached image */;
+	return mem;
+}
+
+// see imgcache.h -- plain printf(), same as k_proc_dump()/
+// k_pidreg_dump(), this is only ever called from sh.c
+z_rv k_imgcache_dump(void) {
+	int shown = 0;
+	for (int e = 0; e < Z_IMGCACHE_MAX; e++) {
+		if (!z_imgcache[e].used) continue;
+		printf(" slot: %i name: %-12s size: %7ld at: %.8lx age: %ld ticks\n",
+			e, z_imgcache[e].name[0] ? z_imgcache[e].name : "(stale)",
+			(long)z_imgcache[e].size, (uint32_t)(uintptr_t)z_imgcache[e].mem,
+			(long)(z_kernel_ticks - z_imgcache[e].last_used));
+		shown++;
+	}
+	if (!shown) printf(" (empty)\n");
+	printf(" hits: %ld misses: %ld\n", (long)z_imgcache_hits, (long)z_imgcache_misses);
+	return Z_OK;
+}
@@ -0,0 +1,80 @@
+#ifndef Z_IMGCACHE_H
+#define Z_IMGCACHE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "kernel.h"
+
+/*
+ * Zeitlos OS
+ * Copyright (c) 2025 Lone Dynamics Corporation. All rights reserved.
+ *
+ * App image cache -- keeps the pristine, freshly-loaded bytes of
+ * recently launched binaries in otherwise-unused main RAM, so
+ * launching the same app again (wm's dock_launch() re-opening `term`,
+ * `run gpu3d` a second time) is one memcpy() instead of a full
+ * fs_load() over the bit-banged SD card (sdmm.c).
+ *
+ * Every launch path (sh.c's `run`/init(), k_proc_run() in kernel.c)
+ * goes through k_imgcache_size()/k_imgcache_load() instead of
+ * fs_size()/fs_load() directly. A cached copy is only trusted if the
+ * file on disk still has the same size AND FAT modification date/time
+ * (f_stat(), one directory lookup -- far cheaper than reading the
+ * whole file). That alone isn't enough on this board: ffconf.h has
+ * FF_FS_NORTC=1, so every file written ON the board (tget, xf, te)
+ * gets the same fixed timestamp -- so every kernel-side write/delete
+ * path (fs.c's fs_write_file()/fs_open_write()/fs_touch()/fs_unlink(), fsapi.c's
+ * k_fs_write()/k_fs_open_write()) also calls k_imgcache_invalidate()
+ * on the name it's about to change. The size+timestamp check is what
+ * catches a card edited on a PC between boots; the explicit
+ * invalidation is what catches everything written from this side.
+ *
+ * Memory: entries are only ever admitted into genuinely spare RAM (a
+ * plain k_mem_alloc() -- admission never evicts anything, including
+ * other cache entries), and are given back LRU-first whenever
+ * something more important needs the space -- k_imgcache_alloc()
+ * below is what every other kernel allocation goes through
+ * (k_proc_create(), sh.c's `xf` buffer, fmap.c's mappings, msg.c's
+ * copy arenas and channel pairs, fsapi.c's readahead pool), so none
+ * of them fails for lack of memory while the cache is still holding
+ * any. A new k_mem_alloc() caller in the kernel should do the same.
+ */
+
+#define Z_IMGCACHE_MAX       8   // cached images at once
+#define Z_IMGCACHE_NAME_MAX  32  // same bound as k_proc_run()'s own name copy
+
+// zeroes the table -- called once from kernel.c's main(), alongside
+// k_pidreg_init(), for the same not-reliably-zero-.bss reason.
+void k_imgcache_init(void);
+
+// size of `name` on disk (0 = not found), same contract as fs_size().
+// Also remembers the file's current FAT size/date/time for the
+// k_imgcache_load() that normally follows, so a launch only stats
+// the file once.
+uint32_t k_imgcache_size(char *name);
+
+// loads `name` into physical address `dst`, same contract as
+// fs_load() (0 = success). Served from the cache when the cached copy
+// is still valid; otherwise read from disk as before and, if there's
+// spare RAM for it, admitted into the cache afterwards -- from `dst`
+// itself, before the caller k_proc_start()s the new process and it
+// starts scribbling over its own .data/.bss.
+int k_imgcache_load(uint32_t dst, char *name);
+
+// drops any cached copy of `name` -- see the header comment for who
+// calls this and why.
+void k_imgcache_invalidate(const char *name);
+
+// frees the least-recently-used entry. false if there was nothing
+// left to free.
+bool k_imgcache_evict(void);
+
+// k_mem_alloc(), evicting cached images LRU-first until the
+// allocation succeeds or the cache is empty.
+void *k_imgcache_alloc(uint32_t size);
+
+// prints every cached image plus hit/miss counters -- `ic` in sh.c.
+z_rv k_imgcache_dump(void);
+
+#endif
@@ -21,6 +21,10 @@
 #include "msg.h"
 #include "hid.h"
 #include "pidreg.h"
+#include "imgcache.h"
+#include "fmap.h"
+#include "fs/diskcache.h"
+#include "klog.h"
 #include "logo.h"
 #include "fs/fs.h"
 #include "fsapi.h"
@@ -71,6 +75,10 @@ z_obj_t *k_proc_kill_syscall(z_obj_t *args);	// ditto -- named _syscall, not
 									// reasoning as k_proc_run()'s own comment
 									// just above.
 
+z_obj_t *k_fast_entry(z_obj_t *args);	// Z_SYS_FAST_ENTRY -- see below
+uint32_t k_fast_uptime(uint32_t a1, uint32_t a2, uint32_t a3);
+uint32_t k_fast_getpid(uint32_t a1, uint32_t a2, uint32_t a3);
+
 typedef z_obj_t* (*z_syscall_t)(z_obj_t *args);
 
 z_syscall_t z_syscall_table[Z_SYSCALL_COUNT] = {
@@ -79,6 +87,16 @@ z_syscall_t z_syscall_table[Z_SYSCALL_COUNT] = {
 #undef Z_SYSCALL
 };
 
+// fastcalls.def, indexed by the SAME Z_SYS_* ids as z_syscall_table[]
+// above -- NULL for every syscall that's ordinary-only.
+typedef uint32_t (*z_fastcall_t)(uint32_t a1, uint32_t a2, uint32_t a3);
+
+z_fastcall_t z_fastcall_table[Z_SYSCALL_COUNT] = {
+#define Z_MKFASTCALL(name, fn) [Z_SYS_##name] = fn,
+#include "../common/fastcalls.def"
+#undef Z_MKFASTCALL
+};
+
 extern char _start, _end;
 
 // linker-provided, see riscv-os.ld's .sdata section ("__global_pointer$
@@ -90,11 +108,15 @@ extern char __global_pointer$;
 volatile uint32_t __attribute__((section(".bss"))) z_pid = 0;
 volatile z_proc __attribute__((section(".bss"))) z_procs[Z_PROCS_MAX];
 volatile uint32_t __attribute__((section(".bss"))) z_kernel_ticks = 0;
+// pid + 1 the next KTIMER swap should try before anyone else (0 = plain
+// round-robin) -- see k_proc_handoff()
+volatile uint32_t __attribute__((section(".bss"))) z_sched_next = 0;
 
 // --
 
 void sh(void);
 uint32_t *z_kernel_entry(uint32_t cmd, uint32_t *args, uint32_t val);
+uint32_t z_kernel_fast_entry(uint32_t syscall_id, uint32_t a1, uint32_t a2, uint32_t a3);
 uint32_t k_proc_active_count(void);
 
 void kprint(const char *s);
@@ -128,9 +150,32 @@ z_obj_t *k_getpid(z_obj_t *args) {
 	return (&z_ok);
 }
 
+// fast-path twins of z_uptime()/k_getpid() above -- see
+// z_kernel_fast_entry() below.
+uint32_t k_fast_uptime(uint32_t a1, uint32_t a2, uint32_t a3) {
+	return z_kernel_ticks;
+}
+
+uint32_t k_fast_getpid(uint32_t a1, uint32_t a2, uint32_t a3) {
+	return z_pid;
+}
+
+// hands out z_kernel_fast_entry()'s address -- see its own comment
+// below. a syscall rather than a second fixed pointer next to
+// reg_kernel because there's no room for one: 0x00-0x0b is the BIOS
+// reset vector and 0x10 is irq_vec (sw/bios/boot_picorv32.S), and a
+// syscall is what an older kernel (or the simulator, sim/machine.c)
+// can answer "no" to -- args->val.uint32 stays 0 -- which is exactly
+// the fallback zeitlos.c's z_fast_entry() needs.
+z_obj_t *k_fast_entry(z_obj_t *args) {
+	args->type = Z_UINT32;
+	args->val.uint32 = (uint32_t)(uintptr_t)z_kernel_fast_entry;
+	return (&z_ok);
+}
+
 // launches a new process from a named file on the FAT filesystem --
-// same fs_size()/k_proc_create()/k_proc_base()/fs_load()/k_proc_start()
-// sequence as sh.c's "run" shell command and init() (see sh.c), but
+// same k_imgcache_size()/k_proc_create()/k_proc_base()/
+// k_imgcache_load()/k_proc_start() sequence as sh.c's "run" shell command and init() (see sh.c), but
 // reachable via syscall from any running process, not just the kernel
 // shell. This is what lets sw/apps/wm's dock launch apps (e.g. "term",
 // "gpu3d") when an icon is clicked -- before this syscall existed,
@@ -175,7 +220,7 @@ z_obj_t *k_proc_run(z_obj_t *args) {
 	name[sizeof(name) - 1] = 0;
 
 	uint32_t pid = 0;
-	uint32_t size = fs_size(name);
+	uint32_t size = k_imgcache_size(name);
 
 	// see kernel.h's z_proc_stack_size_for() comment -- the same
 	// shared decision sh.c's own `run`/`init` use, so launching
@@ -185,10 +230,13 @@ z_obj_t *k_proc_run(z_obj_t *args) {
 	uint32_t stack_size = z_proc_stack_size_for(name);
 
 	if (size) {
-		pid = k_proc_create(size, stack_size);
+		pid = k_proc_create(size, stack_size, z_proc_mailbox_depth_for(name));
 		if (pid) {
 			uint32_t base = k_proc_base(pid);
-			fs_load(base, name);
+			// a relaunch from wm's dock is a memcpy() out of the
+			// image cache rather than a full SD card read -- see
+			// imgcache.h
+			k_imgcache_load(base, name);
 			k_proc_start(pid);
 		}
 	}
@@ -217,6 +265,12 @@ int main(void) {
 
 	kprint("\nZEITLOS\n");
 
+	// the kernel log ring (klog.h) before the UART -- z_uart_irq()'s
+	// TX side drains it, so it has to be in a sane state before that
+	// interrupt can first fire. zeroed by hand for the same
+	// not-reliably-zero-.bss reason as k_pidreg_init() below.
+	k_klog_init();
+
 	// init uart
 	z_uart_init();
 	printf(" - uart initialized.\n");
@@ -247,6 +301,7 @@ int main(void) {
 		z_procs[p].base = 0x00000000;
 		z_procs[p].flags = 0x00000000;
 	}
+	z_sched_next = 0;
 
 	// zero the pid name registry -- see k_pidreg_init()'s comment in
 	// pidreg.h for why this can't just be left to .bss (short
@@ -259,6 +314,26 @@ int main(void) {
 	// the only place that's actually guaranteed.
 	k_pidreg_init();
 
+	// mailboxes too (msg.h) -- never explicitly emptied before,
+	// which only ever worked because nothing sent before wm started
+	k_msg_init();
+
+	// same reasoning as k_pidreg_init() just above -- the image cache
+	// table (imgcache.h) has to start empty before the first `run`.
+	k_imgcache_init();
+
+	// and the shared file mappings (fmap.h), same reasoning
+	k_fmap_init();
+
+	// and the sector cache's slot table (fs/diskcache.h) -- before
+	// sh.c's f_mount()
+	k_diskcache_init();
+
+	// and the queue of background filesystem requests, and the chunked
+	// reads' readahead pool (fsapi.h)
+	k_fs_async_init();
+	k_fs_readahead_init();
+
 	// create process zero (this process):
 	uint32_t k_size = k_mem_align_up((((uint32_t)&_end - (uint32_t)&_start) +
 		Z_KERNEL_STACK_SIZE), Z_MEM_ALIGNMENT);
@@ -274,7 +349,8 @@ int main(void) {
 
 	// call some function ...
 
-	k_proc_create((uint32_t)&_end - (uint32_t)&_start, Z_PROC_STACK_SIZE_DEFAULT);
+	k_proc_create((uint32_t)&_end - (uint32_t)&_start, Z_PROC_STACK_SIZE_DEFAULT,
+		Z_MAILBOX_DEPTH);
 	k_proc_start(0);
 
 	// set the kernel register so the irq handler knows who to call
@@ -338,6 +414,9 @@ uint32_t *z_kernel_entry(uint32_t syscall_id, uint32_t *regs, uint32_t irqs) {
 	if (syscall_id != Z_SYSCALL_NONE) {
 
 		if (syscall_id >= Z_SYSCALL_COUNT || !z_syscall_table[syscall_id]) {
+			// usually an app built against a newer syscalls.def than
+			// this kernel.bin -- see the warning at the top of that file
+			k_log_dec(K_LOG_WARN, "kernel: unknown syscall ", syscall_id);
 			ret = (uint32_t *)&z_fail;
 		} else {
 			ret = (uint32_t *)z_syscall_table[syscall_id]((z_obj_t *)regs);
@@ -384,12 +463,28 @@ uint32_t *z_kernel_entry(uint32_t syscall_id, uint32_t *regs, uint32_t irqs) {
 			z_procs[z_pid].regs[i] = *(regs + i);
 		}
 
+		// a k_proc_handoff() since the last swap: start the search
+		// just before that pid, so it's the first one looked at. If
+		// it turns out not to be runnable after all, round-robin
+		// simply carries on from there.
+		if (z_sched_next) {
+			z_pid = z_sched_next - 1;
+			z_pid = z_pid ? z_pid - 1 : Z_PROCS_MAX - 1;
+			z_sched_next = 0;
+		}
+
 		// find next active process (round-robin scheduling)
 		next_process:
 		z_pid++;
 		if (z_pid >= Z_PROCS_MAX) z_pid = 0;
 
 		if ((z_procs[z_pid].flags & Z_PROC_FLAG_DIE) == Z_PROC_FLAG_DIE) {
+			// something is still copying into (msg.h) or reading and
+			// writing (fsapi.h's FS_ASYNC) its memory on another
+			// process's behalf -- leave it dying, not running, and
+			// reap it on a later round once that's finished
+			if (k_msg_busy(z_pid) || k_fs_async_busy(z_pid))
+				goto next_process;
 			// free the memory
 			k_mem_free((void *)z_procs[z_pid].base);
 			// release any names this process registered (see
@@ -397,6 +492,19 @@ uint32_t *z_kernel_entry(uint32_t syscall_id, uint32_t *regs, uint32_t irqs) {
 			// reusing this same pid slot would inherit stale name
 			// registrations that were never its own)
 			k_pidreg_release_all(z_pid);
+			// and its HID subscription, if it had one (hid.h) --
+			// otherwise input would keep landing in a dead mailbox
+			k_hid_release(z_pid);
+			// and its mailbox/copy-send arena (msg.h) -- a new
+			// process in this slot mustn't read the old one's mail
+			k_msg_release_all(z_pid);
+			// and its queued FS_ASYNC requests (fsapi.h) -- their
+			// buffers are about to be handed to somebody else
+			k_fs_async_release_all(z_pid);
+			// and its file mappings (fmap.h) -- the last holder
+			// going is what frees one
+			k_fmap_release_all(z_pid);
+			k_log_dec(K_LOG_INFO, "kernel: reaped pid ", z_pid);
 			// kill the process
 			z_procs[z_pid].base = 0x00000000;
 			z_procs[z_pid].flags = 0x00000000;
@@ -406,6 +514,16 @@ uint32_t *z_kernel_entry(uint32_t syscall_id, uint32_t *regs, uint32_t irqs) {
 		if ((z_procs[z_pid].flags & Z_PROC_FLAG_ACTIVE) != Z_PROC_FLAG_ACTIVE)
 			goto next_process;
 
+		// blocked in k_proc_block() -- skip it, unless its timeout
+		// has run out, in which case it's runnable again from here.
+		// pid 0 is never blocked, so this loop always finds someone.
+		if ((z_procs[z_pid].flags & Z_PROC_FLAG_WAIT) == Z_PROC_FLAG_WAIT) {
+			if (!z_procs[z_pid].wait_ticks ||
+				z_kernel_ticks - z_procs[z_pid].wait_start < z_procs[z_pid].wait_ticks)
+				goto next_process;
+			z_procs[z_pid].flags &= ~Z_PROC_FLAG_WAIT;
+		}
+
 		// configure address translation
 		reg_mtu = z_procs[z_pid].base;
 
@@ -422,6 +540,37 @@ uint32_t *z_kernel_entry(uint32_t syscall_id, uint32_t *regs, uint32_t irqs) {
 
 }
 
+// the register-based fast syscall entry (fastcalls.def, docs/
+// app_runtime.md "Fast syscalls"). Same calling convention as
+// z_kernel_entry()'s syscall branch -- a plain jalr from the app,
+// IRQs left enabled -- but arguments arrive in a1..a3 and the result
+// goes back in a0, so there's no z_obj_t for the caller to build on
+// its stack, no pointer for the handler to chase through the MTU, and
+// no returned z_ok/z_fail object for the caller to dereference
+// afterwards. Deliberately NOT sharing z_kernel_entry() itself: that
+// one also has to tell syscalls apart from the IRQ path and carries
+// the scheduler, and keeping this one a leaf-sized function is the
+// whole point.
+//
+// the gp swap is the same one z_kernel_entry() does, for the same
+// reason (see its own comment) -- every fast handler touches some
+// kernel global (z_kernel_ticks, the UART/HID FIFOs, z_mailboxes[]).
+uint32_t z_kernel_fast_entry(uint32_t syscall_id, uint32_t a1, uint32_t a2, uint32_t a3) {
+
+	uint32_t saved_gp;
+	__asm__ volatile ("mv %0, gp" : "=r"(saved_gp));
+	__asm__ volatile ("mv gp, %0" ::
+		"r"((uint32_t)(uintptr_t)&__global_pointer$) : "memory");
+
+	uint32_t ret = Z_FAST_NOSYS;
+	if (syscall_id < Z_SYSCALL_COUNT && z_fastcall_table[syscall_id])
+		ret = z_fastcall_table[syscall_id](a1, a2, a3);
+
+	__asm__ volatile ("mv gp, %0" :: "r"(saved_gp) : "memory");
+	return ret;
+
+}
+
 uint32_t k_proc_active_count(void) {
 
 	uint32_t count = 0;
@@ -437,7 +586,8 @@ uint32_t k_proc_active_count(void) {
 // return process id or 0 on fail. `stack_size` is the per-process
 // stack+heap allowance -- see kernel.h's Z_PROC_STACK_SIZE_DEFAULT/
 // _LARGE comment for which one a given caller should pass.
-uint32_t k_proc_create(uint32_t size, uint32_t stack_size) {
+// `mailbox_depth` likewise comes from z_proc_mailbox_depth_for().
+uint32_t k_proc_create(uint32_t size, uint32_t stack_size, uint32_t mailbox_depth) {
 
 	uint32_t mem_size = k_mem_align_up(size + stack_size,
 		Z_MEM_ALIGNMENT);
@@ -447,7 +597,10 @@ uint32_t k_proc_create(uint32_t size, uint32_t stack_size) {
 
 		if (z_procs[p].base != 0x00000000) continue;
 
-		void *mem = k_mem_alloc(mem_size);
+		// k_imgcache_alloc(), not k_mem_alloc() directly -- gives back
+		// cached app images (imgcache.h) LRU-first if that's what it
+		// takes to fit this process, so the cache never costs a launch
+		void *mem = k_imgcache_alloc(mem_size);
 		if (!mem) return(0);	// NOT Z_FAIL (1) -- this function's
 					// return convention is "0 = no pid
 					// assigned", same as the plain
@@ -475,6 +628,14 @@ uint32_t k_proc_create(uint32_t size, uint32_t stack_size) {
 					// wm's own running memory with
 					// whatever app was actually being
 					// launched.
+		// its mailbox ring (msg.c) -- only fails if the pool can't
+		// even spare Z_MAILBOX_DEPTH_SMALL, in which case there'd be
+		// no way to talk to the process anyway
+		if (k_msg_mailbox_create(p, mailbox_depth) != Z_OK) {
+			k_mem_free(mem);
+			return(0);
+		}
+
 		uint32_t base = (int32_t)(uintptr_t)mem;
 		z_procs[p].base = base;
 		z_procs[p].size = mem_size;
@@ -530,15 +691,65 @@ uint32_t k_proc_create(uint32_t size, uint32_t stack_size) {
 
 z_rv k_proc_start(uint32_t pid) {
 	z_procs[pid].flags |= Z_PROC_FLAG_ACTIVE;
+	k_log_dec(K_LOG_DEBUG, "kernel: started pid ", pid);
+	return Z_OK;
 }
 
 z_rv k_proc_stop(uint32_t pid) {
 	z_procs[pid].flags &= ~Z_PROC_FLAG_ACTIVE;
 }
 
+// see kernel.h. There's no way to give up the CPU early on this
+// hardware (no software interrupt to force a KTIMER round), so the
+// caller just spins out what's left of its current timeslice -- at
+// most one tick -- and from the next KTIMER on the scheduler simply
+// doesn't pick it again until Z_PROC_FLAG_WAIT is gone. The spin is
+// also what notices the wakeup if it lands before that KTIMER does.
+bool k_proc_block(bool (*ready)(uint32_t pid), uint32_t timeout_ticks) {
+
+	uint32_t pid = z_pid;
+	if (pid == 0) return ready(pid);
+
+	uint32_t old_mask = maskirq(0xFFFFFFFF);
+	if (ready(pid)) {
+		maskirq(old_mask);
+		return true;
+	}
+	z_procs[pid].wait_start = z_kernel_ticks;
+	z_procs[pid].wait_ticks = timeout_ticks;
+	z_procs[pid].flags |= Z_PROC_FLAG_WAIT;
+	maskirq(old_mask);
+
+	while ((z_procs[pid].flags & Z_PROC_FLAG_WAIT) == Z_PROC_FLAG_WAIT) {
+		// covers the timeout while this process is still the one
+		// running (the scheduler covers it from then on)
+		if (timeout_ticks && z_kernel_ticks - z_procs[pid].wait_start >= timeout_ticks)
+			z_procs[pid].flags &= ~Z_PROC_FLAG_WAIT;
+	}
+
+	return ready(pid);
+
+}
+
+void k_proc_wake(uint32_t pid) {
+	if (pid >= Z_PROCS_MAX) return;
+	uint32_t old_mask = maskirq(0xFFFFFFFF);
+	z_procs[pid].flags &= ~Z_PROC_FLAG_WAIT;
+	maskirq(old_mask);
+}
+
+// see kernel.h. Only a hint for the next swap -- the current process
+// keeps its timeslice, same as k_proc_block()'s spin, since there's
+// no way to force a KTIMER round early. Last caller wins.
+void k_proc_handoff(uint32_t pid) {
+	if (pid >= Z_PROCS_MAX) return;
+	z_sched_next = pid + 1;
+}
+
 z_rv k_proc_kill(uint32_t pid) {
 	if (pid >= Z_PROCS_MAX) return Z_FAIL;
 	z_procs[pid].flags |= Z_PROC_FLAG_DIE;
+	k_log_dec(K_LOG_DEBUG, "kernel: killing pid ", pid);
 	return Z_OK;
 }
 
@@ -566,10 +777,11 @@ uint32_t k_proc_base(uint32_t pid) {
 	return z_procs[pid].base;
 }
 
+// printf(), not kprint() -- `ks` runs with IRQs up, and kprint()
+// writing the UART directly would race z_uart_irq() draining the TX
+// FIFO/kernel log into the same register.
 z_rv k_kernel_dump(void) {
-	kprint(" kticks: ");
-	kprint_hex32(z_kernel_ticks);
-	kprint("\n");
+	printf(" kticks: %.8lx\n", z_kernel_ticks);
 	return Z_OK;
 }
 
@@ -579,6 +791,13 @@ z_rv k_proc_dump(void) {
 		printf(" pid: %2i base: %.8lx size: %.8lx pc %.8lx sp: %.8lx flags: %.8lx\n",
 			i, z_procs[i].base, z_procs[i].size,
 			z_procs[i].regs[0], z_procs[i].regs[2], z_procs[i].flags);
+		// mailbox: waiting/depth, high-water mark, refused sends
+		z_msg_stats_t ms;
+		ms.pid = i;
+		if (k_msg_stats((z_obj_t *)&ms)->val.uint32 == Z_OK)
+			printf("         mbox: %2ld/%2ld max: %2ld dropped: %ld\n",
+				(long)ms.count, (long)ms.depth, (long)ms.high_water,
+				(long)ms.dropped);
 	}
 	return Z_OK;
 }
@@ -596,13 +815,16 @@ void kprint(const char *s) {
     }
 }
 
+// waits on THRE like kprint() above, instead of the fixed delay loop
+// this used to end with -- which was both slower than necessary and
+// not actually guaranteed to be long enough.
 void kprint_hex_digit(uint8_t val) {
+    while ((reg_uart0_lsr & 0x20) == 0);
     if (val < 10) {
         reg_uart0_data = '0' + val;
     } else {
         reg_uart0_data = 'A' + (val - 10);
     }
-    for (volatile uint32_t i = 0; i < 500; i++);
 }
 
 void kprint_hex32(uint32_t val) {
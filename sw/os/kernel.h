@@ -21,10 +21,19 @@ typedef struct {
 	uint32_t		flags;
 	uint32_t		regs[32];
 
+	// Z_PROC_FLAG_WAIT's deadline -- see k_proc_block()
+	uint32_t		wait_start;
+	uint32_t		wait_ticks;	// 0 = no timeout
+
 } z_proc;
 
 #define Z_PROC_FLAG_ACTIVE	0x000000001
 #define Z_PROC_FLAG_DIE		0x000000002
+// blocked in k_proc_block() -- the scheduler passes over it until
+// k_proc_wake() (or its wait_ticks running out) clears this again.
+// Never set on pid 0: the scheduler relies on there always being
+// at least one runnable process to land on.
+#define Z_PROC_FLAG_WAIT	0x000000004
 
 #define Z_PROCS_MAX 16
 
@@ -96,6 +105,21 @@ static inline uint32_t z_proc_stack_size_for(const char *name) {
 		Z_PROC_STACK_SIZE_LARGE : Z_PROC_STACK_SIZE_DEFAULT;
 }
 
+// and how deep its mailbox should be (zmsg.h's Z_MAILBOX_DEPTH
+// comment) -- decided the same way, by every path that starts a
+// process by name. wm hears from every windowed app plus HID, and net
+// from every client of every protocol it serves, both in bursts;
+// the graphics demos below never get more than a stray Z_WM_REDRAW.
+static inline uint32_t z_proc_mailbox_depth_for(const char *name) {
+	if (!strcmp(name, "wm") || !strcmp(name, "net"))
+		return Z_MAILBOX_DEPTH_LARGE;
+	if (!strcmp(name, "blinky") || !strcmp(name, "bounce") ||
+		!strcmp(name, "bounceblit") || !strcmp(name, "gpu3d") ||
+		!strcmp(name, "gpudemo") || !strcmp(name, "hello"))
+		return Z_MAILBOX_DEPTH_SMALL;
+	return Z_MAILBOX_DEPTH;
+}
+
 // the live process table and the pid of the process currently
 // scheduled/executing -- defined in kernel.c. msg.c (and anything
 // else that needs to translate another process's pointers) needs
@@ -112,7 +136,7 @@ extern volatile uint32_t z_kernel_ticks;
 
 // --
 
-uint32_t k_proc_create(uint32_t size, uint32_t stack_size);
+uint32_t k_proc_create(uint32_t size, uint32_t stack_size, uint32_t mailbox_depth);
 uint32_t k_proc_base(uint32_t pid);
 z_rv k_proc_start(uint32_t pid);
 z_rv k_proc_stop(uint32_t pid);
@@ -120,6 +144,27 @@ z_rv k_proc_dump(void);
 z_rv k_proc_kill(uint32_t pid);
 z_rv k_kernel_dump(void);
 
+// blocks the CALLING process (from inside one of its own syscalls)
+// until someone calls k_proc_wake() on it or timeout_ticks pass (0 =
+// no timeout). `ready` is checked with IRQs masked right before
+// going to sleep, so a wakeup that lands between the caller's own
+// check and this call isn't lost -- if it returns true, this returns
+// straight away. Either way it returns `ready` as checked again on
+// the way out, NOT whether it was woken: k_proc_wake() is
+// unconditional (any message, any channel activity), so a wakeup
+// can come with `ready` still false, and a caller that needs the
+// condition has to loop, with whatever's left of its timeout. pid 0,
+// which must never stop running, doesn't sleep at all -- it just
+// gets `ready` checked once.
+bool k_proc_block(bool (*ready)(uint32_t pid), uint32_t timeout_ticks);
+// safe from interrupt handlers
+void k_proc_wake(uint32_t pid);
+// asks the scheduler to run pid next, ahead of its round-robin turn
+// -- k_msg_call() uses this to pass the CPU straight to the callee
+// and back again, rather than waiting for every other process to
+// have had a slice first. Safe from interrupt handlers.
+void k_proc_handoff(uint32_t pid);
+
 // raw, unbuffered UART print -- no libc stdio involved at all (no
 // buffering, no heap). defined in kernel.c. exposed here (was
 // private to kernel.c) because it's the right tool for exactly the
@@ -0,0 +1,252 @@
+/*
+ * Zeitlos OS
+ * Copyright (c) 2025 Lone Dynamics Corporation. All rights reserved.
+ *
+ * Kernel log ring. See klog.h.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "kernel.h"
+#include "uart.h"
+#include "klog.h"
+
+#define KLOG_MASK (Z_KLOG_SLOTS - 1)
+
+static __attribute__((section(".bss"))) z_klog_entry_t klog[Z_KLOG_SLOTS];
+
+// seq the next k_log() will claim -- entries are 1, 2, 3, ...
+static volatile __attribute__((section(".bss"))) uint32_t klog_next_seq;
+
+// console drain position: the entry being (or next to be) printed,
+// and how far into its formatted line -- see klog_line_char()
+static volatile __attribute__((section(".bss"))) uint32_t klog_con_seq;
+static volatile __attribute__((section(".bss"))) uint32_t klog_con_off;
+
+volatile __attribute__((section(".bss"))) uint8_t k_klog_console_level;
+
+// k_log_write()'s not-yet-terminated line
+static __attribute__((section(".bss"))) char klog_partial[Z_KLOG_TEXT_MAX];
+static __attribute__((section(".bss"))) uint32_t klog_partial_len;
+
+static const char klog_level_chars[] = "EWID";
+
+void k_klog_init(void) {
+	for (int i = 0; i < Z_KLOG_SLOTS; i++)
+		klog[i].seq = 0;
+	klog_next_seq = 1;
+	klog_con_seq = 1;
+	klog_con_off = 0;
+	klog_partial_len = 0;
+	k_klog_console_level = K_LOG_INFO;
+}
+
+// one entry, start to finish. the slot is claimed with IRQs masked
+// (the increment and clearing its seq), filled with them enabled, and published by
+// writing its seq last -- until then both the console and `dmesg`
+// treat it as not there yet. A writer lapped by Z_KLOG_SLOTS others
+// between claim and publish can collide with a later one in the same
+// slot; the console copes (it skips entries that aren't the seq it
+// expects), the text may not -- not worth a lock at this ring size.
+static void klog_emit(uint8_t level, const char *a, uint32_t alen,
+	const char *b, uint32_t blen) {
+
+	// the slot's seq is cleared in the same critical section that
+	// claims it: otherwise the console, in between, would see the
+	// previous lap's seq there and skip the new entry as overwritten
+	uint32_t old_mask = maskirq(0xFFFFFFFF);
+	uint32_t seq = klog_next_seq++;
+	z_klog_entry_t *e = &klog[seq & KLOG_MASK];
+	e->seq = 0;
+	maskirq(old_mask);
+
+	e->ticks = z_kernel_ticks;
+	e->level = level;
+	e->pid = (uint8_t)z_pid;
+
+	uint32_t n = 0;
+	for (uint32_t i = 0; i < alen && n < Z_KLOG_TEXT_MAX; i++) e->text[n++] = a[i];
+	for (uint32_t i = 0; i < blen && n < Z_KLOG_TEXT_MAX; i++) e->text[n++] = b[i];
+	e->len = n;
+
+	e->seq = seq;
+
+	// the console may have been idle -- get the TX interrupt going
+	k_uart_tx_kick();
+
+}
+
+void k_log(uint8_t level, const char *msg) {
+	klog_emit(level, msg, strlen(msg), NULL, 0);
+}
+
+void k_log_hex(uint8_t level, const char *msg, uint32_t val) {
+	char digits[8];
+	for (int i = 0; i < 8; i++) {
+		uint8_t nibble = (val >> ((7 - i) * 4)) & 0xF;
+		digits[i] = (nibble < 10) ? ('0' + nibble) : ('a' + nibble - 10);
+	}
+	klog_emit(level, msg, strlen(msg), digits, 8);
+}
+
+// by hand, least-significant-first then reversed -- same approach as
+// pidreg.c's append_decimal()
+void k_log_dec(uint8_t level, const char *msg, uint32_t val) {
+	char rev[10], digits[10];
+	int n = 0;
+	do {
+		rev[n++] = '0' + (val % 10);
+		val /= 10;
+	} while (val && n < 10);
+	for (int i = 0; i < n; i++) digits[i] = rev[n - 1 - i];
+	klog_emit(level, msg, strlen(msg), digits, n);
+}
+
+void k_log_write(uint8_t level, const char *buf, uint32_t len) {
+
+	// masked for the whole call so two syscalls' output can't end up
+	// interleaved inside klog_partial -- a call is one printf()'s
+	// worth of text, short
+	uint32_t old_mask = maskirq(0xFFFFFFFF);
+
+	for (uint32_t i = 0; i < len; i++) {
+		char c = buf[i];
+		if (c == '\r') continue;
+		if (c != '\n') klog_partial[klog_partial_len++] = c;
+		if (c == '\n' || klog_partial_len == Z_KLOG_TEXT_MAX) {
+			if (klog_partial_len)
+				klog_emit(level, klog_partial, klog_partial_len, NULL, 0);
+			klog_partial_len = 0;
+		}
+	}
+
+	maskirq(old_mask);
+
+}
+
+// the console form of an entry, one character at a time, so the TX
+// interrupt never needs a line buffer: "[0001a2f3] W text\r\n" --
+// ticks in hex (no division in an IRQ handler on rv32i), then the
+// level letter. -1 past the end.
+static int klog_line_char(const z_klog_entry_t *e, uint32_t off) {
+	if (off == 0) return '[';
+	if (off <= 8) {
+		uint8_t nibble = (e->ticks >> ((8 - off) * 4)) & 0xF;
+		return (nibble < 10) ? ('0' + nibble) : ('a' + nibble - 10);
+	}
+	if (off == 9) return ']';
+	if (off == 10 || off == 12) return ' ';
+	if (off == 11) return klog_level_chars[e->level & 3];
+	off -= 13;
+	if (off < e->len) return (uint8_t)e->text[off];
+	if (off == e->len) return '\r';
+	if (off == e->len + 1) return '\n';
+	return -1;
+}
+
+// called from z_uart_irq() (and k_uart_tx_kick(), IRQs masked) only
+int k_klog_console_getc(void) {
+
+	while (klog_con_seq != klog_next_seq) {
+
+		// lapped -- skip to the oldest entry still in the ring
+		if (klog_next_seq - klog_con_seq > Z_KLOG_SLOTS) {
+			klog_con_seq = klog_next_seq - Z_KLOG_SLOTS;
+			klog_con_off = 0;
+		}
+
+		z_klog_entry_t *e = &klog[klog_con_seq & KLOG_MASK];
+
+		if (e->seq != klog_con_seq) {
+			// claimed, not published yet -- its klog_emit() will
+			// kick the UART again once it is
+			if (e->seq == 0) return -1;
+			// overwritten by a newer entry since -- gone
+			klog_con_seq++;
+			klog_con_off = 0;
+			continue;
+		}
+
+		int c = (e->level <= k_klog_console_level) ?
+			klog_line_char(e, klog_con_off) : -1;
+		if (c < 0) {
+			klog_con_seq++;
+			klog_con_off = 0;
+			continue;
+		}
+
+		klog_con_off++;
+		return c;
+
+	}
+
+	return -1;
+
+}
+
+bool k_klog_console_busy(void) {
+	return klog_con_off != 0;
+}
+
+// see klog.h -- plain printf(), this only ever runs as the shell
+z_rv k_klog_dump(void) {
+
+	uint32_t end = klog_next_seq;
+	uint32_t seq = (end - 1 > Z_KLOG_SLOTS) ? end - Z_KLOG_SLOTS : 1;
+	int shown = 0;
+
+	for (; seq != end; seq++) {
+		z_klog_entry_t *e = &klog[seq & KLOG_MASK];
+		if (e->seq != seq) continue;
+		printf("[%8lu] %c %2u: %.*s\n", (unsigned long)e->ticks,
+			klog_level_chars[e->level & 3], e->pid, e->len, e->text);
+		shown++;
+	}
+
+	if (!shown) printf(" (empty)\n");
+	return Z_OK;
+
+}
+
+// Z_SYS_KLOG_READ -- see zklog.h's z_klog_read_args_t. Entries are
+// copied with IRQs enabled and checked afterwards: one whose slot got
+// reused mid-copy (its seq changed) is counted as lost rather than
+// returned half old, half new.
+z_obj_t *k_klog_read(z_obj_t *args) {
+
+	z_klog_read_args_t *a = (z_klog_read_args_t *)args;
+	if (!a || (!a->buf && a->max)) return (&z_fail);
+
+	a->count = 0;
+	a->lost = 0;
+
+	uint32_t end = klog_next_seq;
+	uint32_t oldest = (end - 1 > Z_KLOG_SLOTS) ? end - Z_KLOG_SLOTS : 1;
+	uint32_t seq = a->seq;
+
+	if (seq == 0 || seq < oldest) {
+		if (seq) a->lost = oldest - seq;
+		seq = oldest;
+	}
+
+	while (seq != end && a->count < a->max) {
+		z_klog_entry_t *e = &klog[seq & KLOG_MASK];
+		if (e->seq == seq) {
+			memcpy(&a->buf[a->count], e, sizeof(z_klog_entry_t));
+			if (e->seq == seq && a->buf[a->count].seq == seq) a->count++;
+			else a->lost++;
+		} else if (e->seq == 0) {
+			break;	// still being written -- next call gets it
+		} else {
+			a->lost++;
+		}
+		seq++;
+	}
+
+	a->seq = seq;
+	return (&z_ok);
+
+}
@@ -0,0 +1,77 @@
+#ifndef Z_KLOG_H
+#define Z_KLOG_H
+
+#include <stdint.h>
+
+#include "kernel.h"
+#include "../common/zklog.h"
+
+/*
+ * Zeitlos OS
+ * Copyright (c) 2025 Lone Dynamics Corporation. All rights reserved.
+ *
+ * Kernel log ring -- `dmesg`. A fixed ring of Z_KLOG_SLOTS entries,
+ * each a short line of text plus a level (zklog.h's K_LOG_*), the
+ * writer's pid and a z_kernel_ticks timestamp. Writing one never
+ * waits on the UART: k_log() drops the text into the next slot and
+ * returns, and the UART's own TX interrupt (z_uart_irq() in uart.c)
+ * drains whatever's at or below k_klog_console_level out to the
+ * console in the background, after anything already queued in the
+ * TX FIFO. When writers outrun the UART, the oldest entries are
+ * overwritten -- the console just skips ahead, `dmesg` shows what's
+ * left.
+ *
+ * Safe from any context, including interrupt handlers: claiming a
+ * slot is a three-instruction maskirq() section (no atomics on rv32i,
+ * so that IS the atomic increment here) and nothing ever waits for a
+ * lock. The text is copied in with IRQs enabled; an entry only
+ * becomes visible to the console/`dmesg` once its seq is written,
+ * last. Formatting is by hand (k_log_hex()/k_log_dec()), never
+ * snprintf() -- see pidreg.c's append_decimal() for why kernel code
+ * stays away from it.
+ *
+ * kruntime.c's _write() also lands here when it's running on behalf
+ * of an app (z_pid != 0, i.e. inside a syscall) -- the "deleting ..."/
+ * "failed; error code" printf()s in fs.c and friends -- so that
+ * output no longer spins on the UART in the middle of someone's
+ * syscall. The shell's own output (pid 0) still goes straight to the
+ * console.
+ *
+ * kprint()/kprint_hex32() (kernel.c) are still there, and still
+ * synchronous, for the one case that needs that: before IRQs are up,
+ * or when nothing afterwards can be trusted to run.
+ */
+
+#define Z_KLOG_SLOTS	64	// power of two -- index is seq & (Z_KLOG_SLOTS - 1)
+
+// entries at or below this level are also echoed to the console
+extern volatile uint8_t k_klog_console_level;
+
+// empties the ring -- called once from kernel.c's main(), same
+// not-reliably-zero-.bss reason as k_pidreg_init().
+void k_klog_init(void);
+
+void k_log(uint8_t level, const char *msg);
+// msg followed by val as 8 hex digits / in decimal
+void k_log_hex(uint8_t level, const char *msg, uint32_t val);
+void k_log_dec(uint8_t level, const char *msg, uint32_t val);
+// raw bytes, one entry per line ('\n'-terminated, or Z_KLOG_TEXT_MAX
+// bytes, whichever comes first) -- see kruntime.c's _write()
+void k_log_write(uint8_t level, const char *buf, uint32_t len);
+
+// -- for uart.c's TX interrupt --
+
+// next console byte to send, or -1 if nothing's waiting
+int k_klog_console_getc(void);
+// true while the console is part-way through printing an entry --
+// uart.c lets it finish the line before going back to the TX FIFO,
+// so log lines don't get chopped up by ordinary output
+bool k_klog_console_busy(void);
+
+// `dmesg` in sh.c
+z_rv k_klog_dump(void);
+
+// -- syscall handler, registered in syscalls.def --
+z_obj_t *k_klog_read(z_obj_t *args);
+
+#endif
@@ -15,6 +15,8 @@
 
 #include "../common/zeitlos.h"
 #include "uart.h"
+#include "klog.h"
+#include "fsapi.h"
 
 bool term_echo = true;
 
@@ -56,7 +58,12 @@ void readline(char *buf, int maxlen) {
 	while (1) {
 
 		c = getch();
-		if (c == EOF) continue;
+		if (c == EOF) {
+			// nothing typed: the shell's idle time is what services
+			// apps' background filesystem requests (fsapi.h)
+			k_fs_async_poll();
+			continue;
+		}
 
 		if (c == CH_CR || c == CH_LF) {
 			break;
@@ -83,6 +90,15 @@ void readline(char *buf, int maxlen) {
 
 ssize_t _write(int file, const void *ptr, size_t len)
 {
+	// kernel code running on behalf of an app (inside a syscall --
+	// fs.c's "deleting ..." and error printf()s, mostly) goes to the
+	// kernel log instead of spinning on the UART mid-syscall; see
+	// klog.h. the shell (pid 0) still talks to the console directly.
+	if (z_pid != 0) {
+		k_log_write(K_LOG_INFO, ptr, len);
+		return len;
+	}
+
 	const unsigned char *p = ptr;
 	for (int i = 0; i < len; i++) {
 		if (p[i] == 0x0a) {
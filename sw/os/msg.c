@@ -5,7 +5,8 @@
  * Inter-process messaging.
  *
  * See ../common/zmsg.h for the design rationale. Summary: mailboxes
- * live in kernel memory (one fixed-depth ring per process slot), and
+ * live in kernel memory (one ring per process slot, sized when the
+ * process is created), and
  * a message's payload is never copied -- z_msg_send() just queues the
  * envelope (which still points into the *sender's* own memory), and
  * z_msg_read() resolves those pointers lazily, only for the process
@@ -26,90 +27,419 @@
 #include <stddef.h>
 
 #include "kernel.h"
+#include "mem.h"
 #include "msg.h"
+#include "imgcache.h"
 
 // -- mailboxes --
+//
+// each slot's ring is `depth` envelopes carved out of
+// z_mailbox_pool[] when its process is created
+// (k_msg_mailbox_create()) and handed back when it's reaped.
+// z_mailbox_owner[] records which pid (+1) holds each pool entry, 0 =
+// free; allocation is a first-fit scan for a free run, which is
+// plenty for a few hundred entries that only change hands when a
+// process starts or exits.
 
 typedef struct {
-	z_msg_envelope_t	msgs[Z_MAILBOX_DEPTH];
+	z_msg_envelope_t	*msgs;	// NULL: no process in this slot
+	uint32_t		depth;
 	uint32_t		head;	// next slot to pop
 	uint32_t		tail;	// next slot to push
 	uint32_t		count;
+	uint32_t		high_water;	// most ever queued at once
+	uint32_t		dropped;	// pushes refused for lack of room
+	uint32_t		senders;	// bit per pid parked in
+					// k_msg_send_wait() for room here
 } z_mailbox_t;
 
 volatile __attribute__((section(".bss"))) z_mailbox_t z_mailboxes[Z_PROCS_MAX];
+static __attribute__((section(".bss"))) z_msg_envelope_t z_mailbox_pool[Z_MAILBOX_POOL];
+static __attribute__((section(".bss"))) uint8_t z_mailbox_owner[Z_MAILBOX_POOL];
+
+// which mailbox each process is parked on in k_msg_send_wait() --
+// only meaningful while its bit is set in that mailbox's `senders`
+static volatile __attribute__((section(".bss"))) uint32_t z_msg_send_waits[Z_PROCS_MAX];
+
+// internal result for "refused for lack of room right now" -- worth
+// waiting out in k_msg_send_wait(), reported as plain Z_FAIL anywhere
+// else
+#define MSG_FULL	2
+
+// -- copy-send arenas -- one per mailbox, see zmsg.h's
+// z_msg_send_copy() paragraph. A ring of blocks, each a one-word
+// header (total length incl. the header, plus ARENA_RELEASED once the
+// receiver is done with it) followed by the payload copy: allocated
+// at head, reclaimed from tail as soon as the oldest block is
+// released. Receivers nearly always release in the order they read,
+// which is the order things were sent, so this almost never strands
+// space -- and when one doesn't, that block just holds up the blocks
+// after it until it is released, nothing worse.
+
+#define ARENA_RELEASED	0x80000000
+
+typedef struct {
+	uint8_t		*base;	// NULL until the first copy-send to this pid
+	uint32_t	head;	// offset of the next allocation
+	uint32_t	tail;	// offset of the oldest live block
+	uint32_t	used;	// bytes from tail to head, incl. wrap padding
+	uint32_t	pinned;	// bit per sender mid-copy into it -- see k_msg_busy()
+} z_msg_arena_t;
+
+static __attribute__((section(".bss"))) z_msg_arena_t z_msg_arenas[Z_PROCS_MAX];
+
+// -- outstanding k_msg_call()s -- at most one per process, since the
+// caller is blocked until it's over. While one is active, the only
+// message that wakes that process is the reply it's waiting for
+// (peer + tag); everything else just queues.
+
+typedef struct {
+	uint32_t	peer;
+	uint32_t	tag;
+	bool		active;
+} z_msg_call_t;
+
+static volatile __attribute__((section(".bss"))) z_msg_call_t z_msg_calls[Z_PROCS_MAX];
+
+// -- topics -- see zmsg.h. A slot is in use while it has at least one
+// subscriber; the last one leaving frees it for another topic id.
+// queued[] counts each subscriber's still-unread messages from this
+// topic (incremented on publish, decremented as they're popped), which
+// is what depth[] bounds.
+
+typedef struct {
+	uint32_t	id;
+	uint32_t	subs;			// bit per subscribed pid
+	uint8_t		depth[Z_PROCS_MAX];
+	uint8_t		queued[Z_PROCS_MAX];
+	uint32_t	dropped[Z_PROCS_MAX];
+} z_msg_topic_t;
+
+static volatile __attribute__((section(".bss"))) z_msg_topic_t z_msg_topics[Z_MSG_TOPICS_MAX];
+
+// -- channels -- see zchan.h. A slot is in use while `pair` is set;
+// ends[] holds each end's pid + 1 (opener first), 0 once that end has
+// closed or exited, and the block goes back to k_mem_free() when both
+// are 0. z_chan_waits[] is what each pid parked in Z_CHAN_WAIT is
+// waiting for.
+
+typedef struct {
+	z_chan_pair_t	*pair;
+	uint32_t	ends[2];
+} z_chan_slot_t;
+
+typedef struct {
+	uint32_t	slot;
+	uint32_t	need;
+} z_chan_wait_t;
+
+static __attribute__((section(".bss"))) z_chan_slot_t z_chans[Z_CHAN_MAX];
+static volatile __attribute__((section(".bss"))) z_chan_wait_t z_chan_waits[Z_PROCS_MAX];
+
+// drops end e of channel slot c: both rings read as closed from here
+// on, the other end is woken in case it's parked in Z_CHAN_WAIT (or
+// is about to read and find the ring empty), and the block is freed
+// once nobody's left holding it. IRQs masked by the caller.
+static void chan_drop(uint32_t c, uint32_t e) {
+	z_chan_slot_t *ch = &z_chans[c];
+	ch->ends[e] = 0;
+	ch->pair->ring[0].closed = 1;
+	ch->pair->ring[1].closed = 1;
+	if (ch->ends[e ^ 1]) {
+		k_proc_wake(ch->ends[e ^ 1] - 1);
+		return;
+	}
+	k_mem_free(ch->pair);
+	ch->pair = NULL;
+}
+
+static void mailbox_reset(uint32_t pid) {
+	volatile z_mailbox_t *mb = &z_mailboxes[pid];
+	mb->head = mb->tail = mb->count = 0;
+	mb->high_water = mb->dropped = mb->senders = 0;
+}
+
+void k_msg_init(void) {
+	for (int i = 0; i < Z_MAILBOX_POOL; i++)
+		z_mailbox_owner[i] = 0;
+	for (int p = 0; p < Z_PROCS_MAX; p++) {
+		z_mailboxes[p].msgs = NULL;
+		z_mailboxes[p].depth = 0;
+		mailbox_reset(p);
+		z_msg_arenas[p].base = NULL;
+		z_msg_arenas[p].head = z_msg_arenas[p].tail = z_msg_arenas[p].used = 0;
+		z_msg_arenas[p].pinned = 0;
+		z_msg_calls[p].active = false;
+	}
+	for (int t = 0; t < Z_MSG_TOPICS_MAX; t++)
+		z_msg_topics[t].subs = 0;
+	for (int c = 0; c < Z_CHAN_MAX; c++)
+		z_chans[c].pair = NULL;
+}
+
+// drops pid's subscription to topic slot t, freeing the slot if it
+// was the last one. IRQs masked by the caller.
+static void topic_leave(int t, uint32_t pid) {
+	z_msg_topics[t].subs &= ~(1u << pid);
+	z_msg_topics[t].queued[pid] = 0;
+}
+
+// an envelope published to a topic is leaving pid's mailbox (read, or
+// taken by k_msg_call()) -- give its place back under that
+// subscriber's depth. IRQs masked by the caller. Checks the slot still
+// holds the same topic, in case it was freed and reused meanwhile.
+static void topic_popped(uint32_t pid, const z_msg_envelope_t *env) {
+	if (!env->topic) return;
+	volatile z_msg_topic_t *tp = &z_msg_topics[env->topic - 1];
+	if ((tp->subs & (1u << pid)) && tp->id == env->subject && tp->queued[pid])
+		tp->queued[pid]--;
+}
+
+// hands pid's ring back to the pool. IRQs masked by the caller.
+static void mailbox_free(uint32_t pid) {
+	for (int i = 0; i < Z_MAILBOX_POOL; i++)
+		if (z_mailbox_owner[i] == pid + 1) z_mailbox_owner[i] = 0;
+	z_mailboxes[pid].msgs = NULL;
+	z_mailboxes[pid].depth = 0;
+}
+
+// see msg.h. Asking for more than the pool has left free in one run
+// gets half as much, and so on down to Z_MAILBOX_DEPTH_SMALL.
+z_rv k_msg_mailbox_create(uint32_t pid, uint32_t depth) {
+
+	if (pid >= Z_PROCS_MAX) return Z_FAIL;
+	if (!depth) depth = Z_MAILBOX_DEPTH;
+	if (depth > Z_MAILBOX_POOL) depth = Z_MAILBOX_POOL;
+
+	uint32_t old_mask = maskirq(0xFFFFFFFF);
+
+	mailbox_free(pid);	// never set up twice without a reap, but
+				// a leaked ring would be gone for good
+
+	for (; depth >= Z_MAILBOX_DEPTH_SMALL; depth /= 2) {
+		uint32_t run = 0;
+		for (uint32_t i = 0; i < Z_MAILBOX_POOL; i++) {
+			run = z_mailbox_owner[i] ? 0 : run + 1;
+			if (run < depth) continue;
+			uint32_t first = i + 1 - depth;
+			for (uint32_t j = first; j <= i; j++)
+				z_mailbox_owner[j] = pid + 1;
+			z_mailboxes[pid].msgs = &z_mailbox_pool[first];
+			z_mailboxes[pid].depth = depth;
+			mailbox_reset(pid);
+			maskirq(old_mask);
+			return Z_OK;
+		}
+	}
+
+	maskirq(old_mask);
+	return Z_FAIL;
+
+}
+
+// wakes every pid in the bitmask -- the senders parked on a mailbox
+// that just got room
+static void wake_senders(uint32_t waiters) {
+	for (uint32_t p = 0; waiters; p++, waiters >>= 1)
+		if (waiters & 1) k_proc_wake(p);
+}
+
+// see msg.h -- from the scheduler's reap path, IRQs masked
+bool k_msg_busy(uint32_t pid) {
+	// a sender that's itself been killed will never finish its copy
+	// -- or touch the arena again
+	uint32_t pinned = z_msg_arenas[pid].pinned;
+	for (int p = 0; p < Z_PROCS_MAX; p++)
+		if ((pinned & (1u << p)) &&
+			(z_procs[p].flags & (Z_PROC_FLAG_ACTIVE | Z_PROC_FLAG_DIE)) == Z_PROC_FLAG_ACTIVE)
+			return true;
+	return false;
+}
+
+void k_msg_release_all(uint32_t pid) {
+	// anyone parked waiting for room in pid's mailbox: there'll never
+	// be any -- their retry finds pid gone and fails
+	wake_senders(z_mailboxes[pid].senders);
+	mailbox_reset(pid);
+	mailbox_free(pid);
+	for (int p = 0; p < Z_PROCS_MAX; p++)
+		z_mailboxes[p].senders &= ~(1u << pid);
+	if (z_msg_arenas[pid].base) k_mem_free(z_msg_arenas[pid].base);
+	z_msg_arenas[pid].base = NULL;
+	z_msg_arenas[pid].head = z_msg_arenas[pid].tail = z_msg_arenas[pid].used = 0;
+	z_msg_arenas[pid].pinned = 0;
+	// and any copy of its own it was killed in the middle of
+	for (int p = 0; p < Z_PROCS_MAX; p++)
+		z_msg_arenas[p].pinned &= ~(1u << pid);
+	z_msg_calls[pid].active = false;
+	for (int t = 0; t < Z_MSG_TOPICS_MAX; t++)
+		topic_leave(t, pid);
+	for (uint32_t c = 0; c < Z_CHAN_MAX; c++) {
+		if (!z_chans[c].pair) continue;
+		for (uint32_t e = 0; e < 2; e++)
+			if (z_chans[c].pair && z_chans[c].ends[e] == pid + 1)
+				chan_drop(c, e);
+	}
+	// anyone still waiting on a reply from pid never gets one --
+	// end their call now (k_msg_call() notices it's no longer
+	// active) rather than leaving them to their timeout, or forever
+	for (int p = 0; p < Z_PROCS_MAX; p++) {
+		if (z_msg_calls[p].active && z_msg_calls[p].peer == pid) {
+			z_msg_calls[p].active = false;
+			k_proc_wake(p);
+		}
+	}
+}
+
+static inline bool call_matches(uint32_t pid, const z_msg_envelope_t *env) {
+	return z_msg_calls[pid].active && env->from == z_msg_calls[pid].peer &&
+		env->tag == z_msg_calls[pid].tag;
+}
 
 z_rv z_mailbox_is_empty(uint32_t pid) {
 	return (z_mailboxes[pid].count == 0) ? Z_OK : Z_FAIL;
 }
 
 z_rv z_mailbox_is_full(uint32_t pid) {
-	return (z_mailboxes[pid].count >= Z_MAILBOX_DEPTH) ? Z_OK : Z_FAIL;
+	return (z_mailboxes[pid].count >= z_mailboxes[pid].depth) ? Z_OK : Z_FAIL;
 }
 
-z_rv z_mailbox_push(uint32_t pid, z_msg_envelope_t *msg) {
+// z_mailbox_push()'s body, returning MSG_FULL when there's no room.
+// `quiet` keeps that out of the mailbox's drop count, for a sender
+// that's going to wait and retry (k_msg_send_wait()).
+static uint32_t mailbox_push(uint32_t pid, z_msg_envelope_t *msg, bool quiet) {
 
 	// mask irqs so a scheduler swap can't interleave with another
 	// process pushing/popping the same mailbox mid-update
 	uint32_t old_mask = maskirq(0xFFFFFFFF);
 
-	if (z_mailboxes[pid].count >= Z_MAILBOX_DEPTH) {
+	volatile z_mailbox_t *mb = &z_mailboxes[pid];
+
+	if (!mb->msgs) {
 		maskirq(old_mask);
 		return Z_FAIL;
 	}
 
-	z_mailboxes[pid].msgs[z_mailboxes[pid].tail] = *msg;
-	z_mailboxes[pid].tail = (z_mailboxes[pid].tail + 1) % Z_MAILBOX_DEPTH;
-	z_mailboxes[pid].count++;
+	if (mb->count >= mb->depth) {
+		if (!quiet) mb->dropped++;
+		maskirq(old_mask);
+		return MSG_FULL;
+	}
+
+	mb->msgs[mb->tail] = *msg;
+	mb->tail = (mb->tail + 1) % mb->depth;
+	mb->count++;
+	if (mb->count > mb->high_water) mb->high_water = mb->count;
+
+	// the receiver may be asleep in k_msg_block() -- see kernel.h's
+	// Z_PROC_FLAG_WAIT. One asleep in k_msg_call() is only woken by
+	// its reply, and gets the CPU handed straight back with it.
+	bool in_call = z_msg_calls[pid].active;
+	bool reply = call_matches(pid, msg);
 
 	maskirq(old_mask);
+
+	if (!in_call || reply) k_proc_wake(pid);
+	if (reply) k_proc_handoff(pid);
 	return Z_OK;
 
 }
 
+z_rv z_mailbox_push(uint32_t pid, z_msg_envelope_t *msg) {
+	return (mailbox_push(pid, msg, false) == Z_OK) ? Z_OK : Z_FAIL;
+}
+
+// see msg.h. Same as z_mailbox_push(), except that if the newest
+// envelope still queued has the same sender and subject, and its
+// uint32 payload agrees with msg's on every bit in keep_mask, it's
+// overwritten in place instead of a second one being queued.
+z_rv z_mailbox_push_merge(uint32_t pid, z_msg_envelope_t *msg, uint32_t keep_mask) {
+
+	uint32_t old_mask = maskirq(0xFFFFFFFF);
+
+	if (z_mailboxes[pid].count > 0) {
+		uint32_t depth = z_mailboxes[pid].depth;
+		uint32_t last = (z_mailboxes[pid].tail + depth - 1) % depth;
+		volatile z_msg_envelope_t *e = &z_mailboxes[pid].msgs[last];
+		if (e->from == msg->from && e->subject == msg->subject &&
+			e->obj.type == Z_UINT32 && msg->obj.type == Z_UINT32 &&
+			((e->obj.val.uint32 ^ msg->obj.val.uint32) & keep_mask) == 0) {
+			e->obj.val.uint32 = msg->obj.val.uint32;
+			maskirq(old_mask);
+			return Z_OK;
+		}
+	}
+
+	maskirq(old_mask);
+	return z_mailbox_push(pid, msg);
+
+}
+
 z_rv z_mailbox_pop(uint32_t pid, z_msg_envelope_t *msg) {
 
 	uint32_t old_mask = maskirq(0xFFFFFFFF);
 
-	if (z_mailboxes[pid].count == 0) {
+	volatile z_mailbox_t *mb = &z_mailboxes[pid];
+
+	if (mb->count == 0) {
 		maskirq(old_mask);
 		return Z_FAIL;
 	}
 
-	*msg = z_mailboxes[pid].msgs[z_mailboxes[pid].head];
-	z_mailboxes[pid].head = (z_mailboxes[pid].head + 1) % Z_MAILBOX_DEPTH;
-	z_mailboxes[pid].count--;
+	*msg = mb->msgs[mb->head];
+	mb->head = (mb->head + 1) % mb->depth;
+	mb->count--;
+	topic_popped(pid, msg);
+
+	uint32_t waiters = mb->senders;
+	mb->senders = 0;
 
 	maskirq(old_mask);
+	wake_senders(waiters);
 	return Z_OK;
 
 }
 
-// -- pointer resolution --
+// pops the OLDEST envelope in pid's mailbox from `from` with tag
+// `tag`, wherever it is in the ring, closing the gap behind it so
+// everything else stays queued in its original order. Z_FAIL if
+// there isn't one. k_msg_call()'s reply lookup -- mailboxes are at
+// most Z_MAILBOX_DEPTH_LARGE deep, so the scan and the shuffle are
+// both short.
+static z_rv z_mailbox_take(uint32_t pid, uint32_t from, uint32_t tag,
+	z_msg_envelope_t *msg) {
+
+	uint32_t old_mask = maskirq(0xFFFFFFFF);
+
+	volatile z_mailbox_t *mb = &z_mailboxes[pid];
+	uint32_t depth = mb->depth;
+	for (uint32_t i = 0; i < mb->count; i++) {
+		uint32_t idx = (mb->head + i) % depth;
+		if (mb->msgs[idx].from != from || mb->msgs[idx].tag != tag)
+			continue;
+		*msg = mb->msgs[idx];
+		for (uint32_t j = i; j + 1 < mb->count; j++)
+			mb->msgs[(mb->head + j) % depth] =
+				mb->msgs[(mb->head + j + 1) % depth];
+		mb->tail = (mb->tail + depth - 1) % depth;
+		mb->count--;
+		topic_popped(pid, msg);
+		uint32_t waiters = mb->senders;
+		mb->senders = 0;
+		maskirq(old_mask);
+		wake_senders(waiters);
+		return Z_OK;
+	}
+
+	maskirq(old_mask);
+	return Z_FAIL;
 
-// convert a pointer that was created by process `pid` (i.e. it's
-// expressed relative to that process's 0x8000_0000 mirror) into the
-// physical address it actually refers to. the result is always below
-// the mirror window, so it's dereferenceable directly, from any
-// process's context, without going through the MTU.
-//
-// pid 0 (the kernel, including sh.c acting as pid 0) is a special
-// case: it never runs through the 0x8000_0000 mirror at all -- it
-// executes at, and allocates from, its own native/physical address
-// space directly. applying the mirror-subtraction formula to a
-// pointer that was never mirrored in the first place produces a wild,
-// garbage address (a large unsigned underflow, since such a pointer
-// is nowhere near 0x8000_0000) -- this was a real, crash-causing bug,
-// only ever exercised once something first sent a message *from* the
-// kernel to a regular process (previously, every message was
-// app-to-app or app-to-wm; sh.c's tget/tput were the first
-// kernel-to-app case).
-static inline void *z_translate(uint32_t pid, void *vptr) {
-	if (!vptr) return NULL;
-	if (pid == 0) return vptr;
-	return (void *)((uint32_t)vptr - 0x80000000 + z_procs[pid].base);
 }
 
+// -- pointer resolution --
+
+// z_translate() is in msg.h -- fsapi.c's async requests need it too
+
 // resolve a z_obj_t that (possibly) belongs to process `from_pid` so
 // it's safe for the *current* process to read. scalars are untouched.
 // strings are pointed at the sender's bytes via a physical address --
@@ -186,6 +516,8 @@ static z_rv z_resolve_obj(uint32_t from_pid, z_obj_t *obj,
 
 			z_obj_table_t *dst = &tables[(*tcount)++];
 			dst->len = len;
+			dst->flags = src->flags;	// slot for slot, so a hashed
+			dst->count = src->count;	// map stays findable
 			dst->a = &items[*icount]; *icount += len;
 			dst->b = is_map ? &items[*icount] : NULL;
 			if (is_map) *icount += len;
@@ -227,17 +559,233 @@ static z_rv z_resolve_obj(uint32_t from_pid, z_obj_t *obj,
 
 }
 
+// -- kernel-owned payloads (z_msg_send_copy()) --
+
+#define ARENA_ALIGN(n)	(((n) + 3) & ~3u)
+#define ARENA_MAX_DEPTH	8	// nesting limit for lists/maps
+
+static inline uint32_t *arena_hdr(z_msg_arena_t *a, uint32_t off) {
+	return (uint32_t *)(a->base + off);
+}
+
+// reserves n bytes (a multiple of 4, header included) and returns the
+// block's offset, or Z_MSG_ARENA_SIZE if there isn't room. IRQs
+// masked by the caller.
+static uint32_t arena_alloc(z_msg_arena_t *a, uint32_t n) {
+
+	if (a->used == 0) a->head = a->tail = 0;
+
+	if (a->used + n > Z_MSG_ARENA_SIZE) return Z_MSG_ARENA_SIZE;
+
+	if (a->head >= a->tail) {
+		// free space is [head, end) and [0, tail)
+		if (Z_MSG_ARENA_SIZE - a->head < n) {
+			if (a->tail < n) return Z_MSG_ARENA_SIZE;
+			// doesn't fit before the end -- pad the rest out as an
+			// already-released block and start again from 0
+			uint32_t pad = Z_MSG_ARENA_SIZE - a->head;
+			if (pad) *arena_hdr(a, a->head) = pad | ARENA_RELEASED;
+			a->used += pad;
+			a->head = 0;
+		}
+	} else if (a->tail - a->head < n) {
+		return Z_MSG_ARENA_SIZE;
+	}
+
+	uint32_t off = a->head;
+	*arena_hdr(a, off) = n;
+	a->head = (off + n) % Z_MSG_ARENA_SIZE;
+	a->used += n;
+	return off;
+
+}
+
+// marks the block at off released and reclaims everything now free
+// at the tail. IRQs masked by the caller.
+static void arena_free(z_msg_arena_t *a, uint32_t off) {
+
+	*arena_hdr(a, off) |= ARENA_RELEASED;
+
+	while (a->used) {
+		uint32_t h = *arena_hdr(a, a->tail);
+		if (!(h & ARENA_RELEASED)) break;
+		uint32_t len = h & ~ARENA_RELEASED;
+		a->used -= len;
+		a->tail = (a->tail + len) % Z_MSG_ARENA_SIZE;
+	}
+
+}
+
+// bytes copy_obj() will need for *obj's payload. Runs in the SENDER's
+// syscall, so obj's pointers are read straight through the MTU like
+// any other syscall argument. Z_MSG_ARENA_SIZE (too big to ever fit)
+// for anything that can't be copied.
+static uint32_t copy_size(const z_obj_t *obj, int depth) {
+
+	if (depth > ARENA_MAX_DEPTH) return Z_MSG_ARENA_SIZE;
+
+	switch (obj->type) {
+
+		case Z_STR:
+			return obj->val.str ? ARENA_ALIGN(strlen(obj->val.str) + 1) : 0;
+
+		case Z_BLOB: {
+			const z_blob_t *b = (const z_blob_t *)obj->val.ptr;
+			if (!b) return 0;
+			if (b->len && !b->data) return Z_MSG_ARENA_SIZE;
+			return ARENA_ALIGN(sizeof(z_blob_t)) + ARENA_ALIGN(b->len);
+		}
+
+		case Z_LIST:
+		case Z_MAP: {
+			const z_obj_table_t *t = (const z_obj_table_t *)obj->val.ptr;
+			if (!t) return 0;
+			uint32_t slots = t->len * ((obj->type == Z_MAP) ? 2 : 1);
+			uint32_t n = sizeof(z_obj_table_t) + slots * sizeof(z_obj_t);
+			for (uint32_t i = 0; i < t->len; i++) {
+				n += copy_size(&t->a[i], depth + 1);
+				if (obj->type == Z_MAP) n += copy_size(&t->b[i], depth + 1);
+				if (n >= Z_MSG_ARENA_SIZE) return Z_MSG_ARENA_SIZE;
+			}
+			return n;
+		}
+
+		default:
+			return 0;	// scalars travel in the envelope itself
+
+	}
+
+}
+
+// copies *obj's payload to *cur (advancing it) and points obj at the
+// copy. Sizes/limits already checked by copy_size().
+static void copy_obj(z_obj_t *obj, uint8_t **cur) {
+
+	switch (obj->type) {
+
+		case Z_STR: {
+			if (!obj->val.str) return;
+			uint32_t len = strlen(obj->val.str) + 1;
+			memcpy(*cur, obj->val.str, len);
+			obj->val.str = (char *)*cur;
+			*cur += ARENA_ALIGN(len);
+			return;
+		}
+
+		case Z_BLOB: {
+			const z_blob_t *src = (const z_blob_t *)obj->val.ptr;
+			if (!src) return;
+			z_blob_t *dst = (z_blob_t *)*cur;
+			*cur += ARENA_ALIGN(sizeof(z_blob_t));
+			dst->len = src->len;
+			dst->data = *cur;
+			if (src->len) memcpy(dst->data, src->data, src->len);
+			*cur += ARENA_ALIGN(src->len);
+			obj->val.ptr = dst;
+			return;
+		}
+
+		case Z_LIST:
+		case Z_MAP: {
+			const z_obj_table_t *src = (const z_obj_table_t *)obj->val.ptr;
+			if (!src) return;
+			bool is_map = (obj->type == Z_MAP);
+			z_obj_table_t *dst = (z_obj_table_t *)*cur;
+			*cur += sizeof(z_obj_table_t);
+			dst->len = src->len;
+			dst->flags = src->flags;
+			dst->count = src->count;
+			dst->a = (z_obj_t *)*cur;
+			*cur += src->len * sizeof(z_obj_t);
+			dst->b = NULL;
+			if (is_map) {
+				dst->b = (z_obj_t *)*cur;
+				*cur += src->len * sizeof(z_obj_t);
+			}
+			for (uint32_t i = 0; i < src->len; i++) {
+				dst->a[i] = src->a[i];
+				copy_obj(&dst->a[i], cur);
+				if (is_map) {
+					dst->b[i] = src->b[i];
+					copy_obj(&dst->b[i], cur);
+				}
+			}
+			obj->val.ptr = dst;
+			return;
+		}
+
+		default:
+			return;
+
+	}
+
+}
+
+// queues env for `to` with its payload (env->obj, still in the
+// sender's view, `size` bytes per copy_size()) copied into to's
+// arena first -- the shared half of k_msg_send_copy() and
+// k_msg_publish(). The arena is allocated the first time it's needed.
+// MSG_FULL if the arena or the mailbox has no room; `quiet` as for
+// mailbox_push().
+static uint32_t push_copy(uint32_t to, z_msg_envelope_t *env, uint32_t size, bool quiet) {
+
+	uint32_t n = ARENA_ALIGN(size) + 4;	// + the block header
+	z_msg_arena_t *a = &z_msg_arenas[to];
+
+	uint32_t old_mask = maskirq(0xFFFFFFFF);
+	if (!a->base) {
+		// through the image cache, like every kernel allocation that
+		// has to succeed -- see imgcache.h
+		a->base = (uint8_t *)k_imgcache_alloc(Z_MSG_ARENA_SIZE);
+		a->head = a->tail = a->used = 0;
+	}
+	uint8_t *base = a->base;
+	if (!base) {
+		maskirq(old_mask);
+		return Z_FAIL;
+	}
+	uint32_t off = arena_alloc(a, n);
+	if (off == Z_MSG_ARENA_SIZE && !quiet) z_mailboxes[to].dropped++;
+	// pinned while we copy, so the scheduler leaves the receiver
+	// unreaped (k_msg_busy()) and its arena where it is. Only the
+	// outermost copy unpins -- an IRQ handler's send can land in the
+	// middle of ours, from the same pid.
+	uint32_t pin = 1u << z_pid;
+	bool pinned = (off != Z_MSG_ARENA_SIZE) && !(a->pinned & pin);
+	if (pinned) a->pinned |= pin;
+	maskirq(old_mask);
+
+	if (off == Z_MSG_ARENA_SIZE) return MSG_FULL;
+
+	// the copy itself runs with IRQs enabled -- the block is ours
+	// until it's either queued or handed back below
+	uint8_t *cur = base + off + 4;
+	copy_obj(&env->obj, &cur);
+	env->kbuf = (uint32_t)(uintptr_t)(base + off);
+
+	old_mask = maskirq(0xFFFFFFFF);
+	if (pinned) a->pinned &= ~pin;
+	uint32_t rv = mailbox_push(to, env, quiet);
+	if (rv != Z_OK) arena_free(a, off);
+	maskirq(old_mask);
+
+	return rv;
+
+}
+
 // -- syscalls --
 
-z_obj_t *k_msg_send(z_obj_t *args) {
+// the body of k_msg_send() (copy = false) and k_msg_send_copy(), with
+// MSG_FULL kept apart from other failures for k_msg_send_wait()
+static uint32_t msg_send(z_msg_t *msg, bool copy, bool quiet) {
 
-	z_msg_t *msg = (z_msg_t *)args;
+	uint32_t to = msg->to;
 
-	if (msg->to >= Z_PROCS_MAX || z_procs[msg->to].base == 0)
-		return (&z_fail);
+	if (to >= Z_PROCS_MAX || z_procs[to].base == 0)
+		return Z_FAIL;
 
 	z_msg_envelope_t env;
-	env.to = msg->to;
+	env.to = to;
 	env.from = z_pid;	// stamped by the kernel; the caller's `from` is ignored
 	env.subject = msg->subject;
 	env.tag = msg->tag;
@@ -245,41 +793,614 @@ z_obj_t *k_msg_send(z_obj_t *args) {
 	// scalar payloads are copied as-is here. str/list/map payloads
 	// still point into the *sender's* own memory at this point --
 	// left untouched; z_msg_read() resolves them, lazily, only if the
-	// message actually gets read.
+	// message actually gets read. Unless it's a copy-send, that is.
 	env.obj = msg->obj;
+	env.kbuf = 0;
+	env.topic = 0;
+
+	if (copy) {
+		uint32_t size = copy_size(&env.obj, 0);
+		if (size >= Z_MSG_ARENA_SIZE) return Z_FAIL;
+		if (size) return push_copy(to, &env, size, quiet);
+		// otherwise there's nothing to copy
+	}
 
-	if (z_mailbox_push(msg->to, &env) != Z_OK)
-		return (&z_fail);
+	return mailbox_push(to, &env, quiet);
 
-	return (&z_ok);
+}
 
+z_obj_t *k_msg_send(z_obj_t *args) {
+	return (msg_send((z_msg_t *)args, false, false) == Z_OK) ? (&z_ok) : (&z_fail);
 }
 
-z_obj_t *k_msg_read(z_obj_t *args) {
+// Z_SYS_MSG_SEND_COPY -- same z_msg_t argument as k_msg_send(), but
+// the payload is copied into msg->to's arena before this returns (see
+// zmsg.h). Fails -- with nothing queued and nothing left allocated --
+// if the receiver's mailbox or arena is full, the kernel pool can't
+// spare an arena, or the payload is too big/deep to copy; the caller
+// still owns its data either way.
+z_obj_t *k_msg_send_copy(z_obj_t *args) {
+	return (msg_send((z_msg_t *)args, true, false) == Z_OK) ? (&z_ok) : (&z_fail);
+}
+
+// k_msg_send_wait()'s wakeup condition: whoever made room in the
+// mailbox we're parked on cleared our bit (z_mailbox_pop() and co.)
+static bool space_ready(uint32_t pid) {
+	return !(z_mailboxes[z_msg_send_waits[pid]].senders & (1u << pid));
+}
+
+// Z_SYS_MSG_SEND_WAIT -- args is a z_msg_send_wait_args_t (zmsg.h).
+// k_msg_send() (or k_msg_send_copy() if a->copy), except that a full
+// mailbox -- or arena -- parks the caller until the receiver reads or
+// releases something, then tries again, up to a->timeout ticks (0 =
+// forever). Only running out of time counts as a drop. The caller
+// registers in the receiver's `senders` BEFORE each try, so room made
+// between a failed try and going to sleep still wakes it. pid 0 can't
+// sleep, so the shell polls instead, as in k_msg_call().
+z_obj_t *k_msg_send_wait(z_obj_t *args) {
+
+	z_msg_send_wait_args_t *a = (z_msg_send_wait_args_t *)args;
+	if (!a || !a->msg) return (&z_fail);
+
+	uint32_t pid = z_pid;
+	uint32_t bit = 1u << pid;
+	uint32_t to = a->msg->to;
+	uint32_t timeout = a->timeout;
+
+	if (to >= Z_PROCS_MAX) return (&z_fail);
+
+	// nobody would ever be left running to make room in our own
+	// mailbox
+	if (to == pid)
+		return (msg_send(a->msg, a->copy, false) == Z_OK) ? (&z_ok) : (&z_fail);
+
+	uint32_t start = z_kernel_ticks;
+
+	while (1) {
+
+		uint32_t old_mask = maskirq(0xFFFFFFFF);
+		z_msg_send_waits[pid] = to;
+		z_mailboxes[to].senders |= bit;
+		maskirq(old_mask);
+
+		uint32_t rv = msg_send(a->msg, a->copy, true);
+		uint32_t waited = z_kernel_ticks - start;
+
+		if (rv == MSG_FULL && !(timeout && waited >= timeout)) {
+			k_proc_block(space_ready, timeout ? timeout - waited : 0);
+			continue;
+		}
+
+		old_mask = maskirq(0xFFFFFFFF);
+		z_mailboxes[to].senders &= ~bit;
+		if (rv == MSG_FULL) z_mailboxes[to].dropped++;
+		maskirq(old_mask);
+
+		return (rv == Z_OK) ? (&z_ok) : (&z_fail);
+
+	}
+
+}
+
+// Z_SYS_MSG_STATS -- args is a z_msg_stats_t (zmsg.h) with pid filled
+// in; the rest is filled in from that pid's mailbox. Z_FAIL if there's
+// no process in that slot.
+z_obj_t *k_msg_stats(z_obj_t *args) {
+
+	z_msg_stats_t *s = (z_msg_stats_t *)args;
+	if (!s || s->pid >= Z_PROCS_MAX) return (&z_fail);
+
+	uint32_t old_mask = maskirq(0xFFFFFFFF);
+	volatile z_mailbox_t *mb = &z_mailboxes[s->pid];
+	bool live = (mb->msgs != NULL);
+	s->depth = mb->depth;
+	s->count = mb->count;
+	s->high_water = mb->high_water;
+	s->dropped = mb->dropped;
+	maskirq(old_mask);
+
+	return live ? (&z_ok) : (&z_fail);
+
+}
+
+// Z_SYS_MSG_RELEASE -- args is the caller's z_msg_t, as z_msg_read()
+// filled it in. Hands its _kbuf block back to the CALLER's own arena
+// and clears _kbuf, so releasing twice is harmless; anything that
+// isn't a live block in that arena is ignored.
+z_obj_t *k_msg_release(z_obj_t *args) {
 
 	z_msg_t *msg = (z_msg_t *)args;
+	if (!msg || !msg->_kbuf) return (&z_ok);
 
-	z_msg_envelope_t env;
-	if (z_mailbox_pop(z_pid, &env) != Z_OK)
+	z_msg_arena_t *a = &z_msg_arenas[z_pid];
+	uint32_t p = msg->_kbuf;
+	msg->_kbuf = 0;
+
+	uint32_t old_mask = maskirq(0xFFFFFFFF);
+	uint32_t base = (uint32_t)(uintptr_t)a->base;
+	if (!a->base || p < base || p >= base + Z_MSG_ARENA_SIZE || (p & 3) ||
+		(*arena_hdr(a, p - base) & ARENA_RELEASED)) {
+		maskirq(old_mask);
 		return (&z_fail);
+	}
+	arena_free(a, p - base);
+	// room in the arena is room for a copy-send that was parked on it
+	uint32_t waiters = z_mailboxes[z_pid].senders;
+	z_mailboxes[z_pid].senders = 0;
+	maskirq(old_mask);
+	wake_senders(waiters);
+
+	return (&z_ok);
+
+}
+
+// fills in the reader's z_msg_t from a popped envelope -- shared by
+// k_msg_read() and k_msg_call()
+static void msg_deliver(z_msg_t *msg, const z_msg_envelope_t *env) {
+
+	msg->to = env->to;
+	msg->from = env->from;
+	msg->subject = env->subject;
+	msg->tag = env->tag;
+	msg->obj = env->obj;
+	msg->_kbuf = env->kbuf;
 
-	msg->to = env.to;
-	msg->from = env.from;
-	msg->subject = env.subject;
-	msg->tag = env.tag;
-	msg->obj = env.obj;
+	// a kernel-owned copy is already in physical addresses, readable
+	// from anywhere -- nothing to resolve
+	if (env->kbuf) return;
 
 	uint32_t tcount = 0, icount = 0, bcount = 0;
-	z_resolve_obj(env.from, &msg->obj, msg->_tables, &tcount,
+	z_resolve_obj(env->from, &msg->obj, msg->_tables, &tcount,
 		msg->_items, &icount, msg->_blobs, &bcount);
 	// on scratch-budget overflow the message is still delivered (so
 	// the mailbox doesn't get stuck), but msg->obj comes back as
 	// Z_NONE -- see z_resolve_obj().
 
+}
+
+z_obj_t *k_msg_read(z_obj_t *args) {
+
+	z_msg_t *msg = (z_msg_t *)args;
+
+	z_msg_envelope_t env;
+	if (z_mailbox_pop(z_pid, &env) != Z_OK)
+		return (&z_fail);
+
+	msg_deliver(msg, &env);
+	return (&z_ok);
+
+}
+
+// Z_SYS_MSG_READ_N -- args is a z_msg_batch_args_t (zmsg.h). Just
+// k_msg_read()'s pop + deliver in a loop, so a burst costs one kernel
+// entry instead of one per message; z_ok even when nothing was there
+// (count says how many).
+z_obj_t *k_msg_read_n(z_obj_t *args) {
+
+	z_msg_batch_args_t *a = (z_msg_batch_args_t *)args;
+	if (!a || (!a->msgs && a->n)) return (&z_fail);
+
+	a->count = 0;
+
+	z_msg_envelope_t env;
+	while (a->count < a->n && z_mailbox_pop(z_pid, &env) == Z_OK)
+		msg_deliver(&a->msgs[a->count++], &env);
+
+	return (&z_ok);
+
+}
+
+// Z_SYS_MSG_SEND_N -- args is a z_msg_batch_args_t (zmsg.h). Each
+// message goes through k_msg_send() exactly as if sent on its own,
+// so one full mailbox only costs that one message. z_fail if none at
+// all got through.
+z_obj_t *k_msg_send_n(z_obj_t *args) {
+
+	z_msg_batch_args_t *a = (z_msg_batch_args_t *)args;
+	if (!a || (!a->msgs && a->n)) return (&z_fail);
+
+	a->count = 0;
+	a->failed = 0;
+
+	for (uint32_t i = 0; i < a->n; i++) {
+		if (k_msg_send((z_obj_t *)&a->msgs[i])->val.uint32 == Z_OK)
+			a->count++;
+		else if (i < 32)
+			a->failed |= 1u << i;
+	}
+
+	return (a->count || !a->n) ? (&z_ok) : (&z_fail);
+
+}
+
+// fastcalls.def version of k_msg_read() -- a1 is the caller's
+// z_msg_t *. Every app main loop polls its mailbox far more often
+// than anything's actually in it, so the empty case is answered
+// right here from the count alone, without touching `msg` at all;
+// anything else is just k_msg_read() as before.
+uint32_t k_fast_msg_read(uint32_t a1, uint32_t a2, uint32_t a3) {
+	if (z_mailboxes[z_pid].count == 0) return Z_FAIL;
+	return k_msg_read((z_obj_t *)(uintptr_t)a1)->val.uint32;
+}
+
+static bool mailbox_ready(uint32_t pid) {
+	return z_mailboxes[pid].count != 0;
+}
+
+// Z_SYS_MSG_BLOCK -- args->val.uint32 is the timeout in ticks (0 =
+// none). Returns z_ok once there's something to read, z_fail if the
+// timeout ran out first; doesn't read anything itself, so a caller
+// can't lose a message to it. See k_proc_block() in kernel.c for
+// what "asleep" actually means on this CPU.
+z_obj_t *k_msg_block(z_obj_t *args) {
+	uint32_t timeout = (args && args->type == Z_UINT32) ? args->val.uint32 : 0;
+	// a wakeup for something else (a channel's Z_CHAN_WAKE) leaves the
+	// mailbox empty -- back to sleep for whatever's left, see kernel.h
+	uint32_t start = z_kernel_ticks;
+	for (;;) {
+		uint32_t left = 0;
+		if (timeout) {
+			uint32_t spent = z_kernel_ticks - start;
+			if (spent >= timeout) return mailbox_ready(z_pid) ? (&z_ok) : (&z_fail);
+			left = timeout - spent;
+		}
+		if (k_proc_block(mailbox_ready, left)) return (&z_ok);
+		if (z_pid == 0) return (&z_fail);	// never sleeps -- see kernel.h
+	}
+}
+
+// k_msg_call()'s wakeup condition: the reply is queued, or the call
+// was ended from outside (the callee exited -- k_msg_release_all())
+static bool call_ready(uint32_t pid) {
+	if (!z_msg_calls[pid].active) return true;
+	volatile z_mailbox_t *mb = &z_mailboxes[pid];
+	for (uint32_t i = 0; i < mb->count; i++) {
+		uint32_t idx = (mb->head + i) % mb->depth;
+		if (mb->msgs[idx].from == z_msg_calls[pid].peer &&
+			mb->msgs[idx].tag == z_msg_calls[pid].tag)
+			return true;
+	}
+	return false;
+}
+
+// Z_SYS_MSG_CALL -- args is a z_msg_call_args_t (zmsg.h). Sends
+// a->msg exactly as k_msg_send() would, then sleeps until a reply
+// from the same pid with the same tag shows up and reads it into
+// a->msg, leaving everything else in the mailbox where it was. The
+// call is registered BEFORE the send, so a callee that replies before
+// we're even asleep is still seen. Both directions pass the CPU on
+// with k_proc_handoff(): the callee runs at the next swap instead of
+// after a whole round-robin lap, and z_mailbox_push() does the same
+// for us when the reply lands -- about a tick each way at worst,
+// since the spin in k_proc_block() still has to run out the current
+// slice. pid 0 can't sleep, so the shell just polls here instead.
+z_obj_t *k_msg_call(z_obj_t *args) {
+
+	z_msg_call_args_t *a = (z_msg_call_args_t *)args;
+	if (!a || !a->msg) return (&z_fail);
+
+	z_msg_t *msg = a->msg;
+	uint32_t pid = z_pid;
+	uint32_t peer = msg->to;
+	uint32_t tag = msg->tag;
+	uint32_t timeout = a->timeout;
+
+	// nobody would ever be left running to answer a call to ourselves
+	if (peer == pid) return (&z_fail);
+
+	uint32_t old_mask = maskirq(0xFFFFFFFF);
+	z_msg_calls[pid].peer = peer;
+	z_msg_calls[pid].tag = tag;
+	z_msg_calls[pid].active = true;
+	maskirq(old_mask);
+
+	if (k_msg_send((z_obj_t *)msg)->val.uint32 != Z_OK) {
+		z_msg_calls[pid].active = false;
+		return (&z_fail);
+	}
+	k_proc_handoff(peer);
+
+	uint32_t start = z_kernel_ticks;
+	z_msg_envelope_t env;
+
+	while (z_mailbox_take(pid, peer, tag, &env) != Z_OK) {
+		uint32_t waited = z_kernel_ticks - start;
+		if (!z_msg_calls[pid].active || (timeout && waited >= timeout)) {
+			z_msg_calls[pid].active = false;
+			return (&z_fail);
+		}
+		k_proc_block(call_ready, timeout ? timeout - waited : 0);
+	}
+
+	z_msg_calls[pid].active = false;
+	msg_deliver(msg, &env);
+	return (&z_ok);
+
+}
+
+// Z_SYS_MSG_SUBSCRIBE -- args is a z_msg_topic_args_t (zmsg.h), acting
+// on the caller's own subscription to args->topic. Subscribing again
+// just updates the depth (keeping the drop count); Z_FAIL only if
+// every topic slot is already taken by other topics, or for
+// UNSUBSCRIBE/STATUS on a topic the caller isn't subscribed to.
+z_obj_t *k_msg_subscribe(z_obj_t *args) {
+
+	z_msg_topic_args_t *a = (z_msg_topic_args_t *)args;
+	if (!a) return (&z_fail);
+
+	uint32_t pid = z_pid;
+	uint32_t bit = 1u << pid;
+	uint32_t depth = a->depth ? a->depth : Z_MSG_TOPIC_DEPTH;
+	if (depth > z_mailboxes[pid].depth) depth = z_mailboxes[pid].depth;
+	a->dropped = 0;
+
+	uint32_t old_mask = maskirq(0xFFFFFFFF);
+
+	int t, free_t = -1;
+	for (t = 0; t < Z_MSG_TOPICS_MAX; t++) {
+		if (z_msg_topics[t].subs && z_msg_topics[t].id == a->topic) break;
+		if (!z_msg_topics[t].subs && free_t < 0) free_t = t;
+	}
+	bool subscribed = (t < Z_MSG_TOPICS_MAX) && (z_msg_topics[t].subs & bit);
+
+	z_obj_t *rv = &z_ok;
+
+	switch (a->op) {
+
+		case Z_MSG_TOPIC_SUBSCRIBE:
+			if (t == Z_MSG_TOPICS_MAX) {
+				if (free_t < 0) { rv = &z_fail; break; }
+				t = free_t;
+				z_msg_topics[t].id = a->topic;
+			}
+			if (!subscribed) {
+				z_msg_topics[t].queued[pid] = 0;
+				z_msg_topics[t].dropped[pid] = 0;
+			}
+			z_msg_topics[t].depth[pid] = depth;
+			z_msg_topics[t].subs |= bit;
+			a->dropped = z_msg_topics[t].dropped[pid];
+			break;
+
+		case Z_MSG_TOPIC_UNSUBSCRIBE:
+			if (!subscribed) { rv = &z_fail; break; }
+			a->dropped = z_msg_topics[t].dropped[pid];
+			topic_leave(t, pid);
+			break;
+
+		case Z_MSG_TOPIC_STATUS:
+			if (!subscribed) { rv = &z_fail; break; }
+			a->dropped = z_msg_topics[t].dropped[pid];
+			break;
+
+		default:
+			rv = &z_fail;
+
+	}
+
+	maskirq(old_mask);
+	return rv;
+
+}
+
+// Z_SYS_MSG_PUBLISH -- args is a z_msg_publish_args_t (zmsg.h). One
+// copy-sent envelope per subscriber of msg->subject, each subject to
+// that subscriber's depth; a subscriber that's full gets nothing and
+// its drop count goes up instead. A topic nobody's subscribed to is
+// a successful publish to no one. Z_FAIL only for a payload too big
+// to ever copy.
+z_obj_t *k_msg_publish(z_obj_t *args) {
+
+	z_msg_publish_args_t *a = (z_msg_publish_args_t *)args;
+	if (!a || !a->msg) return (&z_fail);
+
+	z_msg_t *msg = a->msg;
+	uint32_t topic = msg->subject;
+	a->delivered = a->dropped = 0;
+
+	int t;
+	for (t = 0; t < Z_MSG_TOPICS_MAX; t++)
+		if (z_msg_topics[t].subs && z_msg_topics[t].id == topic) break;
+	if (t == Z_MSG_TOPICS_MAX) return (&z_ok);
+
+	uint32_t size = copy_size(&msg->obj, 0);
+	if (size >= Z_MSG_ARENA_SIZE) return (&z_fail);
+
+	volatile z_msg_topic_t *tp = &z_msg_topics[t];
+
+	for (uint32_t pid = 0; pid < Z_PROCS_MAX; pid++) {
+
+		uint32_t bit = 1u << pid;
+
+		// claim a place under this subscriber's depth first, so a
+		// pop racing with the push below can't push queued[] under
+		uint32_t old_mask = maskirq(0xFFFFFFFF);
+		if (!(tp->subs & bit) || tp->id != topic) {
+			maskirq(old_mask);
+			continue;
+		}
+		if (tp->queued[pid] >= tp->depth[pid]) {
+			tp->dropped[pid]++;
+			maskirq(old_mask);
+			a->dropped++;
+			continue;
+		}
+		tp->queued[pid]++;
+		maskirq(old_mask);
+
+		z_msg_envelope_t env;
+		env.to = pid;
+		env.from = z_pid;
+		env.subject = topic;
+		env.tag = msg->tag;
+		env.obj = msg->obj;
+		env.kbuf = 0;
+		env.topic = t + 1;
+
+		z_rv rv = size ? push_copy(pid, &env, size, false) : z_mailbox_push(pid, &env);
+
+		if (rv == Z_OK) {
+			a->delivered++;
+			continue;
+		}
+
+		// mailbox or arena full -- give the place back, count the drop
+		old_mask = maskirq(0xFFFFFFFF);
+		if ((tp->subs & bit) && tp->id == topic) {
+			if (tp->queued[pid]) tp->queued[pid]--;
+			tp->dropped[pid]++;
+		}
+		maskirq(old_mask);
+		a->dropped++;
+
+	}
+
 	return (&z_ok);
 
 }
 
+// finds the channel slot holding `pair` with the caller as one of its
+// ends, and which end. IRQs masked by the caller.
+static bool chan_find(const z_chan_pair_t *pair, uint32_t pid, uint32_t *c, uint32_t *e) {
+	if (!pair) return false;
+	for (uint32_t i = 0; i < Z_CHAN_MAX; i++) {
+		if (z_chans[i].pair != pair) continue;
+		for (uint32_t j = 0; j < 2; j++) {
+			if (z_chans[i].ends[j] == pid + 1) {
+				*c = i;
+				*e = j;
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+// Z_CHAN_WAIT's wakeup condition: the ring this pid writes into has
+// the room it asked for, or the channel is closed (or gone)
+static bool chan_room_ready(uint32_t pid) {
+	z_chan_slot_t *ch = &z_chans[z_chan_waits[pid].slot];
+	if (!ch->pair) return true;
+	uint32_t e = (ch->ends[0] == pid + 1) ? 0 : 1;
+	z_chan_t *tx = &ch->pair->ring[e];
+	return tx->closed || z_chan_room(tx) >= z_chan_waits[pid].need;
+}
+
+// Z_SYS_CHAN -- args is a z_chan_args_t (zchan.h). The data itself
+// never comes through here: the two ends move bytes through the rings
+// on their own, and only come to the kernel to set a channel up, tear
+// it down, or sleep and wake.
+z_obj_t *k_chan(z_obj_t *args) {
+
+	z_chan_args_t *a = (z_chan_args_t *)args;
+	if (!a) return (&z_fail);
+
+	uint32_t pid = z_pid;
+	uint32_t c, e;
+	uint32_t old_mask;
+
+	switch (a->op) {
+
+		case Z_CHAN_OPEN: {
+
+			a->pair = NULL;
+			if (a->peer >= Z_PROCS_MAX || a->peer == pid ||
+				z_procs[a->peer].base == 0) return (&z_fail);
+
+			old_mask = maskirq(0xFFFFFFFF);
+			for (c = 0; c < Z_CHAN_MAX && z_chans[c].pair; c++);
+			z_chan_pair_t *pair = (c < Z_CHAN_MAX) ?
+				(z_chan_pair_t *)k_imgcache_alloc(sizeof(z_chan_pair_t)) : NULL;
+			if (!pair) {
+				maskirq(old_mask);
+				return (&z_fail);
+			}
+			for (int r = 0; r < 2; r++) {
+				z_chan_t *ring = &pair->ring[r];
+				ring->magic = Z_CHAN_MAGIC;
+				ring->size = Z_CHAN_RING_SIZE;
+				ring->head = ring->tail = 0;
+				ring->notified = ring->writer_waiting = ring->closed = 0;
+			}
+			z_chans[c].pair = pair;
+			z_chans[c].ends[0] = pid + 1;
+			z_chans[c].ends[1] = a->peer + 1;
+			maskirq(old_mask);
+
+			// a physical address -- what k_imgcache_alloc() returns is
+			// already reachable from any process as-is
+			a->pair = pair;
+			return (&z_ok);
+
+		}
+
+		case Z_CHAN_WAIT:
+
+			// pid 0 can't sleep -- the shell doesn't use channels
+			if (pid == 0) return (&z_fail);
+
+			old_mask = maskirq(0xFFFFFFFF);
+			if (!chan_find(a->pair, pid, &c, &e)) {
+				maskirq(old_mask);
+				return (&z_fail);
+			}
+			z_chan_waits[pid].slot = c;
+			z_chan_waits[pid].need = (a->need > Z_CHAN_RING_SIZE) ?
+				Z_CHAN_RING_SIZE : a->need;
+			maskirq(old_mask);
+
+			// k_proc_wake() is unconditional -- the reader wakes us
+			// after every span it consumes, and a message arriving
+			// wakes us too -- so a wakeup doesn't mean there's `need`
+			// yet. Back to sleep until there is, the channel's gone,
+			// or the whole timeout (not just one sleep's) is up.
+			uint32_t start = z_kernel_ticks;
+			for (;;) {
+				uint32_t left = 0;
+				if (a->timeout) {
+					uint32_t spent = z_kernel_ticks - start;
+					if (spent >= a->timeout) break;
+					left = a->timeout - spent;
+				}
+				if (k_proc_block(chan_room_ready, left)) break;
+			}
+
+			old_mask = maskirq(0xFFFFFFFF);
+			bool ok = z_chans[c].pair == a->pair &&
+				!a->pair->ring[e].closed &&
+				z_chan_room(&a->pair->ring[e]) >= z_chan_waits[pid].need;
+			maskirq(old_mask);
+			return ok ? (&z_ok) : (&z_fail);
+
+		case Z_CHAN_WAKE:
+
+			old_mask = maskirq(0xFFFFFFFF);
+			if (!chan_find(a->pair, pid, &c, &e)) {
+				maskirq(old_mask);
+				return (&z_fail);
+			}
+			if (z_chans[c].ends[e ^ 1])
+				k_proc_wake(z_chans[c].ends[e ^ 1] - 1);
+			maskirq(old_mask);
+			return (&z_ok);
+
+		case Z_CHAN_CLOSE:
+
+			old_mask = maskirq(0xFFFFFFFF);
+			if (!chan_find(a->pair, pid, &c, &e)) {
+				maskirq(old_mask);
+				return (&z_fail);
+			}
+			chan_drop(c, e);
+			maskirq(old_mask);
+			return (&z_ok);
+
+	}
+
+	return (&z_fail);
+
+}
+
 // -- kernel-side message API for sh.c -- see msg.h for why this
 // exists separately from zeitlos.c's app-facing wrappers --
 
@@ -299,10 +1420,58 @@ z_rv z_msg_wait(z_msg_t *msg, uint32_t subject, uint32_t tag) {
 			if (msg->subject == subject && msg->tag == tag)
 				return Z_OK;
 			// not the message we're waiting for -- discard and keep going
+			z_msg_release(msg);
 		}
 	}
 }
 
+z_rv z_msg_send_copy(z_msg_t *msg) {
+	z_obj_t *rv = k_msg_send_copy((z_obj_t *)msg);
+	return rv->val.uint32;
+}
+
+z_rv z_msg_release(z_msg_t *msg) {
+	z_obj_t *rv = k_msg_release((z_obj_t *)msg);
+	return rv->val.uint32;
+}
+
+z_rv z_msg_block(uint32_t timeout_ticks) {
+	z_obj_t obj;
+	obj.type = Z_UINT32;
+	obj.val.uint32 = timeout_ticks;
+	z_obj_t *rv = k_msg_block(&obj);
+	return rv->val.uint32;
+}
+
+z_rv z_msg_send_copy_wait(z_msg_t *msg, uint32_t timeout_ticks) {
+	z_msg_send_wait_args_t args;
+	args.msg = msg;
+	args.timeout = timeout_ticks;
+	args.copy = 1;
+	z_obj_t *rv = k_msg_send_wait((z_obj_t *)&args);
+	return rv->val.uint32;
+}
+
+z_rv z_msg_publish(uint32_t topic, uint32_t tag, z_obj_t obj) {
+	z_msg_t msg;
+	msg.to = 0;
+	msg.subject = topic;
+	msg.tag = tag;
+	msg.obj = obj;
+	z_msg_publish_args_t args;
+	args.msg = &msg;
+	z_obj_t *rv = k_msg_publish((z_obj_t *)&args);
+	return rv->val.uint32;
+}
+
+z_rv z_msg_call(z_msg_t *msg, uint32_t timeout_ticks) {
+	z_msg_call_args_t args;
+	args.msg = msg;
+	args.timeout = timeout_ticks;
+	z_obj_t *rv = k_msg_call((z_obj_t *)&args);
+	return rv->val.uint32;
+}
+
 z_rv z_msg_new_send(uint32_t to, uint32_t subject, uint32_t tag, z_obj_t obj) {
 	z_msg_t msg;
 	msg.to = to;
@@ -319,6 +1488,7 @@ z_rv z_msg_wait_timeout(z_msg_t *msg, uint32_t subject, uint32_t tag, uint32_t t
 			if (msg->subject == subject && msg->tag == tag)
 				return Z_OK;
 			// not the message we're waiting for -- discard and keep going
+			z_msg_release(msg);
 		}
 	}
 	return Z_FAIL;
@@ -3,12 +3,63 @@
 
 #include "kernel.h"
 
+// -- pointer resolution --
+
+// convert a pointer that was created by process `pid` (i.e. it's
+// expressed relative to that process's 0x8000_0000 mirror) into the
+// physical address it actually refers to. the result is always below
+// the mirror window, so it's dereferenceable directly, from any
+// process's context, without going through the MTU.
+//
+// pid 0 (the kernel, including sh.c acting as pid 0) is a special
+// case: it never runs through the 0x8000_0000 mirror at all -- it
+// executes at, and allocates from, its own native/physical address
+// space directly. applying the mirror-subtraction formula to a
+// pointer that was never mirrored in the first place produces a wild,
+// garbage address (a large unsigned underflow, since such a pointer
+// is nowhere near 0x8000_0000) -- this was a real, crash-causing bug,
+// only ever exercised once something first sent a message *from* the
+// kernel to a regular process (previously, every message was
+// app-to-app or app-to-wm; sh.c's tget/tput were the first
+// kernel-to-app case).
+static inline void *z_translate(uint32_t pid, void *vptr) {
+	if (!vptr) return NULL;
+	if (pid == 0) return vptr;
+	return (void *)((uint32_t)vptr - 0x80000000 + z_procs[pid].base);
+}
+
 // -- mailbox primitives -- only the kernel calls these --
 
 z_rv z_mailbox_is_empty(uint32_t pid);
 z_rv z_mailbox_is_full(uint32_t pid);
 z_rv z_mailbox_push(uint32_t pid, z_msg_envelope_t *msg);
 z_rv z_mailbox_pop(uint32_t pid, z_msg_envelope_t *msg);
+// for kernel-generated Z_UINT32 messages that supersede each other
+// (hid.c's mouse motion): replaces the newest queued envelope instead
+// of adding one when it's from the same sender, has the same subject,
+// and matches msg's payload on keep_mask (bits that must not be
+// merged away -- e.g. mouse buttons). Safe from interrupt handlers.
+z_rv z_mailbox_push_merge(uint32_t pid, z_msg_envelope_t *msg, uint32_t keep_mask);
+
+// empties every mailbox and copy-send arena -- called once from
+// kernel.c's main(), same not-reliably-zero-.bss reason as
+// k_pidreg_init()
+void k_msg_init(void);
+// drops pid's queued messages, frees its copy-send arena, ends its
+// topic subscriptions and closes its end of any channel, so a later
+// process in the same slot starts with an empty mailbox and hears
+// about nothing it didn't subscribe to -- from the scheduler's reap
+// path, same as k_pidreg_release_all()
+void k_msg_release_all(uint32_t pid);
+// true while another process is copying a message into pid's arena
+// -- the scheduler holds off reaping pid (and freeing its memory)
+// until it's done
+bool k_msg_busy(uint32_t pid);
+// gives pid's mailbox a ring of `depth` envelopes (0 = Z_MAILBOX_DEPTH)
+// from the shared pool -- or less, down to Z_MAILBOX_DEPTH_SMALL, if
+// that's all there's room for (zmsg.h). From k_proc_create(); Z_FAIL
+// only if even the smallest won't fit.
+z_rv k_msg_mailbox_create(uint32_t pid, uint32_t depth);
 
 // -- syscall handlers, registered in syscalls.def --
 //
@@ -19,6 +70,20 @@ z_rv z_mailbox_pop(uint32_t pid, z_msg_envelope_t *msg);
 
 z_obj_t *k_msg_send(z_obj_t *args);
 z_obj_t *k_msg_read(z_obj_t *args);
+z_obj_t *k_msg_block(z_obj_t *args);
+z_obj_t *k_msg_send_copy(z_obj_t *args);
+z_obj_t *k_msg_release(z_obj_t *args);
+z_obj_t *k_msg_call(z_obj_t *args);
+z_obj_t *k_msg_read_n(z_obj_t *args);
+z_obj_t *k_msg_send_n(z_obj_t *args);
+z_obj_t *k_msg_subscribe(z_obj_t *args);
+z_obj_t *k_msg_publish(z_obj_t *args);
+z_obj_t *k_msg_send_wait(z_obj_t *args);
+z_obj_t *k_msg_stats(z_obj_t *args);
+z_obj_t *k_chan(z_obj_t *args);
+
+// fastcalls.def -- register-based k_msg_read(), see msg.c
+uint32_t k_fast_msg_read(uint32_t a1, uint32_t a2, uint32_t a3);
 
 // -- for sh.c (pid 0, i.e. the kernel itself acting as a process) --
 //
@@ -36,6 +101,17 @@ z_rv z_msg_send(z_msg_t *msg);
 z_rv z_msg_read(z_msg_t *msg);
 z_rv z_msg_wait(z_msg_t *msg, uint32_t subject, uint32_t tag);
 z_rv z_msg_new_send(uint32_t to, uint32_t subject, uint32_t tag, z_obj_t obj);
+z_rv z_msg_send_copy(z_msg_t *msg);
+z_rv z_msg_release(z_msg_t *msg);
+z_rv z_msg_call(z_msg_t *msg, uint32_t timeout_ticks);
+// sleeping instead of polling, for kernel code running on behalf of
+// an app inside a syscall (fsapi.c's splice) -- as in k_msg_block()/
+// k_msg_send_wait(), pid 0 still just polls
+z_rv z_msg_block(uint32_t timeout_ticks);
+z_rv z_msg_send_copy_wait(z_msg_t *msg, uint32_t timeout_ticks);
+// the kernel itself publishing (e.g. on a filesystem change) -- the
+// shell has no use for subscribing, so only this half is here
+z_rv z_msg_publish(uint32_t topic, uint32_t tag, z_obj_t obj);
 
 // same as z_msg_wait(), but gives up (returning Z_FAIL) after
 // timeout_ticks with no matching message, instead of waiting forever.
@@ -18,8 +18,13 @@
 #include "mem.h"
 #include "fs/fs.h"
 #include "fs/fatfs/ff.h"
+#include "fsapi.h"
 #include "msg.h"
 #include "pidreg.h"
+#include "imgcache.h"
+#include "fmap.h"
+#include "fs/diskcache.h"
+#include "klog.h"
 
 // --
 
@@ -189,7 +194,10 @@ void sh(void) {
 			fs_unlink(arg);
 
 			uint32_t bytes_received, bytes_written;
-			void *tmp = k_mem_alloc(1024*256); // 256K max file size for now
+			// k_imgcache_alloc() -- 256K is more than a freshly booted
+			// pool has to spare once a few cached app images
+			// (imgcache.h) are sitting in it
+			void *tmp = k_imgcache_alloc(1024*256); // 256K max file size for now
 			uint32_t addr = (uint32_t)(uintptr_t)tmp;
 			printf("uploading to file %s.\n", arg);
 			printf("xfer addr 0x%lx; ready to receive (press D to cancel) ...\n",
@@ -231,15 +239,21 @@ void sh(void) {
 			printf("tget: requesting %s from %s ...\n", remote, ip_str);
 			fflush(stdout);
 
-			z_obj_t req = z_obj_map(2);
-			z_map_set(&req, "ip", z_obj_uint32(ip));
-			z_map_set(&req, "filename", z_obj_str(remote));
-			// note: `req` intentionally never freed -- one-shot
-			// request, same borrowed-payload reasoning used
-			// throughout (see docs/messaging.md)
-
+			// built on the stack (z_arena_t, zobj.h) -- net is done
+			// reading it once it has answered the open below, and
+			// we don't leave this block before then
+			void *req_buf[32];
+			z_arena_t req_arena;
+			z_arena_init(&req_arena, req_buf, sizeof(req_buf));
+			z_obj_t req = z_arena_map(&req_arena, 2);
+			z_arena_map_set(&req_arena, &req, "ip", z_obj_uint32(ip));
+			z_arena_map_set(&req_arena, &req, "filename", z_arena_str(&req_arena, remote));
+
+			// with a window, net sends each block on as soon as it
+			// has it, rather than waiting for our next pull
 			zstream_consumer_t cons;
-			if (!zstream_open(&cons, resolve_net_pid(), req, err, sizeof(err))) {
+			if (!zstream_open_window(&cons, resolve_net_pid(), req,
+				ZSTREAM_WINDOW_DEFAULT, err, sizeof(err))) {
 				printf("tget: failed to open: %s\n", err);
 				continue;
 			}
@@ -251,33 +265,12 @@ void sh(void) {
 				continue;
 			}
 
+			// the rest is pulled and written to `f` as it comes,
+			// straight from net's blobs (fs_splice_in(), fsapi.h)
 			uint32_t total = 0;
-			bool ok = true;
-
-			while (1) {
-
-				const uint8_t *data;
-				uint32_t len;
-				zstream_result_t r = zstream_pull(&cons, &data, &len, err, sizeof(err));
-
-				if (r == ZSTREAM_EOF) break;
-
-				if (r == ZSTREAM_ERROR) {
-					printf("tget: failed: %s\n", err);
-					ok = false;
-					break;
-				}
-
-				if (fs_write_chunk(&f, data, len) != (int)len) {
-					printf("tget: write failed\n");
-					zstream_abort(&cons);
-					ok = false;
-					break;
-				}
-
-				total += len;
-
-			}
+			bool ok = fs_splice_in(&f, &cons, TFTP_REPLY_TIMEOUT_TICKS,
+				&total, err, sizeof(err));
+			if (!ok) printf("tget: failed: %s\n", err);
 
 			fs_close_write(&f);
 
@@ -317,14 +310,16 @@ void sh(void) {
 				continue;
 			}
 
+			// on the stack, as in tget above -- net has read it by
+			// the time it opens its stream back to us
 			uint32_t tag = next_tftp_tag();
-			z_obj_t req = z_obj_map(2);
-			z_map_set(&req, "ip", z_obj_uint32(ip));
-			z_map_set(&req, "filename", z_obj_str(remote));
+			void *req_buf[32];
+			z_arena_t req_arena;
+			z_arena_init(&req_arena, req_buf, sizeof(req_buf));
+			z_obj_t req = z_arena_map(&req_arena, 2);
+			z_arena_map_set(&req_arena, &req, "ip", z_obj_uint32(ip));
+			z_arena_map_set(&req_arena, &req, "filename", z_arena_str(&req_arena, remote));
 			z_msg_new_send(resolve_net_pid(), Z_NET_TFTP_PUT, tag, req);
-			// note: `req` intentionally never freed -- same
-			// borrowed-payload reasoning as tget above; one-shot
-			// per tput call.
 
 			printf("tput: sending %s (%ld bytes) to %s ...\n", local, (long)size, ip_str);
 			fflush(stdout);
@@ -333,54 +328,31 @@ void sh(void) {
 			// open a stream back to us (pid 0) to pull this file's
 			// bytes. we have nothing else to do while this runs, so
 			// a simple blocking loop is fine here, same reasoning as
-			// z_msg_wait_timeout()'s own use below.
+			// z_msg_wait_timeout()'s own use below. Once it's open,
+			// fs_splice_out() (fsapi.h) answers the pulls.
 			zstream_producer_t prod;
 			bool have_stream = false;
-			bool producer_ok = true;
-			uint8_t chunk[ZSTREAM_CHUNK_SIZE_DEFAULT];
+			bool producer_ok = false;
 			uint32_t start = z_uptime_ticks();
 
 			while (z_uptime_ticks() - start < TFTP_REPLY_TIMEOUT_TICKS) {
-
 				z_msg_t msg;
 				if (z_msg_read(&msg) != Z_OK) continue;
-
-				if (!have_stream) {
-					if (msg.subject != Z_STREAM_OPEN) continue;	// discard anything else while waiting to start
-					zstream_accept(&prod, msg.from, msg.tag);
-					have_stream = true;
-					start = z_uptime_ticks();
-					continue;
-				}
-
-				if (msg.subject == Z_STREAM_ABORT) {
-					producer_ok = false;
-					break;
-				}
-
-				if (msg.subject != Z_STREAM_PULL) continue;
-
-				if (zstream_producer_handle(&prod, &msg) != ZSTREAM_EVENT_PULL)
-					continue;	// stale/retry pull, already handled internally
-
-				int32_t n = fs_read_chunk(&f, chunk, sizeof(chunk));
-
-				if (n < 0) {
-					zstream_send_error(&prod, "local read failed");
-					producer_ok = false;
-					break;
-				}
-
-				if (n == 0) {
-					zstream_send_eof(&prod);
-					break;	// our part is done -- net finishes talking to the server on its own
-				}
-
-				zstream_send_chunk(&prod, chunk, (uint32_t)n);
-				start = z_uptime_ticks();
-
+				if (msg.subject != Z_STREAM_OPEN) continue;	// discard anything else while waiting to start
+				zstream_accept(&prod, msg.from, msg.tag);
+				have_stream = true;
+				break;
 			}
 
+			// lent to net a chunk at a time -- the last one until its
+			// reply below, so it lives out here
+			z_fs_splice_chunk_t chunk;
+			uint32_t sent = 0;
+			char send_err[64];
+			if (have_stream)
+				producer_ok = fs_splice_out(&f, NULL, &prod, &chunk, TFTP_REPLY_TIMEOUT_TICKS,
+					&sent, send_err, sizeof(send_err));
+
 			fs_close_read(&f);
 
 			if (!have_stream) {
@@ -390,7 +362,7 @@ void sh(void) {
 			}
 
 			if (!producer_ok) {
-				printf("tput: failed sending local data\n");
+				printf("tput: failed sending local data: %s\n", send_err);
 				continue;
 			}
 
@@ -409,13 +381,14 @@ void sh(void) {
 				printf("tput: failed: %s\n",
 					(err && err->type == Z_STR) ? err->val.str : "unknown error");
 			}
+			z_msg_release(&reply);	// net copy-sends its replies
 
 		}
 
 		// CREATE A PROCESS
 		else if (!strncmp(buffer, "run", cmdlen)) {
 			arg = get_arg(buffer, 1);
-			uint32_t size = fs_size(arg);
+			uint32_t size = k_imgcache_size(arg);
 			if (!size) {
 				printf("file not found/empty\n");
 				continue;
@@ -428,7 +401,8 @@ void sh(void) {
 			// zport.h leak, plus repl's own Scheme stdlib loading --
 			// see zport.c's own z_port_send() comment).
 			uint32_t stack_size = z_proc_stack_size_for(arg);
-			uint32_t pid = k_proc_create(size, stack_size);
+			uint32_t pid = k_proc_create(size, stack_size,
+				z_proc_mailbox_depth_for(arg));
 			printf(" - pid: %ld\n", pid);
 			if (!pid) {
 				printf("unable to create process\n");
@@ -438,7 +412,7 @@ void sh(void) {
 			uint32_t base = k_proc_base(pid);
 			printf(" - base: %lx\n", base);
 			printf(" - loading file\n");
-			fs_load(base, arg);
+			k_imgcache_load(base, arg);
 			printf(" - starting process\n");
 			k_proc_start(pid);
 
@@ -494,6 +468,31 @@ void sh(void) {
 			k_mem_dump();
 		}
 
+		// DISPLAY APP IMAGE CACHE (imgcache.h) -- which binaries a
+		// `run` would currently copy out of RAM instead of reading off
+		// the SD card, and how much of what `free` shows is really
+		// just cached images it'll give back on demand.
+		else if (!strncmp(buffer, "ic", cmdlen)) {
+			k_imgcache_dump();
+		}
+
+		// DISPLAY SHARED FILE MAPPINGS (fmap.h) -- which files are
+		// loaded once for several processes, and who's holding them
+		else if (!strncmp(buffer, "fm", cmdlen)) {
+			k_fmap_dump();
+		}
+
+		// DISPLAY THE SECTOR CACHE (fs/diskcache.h)
+		else if (!strncmp(buffer, "dc", cmdlen)) {
+			k_diskcache_dump();
+		}
+
+		// DISPLAY THE KERNEL LOG RING (klog.h) -- everything still in
+		// it, including K_LOG_DEBUG entries the console doesn't echo
+		else if (!strncmp(buffer, "dmesg", cmdlen)) {
+			k_klog_dump();
+		}
+
 	}
 
 }
@@ -513,18 +512,19 @@ void init(void) {
 	// wm:
 
 	printf("starting wm\n");
-	uint32_t size_wm = fs_size("wm");
+	uint32_t size_wm = k_imgcache_size("wm");
 	if (!size_wm) {
 		printf("init: wm binary not found\n");
 		return;
 	}
-	uint32_t pid_wm = k_proc_create(size_wm, z_proc_stack_size_for("wm"));
+	uint32_t pid_wm = k_proc_create(size_wm, z_proc_stack_size_for("wm"),
+		z_proc_mailbox_depth_for("wm"));
 	if (!pid_wm) {
 		printf("init: unable to create wm process\n");
 		return;
 	}
 	uint32_t base_wm = k_proc_base(pid_wm);
-	fs_load(base_wm, "wm");
+	k_imgcache_load(base_wm, "wm");
 	k_proc_start(pid_wm);
 	printf("init: wm started as pid %ld\n", pid_wm);
 
@@ -548,16 +548,17 @@ void init(void) {
 	// rest of this script, unlike wm's.
 
 	printf("starting net\n");
-	uint32_t size_net = fs_size("net");
+	uint32_t size_net = k_imgcache_size("net");
 	if (!size_net) {
 		printf("init: net binary not found (non-fatal)\n");
 	} else {
-		uint32_t pid_net = k_proc_create(size_net, z_proc_stack_size_for("net"));
+		uint32_t pid_net = k_proc_create(size_net, z_proc_stack_size_for("net"),
+			z_proc_mailbox_depth_for("net"));
 		if (!pid_net) {
 			printf("init: unable to create net process (non-fatal)\n");
 		} else {
 			uint32_t base_net = k_proc_base(pid_net);
-			fs_load(base_net, "net");
+			k_imgcache_load(base_net, "net");
 			k_proc_start(pid_net);
 			printf("init: net started as pid %ld\n", pid_net);
 		}
@@ -581,19 +582,20 @@ void init(void) {
 	// for testing the port protocol in isolation from repl.
 
 	printf("starting repl\n");
-	uint32_t size_repl = fs_size("repl");
+	uint32_t size_repl = k_imgcache_size("repl");
 	if (!size_repl) {
 		printf("init: repl binary not found (non-fatal -- term will "
 			"fall back to local echo)\n");
 		return;
 	}
-	uint32_t pid_repl = k_proc_create(size_repl, z_proc_stack_size_for("repl"));
+	uint32_t pid_repl = k_proc_create(size_repl, z_proc_stack_size_for("repl"),
+		z_proc_mailbox_depth_for("repl"));
 	if (!pid_repl) {
 		printf("init: unable to create repl process (non-fatal)\n");
 		return;
 	}
 	uint32_t base_repl = k_proc_base(pid_repl);
-	fs_load(base_repl, "repl");
+	k_imgcache_load(base_repl, "repl");
 	k_proc_start(pid_repl);
 	printf("init: repl started as pid %ld\n", pid_repl);
 
@@ -699,6 +701,10 @@ void sh_help(void) {
 	printf(" ps                display a process snapshot\n");
 	printf(" pr                display the pid name registry\n");
 	printf(" ks                display a kernel snapshot\n");
+	printf(" ic                display the app image cache\n");
+	printf(" fm                display shared file mappings\n");
+	printf(" dc                display the disk sector cache\n");
+	printf(" dmesg             display the kernel log\n");
 	printf(" cls               clear framebuffer\n");
 	printf(" ls [path]         display list of files\n");
 	printf(" mkdir [path]      make a directory\n");
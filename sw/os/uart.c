@@ -13,13 +13,19 @@
 #include "../common/zeitlos.h"
 #include "kernel.h"
 #include "uart.h"
+#include "klog.h"
 
 #define UART_FIFO_SIZE 512
 
 volatile uint8_t __attribute__((section(".bss"))) uart_rx_fifo[UART_FIFO_SIZE];
 volatile uint8_t __attribute__((section(".bss"))) uart_tx_fifo[UART_FIFO_SIZE];
-volatile uint8_t __attribute__((section(".bss"))) rx_head = 0, rx_tail = 0;
-volatile uint8_t __attribute__((section(".bss"))) tx_head = 0, tx_tail = 0;
+// uint16_t, not uint8_t -- with UART_FIFO_SIZE 512 an 8-bit index
+// silently wrapped at 256 (the `% UART_FIFO_SIZE` never got a chance
+// to), so both FIFOs were only ever half used. Harmless while every
+// write was one byte per syscall; not once k_uart_write() started
+// filling the TX side in bulk.
+volatile uint16_t __attribute__((section(".bss"))) rx_head = 0, rx_tail = 0;
+volatile uint16_t __attribute__((section(".bss"))) tx_head = 0, tx_tail = 0;
 
 uint16_t leds = 0x00;
 
@@ -46,6 +52,23 @@ void uart_irq_disable(void) {
 
 uint32_t ints = 0;
 
+// next byte for the transmitter, IRQs masked (or in the IRQ itself):
+// the TX FIFO first, then the kernel log -- except that a log line
+// already part-way out is finished first, so ordinary output can only
+// land between log lines, never inside one. -1 if there's nothing.
+static int uart_tx_next(void) {
+	if (!k_klog_console_busy() && tx_head != tx_tail) {
+		uint8_t c = uart_tx_fifo[tx_tail];
+		tx_tail = (tx_tail + 1) % UART_FIFO_SIZE;
+		return c;
+	}
+	int c = k_klog_console_getc();
+	if (c >= 0 || tx_head == tx_tail) return c;
+	uint8_t f = uart_tx_fifo[tx_tail];
+	tx_tail = (tx_tail + 1) % UART_FIFO_SIZE;
+	return f;
+}
+
 void z_uart_irq(void) {
 
 	uint8_t iir = reg_uart0_iir;
@@ -67,20 +90,17 @@ void z_uart_irq(void) {
 		switch (int_id) {
 
 			case 0x01: // Transmit Holding Register Empty (THRE)
-				if (tx_head == tx_tail) {
-					// nothing to send; disable THRE interrupt
-					reg_uart0_ier = 0x01;
-				} else {
-					// drain TX FIFO
-					while ((reg_uart0_lsr & 0x20) && (tx_head != tx_tail)) {
-						reg_uart0_data = uart_tx_fifo[tx_tail];
-						tx_tail = (tx_tail + 1) % UART_FIFO_SIZE;
-					}
+				// drain TX FIFO, then the kernel log (klog.h)
+				while (reg_uart0_lsr & 0x20) {
+					int c = uart_tx_next();
+					if (c < 0) break;
+					reg_uart0_data = (uint8_t)c;
+				}
 
-					// check again in case we just finished
-					if (tx_head == tx_tail) {
-						reg_uart0_ier = 0x01;
-					}
+				// nothing went out -- nothing left to send; disable
+				// THRE interrupt
+				if (reg_uart0_lsr & 0x20) {
+					reg_uart0_ier = 0x01;
 				}
 				break;
 
@@ -90,7 +110,7 @@ void z_uart_irq(void) {
 				while (reg_uart0_lsr & 0x01) {  // data Ready
 
 					uint8_t c = reg_uart0_data; // reading data clears error state
-					uint8_t next = (rx_head + 1) % UART_FIFO_SIZE;
+					uint16_t next = (rx_head + 1) % UART_FIFO_SIZE;
 					if (next != rx_tail) {  // RX FIFO not full
 						uart_rx_fifo[rx_head] = c;
 						rx_head = next;
@@ -169,6 +189,34 @@ int16_t k_uart_getc(void) {
 
 }
 
+// caller holds maskirq(). The THRE interrupt only fires on the
+// holding register's transition to empty, so if the UART is already
+// idle, nothing would ever start draining what was just queued --
+// hand it the first byte directly, then make sure THRE is enabled for
+// the rest (and whenever a byte is still in flight, so the kernel log
+// gets its turn once that one's out, see uart_tx_next()).
+static void uart_tx_start(void) {
+
+	if (reg_uart0_lsr & 0x20) {
+		// UART is ready — send directly
+		int c = uart_tx_next();
+		if (c >= 0) reg_uart0_data = (uint8_t)c;
+	}
+
+	if (!(reg_uart0_lsr & 0x20) || tx_head != tx_tail) {
+		reg_uart0_ier = 0b00000011; // Enable TX and RX
+	}
+
+}
+
+// see klog.h -- the log's own writers call this after publishing an
+// entry, in case the UART had nothing else to do.
+void k_uart_tx_kick(void) {
+	uint32_t old_mask = maskirq(0xFFFFFFFF);
+	uart_tx_start();
+	maskirq(old_mask);
+}
+
 void k_uart_putc(char c) {
 
 	// mask ALL irqs (not just the uart one) so a scheduler swap can't
@@ -189,7 +237,7 @@ void k_uart_putc(char c) {
 	// while sh.c's own unrelated code kept working).
 	uint32_t old_mask = maskirq(0xFFFFFFFF);
 
-	uint8_t next = (tx_head + 1) % UART_FIFO_SIZE;
+	uint16_t next = (tx_head + 1) % UART_FIFO_SIZE;
 
 	if (next == tx_tail) {
 		maskirq(old_mask);
@@ -197,22 +245,48 @@ void k_uart_putc(char c) {
 		return;  // Or return error code
 	}
 
-	bool fifo_was_empty = (tx_head == tx_tail);
-
 	uart_tx_fifo[tx_head] = c;
 	tx_head = next;
 
-	if (fifo_was_empty && (reg_uart0_lsr & 0x20)) {
-		// FIFO was empty and UART is ready — send directly
-		reg_uart0_data = uart_tx_fifo[tx_tail];
-		tx_tail = (tx_tail + 1) % UART_FIFO_SIZE;
-	}
+	uart_tx_start();
+
+	maskirq(old_mask);
+
+}
+
+// bulk version of k_uart_putc() -- Z_SYS_UART_WRITE. copies as much
+// of `buf` into uart_tx_fifo as fits in one masked pass (same
+// protection as k_uart_putc(), same reason), then, only if the FIFO
+// filled up before `buf` ran out, waits with IRQs enabled for the
+// THRE interrupt (z_uart_irq() above) to drain some of it and goes
+// again. Raw bytes -- no LF->CRLF here, that's still _write()'s job
+// (zeitlos.c/kruntime.c). Returns len. Never call with IRQs masked:
+// the wait would never end.
+uint32_t k_uart_write(const uint8_t *buf, uint32_t len) {
+
+	uint32_t done = 0;
+
+	while (done < len) {
+
+		uint32_t old_mask = maskirq(0xFFFFFFFF);
+
+		while (done < len) {
+			uint16_t next = (tx_head + 1) % UART_FIFO_SIZE;
+			if (next == tx_tail) break;
+			uart_tx_fifo[tx_head] = buf[done++];
+			tx_head = next;
+		}
+
+		uart_tx_start();
+
+		maskirq(old_mask);
+
+		if (done < len)
+			while (k_uart_tx_full()) /* TX interrupt drains it */;
 
-	if (tx_head != tx_tail) {
-		reg_uart0_ier = 0b00000011; // Enable TX and RX
 	}
 
-	maskirq(old_mask);
+	return len;
 
 }
 
@@ -238,3 +312,43 @@ z_obj_t *z_uart_putc(z_obj_t *obj) {
 	k_uart_putc(c);
 	return (&z_ok);
 }
+
+// see z_uart_write_args_t in zeitlos.h -- written is 0 on failure,
+// which is also what an older kernel without this syscall leaves it
+// at, so zeitlos.c's uart_write() can tell the two apart from
+// success without looking at the returned z_ok/z_fail object.
+z_obj_t *z_uart_write(z_obj_t *obj) {
+	z_uart_write_args_t *a = (z_uart_write_args_t *)obj;
+	if (!a || (!a->buf && a->len)) {
+		if (a) a->written = 0;
+		return (&z_fail);
+	}
+	a->written = k_uart_write(a->buf, a->len);
+	return (&z_ok);
+}
+
+// fastcalls.def versions of z_uart_getc()/_putc()/_rx_empty()/
+// _tx_full()/_write() above -- same results, straight in a0 instead
+// of via the argument object.
+
+uint32_t k_fast_uart_rx_empty(uint32_t a1, uint32_t a2, uint32_t a3) {
+	return k_uart_rx_empty();
+}
+
+uint32_t k_fast_uart_tx_full(uint32_t a1, uint32_t a2, uint32_t a3) {
+	return k_uart_tx_full();
+}
+
+uint32_t k_fast_uart_getc(uint32_t a1, uint32_t a2, uint32_t a3) {
+	return (uint32_t)(int32_t)k_uart_getc();
+}
+
+uint32_t k_fast_uart_putc(uint32_t a1, uint32_t a2, uint32_t a3) {
+	k_uart_putc((char)a1);
+	return Z_OK;
+}
+
+// a1 = buf, a2 = len; returns bytes written
+uint32_t k_fast_uart_write(uint32_t a1, uint32_t a2, uint32_t a3) {
+	return k_uart_write((const uint8_t *)(uintptr_t)a1, a2);
+}
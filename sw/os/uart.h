@@ -8,6 +8,8 @@ void k_uart_putc(char c);
 int16_t k_uart_getc(void);
 bool k_uart_rx_empty(void);
 bool k_uart_tx_full(void);
+uint32_t k_uart_write(const uint8_t *buf, uint32_t len);
+void k_uart_tx_kick(void);
 
 // --
 
@@ -15,5 +17,13 @@ z_obj_t *z_uart_getc(z_obj_t *obj);
 z_obj_t *z_uart_putc(z_obj_t *obj);
 z_obj_t *z_uart_rx_empty(z_obj_t *obj);
 z_obj_t *z_uart_tx_full(z_obj_t *obj);
+z_obj_t *z_uart_write(z_obj_t *obj);
+
+// fastcalls.def
+uint32_t k_fast_uart_getc(uint32_t a1, uint32_t a2, uint32_t a3);
+uint32_t k_fast_uart_putc(uint32_t a1, uint32_t a2, uint32_t a3);
+uint32_t k_fast_uart_rx_empty(uint32_t a1, uint32_t a2, uint32_t a3);
+uint32_t k_fast_uart_tx_full(uint32_t a1, uint32_t a2, uint32_t a3);
+uint32_t k_fast_uart_write(uint32_t a1, uint32_t a2, uint32_t a3);
 
 #endif
@@ -0,0 +1,314 @@
+/*
+ * Host-side microbenchmarks for the shared libraries in sw/common
+ * that sit on every hot path: zobj.c (every message payload), zvt100.c
+ * (every byte term draws) and zline.c (every keystroke a port
+ * provider line-edits).
+ *
+ * Built by `make bench` at -O2 -- NOT with the -O0 the functional
+ * tests use, since the point is how fast the code is, not how easy it
+ * is to step through -- and run on the host, so it says nothing about
+ * absolute PicoRV32 numbers. What it's for is relative: run it before
+ * and after a change to one of these files and compare.
+ *
+ * Each benchmark repeats its body, doubling the repeat count until one
+ * batch takes at least the minimum time (100ms, or the first argument
+ * in ms), and reports that batch. Results go to stdout as one JSON
+ * object, so a script can diff two runs; everything else goes to
+ * stderr.
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "zobj.h"
+#include "zvt100.h"
+#include "zline.h"
+
+static uint64_t min_ns = 100000000ull;
+static int results = 0;
+
+// keeps the compiler from deciding a benchmark's result is unused
+static volatile uint32_t sink;
+
+static uint64_t now_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// runs fn(ctx, n) with a doubling n until it takes at least min_ns,
+// then prints one result. One iteration of fn is `ops` operations
+// (ns_per_op is per operation); `bytes` is what one iteration
+// processes (0 if that isn't meaningful) -- it adds a throughput
+// figure.
+static void bench(const char *name, void (*fn)(void *ctx, uint32_t n),
+	void *ctx, uint32_t ops, uint32_t bytes) {
+
+	uint32_t n = 1;
+	uint64_t ns;
+
+	for (;;) {
+		uint64_t t0 = now_ns();
+		fn(ctx, n);
+		ns = now_ns() - t0;
+		if (ns >= min_ns || n >= 0x40000000u) break;
+		n *= 2;
+	}
+
+	double per_iter = (double)ns / n;
+	double per_op = per_iter / ops;
+
+	printf("%s\n    {\"name\": \"%s\", \"iterations\": %u, \"ops\": %llu, \"ns_per_op\": %.2f",
+		results++ ? "," : "", name, (unsigned)n, (unsigned long long)n * ops, per_op);
+	if (bytes)
+		printf(", \"bytes_per_iteration\": %u, \"mb_per_s\": %.2f",
+			(unsigned)bytes, bytes * 1000.0 / per_iter);
+	printf("}");
+
+	fprintf(stderr, "%-28s %12.2f ns/op\n", name, per_op);
+
+}
+
+// -- zobj --
+
+// a payload shaped like the bigger real ones (a window's create args,
+// a directory listing): a map holding scalars, strings, a blob, a list
+// of maps and a nested map
+static z_obj_t make_tree(void) {
+
+	z_obj_t root = z_obj_map(8);
+	z_map_set(&root, "op", z_obj_uint32(3));
+	z_map_set(&root, "x", z_obj_int32(-12));
+	z_map_set(&root, "scale", z_obj_float32(1.5f));
+	z_obj_t s = z_obj_str("a window title of ordinary length");
+	z_map_set(&root, "title", s);
+	z_obj_free(&s);
+
+	uint8_t bytes[64];
+	for (int i = 0; i < 64; i++) bytes[i] = (uint8_t)i;
+	z_obj_t blob = z_obj_blob(bytes, sizeof(bytes));
+	z_map_set(&root, "data", blob);
+	z_obj_free(&blob);
+
+	z_obj_t entries = z_obj_list(16);
+	z_obj_table_t *et = (z_obj_table_t *)entries.val.ptr;
+	char name[16];
+	for (int i = 0; i < 16; i++) {
+		z_obj_t e = z_obj_map(2);
+		snprintf(name, sizeof(name), "file%02d.txt", i);
+		z_obj_t n = z_obj_str(name);
+		z_map_set(&e, "name", n);
+		z_obj_free(&n);
+		z_map_set(&e, "size", z_obj_uint32(512u * i));
+		et->a[i] = e;
+	}
+	z_map_set(&root, "entries", entries);
+	z_obj_free(&entries);
+
+	z_obj_t rect = z_obj_map(4);
+	z_map_set(&rect, "x", z_obj_uint32(10));
+	z_map_set(&rect, "y", z_obj_uint32(20));
+	z_map_set(&rect, "w", z_obj_uint32(300));
+	z_map_set(&rect, "h", z_obj_uint32(200));
+	z_map_set(&root, "rect", rect);
+	z_obj_free(&rect);
+
+	return root;
+
+}
+
+static void bench_create_free(void *ctx, uint32_t n) {
+	(void)ctx;
+	for (uint32_t i = 0; i < n; i++) {
+		z_obj_t t = make_tree();
+		sink += z_obj_size(&t);
+		z_obj_free(&t);
+	}
+}
+
+static void bench_copy_free(void *ctx, uint32_t n) {
+	for (uint32_t i = 0; i < n; i++) {
+		z_obj_t c = z_obj_copy((z_obj_t *)ctx);
+		sink += z_obj_size(&c);
+		z_obj_free(&c);
+	}
+}
+
+typedef struct {
+	z_obj_t a, b;
+} pair_t;
+
+static void bench_equal(void *ctx, uint32_t n) {
+	pair_t *p = ctx;
+	for (uint32_t i = 0; i < n; i++) sink += z_obj_equal(&p->a, &p->b);
+}
+
+static void bench_flatten(void *ctx, uint32_t n) {
+	static uint8_t buf[8192] __attribute__((aligned(8)));
+	for (uint32_t i = 0; i < n; i++) {
+		sink += z_obj_flatten((z_obj_t *)ctx, buf, sizeof(buf));
+		// moves it each time, so unflatten really relocates
+		((z_obj_flat_t *)buf)->base = 0;
+		sink += z_obj_unflatten(buf, sizeof(buf)) != NULL;
+	}
+}
+
+#define MAP_KEYS_MAX 256
+
+typedef struct {
+	z_obj_t map;
+	uint32_t keys;
+	char names[MAP_KEYS_MAX][16];
+} lookup_t;
+
+static void lookup_init(lookup_t *l, uint32_t keys, int hashed) {
+	l->keys = keys;
+	l->map = hashed ? z_obj_hmap(keys) : z_obj_map(keys);
+	for (uint32_t i = 0; i < keys; i++) {
+		snprintf(l->names[i], sizeof(l->names[i]), "key_%u", (unsigned)i);
+		z_map_set(&l->map, l->names[i], z_obj_uint32(i));
+	}
+}
+
+// every key once per iteration (one op per key), so the linear map's
+// average -- and not just its best -- case is what gets measured
+static void bench_lookup(void *ctx, uint32_t n) {
+	lookup_t *l = ctx;
+	for (uint32_t i = 0; i < n; i++) {
+		for (uint32_t k = 0; k < l->keys; k++) {
+			z_obj_t *v = z_map_find(&l->map, l->names[k]);
+			sink += v ? v->val.uint32 : 0;
+		}
+	}
+}
+
+// -- zvt100 --
+
+// stands in for a recorded session: shell prompts, `ls`-style column
+// output, SGR reverse-video, absolute cursor moves and erases, a
+// full-screen redraw, and enough lines overall that the screen
+// scrolls -- the mix term actually sees over telnet
+static uint32_t make_traffic(uint8_t *buf, uint32_t cap) {
+
+	uint32_t len = 0;
+	char line[160];
+	int n;
+
+#define EMIT(...) do { \
+		n = snprintf(line, sizeof(line), __VA_ARGS__); \
+		if (n < 0 || len + (uint32_t)n > cap) return len; \
+		memcpy(buf + len, line, (uint32_t)n); \
+		len += (uint32_t)n; \
+	} while (0)
+
+	for (int round = 0; round < 8; round++) {
+		EMIT("\x1b[7mzeitlos\x1b[0m:/sd/src$ ls -l\r\n");
+		for (int i = 0; i < 40; i++)
+			EMIT("-rw-r--r--  1 user  %8d  Oct 18 12:%02d  source_file_%03d.c\r\n",
+				1024 * (i + 1), i % 60, i);
+		EMIT("\x1b[2J\x1b[H");
+		for (int row = 1; row <= VT_ROWS; row++)
+			EMIT("\x1b[%d;1H\x1b[K%3d  int value_%d = compute(%d, %d);", row, row, row, row, round);
+		EMIT("\x1b[%d;1H\x1b[7m-- INSERT --\x1b[0m\x1b[1;1H", VT_ROWS);
+		for (int i = 0; i < 10; i++)
+			EMIT("\x1b[%d;%dHx\x08\x08\tdone\r\n", 1 + i, 5 + i);
+	}
+
+#undef EMIT
+
+	return len;
+
+}
+
+typedef struct {
+	vt_screen_t vt;
+	const uint8_t *data;
+	uint32_t len;
+} vt_ctx_t;
+
+static void bench_vt_feed(void *ctx, uint32_t n) {
+	vt_ctx_t *c = ctx;
+	for (uint32_t i = 0; i < n; i++) {
+		vt_feed(&c->vt, c->data, c->len);
+		vt_clear_dirty(&c->vt);
+	}
+	sink += (uint32_t)c->vt.cursor_x;
+}
+
+// -- zline --
+
+// someone typing commands: ordinary keys, a few corrections, Enter
+static const char keystrokes[] =
+	"ls -l /sd/src\r"
+	"cat readme.txx\x08\x08\x08txt\r"
+	"tget 192.168.1.10 kernel.bin\r"
+	"(define (square x) (* x x))\r"
+	"echo hello wrold\x08\x08\x08\x08\x08world\r\n";
+
+static void bench_line_feed(void *ctx, uint32_t n) {
+	(void)ctx;
+	z_line_t line;
+	char echo[Z_LINE_ECHO_MAX];
+	uint32_t echo_len;
+	z_line_reset(&line);
+	for (uint32_t i = 0; i < n; i++) {
+		for (uint32_t k = 0; k < sizeof(keystrokes) - 1; k++) {
+			if (z_line_feed(&line, (uint8_t)keystrokes[k], echo, &echo_len, sizeof(echo))) {
+				sink += line.len;
+				z_line_reset(&line);
+			}
+			sink += echo_len;
+		}
+	}
+}
+
+int main(int argc, char **argv) {
+
+	if (argc > 1) min_ns = strtoull(argv[1], NULL, 10) * 1000000ull;
+
+	printf("{\n  \"suite\": \"sw/common host benchmarks\",\n  \"results\": [");
+
+	z_obj_t tree = make_tree();
+	bench("zobj_create_free", bench_create_free, NULL, 1, 0);
+	bench("zobj_copy_free", bench_copy_free, &tree, 1, 0);
+
+	pair_t eq = { tree, z_obj_copy(&tree) };
+	bench("zobj_equal", bench_equal, &eq, 1, 0);
+	z_obj_free(&eq.b);
+
+	bench("zobj_flatten_unflatten", bench_flatten, &tree, 1, 0);
+	z_obj_free(&tree);
+
+	static lookup_t l;
+	static const uint32_t sizes[] = { 4, 16, 64, 256 };
+	char name[48];
+	for (uint32_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+		for (int hashed = 0; hashed < 2; hashed++) {
+			lookup_init(&l, sizes[s], hashed);
+			snprintf(name, sizeof(name), "map_find_%s_%u",
+				hashed ? "hashed" : "linear", (unsigned)sizes[s]);
+			bench(name, bench_lookup, &l, sizes[s], 0);
+			z_obj_free(&l.map);
+		}
+	}
+
+	static uint8_t traffic[65536];
+	static vt_ctx_t vc;
+	vc.data = traffic;
+	vc.len = make_traffic(traffic, sizeof(traffic));
+	vt_init(&vc.vt);
+	bench("vt_feed", bench_vt_feed, &vc, vc.len, vc.len);
+
+	bench("line_feed", bench_line_feed, NULL,
+		sizeof(keystrokes) - 1, sizeof(keystrokes) - 1);
+
+	printf("\n  ]\n}\n");
+
+	return 0;
+
+}
@@ -543,6 +543,209 @@ void print_test_summary(void) {
     }
 }
 
+int test_flatten_roundtrip(void) {
+    TEST_START("flatten / unflatten round trip");
+
+    // deliberately bigger than a message's resolve scratch
+    // (Z_MSG_MAX_TABLES/Z_MSG_MAX_ITEMS in zmsg.h) -- 6 tables, 40 items
+    // z_map_set() copies its value, so each one built here is freed
+    // once it's set
+    z_obj_t root = z_obj_map(3);
+    z_obj_t name = z_obj_str("listing");
+    z_map_set(&root, "name", name);
+    z_obj_free(&name);
+    z_obj_t bytes = z_obj_blob("a\0b", 3);
+    z_map_set(&root, "blob", bytes);
+    z_obj_free(&bytes);
+    z_obj_t entries = z_obj_list(4);
+    z_obj_table_t *et = (z_obj_table_t *)entries.val.ptr;
+    for (uint32_t i = 0; i < 4; i++) {
+        et->a[i] = z_obj_map(4);
+        z_map_set(&et->a[i], "idx", z_obj_uint32(i));
+        z_map_set(&et->a[i], "neg", z_obj_int32(-(int32_t)i));
+        z_map_set(&et->a[i], "f", z_obj_float32(i * 0.5f));
+        z_obj_t s = z_obj_str("entry");
+        z_map_set(&et->a[i], "s", s);
+        z_obj_free(&s);
+    }
+    z_map_set(&root, "entries", entries);
+    z_obj_free(&entries);
+
+    uint32_t need = z_obj_flat_size(&root);
+    TEST_ASSERT(need > sizeof(z_obj_flat_t), "flat size is computed");
+
+    void *buf = malloc(need);
+    TEST_ASSERT(z_obj_flatten(&root, buf, need - 1) == 0, "flatten refuses a short buffer");
+    TEST_ASSERT(z_obj_flatten(&root, buf, need) == need, "flatten fills exactly the computed size");
+
+    // move it somewhere else first, as a message copy would
+    void *moved = malloc(need);
+    memcpy(moved, buf, need);
+    memset(buf, 0xAA, need);
+
+    z_obj_t *out = z_obj_unflatten(moved, need);
+    TEST_ASSERT(out != NULL, "unflatten succeeds");
+    TEST_ASSERT(z_obj_equal(out, &root), "unflattened tree equals the original");
+    TEST_ASSERT(z_obj_unflatten(moved, need) == out, "unflatten at the same address is a no-op");
+
+    // relocating an already-relocated buffer again
+    void *again = malloc(need);
+    memcpy(again, moved, need);
+    memset(moved, 0x55, need);
+    z_obj_t *out2 = z_obj_unflatten(again, need);
+    TEST_ASSERT(out2 != NULL && z_obj_equal(out2, &root), "re-relocation after a second move");
+
+    z_obj_t *blob = z_map_find(out2, "blob");
+    TEST_ASSERT(blob && z_blob_len(blob) == 3 && memcmp(z_blob_data(blob), "a\0b", 3) == 0,
+        "blob bytes survive");
+
+    z_obj_t wrapped = z_obj_flat(&root);
+    TEST_ASSERT(wrapped.type == Z_BLOB && z_blob_len(&wrapped) == need, "z_obj_flat wraps it in a blob");
+    z_obj_t *out3 = z_obj_unflatten(z_blob_data(&wrapped), z_blob_len(&wrapped));
+    TEST_ASSERT(out3 != NULL && z_obj_equal(out3, &root), "blob form unflattens");
+
+    z_obj_free(&wrapped);
+    free(buf);
+    free(moved);
+    free(again);
+    z_obj_free(&root);
+
+    TEST_END();
+}
+
+int test_unflatten_rejects_bad_input(void) {
+    TEST_START("unflatten rejects bad input");
+
+    z_obj_t list = z_obj_list(2);
+    z_obj_table_t *t = (z_obj_table_t *)list.val.ptr;
+    t->a[0] = z_obj_str("hello");
+    t->a[1] = z_obj_uint32(7);
+
+    uint32_t need = z_obj_flat_size(&list);
+    void *buf = malloc(need);
+    z_obj_flatten(&list, buf, need);
+
+    TEST_ASSERT(z_obj_unflatten(buf, need - 1) == NULL, "truncated buffer rejected");
+    TEST_ASSERT(z_obj_unflatten(NULL, need) == NULL, "NULL buffer rejected");
+
+    // point the table past the end of the buffer
+    z_obj_flat_t *h = (z_obj_flat_t *)buf;
+    h->root.val.ptr = (void *)(uintptr_t)(need + 64);
+    TEST_ASSERT(z_obj_unflatten(buf, need) == NULL, "out-of-range offset rejected");
+    TEST_ASSERT(z_obj_unflatten(buf, need) == NULL, "failed buffer stays invalid");
+
+    char junk[64] = { 0 };
+    TEST_ASSERT(z_obj_unflatten(junk, sizeof(junk)) == NULL, "missing magic rejected");
+
+    free(buf);
+    z_obj_free(&list);
+
+    TEST_END();
+}
+
+int test_arena(void) {
+    TEST_START("arena build / reset");
+
+    void *buf[32];  // pointer-aligned, like a real caller's
+    z_arena_t a;
+    z_arena_init(&a, buf, sizeof(buf));
+
+    z_obj_t map = z_arena_map(&a, 2);
+    TEST_ASSERT(map.type == Z_MAP, "map built in the arena");
+    TEST_ASSERT(z_arena_map_set(&a, &map, "ok", z_obj_uint32(1)), "scalar value set");
+    TEST_ASSERT(z_arena_map_set(&a, &map, "error", z_arena_str(&a, "nope")), "string value set");
+    TEST_ASSERT(z_arena_map_set(&a, &map, "ok", z_obj_uint32(0)), "existing key overwritten");
+    TEST_ASSERT(!z_arena_map_set(&a, &map, "extra", z_obj_uint32(2)), "full map refuses a new key");
+
+    z_obj_t *ok = z_map_find(&map, "ok");
+    z_obj_t *err = z_map_find(&map, "error");
+    TEST_ASSERT(ok && ok->val.uint32 == 0, "overwritten value found");
+    TEST_ASSERT(err && strcmp(err->val.str, "nope") == 0, "string value found");
+    TEST_ASSERT((uint8_t *)err->val.str >= (uint8_t *)buf &&
+        (uint8_t *)err->val.str < (uint8_t *)buf + sizeof(buf), "string lives in the buffer");
+
+    uint8_t bytes[3] = { 1, 0, 2 };
+    z_obj_t blob = z_arena_blob(&a, bytes, sizeof(bytes));
+    TEST_ASSERT(z_blob_len(&blob) == 3 && memcmp(z_blob_data(&blob), bytes, 3) == 0, "blob copied");
+
+    uint32_t used = a.used;
+    TEST_ASSERT(z_arena_blob(&a, NULL, sizeof(buf)).type == Z_NONE, "oversized blob fails cleanly");
+    TEST_ASSERT(z_arena_str(&a, "fits?").type == Z_STR, "arena still usable after a failure");
+    TEST_ASSERT(a.used >= used, "failures never shrink the arena");
+
+    z_arena_reset(&a);
+    TEST_ASSERT(a.used == 0, "reset empties the arena");
+    z_obj_t again = z_arena_map(&a, 2);
+    TEST_ASSERT(again.val.ptr == map.val.ptr, "reset reuses the same memory");
+
+    z_arena_t heap;
+    TEST_ASSERT(z_arena_create(&heap, 128), "heap arena created");
+    TEST_ASSERT(z_arena_list(&heap, 4).type == Z_LIST, "list built in a heap arena");
+    z_arena_destroy(&heap);
+    TEST_ASSERT(heap.buf == NULL && heap.size == 0, "destroy frees and clears");
+
+    TEST_END();
+}
+
+int test_hmap(void) {
+    TEST_START("hashed map grow / copy / flatten");
+
+    z_obj_t map = z_obj_hmap(4);
+    TEST_ASSERT(map.type == Z_MAP, "hashed map created");
+    z_obj_table_t *t = (z_obj_table_t *)map.val.ptr;
+    uint32_t cap = t->len;
+    TEST_ASSERT((t->flags & Z_TABLE_HASHED) && (cap & (cap - 1)) == 0, "power-of-two columns");
+
+    char key[16];
+    for (uint32_t i = 0; i < 40; i++) {
+        snprintf(key, sizeof(key), "key%u", (unsigned)i);
+        TEST_ASSERT(z_map_set(&map, key, z_obj_uint32(i)), "key set");
+    }
+    t = (z_obj_table_t *)map.val.ptr;
+    TEST_ASSERT(t->len > cap && t->count == 40, "map grew past its first size");
+    TEST_ASSERT(t->count * 4 <= t->len * 3, "stays at most 3/4 full");
+
+    int all = 1;
+    for (uint32_t i = 0; i < 40; i++) {
+        snprintf(key, sizeof(key), "key%u", (unsigned)i);
+        z_obj_t *v = z_map_find(&map, key);
+        if (!v || v->val.uint32 != i) all = 0;
+    }
+    TEST_ASSERT(all, "every key found after growing");
+    TEST_ASSERT(z_map_find(&map, "key40") == NULL, "missing key not found");
+
+    z_obj_t seven = z_obj_str("seven");  // z_map_set() copies it
+    TEST_ASSERT(z_map_set(&map, "key7", seven), "existing key overwritten");
+    z_obj_free(&seven);
+    TEST_ASSERT(t->count == 40, "overwrite doesn't add a key");
+
+    z_obj_t copy = z_obj_copy(&map);
+    z_obj_t *v = z_map_find(&copy, "key7");
+    TEST_ASSERT(v && v->type == Z_STR && strcmp(v->val.str, "seven") == 0, "copy stays findable");
+    TEST_ASSERT(z_obj_equal(&map, &copy), "copy equals the original");
+
+    uint8_t buf[4096] __attribute__((aligned(8)));
+    TEST_ASSERT(z_obj_flatten(&map, buf, sizeof(buf)) > 0, "hashed map flattens");
+    z_obj_t *root = z_obj_unflatten(buf, sizeof(buf));
+    v = root ? z_map_find(root, "key39") : NULL;
+    TEST_ASSERT(v && v->val.uint32 == 39, "flattened copy stays findable");
+
+    z_obj_free(&copy);
+    z_obj_free(&map);
+
+    void *abuf[64];
+    z_arena_t a;
+    z_arena_init(&a, abuf, sizeof(abuf));
+    z_obj_t amap = z_arena_hmap(&a, 3);
+    TEST_ASSERT(z_arena_map_set(&a, &amap, "x", z_obj_uint32(1)) &&
+        z_arena_map_set(&a, &amap, "y", z_obj_uint32(2)) &&
+        z_arena_map_set(&a, &amap, "z", z_obj_uint32(3)), "arena hashed map filled");
+    v = z_map_find(&amap, "y");
+    TEST_ASSERT(v && v->val.uint32 == 2, "arena hashed map findable");
+
+    TEST_END();
+}
+
 // Manual test with print output
 void manual_test_print(void) {
     printf("=== Manual Print Test ===\n");
@@ -641,6 +844,10 @@ int main(void) {
     test_copy_function();
     test_map_find_function();
     test_convenience_aliases();
+    test_flatten_roundtrip();
+    test_unflatten_rejects_bad_input();
+    test_arena();
+    test_hmap();
     
     print_test_summary();
     printf("\n");